@@ -27,6 +27,34 @@ int main(int argc, char **argv)
 
 ]) dnl SQUID_CHECK_EPOLL
 
+dnl check that io_uring actually works and supports the features we need
+dnl sets squid_cv_io_uring_works to "yes" or "no"
+AC_DEFUN([SQUID_CHECK_IO_URING],[
+
+    AC_CACHE_CHECK(if io_uring works, squid_cv_io_uring_works,
+      AC_RUN_IFELSE([AC_LANG_SOURCE([[
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+int main(int argc, char **argv)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = syscall(__NR_io_uring_setup, 8, &params);
+    if (fd < 0) {
+	perror("io_uring_setup:");
+	return 1;
+    }
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+	return 1;
+    return 0;
+}
+      ]])],[squid_cv_io_uring_works=yes],[squid_cv_io_uring_works=no],[:]))
+
+]) dnl SQUID_CHECK_IO_URING
+
 dnl check that /dev/poll actually works
 dnl sets squid_cv_devpoll_works to "yes" or "no"
 AC_DEFUN([SQUID_CHECK_DEVPOLL],[
@@ -27,6 +27,7 @@
 #include "DiskIO/IORequestor.h"
 #include "DiskIO/ReadRequest.h"
 #include "DiskIO/WriteRequest.h"
+#include "fatal.h"
 #include "fs_io.h"
 #include "globals.h"
 
@@ -17,6 +17,7 @@
 #include "DiskdFile.h"
 #include "DiskdIOStrategy.h"
 #include "DiskIO/DiskFile.h"
+#include "fatal.h"
 #include "fd.h"
 #include "SquidConfig.h"
 #include "SquidIpc.h"
@@ -27,13 +27,29 @@ public:
     class Config
     {
     public:
-        Config(): ioTimeout(0), ioRate(-1) {}
+        Config(): ioTimeout(0), ioRate(-1), ioUring(false), directIo(false), diskers(1), diskerIndex(-1) {}
 
         /// canRead/Write should return false if expected I/O delay exceeds it
         time_msec_t ioTimeout; // not enforced if zero, which is the default
 
         /// shape I/O request stream to approach that many per second
         int ioRate; // not enforced if negative, which is the default
+
+        /// queue I/O to the IoUring DiskIO module instead of making blocking
+        /// system calls (in diskers and other kids doing the actual disk I/O)
+        bool ioUring;
+
+        /// bypass OS page cache using O_DIRECT and reorder queued requests by
+        /// their file offsets (in diskers)
+        bool directIo;
+
+        /// the number of diskers sharing file I/O, each handling requests
+        /// for its own set of file areas (IpcIo)
+        int diskers;
+
+        /// which of those diskers this kid is, starting with zero (in
+        /// diskers); other kids use -1
+        int diskerIndex;
     };
 
     typedef RefCount<DiskFile> Pointer;
@@ -48,6 +64,9 @@ public:
     virtual void close() = 0;
     virtual bool canRead() const = 0;
     virtual bool canWrite() const {return true;}
+    /// whether an optional read (e.g., a read-ahead) would not crowd out
+    /// reads and writes that callers cannot do without
+    virtual bool canReadAhead() const { return canRead(); }
 
     /** During migration only */
     virtual int getFD() const {return -1;}
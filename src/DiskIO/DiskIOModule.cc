@@ -22,6 +22,9 @@
 #if HAVE_DISKIO_MODULE_DISKTHREADS
 #include "DiskIO/DiskThreads/DiskThreadsDiskIOModule.h"
 #endif
+#if HAVE_DISKIO_MODULE_IOURING
+#include "DiskIO/IoUring/IoUringDiskIOModule.h"
+#endif
 #if HAVE_DISKIO_MODULE_IPCIO
 #include "DiskIO/IpcIo/IpcIoDiskIOModule.h"
 #endif
@@ -56,6 +59,9 @@ DiskIOModule::SetupAllModules()
 #if HAVE_DISKIO_MODULE_DISKTHREADS
     DiskThreadsDiskIOModule::GetInstance();
 #endif
+#if HAVE_DISKIO_MODULE_IOURING
+    IoUringDiskIOModule::GetInstance();
+#endif
 #if HAVE_DISKIO_MODULE_IPCIO
     IpcIoDiskIOModule::GetInstance();
 #endif
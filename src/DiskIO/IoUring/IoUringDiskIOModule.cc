@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "DiskIO/IoUring/IoUringDiskIOModule.h"
+#include "DiskIO/IoUring/IoUringIOStrategy.h"
+
+IoUringDiskIOModule::IoUringDiskIOModule()
+{
+    ModuleAdd(*this);
+}
+
+IoUringDiskIOModule &
+IoUringDiskIOModule::GetInstance()
+{
+    return Instance;
+}
+
+void
+IoUringDiskIOModule::init()
+{}
+
+void
+IoUringDiskIOModule::gracefulShutdown()
+{}
+
+DiskIOStrategy *
+IoUringDiskIOModule::createStrategy()
+{
+    return new IoUringIOStrategy();
+}
+
+IoUringDiskIOModule IoUringDiskIOModule::Instance;
+
+char const *
+IoUringDiskIOModule::type () const
+{
+    return "IoUring";
+}
+
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_DISKIO_IOURING_IOURINGDISKIOMODULE_H
+#define SQUID_SRC_DISKIO_IOURING_IOURINGDISKIOMODULE_H
+
+#if HAVE_DISKIO_MODULE_IOURING
+
+#include "DiskIO/DiskIOModule.h"
+
+class IoUringDiskIOModule : public DiskIOModule
+{
+
+public:
+    static IoUringDiskIOModule &GetInstance();
+    IoUringDiskIOModule();
+    void init() override;
+    void gracefulShutdown() override;
+    char const *type () const override;
+    DiskIOStrategy* createStrategy() override;
+
+private:
+    static IoUringDiskIOModule Instance;
+};
+
+#endif /* HAVE_DISKIO_MODULE_IOURING */
+#endif /* SQUID_SRC_DISKIO_IOURING_IOURINGDISKIOMODULE_H */
+
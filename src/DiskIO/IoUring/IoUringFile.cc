@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 79    Disk IO Routines */
+
+#include "squid.h"
+#include "debug/Stream.h"
+#include "DiskIO/IoUring/IoUringFile.h"
+#include "DiskIO/IoUring/IoUringIOStrategy.h"
+#include "DiskIO/IoUring/IoUringQueue.h"
+#include "DiskIO/ReadRequest.h"
+#include "DiskIO/WriteRequest.h"
+#include "fd.h"
+#include "fs_io.h"
+#include "globals.h"
+#include "mem/AllocatorProxy.h"
+#include "StatCounters.h"
+
+#include <algorithm>
+#include <cerrno>
+#if HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+CBDATA_CLASS_INIT(IoUringFile);
+
+/// a queued IoUringFile read or write
+class IoUringFileOperation: public IoUringOperation
+{
+public:
+    IoUringFileOperation(const IoUringFile::Pointer &aFile, const uint64_t aSequence):
+        file(aFile), sequence(aSequence) {}
+
+    /// informs the file about our results; see IoUringFile::noteFinished()
+    virtual void deliver() = 0;
+
+    const IoUringFile::Pointer file; ///< keeps the file open while we are queued
+    const uint64_t sequence; ///< IoUringFile::read() and write() call number
+};
+
+/// a queued IoUringFile read
+class IoUringReadOperation: public IoUringFileOperation
+{
+    MEMPROXY_CLASS(IoUringReadOperation);
+
+public:
+    IoUringReadOperation(const IoUringFile::Pointer &aFile, const uint64_t aSequence, ReadRequest *aRequest):
+        IoUringFileOperation(aFile, aSequence), request(aRequest) {}
+
+    /* IoUringOperation API */
+    void finish(const int aResult) override {
+        result = aResult;
+        file->noteFinished(*this);
+    }
+
+    /* IoUringFileOperation API */
+    void deliver() override { file->readDone(*request, result); }
+
+private:
+    const ReadRequest::Pointer request;
+    int result = 0; ///< finish() parameter
+};
+
+/// a queued IoUringFile write; handles partial writes
+class IoUringWriteOperation: public IoUringFileOperation
+{
+    MEMPROXY_CLASS(IoUringWriteOperation);
+
+public:
+    IoUringWriteOperation(IoUringQueue &aQueue, const IoUringFile::Pointer &aFile, const uint64_t aSequence, WriteRequest *aRequest, const off_t anOffset):
+        IoUringFileOperation(aFile, aSequence), queue(aQueue), request(aRequest), offset(anOffset) {}
+
+    /// queues the remaining bytes
+    void start() {
+        ++attempts;
+        queue.write(file->getFD(), request->buf + written, request->len - written, offset + written, this);
+    }
+
+    /* IoUringOperation API */
+    void finish(const int result) override {
+        if (result < 0) {
+            finalize(-result);
+            return;
+        }
+
+        fd_bytes(file->getFD(), result, IoDirection::Write);
+        written += static_cast<size_t>(result);
+        // Partial writes to disk do happen. Like diskers, we write leftovers
+        // ourselves because the caller could only write them again.
+        const int attemptLimit = 10;
+        if (written < request->len && result > 0 && attempts < attemptLimit) {
+            start();
+            return;
+        }
+
+        finalize(written < request->len ? EIO : 0);
+    }
+
+    /* IoUringFileOperation API */
+    void deliver() override { file->writeDone(*request, xerrno, written); }
+
+private:
+    void finalize(const int anErrno) {
+        xerrno = anErrno;
+        file->noteFinished(*this);
+    }
+
+    IoUringQueue &queue;
+    const WriteRequest::Pointer request;
+    const off_t offset; ///< where the first request byte goes
+    size_t written = 0; ///< the number of bytes written so far
+    int attempts = 0; ///< the number of write(2)-like calls queued so far
+    int xerrno = 0; ///< finalize() parameter
+};
+
+IoUringFile::IoUringFile(char const *aPath, IoUringIOStrategy *aStrategy):
+    strategy(aStrategy)
+{
+    assert(aPath);
+    debugs(79, 3, "IoUringFile::IoUringFile: " << aPath);
+    path_ = xstrdup(aPath);
+}
+
+IoUringFile::~IoUringFile()
+{
+    safe_free(path_);
+    doClose();
+}
+
+// XXX: almost a copy of BlockingFile::open
+void
+IoUringFile::open(int flags, mode_t, RefCount<IORequestor> callback)
+{
+    assert(fd < 0);
+
+    fd = file_open(path_, flags);
+    ioRequestor = callback;
+
+    if (fd < 0) {
+        const auto xerrno = errno;
+        debugs(79, 3, "open error: " << xstrerr(xerrno));
+        error_ = true;
+    } else {
+        ++store_open_disk_fd;
+        debugs(79, 3, "FD " << fd);
+
+        // queued appends cannot rely on the kernel-maintained file position
+        struct stat sb;
+        if (fstat(fd, &sb) == 0)
+            appendOffset = sb.st_size;
+        (void)strategy->queue(); // create our ring before the first I/O
+    }
+
+    callback->ioCompletedNotification();
+}
+
+/**
+ * Alias for IoUringFile::open(...)
+ \copydoc IoUringFile::open(int flags, mode_t mode, RefCount<IORequestor> callback)
+ */
+void
+IoUringFile::create(int flags, mode_t mode, RefCount<IORequestor> callback)
+{
+    /* We use the same logic path for open */
+    open(flags, mode, callback);
+}
+
+void
+IoUringFile::doClose()
+{
+    if (fd >= 0) {
+        file_close(fd);
+        fd = -1;
+        --store_open_disk_fd;
+    }
+}
+
+void
+IoUringFile::close()
+{
+    debugs(79, 3, this << " closing for " << ioRequestor);
+
+    if (ioInProgress()) {
+        // callers like UFSStoreState wait for ioInProgress() to become false
+        debugs(79, DBG_CRITICAL, "ERROR: Squid BUG: IoUringFile::close: " <<
+               "did NOT close because ioInProgress() is true");
+        return;
+    }
+
+    doClose();
+    assert(ioRequestor != nullptr);
+    ioRequestor->closeCompleted();
+}
+
+bool
+IoUringFile::canRead() const
+{
+    return fd >= 0;
+}
+
+bool
+IoUringFile::canWrite() const
+{
+    return fd >= 0;
+}
+
+bool
+IoUringFile::error() const
+{
+    return error_;
+}
+
+bool
+IoUringFile::ioInProgress() const
+{
+    return inProgressIOs > 0;
+}
+
+void
+IoUringFile::read(ReadRequest *aRequest)
+{
+    debugs(79, 3, "(FD " << fd << ", " << aRequest->len << ", " <<
+           aRequest->offset << ")");
+
+    assert(fd >= 0);
+    assert(ioRequestor != nullptr);
+    assert(aRequest->offset >= 0);
+
+    ++statCounter.syscalls.disk.reads;
+    ++inProgressIOs;
+    strategy->queue().read(fd, aRequest->buf, aRequest->len, aRequest->offset,
+                           new IoUringReadOperation(this, ++queuedIOs, aRequest));
+}
+
+void
+IoUringFile::noteFinished(IoUringFileOperation &op)
+{
+    if (op.sequence != deliveredIOs + 1) {
+        debugs(79, 5, "delaying #" << op.sequence << " until #" << (deliveredIOs + 1) << " finishes");
+        finishedIOs.emplace(op.sequence, &op);
+        return;
+    }
+
+    // the last operation may hold the last reference to us
+    const Pointer self(this);
+    delete deliver(op);
+    while (!finishedIOs.empty() && finishedIOs.begin()->first == deliveredIOs + 1) {
+        const auto next = finishedIOs.begin()->second;
+        finishedIOs.erase(finishedIOs.begin());
+        delete deliver(*next);
+    }
+}
+
+/// informs the requestor about the finished operation results
+/// \returns the given operation
+IoUringFileOperation *
+IoUringFile::deliver(IoUringFileOperation &op)
+{
+    ++deliveredIOs;
+    op.deliver();
+    return &op;
+}
+
+void
+IoUringFile::readDone(ReadRequest &aRequest, const int result)
+{
+    assert(inProgressIOs > 0);
+    --inProgressIOs;
+
+    ssize_t rlen = 0;
+    int errflag = DISK_OK;
+    if (result < 0) {
+        debugs(79, 3, "FD " << fd << " read error: " << xstrerr(-result));
+        rlen = -1;
+        errflag = DISK_ERROR;
+        errno = -result;
+    } else {
+        rlen = result;
+        fd_bytes(fd, result, IoDirection::Read);
+    }
+
+    ioRequestor->readCompleted(aRequest.buf, rlen, errflag, &aRequest);
+}
+
+void
+IoUringFile::write(WriteRequest *aRequest)
+{
+    debugs(79, 3, "(FD " << fd << ", " << aRequest->len << ", " <<
+           aRequest->offset << ")");
+
+    assert(fd >= 0);
+    assert(ioRequestor != nullptr);
+
+    // concurrently queued writes may complete in any order, so we cannot
+    // ask the kernel to append (i.e. use and update the file position)
+    const auto offset = aRequest->offset < 0 ? appendOffset : aRequest->offset;
+    appendOffset = std::max(appendOffset, static_cast<off_t>(offset + aRequest->len));
+
+    ++statCounter.syscalls.disk.writes;
+    ++inProgressIOs;
+    const auto op = new IoUringWriteOperation(strategy->queue(), this, ++queuedIOs, aRequest, offset);
+    op->start();
+}
+
+void
+IoUringFile::writeDone(WriteRequest &aRequest, const int xerrno, const size_t written)
+{
+    assert(inProgressIOs > 0);
+    --inProgressIOs;
+
+    if (xerrno) {
+        debugs(79, DBG_IMPORTANT, "ERROR: " << path_ << " write failure after " <<
+               written << '/' << aRequest.len << " bytes: " << xstrerr(xerrno));
+        error_ = true;
+    } else {
+        debugs(79, 5, "wrote " << aRequest.len << " to FD " << fd << " at " << aRequest.offset);
+    }
+
+    if (aRequest.free_func)
+        (aRequest.free_func)(const_cast<char*>(aRequest.buf)); // broken API?
+
+    const auto errflag = xerrno ? (xerrno == ENOSPC ? DISK_NO_SPACE_LEFT : DISK_ERROR) : DISK_OK;
+    ioRequestor->writeCompleted(errflag, xerrno ? 0 : aRequest.len, &aRequest);
+}
+
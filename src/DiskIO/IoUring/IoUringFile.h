@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_DISKIO_IOURING_IOURINGFILE_H
+#define SQUID_SRC_DISKIO_IOURING_IOURINGFILE_H
+
+#if HAVE_DISKIO_MODULE_IOURING
+
+#include "cbdata.h"
+#include "DiskIO/DiskFile.h"
+#include "DiskIO/IORequestor.h"
+
+#include <map>
+
+class IoUringFileOperation;
+class IoUringIOStrategy;
+
+/// A file with reads and writes queued to the IoUringIOStrategy ring. Opening
+/// and closing are synchronous. Requestors learn about finished reads and
+/// writes in the order of read() and write() calls because the kernel may
+/// complete them in a different order, and some requestors (e.g., rock
+/// cache_dirs) need the original order.
+class IoUringFile : public DiskFile
+{
+    CBDATA_CLASS(IoUringFile);
+
+public:
+    typedef RefCount<IoUringFile> Pointer;
+
+    IoUringFile(char const *path, IoUringIOStrategy *);
+    ~IoUringFile() override;
+
+    /* DiskFile API */
+    void open(int flags, mode_t mode, RefCount<IORequestor> callback) override;
+    void create(int flags, mode_t mode, RefCount<IORequestor> callback) override;
+    void read(ReadRequest *) override;
+    void write(WriteRequest *) override;
+    void close() override;
+    bool error() const override;
+    int getFD() const override { return fd; }
+    bool canRead() const override;
+    bool canWrite() const override;
+    bool ioInProgress() const override;
+
+    /// called by IoUringFileOperation when it is done; delivers its
+    /// results and destroys it (now or after earlier operations finish)
+    void noteFinished(IoUringFileOperation &);
+
+    /// called by IoUringReadOperation when the kernel is done reading
+    void readDone(ReadRequest &, int result);
+    /// called by IoUringWriteOperation when it is done writing
+    void writeDone(WriteRequest &, int xerrno, size_t written);
+
+private:
+    void doClose();
+    IoUringFileOperation *deliver(IoUringFileOperation &);
+
+    char const *path_ = nullptr;
+    IoUringIOStrategy *strategy = nullptr;
+    RefCount<IORequestor> ioRequestor;
+    int fd = -1;
+    bool error_ = false;
+    size_t inProgressIOs = 0; ///< queued reads and writes that have not finished
+    off_t appendOffset = 0; ///< where the next write without an offset goes
+
+    uint64_t queuedIOs = 0; ///< the number of read() and write() calls
+    uint64_t deliveredIOs = 0; ///< the number of delivered operation results
+    /// finished operations waiting for earlier operations to finish
+    std::map<uint64_t, IoUringFileOperation *> finishedIOs;
+};
+
+#endif /* HAVE_DISKIO_MODULE_IOURING */
+#endif /* SQUID_SRC_DISKIO_IOURING_IOURINGFILE_H */
+
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 79    Disk IO Routines */
+
+#include "squid.h"
+#include "DiskIO/IoUring/IoUringFile.h"
+#include "DiskIO/IoUring/IoUringIOStrategy.h"
+#include "DiskIO/IoUring/IoUringQueue.h"
+#include "unlinkd.h"
+
+#include <algorithm>
+
+IoUringIOStrategy::IoUringIOStrategy() = default;
+
+IoUringIOStrategy::~IoUringIOStrategy() = default;
+
+IoUringQueue &
+IoUringIOStrategy::queue()
+{
+    if (!queue_)
+        queue_.reset(new IoUringQueue(QueueSize));
+    return *queue_;
+}
+
+bool
+IoUringIOStrategy::shedLoad()
+{
+    return queue_ && queue_->inFlight() >= MaxInFlight;
+}
+
+int
+IoUringIOStrategy::load()
+{
+    if (!queue_)
+        return 0;
+    return static_cast<int>(std::min(queue_->inFlight(), MaxInFlight) * 1000 / MaxInFlight);
+}
+
+DiskFile::Pointer
+IoUringIOStrategy::newFile(char const *path)
+{
+    if (shedLoad())
+        return nullptr;
+
+    return new IoUringFile(path, this);
+}
+
+void
+IoUringIOStrategy::sync()
+{
+    if (queue_)
+        queue_->drain();
+}
+
+bool
+IoUringIOStrategy::unlinkdUseful() const
+{
+    return true;
+}
+
+void
+IoUringIOStrategy::unlinkFile(char const *path)
+{
+    unlinkdUnlink(path);
+}
+
+/// submits the I/O queued since the last call and finishes completed I/O
+int
+IoUringIOStrategy::callback()
+{
+    if (!queue_)
+        return 0;
+
+    queue_->submit();
+    return queue_->harvest() ? 1 : 0;
+}
+
+void
+IoUringIOStrategy::statfs(StoreEntry &e) const
+{
+    if (queue_)
+        queue_->stat(e);
+}
+
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_DISKIO_IOURING_IOURINGIOSTRATEGY_H
+#define SQUID_SRC_DISKIO_IOURING_IOURINGIOSTRATEGY_H
+
+#if HAVE_DISKIO_MODULE_IOURING
+
+#include "DiskIO/DiskIOStrategy.h"
+
+#include <memory>
+
+class IoUringQueue;
+
+/// Disk I/O using Linux io_uring(7): each cache_dir gets its own ring. File
+/// reads and writes are queued and submitted to the kernel in batches, once
+/// per main loop iteration (see callback()).
+class IoUringIOStrategy : public DiskIOStrategy
+{
+
+public:
+    /// the number of SQEs in a ring
+    static constexpr unsigned QueueSize = 256;
+    /// the number of unfinished operations that makes us shed load
+    static constexpr size_t MaxInFlight = 4*QueueSize;
+
+    IoUringIOStrategy();
+    ~IoUringIOStrategy() override;
+
+    /// the ring for our files; created when the first file is opened so that
+    /// each kid process gets its own ring
+    IoUringQueue &queue();
+
+    /* DiskIOStrategy API */
+    bool shedLoad() override;
+    int load() override;
+    RefCount<DiskFile> newFile(char const *path) override;
+    void sync() override;
+    bool unlinkdUseful() const override;
+    void unlinkFile(char const *) override;
+    int callback() override;
+    void statfs(StoreEntry &) const override;
+
+private:
+    std::unique_ptr<IoUringQueue> queue_;
+};
+
+#endif /* HAVE_DISKIO_MODULE_IOURING */
+#endif /* SQUID_SRC_DISKIO_IOURING_IOURINGIOSTRATEGY_H */
+
@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 79    Disk IO Routines */
+
+#include "squid.h"
+#include "comm/Loops.h"
+#include "compat/unistd.h"
+#include "debug/Stream.h"
+#include "DiskIO/IoUring/IoUringQueue.h"
+#include "fatal.h"
+#include "fd.h"
+#include "fde.h"
+#include "Store.h"
+
+#include <algorithm>
+#include <cerrno>
+#if HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#endif
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#if HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+
+template <class Value>
+static Value *
+RingField(void *ring, const unsigned offset)
+{
+    return reinterpret_cast<Value *>(static_cast<char *>(ring) + offset);
+}
+
+/// mmap(2)s the given io_uring region; quits on failures
+static void *
+MapRing(const int ringFd, const size_t size, const off_t offset, const char *name)
+{
+    const auto ring = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ringFd, offset);
+    if (ring == MAP_FAILED) {
+        const auto xerrno = errno;
+        fatalf("IoUring DiskIO: mmap(%s): %s\n", name, xstrerr(xerrno));
+    }
+    return ring;
+}
+
+IoUringQueue::IoUringQueue(const unsigned entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CLAMP;
+
+    ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ringFd < 0) {
+        const auto xerrno = errno;
+        fatalf("IoUring DiskIO: io_uring_setup(2): %s\n", xstrerr(xerrno));
+    }
+
+    // completions exceeding CQ ring capacity must be kept, not dropped
+    if (!(params.features & IORING_FEAT_NODROP))
+        fatal("IoUring DiskIO: io_uring lacks IORING_FEAT_NODROP support; Linux v5.5 or later is required\n");
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    const auto singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap)
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRing = MapRing(ringFd, sqRingSize, IORING_OFF_SQ_RING, "IORING_OFF_SQ_RING");
+    cqRing = singleMmap ? sqRing : MapRing(ringFd, cqRingSize, IORING_OFF_CQ_RING, "IORING_OFF_CQ_RING");
+    sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = static_cast<struct io_uring_sqe *>(MapRing(ringFd, sqesSize, IORING_OFF_SQES, "IORING_OFF_SQES"));
+
+    sqHead = RingField<unsigned>(sqRing, params.sq_off.head);
+    sqTail = RingField<unsigned>(sqRing, params.sq_off.tail);
+    sqMask = RingField<unsigned>(sqRing, params.sq_off.ring_mask);
+    sqArray = RingField<unsigned>(sqRing, params.sq_off.array);
+    sqEntries = params.sq_entries;
+    sqLocalTail = *sqTail;
+
+    cqHead = RingField<unsigned>(cqRing, params.cq_off.head);
+    cqTail = RingField<unsigned>(cqRing, params.cq_off.tail);
+    cqMask = RingField<unsigned>(cqRing, params.cq_off.ring_mask);
+    cqes = RingField<struct io_uring_cqe>(cqRing, params.cq_off.cqes);
+
+    // the ring FD becomes readable when the CQ ring has completions
+    fd_open(ringFd, FD_FILE, "io_uring disk I/O completions");
+    Comm::SetSelect(ringFd, COMM_SELECT_READ, &IoUringQueue::HandleReadiness, this, 0);
+
+    debugs(79, 2, "io_uring FD " << ringFd << " with " << params.sq_entries <<
+           " SQEs and " << params.cq_entries << " CQEs");
+}
+
+IoUringQueue::~IoUringQueue()
+{
+    drain();
+
+    Comm::ResetSelect(ringFd);
+    xclose(ringFd);
+    fd_close(ringFd);
+
+    munmap(sqes, sqesSize);
+    if (cqRing != sqRing)
+        munmap(cqRing, cqRingSize);
+    munmap(sqRing, sqRingSize);
+}
+
+/// Comm handler for ring FD readiness
+void
+IoUringQueue::HandleReadiness(const int fd, void *data)
+{
+    const auto queue = static_cast<IoUringQueue *>(data);
+    queue->harvest();
+    Comm::SetSelect(fd, COMM_SELECT_READ, &IoUringQueue::HandleReadiness, data, 0);
+}
+
+/// \returns a zeroed SQE ready to be filled, submitting queued SQEs if needed
+io_uring_sqe &
+IoUringQueue::nextSqe()
+{
+    if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+        submit();
+    while (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+        // the kernel did not accept our SQEs; it may need us to reap completions
+        waitForCompletions();
+        harvest();
+        submit();
+    }
+
+    const auto index = sqLocalTail & *sqMask;
+    auto &sqe = sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqArray[index] = index;
+    ++sqLocalTail;
+    ++queued;
+    maxInFlight = std::max(maxInFlight, ++inFlight_);
+    return sqe;
+}
+
+void
+IoUringQueue::read(const int fd, char *buf, const size_t len, const off_t offset, IoUringOperation *op)
+{
+    auto &sqe = nextSqe();
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<uint64_t>(buf);
+    sqe.len = static_cast<uint32_t>(len);
+    sqe.off = static_cast<uint64_t>(offset);
+    sqe.user_data = reinterpret_cast<uint64_t>(op);
+}
+
+void
+IoUringQueue::write(const int fd, const char *buf, const size_t len, const off_t offset, IoUringOperation *op)
+{
+    auto &sqe = nextSqe();
+    sqe.opcode = IORING_OP_WRITE;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<uint64_t>(buf);
+    sqe.len = static_cast<uint32_t>(len);
+    sqe.off = static_cast<uint64_t>(offset);
+    sqe.user_data = reinterpret_cast<uint64_t>(op);
+}
+
+/// publishes queued SQEs and, optionally, waits for completions
+/// \returns io_uring_enter(2) result
+int
+IoUringQueue::enter(const unsigned minComplete)
+{
+    __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+    const auto toSubmit = sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    const unsigned flags = minComplete ? IORING_ENTER_GETEVENTS : 0;
+
+    ++enterCalls;
+    const auto result = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+    if (result > 0)
+        submitted += result;
+    return result;
+}
+
+void
+IoUringQueue::submit()
+{
+    while (sqLocalTail != __atomic_load_n(sqTail, __ATOMIC_RELAXED) ||
+            sqLocalTail != __atomic_load_n(sqHead, __ATOMIC_ACQUIRE)) {
+        if (enter(0) >= 0)
+            return;
+        const auto xerrno = errno;
+        if (xerrno == EINTR)
+            continue;
+        if (xerrno == EAGAIN || xerrno == EBUSY) {
+            // the kernel needs us to reap completions first; we will retry
+            debugs(79, 3, "postponing submission: " << xstrerr(xerrno));
+            return;
+        }
+        fatalf("IoUring DiskIO: io_uring_enter(2) submission failure: %s\n", xstrerr(xerrno));
+    }
+}
+
+/// blocks until at least one operation completes
+void
+IoUringQueue::waitForCompletions()
+{
+    while (enter(1) < 0) {
+        const auto xerrno = errno;
+        if (xerrno == EINTR)
+            continue;
+        if (xerrno == EAGAIN || xerrno == EBUSY)
+            return; // completions are already waiting for us
+        fatalf("IoUring DiskIO: io_uring_enter(2) wait failure: %s\n", xstrerr(xerrno));
+    }
+}
+
+int
+IoUringQueue::harvest()
+{
+    // an operation finishing during harvest() is harvested by the caller
+    if (harvesting)
+        return 0;
+    harvesting = true;
+
+    int count = 0;
+    auto head = *cqHead;
+    while (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+        const auto &cqe = cqes[head & *cqMask];
+        const auto op = reinterpret_cast<IoUringOperation *>(cqe.user_data);
+        const auto result = cqe.res;
+        // release the CQE before finish() may queue more operations
+        __atomic_store_n(cqHead, ++head, __ATOMIC_RELEASE);
+
+        assert(inFlight_ > 0);
+        --inFlight_;
+        ++finished;
+        ++count;
+        op->finish(result);
+    }
+
+    harvesting = false;
+    return count;
+}
+
+void
+IoUringQueue::drain()
+{
+    submit();
+    while (inFlight_) {
+        if (!harvest())
+            waitForCompletions();
+        submit(); // finished operations may have queued more
+    }
+}
+
+void
+IoUringQueue::stat(StoreEntry &e) const
+{
+    storeAppendPrintf(&e, "io_uring operations in flight: %zu (max %zu)\n", inFlight_, maxInFlight);
+    storeAppendPrintf(&e, "io_uring operations queued: %" PRIu64 ", submitted: %" PRIu64 ", finished: %" PRIu64 "\n",
+                      queued, submitted, finished);
+    storeAppendPrintf(&e, "io_uring_enter(2) calls: %" PRIu64 "\n", enterCalls);
+}
+
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_DISKIO_IOURING_IOURINGQUEUE_H
+#define SQUID_SRC_DISKIO_IOURING_IOURINGQUEUE_H
+
+#if HAVE_DISKIO_MODULE_IOURING
+
+#include "store/forward.h"
+
+#include <cstddef>
+#include <cstdint>
+
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+/// a read or write operation queued by IoUringQueue
+class IoUringOperation
+{
+public:
+    virtual ~IoUringOperation() {}
+
+    /// Called when the kernel completes the operation, with the number of
+    /// transferred bytes or a negated errno value. The queue does not own
+    /// operations; this is the last queue call for the given operation.
+    virtual void finish(int result) = 0;
+};
+
+/// A Linux io_uring(7) instance for disk I/O. Reads and writes only queue
+/// submission queue entries (SQEs). Queued entries are handed to the kernel
+/// in batches, one io_uring_enter(2) call per submit(), and completions are
+/// harvested from the mmap(2)ed completion queue without system calls. Any
+/// number of operations may be in flight without a thread per operation.
+///
+/// The ring FD is registered with Comm, so completions are harvested by the
+/// main loop even when the queue owner does not poll for them.
+class IoUringQueue
+{
+public:
+    /// creates a ring with the given number of SQEs; quits on failures
+    explicit IoUringQueue(unsigned entries);
+    ~IoUringQueue();
+
+    IoUringQueue(IoUringQueue &&) = delete; // no copying or moving of any kind
+
+    /// queues a pread(2)-like operation
+    void read(int fd, char *buf, size_t len, off_t offset, IoUringOperation *);
+    /// queues a pwrite(2)-like operation
+    void write(int fd, const char *buf, size_t len, off_t offset, IoUringOperation *);
+
+    /// hands all queued operations to the kernel
+    void submit();
+
+    /// finishes all completed operations
+    /// \returns the number of finished operations
+    int harvest();
+
+    /// submits queued operations and waits for all operations to finish
+    void drain();
+
+    /// the number of queued or submitted operations that have not finished
+    size_t inFlight() const { return inFlight_; }
+
+    /// reports queue statistics
+    void stat(StoreEntry &) const;
+
+private:
+    static void HandleReadiness(int fd, void *data);
+
+    io_uring_sqe &nextSqe();
+    int enter(unsigned minComplete);
+    void waitForCompletions();
+
+    int ringFd = -1; ///< io_uring_setup(2) result
+
+    /* mmap(2)ed submission queue ring */
+    void *sqRing = nullptr;
+    size_t sqRingSize = 0;
+    unsigned *sqHead = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned *sqMask = nullptr;
+    unsigned *sqArray = nullptr;
+    unsigned sqEntries = 0;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqesSize = 0;
+    /// our copy of the SQ tail; differs from *sqTail while SQEs await submission
+    unsigned sqLocalTail = 0;
+
+    /* mmap(2)ed completion queue ring */
+    void *cqRing = nullptr;
+    size_t cqRingSize = 0;
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned *cqMask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+    size_t inFlight_ = 0; ///< operations that have not finished yet
+    bool harvesting = false; ///< whether harvest() is running
+
+    /* statistics */
+    uint64_t queued = 0; ///< the number of queued operations
+    uint64_t submitted = 0; ///< the number of SQEs accepted by the kernel
+    uint64_t finished = 0; ///< the number of finished operations
+    uint64_t enterCalls = 0; ///< the number of io_uring_enter(2) calls
+    size_t maxInFlight = 0; ///< the maximum inFlight() value seen so far
+};
+
+#endif /* HAVE_DISKIO_MODULE_IOURING */
+#endif /* SQUID_SRC_DISKIO_IOURING_IOURINGQUEUE_H */
+
@@ -13,6 +13,9 @@
 #include "base/CodeContext.h"
 #include "base/RunnersRegistry.h"
 #include "base/TextException.h"
+#if HAVE_DISKIO_MODULE_IOURING
+#include "DiskIO/IoUring/IoUringQueue.h"
+#endif
 #include "DiskIO/IORequestor.h"
 #include "DiskIO/IpcIo/IpcIoFile.h"
 #include "DiskIO/ReadRequest.h"
@@ -27,12 +30,20 @@
 #include "ipc/StrandCoord.h"
 #include "ipc/StrandSearch.h"
 #include "ipc/UdsOp.h"
+#include "mem/AllocatorProxy.h"
 #include "sbuf/SBuf.h"
 #include "SquidConfig.h"
 #include "StatCounters.h"
 #include "tools.h"
 
+#include <algorithm>
+#include <array>
 #include <cerrno>
+#include <iomanip>
+#include <vector>
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 
 CBDATA_CLASS_INIT(IpcIoFile);
 
@@ -44,6 +55,11 @@ static const char *const ShmLabel = "io_file";
 // TODO: make configurable or compute from squid.conf settings if possible
 static const int QueueCapacity = 1024;
 
+/// With multiple diskers per db file, each disker handles requests for every
+/// Nth db file stripe of this size. Large stripes keep neighboring slots
+/// (e.g., slots of one cached entry) in one disker that can coalesce their I/O.
+static const off_t StripeSize = 1024*1024;
+
 const double IpcIoFile::Timeout = 7; // seconds;  XXX: ALL,9 may require more
 IpcIoFile::IpcIoFileList IpcIoFile::WaitingForOpen;
 IpcIoFile::IpcIoFilesMap IpcIoFile::IpcIoFiles;
@@ -51,8 +67,9 @@ std::unique_ptr<IpcIoFile::Queue> IpcIoFile::queue;
 
 bool IpcIoFile::DiskerHandleMoreRequestsScheduled = false;
 
-static bool DiskerOpen(const SBuf &path, int flags, mode_t mode);
+static bool DiskerOpen(const SBuf &path, int flags, mode_t mode, const DiskFile::Config &);
 static void DiskerClose(const SBuf &path);
+static void DiskerStat(std::ostream &);
 
 /// IpcIo wrapper for debugs() streams; XXX: find a better class name
 struct SipcIo {
@@ -71,6 +88,18 @@ operator <<(std::ostream &os, const SipcIo &sio)
            sio.msg.command << sio.disker;
 }
 
+/// the strand tag of the given disker among the diskers sharing the db file
+static String
+DiskerTag(const String &dbName, const int diskerIndex)
+{
+    if (diskerIndex <= 0)
+        return dbName; // the only disker in most configurations
+
+    SBuf tag;
+    tag.appendf("%s#%d", dbName.termedBuf(), diskerIndex);
+    return String(tag.c_str());
+}
+
 /* IpcIo::Command */
 
 std::ostream &
@@ -108,10 +137,12 @@ IpcIoFile::~IpcIoFile()
 {
     SWALLOW_EXCEPTIONS({
         if (diskId >= 0) {
-            const auto i = IpcIoFiles.find(diskId);
-            Must(i != IpcIoFiles.end());
-            Must(i->second == this);
-            IpcIoFiles.erase(i);
+            for (const auto id: diskIds) {
+                const auto i = IpcIoFiles.find(id);
+                Must(i != IpcIoFiles.end());
+                Must(i->second == this);
+                IpcIoFiles.erase(i);
+            }
         }
     });
 }
@@ -137,27 +168,36 @@ IpcIoFile::open(int flags, mode_t mode, RefCount<IORequestor> callback)
     }
 
     if (IamDiskProcess()) {
-        error_ = !DiskerOpen(SBuf(dbName.termedBuf()), flags, mode);
+        error_ = !DiskerOpen(SBuf(dbName.termedBuf()), flags, mode, config);
         if (error_)
             return;
 
         diskId = KidIdentifier;
+        diskIds.assign(1, diskId);
         const bool inserted =
             IpcIoFiles.insert(std::make_pair(diskId, this)).second;
         Must(inserted);
 
-        queue->localRateLimit().store(config.ioRate);
+        // diskers sharing the db file share its I/O rate limit
+        const auto diskers = max(config.diskers, 1);
+        const auto ioRate = config.ioRate > 0 ? (config.ioRate + diskers - 1) / diskers : config.ioRate;
+        queue->localRateLimit().store(ioRate);
 
-        Ipc::StrandMessage::NotifyCoordinator(Ipc::mtRegisterStrand, dbName.termedBuf());
+        Ipc::StrandMessage::NotifyCoordinator(Ipc::mtRegisterStrand,
+                                              DiskerTag(dbName, config.diskerIndex).termedBuf());
 
         ioRequestor->ioCompletedNotification();
         return;
     }
 
-    const Ipc::StrandSearchRequest request(dbName);
-    Ipc::TypedMsgHdr msg;
-    request.pack(msg);
-    Ipc::SendMessage(Ipc::Port::CoordinatorAddr(), msg);
+    // HandleOpenResponse() fills diskIds as diskers are found
+    diskIds.assign(max(config.diskers, 1), -1);
+    for (size_t i = 0; i < diskIds.size(); ++i) {
+        const Ipc::StrandSearchRequest request(DiskerTag(dbName, i));
+        Ipc::TypedMsgHdr msg;
+        request.pack(msg);
+        Ipc::SendMessage(Ipc::Port::CoordinatorAddr(), msg);
+    }
 
     WaitingForOpen.push_back(this);
 
@@ -174,17 +214,18 @@ IpcIoFile::openCompleted(const Ipc::StrandMessage *const response)
         debugs(79, DBG_IMPORTANT, "ERROR: " << dbName << " communication " <<
                "channel establishment timeout");
         error_ = true;
-    } else {
-        diskId = response->strand.kidId;
-        if (diskId >= 0) {
+    } else if (response->strand.kidId >= 0) {
+        // HandleOpenResponse() has found all our diskers
+        diskId = diskIds.front();
+        for (const auto id: diskIds) {
             const bool inserted =
-                IpcIoFiles.insert(std::make_pair(diskId, this)).second;
+                IpcIoFiles.insert(std::make_pair(id, this)).second;
             Must(inserted);
-        } else {
-            error_ = true;
-            debugs(79, DBG_IMPORTANT, "ERROR: no disker claimed " <<
-                   "responsibility for " << dbName);
         }
+    } else {
+        error_ = true;
+        debugs(79, DBG_IMPORTANT, "ERROR: no disker claimed " <<
+               "responsibility for " << response->strand.tag);
     }
 
     ioRequestor->ioCompletedNotification();
@@ -226,6 +267,13 @@ IpcIoFile::canWrite() const
     return diskId >= 0 && !error_ && canWait();
 }
 
+bool
+IpcIoFile::canReadAhead() const
+{
+    // keep half of the queue for requests that push() must not drop
+    return canRead() && pendingRequests() < QueueCapacity/2;
+}
+
 bool
 IpcIoFile::error() const
 {
@@ -390,19 +438,22 @@ IpcIoFile::push(IpcIoPendingRequest *const pending)
             memcpy(buf, pending->writeRequest->buf, ipcIo.len); // optimize away
         }
 
-        debugs(47, 7, "pushing " << SipcIo(KidIdentifier, ipcIo, diskId));
+        debugs(47, 7, "pushing " << SipcIo(KidIdentifier, ipcIo, diskerFor(ipcIo.offset)));
 
         // protect DiskerHandleRequest() from pop queue overflow
         if (pendingRequests() >= QueueCapacity)
             throw Ipc::OneToOneUniQueue::Full();
 
-        if (queue->push(diskId, ipcIo))
-            Notify(diskId); // must notify disker
+        const auto disker = diskerFor(ipcIo.offset);
+        if (queue->push(disker, ipcIo))
+            Notify(disker); // must notify disker
         trackPendingRequest(ipcIo.requestId, pending);
+        if (diskIds.size() > 1)
+            responseOrder.push_back(ipcIo.requestId);
     } catch (const Queue::Full &) {
         debugs(47, DBG_IMPORTANT, "ERROR: worker I/O push queue for " <<
                dbName << " overflow: " <<
-               SipcIo(KidIdentifier, ipcIo, diskId)); // TODO: report queue len
+               SipcIo(KidIdentifier, ipcIo, diskerFor(ipcIo.offset))); // TODO: report queue len
         // TODO: grow queue size
         if (ipcIo.page)
             Ipc::Mem::PutPage(ipcIo.page);
@@ -416,6 +467,15 @@ IpcIoFile::push(IpcIoPendingRequest *const pending)
     }
 }
 
+/// the kid ID of the disker responsible for the given db file offset
+int
+IpcIoFile::diskerFor(const off_t offset) const
+{
+    if (diskIds.size() <= 1)
+        return diskId;
+    return diskIds[(offset / StripeSize) % diskIds.size()];
+}
+
 /// whether we think there is enough time to complete the I/O
 bool
 IpcIoFile::canWait() const
@@ -423,22 +483,34 @@ IpcIoFile::canWait() const
     if (!config.ioTimeout)
         return true; // no timeout specified
 
+    // we do not know which disker will get the I/O
+    for (const auto id: diskIds) {
+        if (!canWaitFor(id))
+            return false;
+    }
+    return true;
+}
+
+/// whether we think the given disker has enough time to complete the I/O
+bool
+IpcIoFile::canWaitFor(const int disker) const
+{
     IpcIoMsg oldestIo;
-    if (!queue->findOldest(diskId, oldestIo) || oldestIo.start.tv_sec <= 0)
+    if (!queue->findOldest(disker, oldestIo) || oldestIo.start.tv_sec <= 0)
         return true; // we cannot estimate expected wait time; assume it is OK
 
     const int oldestWait = tvSubMsec(oldestIo.start, current_time);
 
     int rateWait = -1; // time in millisecons
-    const int ioRate = queue->rateLimit(diskId).load();
+    const int ioRate = queue->rateLimit(disker).load();
     if (ioRate > 0) {
         // if there are N requests pending, the new one will wait at
         // least N/max-swap-rate seconds
-        rateWait = static_cast<int>(1e3 * queue->outSize(diskId) / ioRate);
+        rateWait = static_cast<int>(1e3 * queue->outSize(disker) / ioRate);
         // adjust N/max-swap-rate value based on the queue "balance"
         // member, in case we have been borrowing time against future
         // I/O already
-        rateWait += queue->balance(diskId);
+        rateWait += queue->balance(disker);
     }
 
     const int expectedWait = max(oldestWait, rateWait);
@@ -447,7 +519,7 @@ IpcIoFile::canWait() const
         return true; // expected wait time is acceptable
 
     debugs(47,2, "cannot wait: " << expectedWait <<
-           " oldest: " << SipcIo(KidIdentifier, oldestIo, diskId));
+           " oldest: " << SipcIo(KidIdentifier, oldestIo, disker));
     return false; // do not want to wait that long
 }
 
@@ -458,9 +530,17 @@ IpcIoFile::HandleOpenResponse(const Ipc::StrandMessage &response)
     debugs(47, 7, "coordinator response to open request");
     for (IpcIoFileList::iterator i = WaitingForOpen.begin();
             i != WaitingForOpen.end(); ++i) {
-        if (response.strand.tag == (*i)->dbName) {
-            (*i)->openCompleted(&response);
-            WaitingForOpen.erase(i);
+        auto &diskIds = (*i)->diskIds;
+        for (size_t d = 0; d < diskIds.size(); ++d) {
+            if (diskIds[d] >= 0 || response.strand.tag != DiskerTag((*i)->dbName, d))
+                continue;
+
+            diskIds[d] = response.strand.kidId;
+            const auto waitingForMore = std::find(diskIds.begin(), diskIds.end(), -1) != diskIds.end();
+            if (response.strand.kidId < 0 || !waitingForMore) {
+                (*i)->openCompleted(&response);
+                WaitingForOpen.erase(i);
+            }
             return;
         }
     }
@@ -493,21 +573,61 @@ IpcIoFile::handleResponse(IpcIoMsg &ipcIo)
     const int requestId = ipcIo.requestId;
 
     Must(requestId);
+    if (diskIds.size() > 1) {
+        // another disker may still be working on an earlier request
+        if (IpcIoPendingRequest *const pending = findRequest(requestId)) {
+            debugs(47, 7, "holding disker response to " << SipcIo(KidIdentifier, ipcIo, diskerFor(ipcIo.offset)));
+            pending->heldResponse.reset(new IpcIoMsg(ipcIo));
+            deliverOrderedResponses();
+        } else {
+            debugs(47, 4, "LATE disker response to " << SipcIo(KidIdentifier, ipcIo, diskerFor(ipcIo.offset)));
+        }
+        return;
+    }
+
     if (IpcIoPendingRequest *const pending = dequeueRequest(requestId)) {
-        CallBack(pending->codeContext, [&] {
-            debugs(47, 7, "popped disker response to " << SipcIo(KidIdentifier, ipcIo, diskId));
-            if (myPid == ipcIo.workerPid)
-                pending->completeIo(&ipcIo);
-            else
-                debugs(47, 5, "ignoring response meant for our predecessor PID: " << ipcIo.workerPid);
-            delete pending; // XXX: leaking if throwing
-        });
+        deliverResponse(pending, ipcIo);
     } else {
         debugs(47, 4, "LATE disker response to " << SipcIo(KidIdentifier, ipcIo, diskId));
         // nothing we can do about it; completeIo() has been called already
     }
 }
 
+/// completes the given (already dequeued) request using the disker response
+void
+IpcIoFile::deliverResponse(IpcIoPendingRequest *const pending, IpcIoMsg &ipcIo)
+{
+    CallBack(pending->codeContext, [&] {
+        debugs(47, 7, "popped disker response to " << SipcIo(KidIdentifier, ipcIo, diskerFor(ipcIo.offset)));
+        if (myPid == ipcIo.workerPid)
+            pending->completeIo(&ipcIo);
+        else
+            debugs(47, 5, "ignoring response meant for our predecessor PID: " << ipcIo.workerPid);
+        delete pending; // XXX: leaking if throwing
+    });
+}
+
+/// delivers held responses that are no longer waiting for responses to
+/// earlier requests
+void
+IpcIoFile::deliverOrderedResponses()
+{
+    while (!responseOrder.empty()) {
+        const auto requestId = responseOrder.front();
+        IpcIoPendingRequest *const pending = findRequest(requestId);
+        if (pending && !pending->heldResponse)
+            return; // still waiting for this response
+
+        responseOrder.pop_front();
+        if (!pending)
+            continue; // timed out
+
+        (void)dequeueRequest(requestId);
+        const auto response = std::move(pending->heldResponse);
+        deliverResponse(pending, *response);
+    }
+}
+
 void
 IpcIoFile::Notify(const int peerId)
 {
@@ -550,6 +670,8 @@ IpcIoFile::StatQueue(std::ostream &os)
     if (queue.get()) {
         os << "SMP disk I/O queues:\n";
         queue->stat<IpcIoMsg>(os);
+        if (IamDiskProcess())
+            DiskerStat(os);
     }
 }
 
@@ -611,6 +733,11 @@ IpcIoFile::checkTimeouts()
     typedef RequestMap::const_iterator RMCI;
     for (RMCI i = olderRequests->begin(); i != olderRequests->end(); ++i) {
         IpcIoPendingRequest *const pending = i->second;
+        if (const auto response = std::move(pending->heldResponse)) {
+            // this disker responded, but an earlier request has timed out
+            deliverResponse(pending, *response);
+            continue;
+        }
         CallBack(pending->codeContext, [&] {
             const auto requestId = i->first;
             debugs(47, 7, "disker timeout; ipcIo" << KidIdentifier << '.' << requestId);
@@ -623,6 +750,9 @@ IpcIoFile::checkTimeouts()
     swap(olderRequests, newerRequests); // switches pointers around
     if (!olderRequests->empty() && !timeoutCheckScheduled)
         scheduleTimeoutCheck();
+
+    // responses to newer requests no longer wait for timed out requests
+    deliverOrderedResponses();
 }
 
 /// prepare to check for timeouts in a little while
@@ -639,6 +769,18 @@ IpcIoFile::scheduleTimeoutCheck()
     });
 }
 
+/// returns the right IpcIoFile pending request (or nil)
+IpcIoPendingRequest *
+IpcIoFile::findRequest(const unsigned int requestId) const
+{
+    for (const auto map: {&requestMap1, &requestMap2}) {
+        const auto i = map->find(requestId);
+        if (i != map->end())
+            return i->second;
+    }
+    return nullptr;
+}
+
 /// returns and forgets the right IpcIoFile pending request
 IpcIoPendingRequest *
 IpcIoFile::dequeueRequest(const unsigned int requestId)
@@ -728,6 +870,347 @@ IpcIoPendingRequest::completeIo(IpcIoMsg *const response)
 
 static SBuf DbName; ///< full db file name
 static int TheFile = -1; ///< db file descriptor
+/// db file descriptor for O_DIRECT I/O (or -1 when not using O_DIRECT)
+static int TheDirectFile = -1;
+#if HAVE_DISKIO_MODULE_IOURING
+/// queues db I/O when configured to use io_uring(7) (or nil)
+static IoUringQueue *TheQueue = nullptr;
+#endif
+
+/// Disker responses to popped worker requests. Workers (e.g., rock
+/// Rock::IoState::expectedReply()) need responses in the order of their
+/// requests, but queued I/O may complete in a different order.
+class DiskerResponses
+{
+public:
+    /// \returns the sequence number of the just-popped request from the worker
+    uint64_t notePopped(const int workerId) { return ++workers[workerId].popped; }
+
+    /// Sends the response to the given request (and any delayed responses to
+    /// later requests from the same worker) or, if the worker is still waiting
+    /// for earlier responses, delays it. Given a nil response, just stops
+    /// waiting for the given request response.
+    void respond(const int workerId, const uint64_t sequence, const IpcIoMsg *);
+
+private:
+    /// responses to one worker
+    class WorkerResponses
+    {
+    public:
+        uint64_t popped = 0; ///< the number of requests popped so far
+        uint64_t handled = 0; ///< the number of sent or ignored responses
+        /// responses waiting for earlier responses; nil ones will not be sent
+        std::map<uint64_t, std::unique_ptr<IpcIoMsg> > delayed;
+    };
+
+    std::map<int, WorkerResponses> workers;
+};
+
+void
+DiskerResponses::respond(const int workerId, const uint64_t sequence, const IpcIoMsg *response)
+{
+    auto &worker = workers[workerId];
+    if (sequence != worker.handled + 1) {
+        debugs(47, 7, "delaying response #" << sequence << " to worker" << workerId <<
+               " until #" << (worker.handled + 1));
+        worker.delayed.emplace(sequence, response ? new IpcIoMsg(*response) : nullptr);
+        return;
+    }
+
+    ++worker.handled;
+    if (response) {
+        auto ipcIo = *response;
+        IpcIoFile::DiskerRespond(workerId, ipcIo);
+    }
+
+    while (!worker.delayed.empty() && worker.delayed.begin()->first == worker.handled + 1) {
+        const auto next = std::move(worker.delayed.begin()->second);
+        worker.delayed.erase(worker.delayed.begin());
+        ++worker.handled;
+        if (next)
+            IpcIoFile::DiskerRespond(workerId, *next);
+    }
+}
+
+/// orders responses to all workers
+static DiskerResponses TheResponses;
+
+/// the number of I/O requests that bypassed OS page cache via TheDirectFile
+static uint64_t DirectIoCount = 0;
+/// the number of TheDirectFile I/O requests that used TheFile instead because
+/// their alignment or size did not allow O_DIRECT I/O
+static uint64_t DirectIoFallbackCount = 0;
+
+/// A db file area that an O_DIRECT request must cover to transfer the bytes
+/// requested by the given IpcIoMsg. The request I/O page is used as the
+/// aligned O_DIRECT buffer, so the area must fit into that page.
+class DirectIoArea
+{
+public:
+    explicit DirectIoArea(const IpcIoMsg &ipcIo):
+        len(min(ipcIo.len, Ipc::Mem::PageSize())),
+        head(ipcIo.offset % Ipc::Mem::PageAlignment()),
+        start(ipcIo.offset - head),
+        size(RoundUp(head + len, Ipc::Mem::PageAlignment()))
+    {}
+
+    /// whether an O_DIRECT read can bring the requested bytes into the page
+    bool readable() const { return TheDirectFile >= 0 && size <= Ipc::Mem::PageSize(); }
+
+    /// Whether an O_DIRECT write can store the requested page bytes. Such
+    /// writes also store (zeroed) page bytes after the requested ones, up to
+    /// the alignment boundary. Rock slot-size restrictions guarantee that
+    /// those extra bytes belong to the same (and otherwise unused) db slot.
+    bool writable() const { return readable() && !head; }
+
+    /// zeroes the page bytes written after the requested ones
+    void pad(char *page) const { memset(page + len, 0, size - len); }
+
+    /// moves the requested bytes to the start of the page filled by an
+    /// O_DIRECT read of this area
+    /// \returns the number of requested bytes that were read
+    size_t extract(char *page, const size_t readSize) const {
+        if (readSize <= head)
+            return 0;
+        const auto extracted = min(readSize - head, len);
+        if (head)
+            memmove(page, page + head, extracted);
+        return extracted;
+    }
+
+    const size_t len; ///< the number of requested bytes
+    const size_t head; ///< the number of unwanted bytes preceding requested ones
+    const off_t start; ///< aligned db offset of the first byte to transfer
+    const size_t size; ///< aligned number of bytes to transfer
+
+private:
+    static size_t RoundUp(const size_t value, const size_t alignment) {
+        return ((value + alignment - 1) / alignment) * alignment;
+    }
+};
+
+/// Disker I/O requests popped from worker queues but not started yet. A new
+/// set of requests is popped only after all previously popped requests were
+/// started. Popped requests are started in their popping order or, with
+/// elevator ordering, in the ascending order of their db offsets, sweeping
+/// the db file in one direction before wrapping around to its beginning
+/// (i.e. the circular "elevator" order) to reduce disk seeks. Requests for
+/// adjacent db areas may be started together (see popAdjacent()).
+/// DiskerResponses still sends responses in the order of worker requests.
+class DiskerBatch
+{
+public:
+    /// the maximum number of requests popped together
+    static const size_t Window = 128;
+
+    explicit DiskerBatch(const bool useElevator): elevator(useElevator) {}
+
+    bool empty() const { return pending.empty(); }
+    bool full() const { return pending.size() >= Window; }
+
+    /// remembers a request popped from the worker queues
+    void add(const int workerId, const IpcIoMsg &, uint64_t sequence);
+
+    /// orders remembered requests
+    void sort();
+
+    /// forgets the next request to start
+    /// \returns false if there are no pending requests
+    bool pop(int &workerId, IpcIoMsg &, uint64_t &sequence);
+
+    /// forgets a pending request that may be started together with the given
+    /// one using a single preadv(2) or pwritev(2) call
+    /// \returns false if there are no such requests
+    bool popAdjacent(const IpcIoMsg &previous, int &workerId, IpcIoMsg &, uint64_t &sequence);
+
+    /// reports current state and reordering statistics
+    void stat(std::ostream &) const;
+
+private:
+    /// a remembered request
+    class Request
+    {
+    public:
+        int workerId;
+        IpcIoMsg ipcIo;
+        uint64_t sequence; ///< DiskerResponses::notePopped() result
+        uint64_t arrival; ///< add() call sequence number
+    };
+
+    void take(std::vector<Request>::iterator, int &workerId, IpcIoMsg &, uint64_t &sequence);
+
+    /// whether to start requests in elevator order
+    const bool elevator;
+
+    /// remembered requests, in the reverse starting order after sort()
+    std::vector<Request> pending;
+
+    /// the db offset where the last started request ended
+    off_t lastOffset = 0;
+
+    uint64_t arrivals = 0; ///< the number of add() calls
+    uint64_t batches = 0; ///< the number of sort() calls with pending requests
+    size_t maxDepth = 0; ///< the maximum number of pending requests
+
+    /// request counts indexed by the binary logarithm of one plus the number
+    /// of earlier-popped requests still pending when a request was started
+    std::array<uint64_t, 8> distances = {};
+};
+
+/// the maximum number of I/O requests handled by one preadv(2) or pwritev(2)
+static const size_t MaxCoalescedRequests = 32;
+
+/// the maximum number of unwanted bytes between two coalesced reads (e.g., the
+/// DbCellHeader preceding rock slot data); those bytes are read and ignored
+static const size_t MaxCoalescedReadGap = 4096;
+
+/// whether the second request may be handled by the same preadv(2) or
+/// pwritev(2) call, right after the first request
+static bool
+DiskerAdjacent(const IpcIoMsg &first, const IpcIoMsg &second)
+{
+    if (first.command != second.command)
+        return false;
+    if (first.command != IpcIo::cmdRead && first.command != IpcIo::cmdWrite)
+        return false;
+
+    const auto firstEnd = first.offset + static_cast<off_t>(min(first.len, Ipc::Mem::PageSize()));
+    if (second.offset < firstEnd)
+        return false;
+    const auto gap = static_cast<uint64_t>(second.offset - firstEnd);
+    // we cannot write a gap without overwriting db bytes we do not have
+    return first.command == IpcIo::cmdRead ? gap <= MaxCoalescedReadGap : gap == 0;
+}
+
+void
+DiskerBatch::add(const int workerId, const IpcIoMsg &ipcIo, const uint64_t sequence)
+{
+    pending.push_back(Request{workerId, ipcIo, sequence, arrivals++});
+    maxDepth = max(maxDepth, pending.size());
+}
+
+void
+DiskerBatch::sort()
+{
+    if (pending.empty())
+        return;
+
+    ++batches;
+
+    if (!elevator) {
+        std::reverse(pending.begin(), pending.end()); // pop() takes from the back
+        return;
+    }
+
+    // requests at or after lastOffset come first; then we wrap around
+    const auto sweepPosition = [this](const Request &r) {
+        return std::make_pair(r.ipcIo.offset < lastOffset, r.ipcIo.offset);
+    };
+    std::sort(pending.begin(), pending.end(), [&sweepPosition](const Request &a, const Request &b) {
+        return sweepPosition(b) < sweepPosition(a); // pop() takes from the back
+    });
+}
+
+bool
+DiskerBatch::pop(int &workerId, IpcIoMsg &ipcIo, uint64_t &sequence)
+{
+    if (pending.empty())
+        return false;
+
+    take(pending.end() - 1, workerId, ipcIo, sequence);
+    return true;
+}
+
+bool
+DiskerBatch::popAdjacent(const IpcIoMsg &previous, int &workerId, IpcIoMsg &ipcIo, uint64_t &sequence)
+{
+    // in elevator order, the best candidate is usually the next one
+    for (auto i = pending.rbegin(); i != pending.rend(); ++i) {
+        if (DiskerAdjacent(previous, i->ipcIo)) {
+            take(std::next(i).base(), workerId, ipcIo, sequence);
+            return true;
+        }
+    }
+    return false;
+}
+
+/// forgets the given pending request, updating statistics
+void
+DiskerBatch::take(const std::vector<Request>::iterator next, int &workerId, IpcIoMsg &ipcIo, uint64_t &sequence)
+{
+    size_t overtaken = 0;
+    for (const auto &other: pending)
+        overtaken += other.arrival < next->arrival;
+    size_t bucket = 0;
+    while (overtaken && bucket + 1 < distances.size()) {
+        overtaken >>= 1;
+        ++bucket;
+    }
+    ++distances[bucket];
+
+    workerId = next->workerId;
+    ipcIo = next->ipcIo;
+    sequence = next->sequence;
+    lastOffset = ipcIo.offset + ipcIo.len;
+    pending.erase(next);
+}
+
+void
+DiskerBatch::stat(std::ostream &os) const
+{
+    os << "  elevator ordering: " << (elevator ? "on" : "off") << "\n";
+    os << "  pending requests: " << pending.size() << " (max " << maxDepth << ")\n";
+    os << "  requests: " << arrivals << ", batches: " << batches;
+    if (batches)
+        os << " (" << std::fixed << std::setprecision(2) <<
+           (static_cast<double>(arrivals) / batches) << " requests per batch)";
+    os << "\n";
+
+    os << "  reorder distance histogram:\n";
+    uint64_t lowest = 0;
+    for (size_t bucket = 0; bucket < distances.size(); ++bucket) {
+        const uint64_t highest = bucket ? (uint64_t(1) << bucket) - 1 : 0;
+        os << "    " << lowest;
+        if (bucket + 1 == distances.size())
+            os << '+';
+        else if (highest > lowest)
+            os << '-' << highest;
+        os << ": " << distances[bucket] << "\n";
+        lowest = highest + 1;
+    }
+}
+
+/// disker I/O requests popped but not yet started (or nil)
+static DiskerBatch *TheBatch = nullptr;
+
+/// the number of read and write requests handled by this disker
+static uint64_t DiskerIoCount = 0;
+/// the number of requests handled by DiskerCoalesce() preadv(2)/pwritev(2)
+static uint64_t CoalescedIoCount = 0;
+/// the number of preadv(2) and pwritev(2) calls made by DiskerCoalesce()
+static uint64_t CoalescedCallCount = 0;
+
+/// reports disker-specific I/O statistics
+static void
+DiskerStat(std::ostream &os)
+{
+    os << "Disker I/O for " << DbName << ":\n";
+    const auto calls = DiskerIoCount - CoalescedIoCount + CoalescedCallCount;
+    os << "  requests: " << DiskerIoCount << ", coalesced requests: " << CoalescedIoCount <<
+       " in " << CoalescedCallCount << " preadv/pwritev calls\n";
+    os << "  merge ratio: " << std::fixed << std::setprecision(2) <<
+       (calls ? static_cast<double>(DiskerIoCount) / calls : 1.0) << " requests per I/O call\n";
+
+    if (TheDirectFile >= 0) {
+        os << "Disker O_DIRECT I/O:\n";
+        os << "  requests: " << DirectIoCount << ", page cache fallbacks: " << DirectIoFallbackCount << "\n";
+    }
+
+    if (TheBatch) {
+        os << "Disker request batching:\n";
+        TheBatch->stat(os);
+    }
+}
 
 static void
 diskerRead(IpcIoMsg &ipcIo)
@@ -739,9 +1222,21 @@ diskerRead(IpcIoMsg &ipcIo)
     }
 
     char *const buf = Ipc::Mem::PagePointer(ipcIo.page);
-    const ssize_t read = pread(TheFile, buf, min(ipcIo.len, Ipc::Mem::PageSize()), ipcIo.offset);
+    const DirectIoArea area(ipcIo);
+    ssize_t read = 0;
+    if (area.readable()) {
+        ++DirectIoCount;
+        read = pread(TheDirectFile, buf, area.size, area.start);
+        fd_bytes(TheDirectFile, read, IoDirection::Read);
+        if (read >= 0)
+            read = area.extract(buf, read);
+    } else {
+        if (TheDirectFile >= 0)
+            ++DirectIoFallbackCount;
+        read = pread(TheFile, buf, area.len, ipcIo.offset);
+        fd_bytes(TheFile, read, IoDirection::Read);
+    }
     ++statCounter.syscalls.disk.reads;
-    fd_bytes(TheFile, read, IoDirection::Read);
 
     if (read >= 0) {
         ipcIo.xerrno = 0;
@@ -762,18 +1257,32 @@ diskerRead(IpcIoMsg &ipcIo)
 static void
 diskerWriteAttempts(IpcIoMsg &ipcIo)
 {
-    const char *buf = Ipc::Mem::PagePointer(ipcIo.page);
+    char *buf = Ipc::Mem::PagePointer(ipcIo.page);
     size_t toWrite = min(ipcIo.len, Ipc::Mem::PageSize());
     size_t wroteSoFar = 0;
     off_t offset = ipcIo.offset;
+
+    const DirectIoArea area(ipcIo);
+    if (area.writable()) {
+        ++DirectIoCount;
+        area.pad(buf);
+    } else if (TheDirectFile >= 0) {
+        ++DirectIoFallbackCount;
+    }
+
     // Partial writes to disk do happen. It is unlikely that the caller can
     // handle partial writes by doing something other than writing leftovers
     // again, so we try to write them ourselves to minimize overheads.
     const int attemptLimit = 10;
     for (int attempts = 1; attempts <= attemptLimit; ++attempts) {
-        const ssize_t result = pwrite(TheFile, buf, toWrite, offset);
+        // leftovers of a partial O_DIRECT write are written via OS page cache
+        const auto direct = attempts == 1 && area.writable();
+        const auto fd = direct ? TheDirectFile : TheFile;
+        const ssize_t result = direct ?
+                               pwrite(fd, buf, area.size, offset) :
+                               pwrite(fd, buf, toWrite, offset);
         ++statCounter.syscalls.disk.writes;
-        fd_bytes(TheFile, result, IoDirection::Write);
+        fd_bytes(fd, result, IoDirection::Write);
 
         if (result < 0) {
             ipcIo.xerrno = errno;
@@ -786,7 +1295,8 @@ diskerWriteAttempts(IpcIoMsg &ipcIo)
             return; // bail on error
         }
 
-        const size_t wroteNow = static_cast<size_t>(result); // result >= 0
+        // result >= 0; ignore O_DIRECT padding
+        const size_t wroteNow = min(static_cast<size_t>(result), toWrite);
         ipcIo.xerrno = 0;
 
         debugs(47,3, "disker" << KidIdentifier << " wrote " <<
@@ -822,6 +1332,307 @@ diskerWrite(IpcIoMsg &ipcIo)
     Ipc::Mem::PutPage(ipcIo.page);
 }
 
+#if HAVE_PREADV && HAVE_PWRITEV
+
+/// an I/O request handled by DiskerCoalesce()
+class CoalescedRequest
+{
+public:
+    int workerId;
+    IpcIoMsg ipcIo;
+    uint64_t sequence; ///< DiskerResponses::notePopped() result
+};
+
+typedef std::vector<CoalescedRequest> CoalescedRequests;
+
+/// reads adjacent db areas using one preadv(2) call; sets ipcIo results
+static void
+diskerCoalescedRead(CoalescedRequests &run)
+{
+    // bytes between requested areas are read here and ignored
+    static char gapBuf[MaxCoalescedReadGap];
+
+    // we cannot read into a page we do not have; read the rest individually
+    size_t withPages = 0;
+    while (withPages < run.size() && Ipc::Mem::GetPage(Ipc::Mem::PageId::ioPage, run[withPages].ipcIo.page))
+        ++withPages;
+    CoalescedRequests leftovers(run.begin() + withPages, run.end());
+    run.resize(withPages);
+
+    std::vector<struct iovec> iov;
+    off_t end = run.empty() ? 0 : run.front().ipcIo.offset;
+    for (const auto &r: run) {
+        if (const auto gap = static_cast<size_t>(r.ipcIo.offset - end))
+            iov.push_back({gapBuf, gap});
+        const auto len = min(r.ipcIo.len, Ipc::Mem::PageSize());
+        iov.push_back({Ipc::Mem::PagePointer(r.ipcIo.page), len});
+        end = r.ipcIo.offset + len;
+    }
+
+    if (!iov.empty()) {
+        const auto result = preadv(TheFile, iov.data(), iov.size(), run.front().ipcIo.offset);
+        const auto xerrno = errno;
+        ++statCounter.syscalls.disk.reads;
+        fd_bytes(TheFile, result, IoDirection::Read);
+        ++CoalescedCallCount;
+        CoalescedIoCount += run.size();
+
+        if (result < 0) {
+            debugs(47, 5, "disker" << KidIdentifier << " read error: " << xerrno <<
+                   " while reading " << run.size() << " coalesced requests");
+            for (auto &r: run) {
+                r.ipcIo.xerrno = xerrno;
+                r.ipcIo.len = 0;
+            }
+        } else {
+            debugs(47, 8, "disker" << KidIdentifier << " read " << result <<
+                   " bytes for " << run.size() << " coalesced requests");
+            auto unassigned = static_cast<size_t>(result);
+            off_t position = run.front().ipcIo.offset;
+            for (auto &r: run) {
+                const auto gap = static_cast<size_t>(r.ipcIo.offset - position);
+                unassigned -= min(gap, unassigned);
+                const auto len = min(min(r.ipcIo.len, Ipc::Mem::PageSize()), unassigned);
+                unassigned -= len;
+                position = r.ipcIo.offset + min(r.ipcIo.len, Ipc::Mem::PageSize());
+                r.ipcIo.xerrno = 0;
+                r.ipcIo.len = len;
+            }
+        }
+    }
+
+    for (auto &r: leftovers)
+        diskerRead(r.ipcIo);
+    run.insert(run.end(), leftovers.begin(), leftovers.end());
+}
+
+/// writes adjacent db areas using one pwritev(2) call; sets ipcIo results
+static void
+diskerCoalescedWrite(CoalescedRequests &run)
+{
+    std::vector<struct iovec> iov;
+    for (const auto &r: run)
+        iov.push_back({Ipc::Mem::PagePointer(r.ipcIo.page), min(r.ipcIo.len, Ipc::Mem::PageSize())});
+
+    const auto result = pwritev(TheFile, iov.data(), iov.size(), run.front().ipcIo.offset);
+    const auto xerrno = errno;
+    ++statCounter.syscalls.disk.writes;
+    fd_bytes(TheFile, result, IoDirection::Write);
+    ++CoalescedCallCount;
+    CoalescedIoCount += run.size();
+
+    if (result < 0)
+        debugs(47, 3, "disker" << KidIdentifier << " retries " << run.size() <<
+               " coalesced writes individually after error: " << xstrerr(xerrno));
+
+    auto unassigned = static_cast<size_t>(max(result, static_cast<ssize_t>(0)));
+    for (auto &r: run) {
+        const auto toWrite = min(r.ipcIo.len, Ipc::Mem::PageSize());
+        if (unassigned >= toWrite) {
+            unassigned -= toWrite;
+            r.ipcIo.xerrno = 0;
+            r.ipcIo.len = toWrite;
+        } else {
+            // rewrite the whole page; partial writes to disk are rare
+            unassigned = 0;
+            diskerWriteAttempts(r.ipcIo); // may fail
+        }
+        Ipc::Mem::PutPage(r.ipcIo.page);
+    }
+}
+
+/// Handles the given read or write request together with adjacent TheBatch
+/// requests (if any) using a single preadv(2) or pwritev(2) call. Responds to
+/// all handled requests.
+/// \returns false (without handling the given request) if the request cannot
+/// be coalesced with others
+static bool
+diskerCoalesce(const int workerId, const IpcIoMsg &ipcIo, const uint64_t sequence)
+{
+    // io_uring submits queued requests together already, while O_DIRECT
+    // buffer alignment rules are not compatible with our read gaps
+    if (TheDirectFile >= 0 || !TheBatch)
+        return false;
+#if HAVE_DISKIO_MODULE_IOURING
+    if (TheQueue)
+        return false;
+#endif
+
+    CoalescedRequests run;
+    run.push_back(CoalescedRequest{workerId, ipcIo, sequence});
+    CoalescedRequest next;
+    while (run.size() < MaxCoalescedRequests &&
+            TheBatch->popAdjacent(run.back().ipcIo, next.workerId, next.ipcIo, next.sequence))
+        run.push_back(next);
+
+    if (run.size() == 1)
+        return false;
+
+    debugs(47, 5, "disker" << KidIdentifier << " coalesces " << run.size() <<
+           (ipcIo.command == IpcIo::cmdRead ? " reads" : " writes") << " at " << ipcIo.offset);
+    DiskerIoCount += run.size() - 1; // the caller counted the given request
+
+    if (ipcIo.command == IpcIo::cmdRead)
+        diskerCoalescedRead(run);
+    else // ipcIo.command == IpcIo::cmdWrite
+        diskerCoalescedWrite(run);
+
+    for (const auto &r: run)
+        TheResponses.respond(r.workerId, r.sequence, &r.ipcIo);
+    return true;
+}
+
+#endif /* HAVE_PREADV && HAVE_PWRITEV */
+
+#if HAVE_DISKIO_MODULE_IOURING
+
+/// An I/O request queued to TheQueue instead of being handled by diskerRead()
+/// or diskerWrite(). The response is sent to the worker when the kernel is done.
+class IpcIoDiskerOperation: public IoUringOperation
+{
+    MEMPROXY_CLASS(IpcIoDiskerOperation);
+
+public:
+    /// queues the I/O request or, if that is impossible, responds with an error
+    static void Start(const int workerId, const IpcIoMsg &ipcIo, uint64_t sequence);
+
+    /* IoUringOperation API */
+    void finish(int result) override;
+
+private:
+    IpcIoDiskerOperation(const int aWorkerId, const IpcIoMsg &anIpcIo, const uint64_t aSequence):
+        workerId(aWorkerId), sequence(aSequence), ipcIo(anIpcIo), toTransfer(min(ipcIo.len, Ipc::Mem::PageSize())), area(ipcIo) {}
+
+    void queue();
+    void respond();
+
+    const int workerId; ///< the worker waiting for our response
+    const uint64_t sequence; ///< DiskerResponses::notePopped() result
+    IpcIoMsg ipcIo; ///< the request (and, eventually, the response)
+    const size_t toTransfer; ///< the number of bytes we want to read or write
+    size_t transferred = 0; ///< the number of bytes read or written so far
+    int attempts = 0; ///< the number of queued read(2)-like or write(2)-like calls
+    const DirectIoArea area; ///< O_DIRECT parameters for this request
+    bool direct = false; ///< whether the last queued call uses TheDirectFile
+};
+
+void
+IpcIoDiskerOperation::Start(const int workerId, const IpcIoMsg &ipcIo, const uint64_t sequence)
+{
+    const auto op = new IpcIoDiskerOperation(workerId, ipcIo, sequence);
+    if (op->ipcIo.command == IpcIo::cmdRead &&
+            !Ipc::Mem::GetPage(Ipc::Mem::PageId::ioPage, op->ipcIo.page)) {
+        debugs(47,2, "run out of shared memory pages for IPC I/O");
+        op->ipcIo.len = 0;
+        op->respond();
+        return;
+    }
+
+    const auto isRead = op->ipcIo.command == IpcIo::cmdRead;
+    if (isRead ? op->area.readable() : op->area.writable())
+        ++DirectIoCount;
+    else if (TheDirectFile >= 0)
+        ++DirectIoFallbackCount;
+
+    op->queue();
+}
+
+/// queues a read or write of the remaining bytes
+void
+IpcIoDiskerOperation::queue()
+{
+    ++attempts;
+    char *const page = Ipc::Mem::PagePointer(ipcIo.page);
+    const auto isRead = ipcIo.command == IpcIo::cmdRead;
+
+    // mimic diskerRead() and diskerWriteAttempts() O_DIRECT decisions
+    direct = attempts == 1 && (isRead ? area.readable() : area.writable());
+    if (direct) {
+        if (isRead) {
+            TheQueue->read(TheDirectFile, page, area.size, area.start, this);
+        } else {
+            area.pad(page);
+            TheQueue->write(TheDirectFile, page, area.size, area.start, this);
+        }
+        return;
+    }
+
+    char *const buf = page + transferred;
+    const auto offset = ipcIo.offset + transferred;
+    if (isRead)
+        TheQueue->read(TheFile, buf, toTransfer, offset, this);
+    else
+        TheQueue->write(TheFile, buf, toTransfer - transferred, offset, this);
+}
+
+void
+IpcIoDiskerOperation::finish(int result)
+{
+    const auto isRead = ipcIo.command == IpcIo::cmdRead;
+    if (isRead)
+        ++statCounter.syscalls.disk.reads;
+    else
+        ++statCounter.syscalls.disk.writes;
+    fd_bytes(direct ? TheDirectFile : TheFile, result, isRead ? IoDirection::Read : IoDirection::Write);
+
+    if (direct && result > 0) {
+        // ignore O_DIRECT alignment bytes
+        const auto wanted = isRead ?
+                            area.extract(Ipc::Mem::PagePointer(ipcIo.page), result) :
+                            min(static_cast<size_t>(result), toTransfer);
+        result = static_cast<int>(wanted);
+    }
+
+    if (result < 0) {
+        ipcIo.xerrno = -result;
+        if (!isRead)
+            debugs(47, DBG_IMPORTANT, "ERROR: " << DbName << " failure" <<
+                   " writing " << (toTransfer - transferred) << '/' << ipcIo.len <<
+                   " at " << ipcIo.offset << '+' << transferred <<
+                   " on " << attempts << " try: " << xstrerr(ipcIo.xerrno));
+        else
+            debugs(47,5, "disker" << KidIdentifier << " read error: " << ipcIo.xerrno);
+        ipcIo.len = isRead ? 0 : transferred;
+        respond();
+        return;
+    }
+
+    ipcIo.xerrno = 0;
+    transferred += static_cast<size_t>(result);
+    debugs(47, isRead ? 8 : 3, "disker" << KidIdentifier << (isRead ? " read " : " wrote ") <<
+           (transferred >= toTransfer ? "all " : "just ") << result <<
+           " out of " << toTransfer << '/' << ipcIo.len << " at " << ipcIo.offset <<
+           " on " << attempts << " try");
+
+    // mimic diskerWriteAttempts() handling of partial writes
+    const int attemptLimit = 10;
+    if (!isRead && result > 0 && transferred < toTransfer && attempts < attemptLimit) {
+        queue();
+        return;
+    }
+
+    if (!isRead && transferred < toTransfer)
+        debugs(47, DBG_IMPORTANT, "ERROR: " << DbName << " exhausted all " <<
+               attempts << " attempts while writing " <<
+               (toTransfer - transferred) << '/' << ipcIo.len << " at " <<
+               ipcIo.offset << '+' << transferred);
+
+    ipcIo.len = transferred;
+    respond();
+}
+
+/// sends the response to the worker and destroys this operation
+void
+IpcIoDiskerOperation::respond()
+{
+    if (ipcIo.command == IpcIo::cmdWrite)
+        Ipc::Mem::PutPage(ipcIo.page);
+    TheResponses.respond(workerId, sequence, &ipcIo);
+    delete this;
+}
+
+#endif /* HAVE_DISKIO_MODULE_IOURING */
+
 void
 IpcIoFile::DiskerHandleMoreRequests(void *source)
 {
@@ -904,11 +1715,12 @@ IpcIoFile::DiskerHandleRequests()
     int popped = 0;
     int workerId = 0;
     IpcIoMsg ipcIo;
-    while (!WaitBeforePop() && queue->pop(workerId, ipcIo)) {
+    uint64_t sequence = 0;
+    while (DiskerPop(workerId, ipcIo, sequence)) {
         ++popped;
 
         // at least one I/O per call is guaranteed if the queue is not empty
-        DiskerHandleRequest(workerId, ipcIo);
+        DiskerHandleRequest(workerId, ipcIo, sequence);
 
         getCurrentTime();
         const double elapsedMsec = tvSubMsec(loopStart, current_time);
@@ -928,20 +1740,39 @@ IpcIoFile::DiskerHandleRequests()
         }
     }
 
-    // TODO: consider using O_DIRECT with "elevator" optimization where we pop
-    // requests first, then reorder the popped requests to optimize seek time,
-    // then do I/O, then take a break, and come back for the next set of I/O
-    // requests.
+#if HAVE_DISKIO_MODULE_IOURING
+    // all I/O requests popped above reach the kernel in one batch
+    if (TheQueue)
+        TheQueue->submit();
+#endif
+}
+
+/// gets the next I/O request to handle, in TheBatch order
+/// \returns false if there are no requests to handle now
+bool
+IpcIoFile::DiskerPop(int &workerId, IpcIoMsg &ipcIo, uint64_t &sequence)
+{
+    // pop requests first, then reorder the popped requests to optimize seek
+    // time, then do I/O (possibly taking breaks), and come back for the next
+    // set of I/O requests
+    assert(TheBatch);
+    if (TheBatch->empty()) {
+        while (!TheBatch->full() && !WaitBeforePop() && queue->pop(workerId, ipcIo))
+            TheBatch->add(workerId, ipcIo, TheResponses.notePopped(workerId));
+        TheBatch->sort();
+    }
+    return TheBatch->pop(workerId, ipcIo, sequence);
 }
 
 /// called when disker receives an I/O request
 void
-IpcIoFile::DiskerHandleRequest(const int workerId, IpcIoMsg &ipcIo)
+IpcIoFile::DiskerHandleRequest(const int workerId, IpcIoMsg &ipcIo, const uint64_t sequence)
 {
     if (ipcIo.command != IpcIo::cmdRead && ipcIo.command != IpcIo::cmdWrite) {
         debugs(0, DBG_CRITICAL, "ERROR: " << DbName <<
                " should not receive " << ipcIo.command <<
                " ipcIo" << workerId << '.' << ipcIo.requestId);
+        TheResponses.respond(workerId, sequence, nullptr);
         return;
     }
 
@@ -953,6 +1784,20 @@ IpcIoFile::DiskerHandleRequest(const int workerId, IpcIoMsg &ipcIo)
     const auto workerPid = ipcIo.workerPid;
     assert(workerPid >= 0);
 
+    ++DiskerIoCount;
+
+#if HAVE_DISKIO_MODULE_IOURING
+    if (TheQueue) {
+        IpcIoDiskerOperation::Start(workerId, ipcIo, sequence); // will respond
+        return;
+    }
+#endif
+
+#if HAVE_PREADV && HAVE_PWRITEV
+    if (diskerCoalesce(workerId, ipcIo, sequence))
+        return; // responded
+#endif
+
     if (ipcIo.command == IpcIo::cmdRead)
         diskerRead(ipcIo);
     else // ipcIo.command == IpcIo::cmdWrite
@@ -960,6 +1805,13 @@ IpcIoFile::DiskerHandleRequest(const int workerId, IpcIoMsg &ipcIo)
 
     assert(ipcIo.workerPid == workerPid);
 
+    TheResponses.respond(workerId, sequence, &ipcIo);
+}
+
+/// sends the results of the given I/O request to the worker
+void
+IpcIoFile::DiskerRespond(const int workerId, IpcIoMsg &ipcIo)
+{
     debugs(47, 7, "pushing " << SipcIo(workerId, ipcIo, KidIdentifier));
 
     try {
@@ -977,7 +1829,7 @@ IpcIoFile::DiskerHandleRequest(const int workerId, IpcIoMsg &ipcIo)
 }
 
 static bool
-DiskerOpen(const SBuf &path, int flags, mode_t)
+DiskerOpen(const SBuf &path, int flags, mode_t, const DiskFile::Config &config)
 {
     assert(TheFile < 0);
 
@@ -993,12 +1845,59 @@ DiskerOpen(const SBuf &path, int flags, mode_t)
 
     ++store_open_disk_fd;
     debugs(79,3, "rock db opened " << DbName << ": FD " << TheFile);
+
+    if (config.directIo) {
+#if defined(O_DIRECT)
+        // the buffered descriptor remains for requests that O_DIRECT cannot handle
+        TheDirectFile = file_open(DbName.c_str(), flags | O_DIRECT);
+        if (TheDirectFile < 0) {
+            const auto xerrno = errno;
+            debugs(47, DBG_IMPORTANT, "WARNING: cannot open " << DbName << " with O_DIRECT: " <<
+                   xstrerr(xerrno) << "; disk I/O will use OS page cache");
+        } else {
+            ++store_open_disk_fd;
+            debugs(47, 2, "disker" << KidIdentifier << " bypasses OS page cache for " << DbName << ": FD " << TheDirectFile);
+        }
+#else
+        assert(false); // Rock::SwapDir::parseDirectIoOption() prevents this
+#endif
+    }
+
+    assert(!TheBatch);
+    TheBatch = new DiskerBatch(config.directIo);
+
+    if (config.ioUring) {
+#if HAVE_DISKIO_MODULE_IOURING
+        assert(!TheQueue);
+        TheQueue = new IoUringQueue(QueueCapacity);
+        debugs(47, 2, "disker" << KidIdentifier << " queues " << DbName << " I/O to io_uring");
+#else
+        assert(false); // Rock::SwapDir::parseIoEngineOption() prevents this
+#endif
+    }
+
     return true;
 }
 
 static void
 DiskerClose(const SBuf &path)
 {
+#if HAVE_DISKIO_MODULE_IOURING
+    // finish queued I/O before closing the file it refers to
+    delete TheQueue;
+    TheQueue = nullptr;
+#endif
+
+    if (TheDirectFile >= 0) {
+        file_close(TheDirectFile);
+        TheDirectFile = -1;
+        --store_open_disk_fd;
+    }
+
+    // workers will time out any requests still pending in TheBatch
+    delete TheBatch;
+    TheBatch = nullptr;
+
     if (TheFile >= 0) {
         file_close(TheFile);
         debugs(79,3, "rock db closed " << path << ": FD " << TheFile);
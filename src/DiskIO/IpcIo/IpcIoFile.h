@@ -17,8 +17,10 @@
 #include "ipc/mem/Page.h"
 #include "SquidString.h"
 #include <list>
+#include <deque>
 #include <map>
 #include <memory>
+#include <vector>
 
 namespace Ipc
 {
@@ -60,6 +62,8 @@ public:
 };
 
 class IpcIoPendingRequest;
+class IpcIoDiskerOperation;
+class DiskerResponses;
 
 /// In a worker process, represents a single (remote) cache_dir disker file.
 /// In a disker process, used as a bunch of static methods handling that file.
@@ -84,6 +88,7 @@ public:
     int getFD() const override;
     bool canRead() const override;
     bool canWrite() const override;
+    bool canReadAhead() const override;
     bool ioInProgress() const override;
 
     /// handle open response from coordinator
@@ -99,14 +104,19 @@ public:
 
 protected:
     friend class IpcIoPendingRequest;
+    friend class IpcIoDiskerOperation;
+    friend class DiskerResponses;
     void openCompleted(const Ipc::StrandMessage *);
     void readCompleted(ReadRequest *readRequest, IpcIoMsg *const response);
     void writeCompleted(WriteRequest *writeRequest, const IpcIoMsg *const response);
     bool canWait() const;
+    bool canWaitFor(const int disker) const;
 
 private:
+    int diskerFor(const off_t offset) const;
     void trackPendingRequest(const unsigned int id, IpcIoPendingRequest *const pending);
     void push(IpcIoPendingRequest *const pending);
+    IpcIoPendingRequest *findRequest(const unsigned int requestId) const;
     IpcIoPendingRequest *dequeueRequest(const unsigned int requestId);
 
     /// the total number of I/O requests in push queue and pop queue
@@ -122,10 +132,14 @@ private:
 
     static void HandleResponses(const char *const when);
     void handleResponse(IpcIoMsg &ipcIo);
+    void deliverResponse(IpcIoPendingRequest *const pending, IpcIoMsg &ipcIo);
+    void deliverOrderedResponses();
 
     static void DiskerHandleMoreRequests(void*);
     static void DiskerHandleRequests();
-    static void DiskerHandleRequest(const int workerId, IpcIoMsg &ipcIo);
+    static bool DiskerPop(int &workerId, IpcIoMsg &ipcIo, uint64_t &sequence);
+    static void DiskerHandleRequest(const int workerId, IpcIoMsg &ipcIo, uint64_t sequence);
+    static void DiskerRespond(const int workerId, IpcIoMsg &ipcIo);
     static bool WaitBeforePop();
 
     static void HandleMessagesAtStart();
@@ -133,7 +147,11 @@ private:
 private:
     const String dbName; ///< the name of the file we are managing
     const pid_t myPid; ///< optimization: cached process ID of our process
-    int diskId; ///< the kid ID of the disker we talk to
+    int diskId; ///< the kid ID of the (first) disker we talk to
+
+    /// the kid IDs of all the diskers we talk to (or -1 for diskers we have
+    /// not found yet); each disker handles requests for its own db stripes
+    std::vector<int> diskIds;
     RefCount<IORequestor> ioRequestor;
 
     bool error_; ///< whether we have seen at least one I/O error (XXX)
@@ -148,6 +166,11 @@ private:
     RequestMap *newerRequests; ///< newer requests (map2 or map1)
     bool timeoutCheckScheduled; ///< we expect a CheckTimeouts() call
 
+    /// with multiple diskers, IDs of requests that still need responses, in
+    /// request order; responses from different diskers are delivered in
+    /// this order because requestors (e.g., rock) need it
+    std::deque<unsigned int> responseOrder;
+
     static const double Timeout; ///< timeout value in seconds
 
     typedef std::list<Pointer> IpcIoFileList;
@@ -180,6 +203,10 @@ public:
 
     CodeContext::Pointer codeContext; ///< requestor's context
 
+    /// a disker response waiting for responses to earlier requests (sent to
+    /// other diskers) to be delivered first
+    std::unique_ptr<IpcIoMsg> heldResponse;
+
 private:
     IpcIoPendingRequest(const IpcIoPendingRequest &d); // not implemented
     IpcIoPendingRequest &operator =(const IpcIoPendingRequest &d); // ditto
@@ -28,6 +28,7 @@
 #include "CommCalls.h"
 #include "errorpage.h"
 #include "event.h"
+#include "fatal.h"
 #include "fd.h"
 #include "fde.h"
 #include "FwdState.h"
@@ -492,6 +493,44 @@ FwdState::reactToZeroSizeObject()
     }
 }
 
+/// Whether the given open TCP Fast Open connection failed its deferred TCP
+/// handshake after ConnOpener reported success. Only the first server I/O
+/// failing with a handshake error qualifies; closures initiated by Squid
+/// (e.g., after client aborts) do not set such errors.
+bool
+FwdState::fastOpenHandshakeFailed(const Comm::Connection &conn) const
+{
+    const auto &F = fd_table[conn.fd];
+    if (!F.flags.tcpFastOpen || F.bytes_read || !err)
+        return false;
+
+    if (err->type != ERR_READ_ERROR && err->type != ERR_WRITE_ERROR)
+        return false;
+
+    switch (err->xerrno) {
+    case ECONNREFUSED:
+    case ETIMEDOUT:
+    case EHOSTUNREACH:
+    case ENETUNREACH:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// treats a failed deferred TCP Fast Open handshake as a failed connection
+/// attempt; our Fast Open requests are always retriable
+void
+FwdState::reactToFastOpenFailure()
+{
+    debugs(17, 3, "Fast Open handshake failed for " << serverConn);
+    NoteOutgoingConnectionFailure(serverConn->getPeer());
+    flags.connected_okay = false;
+    const auto anErr = new ErrorState(ERR_CONNECT_FAIL, Http::scBadGateway, request, al);
+    anErr->xerrno = err->xerrno;
+    fail(anErr);
+}
+
 /**
  * Frees fwdState without closing FD or generating an abort
  */
@@ -501,6 +540,8 @@ FwdState::unregister(Comm::ConnectionPointer &conn)
     debugs(17, 3, entry->url() );
     assert(serverConnection() == conn);
     assert(Comm::IsConnOpen(conn));
+    if (fastOpenHandshakeFailed(*conn))
+        reactToFastOpenFailure();
     comm_remove_close_handler(conn->fd, closeHandler);
     closeHandler = nullptr;
     serverConn = nullptr;
@@ -757,6 +798,8 @@ FwdState::serverClosed()
         const auto uses = fd_table[serverConn->fd].pconn.uses;
         debugs(17, 3, "prior uses: " << uses);
         fwdPconnPool->noteUses(uses); // XXX: May not have come from fwdPconnPool
+        if (fastOpenHandshakeFailed(*serverConn))
+            reactToFastOpenFailure();
         serverConn->noteClosure();
     }
     serverConn = nullptr;
@@ -1132,6 +1175,8 @@ FwdState::connectStart()
     const auto cs = new HappyConnOpener(destinations, callback, cause, start_t, n_tries, al);
     cs->setHost(request->url.host());
     bool retriable = checkRetriable();
+    // we may have to resend a request lost with a deferred TCP handshake
+    cs->allowFastOpen(retriable);
     if (!retriable && Config.accessList.serverPconnForNonretriable) {
         ACLFilledChecklist ch(Config.accessList.serverPconnForNonretriable, request);
         ch.al = al;
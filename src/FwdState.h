@@ -195,6 +195,8 @@ private:
 
     void notifyConnOpener();
     void reactToZeroSizeObject();
+    bool fastOpenHandshakeFailed(const Comm::Connection &) const;
+    void reactToFastOpenFailure();
 
     void updateAleWithFinalError();
 
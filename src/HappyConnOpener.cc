@@ -588,6 +588,8 @@ HappyConnOpener::openFreshConnection(Attempt &attempt, PeerConnectionPointer &de
     auto cs = new Comm::ConnOpener(conn, callConnect, connTimeout);
     if (!conn->getPeer())
         cs->setHost(host_);
+    if (allowFastOpen_)
+        cs->allowFastOpen();
 
     attempt.path = dest; // but not the being-opened conn!
     attempt.connWait.start(cs, callConnect);
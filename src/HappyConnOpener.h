@@ -118,6 +118,9 @@ public:
     /// configures whether the request may be retried later if things go wrong
     void setRetriable(bool retriable) { retriable_ = retriable; }
 
+    /// configures whether fresh connections may use TCP Fast Open
+    void allowFastOpen(bool permitted) { allowFastOpen_ = permitted; }
+
     /// configures the origin server domain name
     void setHost(const char *);
 
@@ -234,6 +237,9 @@ private:
     /// whether we are opening connections for a request that may be resent
     bool retriable_ = true;
 
+    /// whether fresh connections may defer their TCP handshake
+    bool allowFastOpen_ = false;
+
     /// origin server domain name (or equivalent)
     const char *host_ = nullptr;
 
@@ -99,6 +99,19 @@ HttpRequestPointer icpGetRequest(const char *url, int reqnum, int fd, const Ip::
 /// \ingroup ServerProtocolICPAPI
 void icpCreateAndSend(icp_opcode, int flags, char const *url, int reqnum, int pad, int fd, const Ip::Address &from, AccessLogEntryPointer);
 
+/// Starts accumulating fresh ICP messages sent through the given socket so
+/// that icpFlushSendBatch() can write them using a single sendmmsg(2) call.
+/// Batching continues until icpEndSendBatch().
+void icpBeginSendBatch(int fd);
+
+/// writes ICP messages accumulated since icpBeginSendBatch() or the last flush
+/// \returns the number of messages that could not be written now; each was
+/// queued for a retry (and counted in icp.replies_queued statistics)
+int icpFlushSendBatch();
+
+/// flushes accumulated ICP messages and stops batching
+void icpEndSendBatch();
+
 /// \ingroup ServerProtocolICPAPI
 icp_opcode icpGetCommonOpcode();
 
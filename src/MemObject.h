@@ -25,9 +25,12 @@
 #include "DelayId.h"
 #endif
 
+#include <memory>
+
 typedef void STMCB (void *data, StoreIOBuffer wroteBuffer);
 
 class store_client;
+class MemStoreDeflater;
 class PeerSelector;
 
 class MemObject
@@ -199,6 +202,9 @@ public:
         int64_t offset = 0; ///< bytes written/read to/from the memory cache so far
 
         Store::IoStatus io = Store::ioUndecided; ///< current I/O state
+
+        /// compresses the body while writing; nil if stored as is
+        std::shared_ptr<MemStoreDeflater> deflater;
     };
     MemCache memCache; ///< current [shared] memory caching state for the entry
 
@@ -11,17 +11,23 @@
 #include "squid.h"
 #include "base/RunnersRegistry.h"
 #include "CollapsedForwarding.h"
+#include "fatal.h"
 #include "HttpReply.h"
 #include "ipc/mem/Page.h"
 #include "ipc/mem/Pages.h"
+#include "md5.h"
 #include "MemObject.h"
 #include "MemStore.h"
+#include "MemStoreCheckpoint.h"
+#include "MemStoreCompression.h"
 #include "mime_header.h"
 #include "sbuf/SBuf.h"
 #include "sbuf/Stream.h"
 #include "SquidConfig.h"
 #include "SquidMath.h"
+#include "store/AdmissionFilter.h"
 #include "store/forward.h"
+#include "store_key_md5.h"
 #include "StoreStats.h"
 #include "tools.h"
 
@@ -199,6 +205,11 @@ MemStore::init()
     Must(!map);
     map = new MemStoreMap(SBuf(MapLabel));
     map->cleaner = this;
+
+    if (MemStoreCheckpoint::Responsible()) {
+        checkpoint.reset(new MemStoreCheckpoint(*this));
+        checkpoint->start();
+    }
 }
 
 void
@@ -258,6 +269,42 @@ MemStore::stat(StoreEntry &e) const
             }
         }
     }
+
+    if (Ipc::Mem::PagePoolCount() > 1) {
+        storeAppendPrintf(&e, "Page pools:      %9zu (one per NUMA node)\n", Ipc::Mem::PagePoolCount());
+        const auto node = Ipc::Mem::LocalPageNode();
+        if (node >= 0) {
+            const auto reads = localSliceReads + remoteSliceReads;
+            storeAppendPrintf(&e, "Local NUMA node: %9d\n", node);
+            storeAppendPrintf(&e, "Local slice reads:  %" PRIu64 " %.2f%%\n",
+                              localSliceReads, Math::doublePercent(localSliceReads, reads));
+            storeAppendPrintf(&e, "Remote slice reads: %" PRIu64 " %.2f%%\n",
+                              remoteSliceReads, Math::doublePercent(remoteSliceReads, reads));
+        } else {
+            storeAppendPrintf(&e, "Local NUMA node: none (see cpu_affinity_map)\n");
+        }
+    }
+
+    if (Config.memCompression.enabled || compressionStats.entries || decompressionStats.entries) {
+        compressionStats.dump(e, "Compression", "stored");
+        decompressionStats.dump(e, "Decompression", "loaded");
+    }
+
+    if (checkpoint)
+        checkpoint->stat(e);
+
+    Store::AdmissionFilter::StatStore(e, Store::AdmissionFilter::MemoryCacheId);
+}
+
+void
+MemStore::CompressionStats::dump(StoreEntry &e, const char * const label, const char * const verb) const
+{
+    const auto perEntry = std::chrono::duration<double, std::micro>(time).count() / std::max<uint64_t>(entries, 1);
+    storeAppendPrintf(&e, "%s: %" PRIu64 " entries %s\n", label, entries, verb);
+    storeAppendPrintf(&e, "%s ratio: %.2f (%" PRIu64 " -> %" PRIu64 " body bytes)\n", label,
+                      compressedBytes ? double(originalBytes) / compressedBytes : 0.0,
+                      originalBytes, compressedBytes);
+    storeAppendPrintf(&e, "%s time: %.1f usec per entry\n", label, perEntry);
 }
 
 void
@@ -314,6 +361,9 @@ MemStore::get(const cache_key *key)
     if (!map)
         return nullptr;
 
+    if (const auto e = getOptimistically(key))
+        return e;
+
     sfileno index;
     const Ipc::StoreMapAnchor *const slot = map->openForReading(key, index);
     if (!slot)
@@ -342,10 +392,115 @@ MemStore::get(const cache_key *key)
     }
 
     map->freeEntry(index); // do not let others into the same trap
-    destroyStoreEntry(static_cast<hash_link *>(e));
+    destroyStoreEntry(e);
     return nullptr;
 }
 
+/// Copying larger entries takes long enough for writers to invalidate the
+/// copy; such entries are read under a lock instead.
+static const uint64_t OptimisticReadMax = 64*1024;
+
+/// get() without locking the map entry (see Ipc::ReadWriteLock)
+/// \returns nil if the caller should get() the entry the usual way
+StoreEntry *
+MemStore::getOptimistically(const cache_key *key)
+{
+    sfileno index;
+    uint32_t version;
+    const auto slot = map->openForOptimisticReading(key, index, version);
+    if (!slot)
+        return nullptr;
+
+    // take snapshots of everything we need before validating our reads
+    auto e = new StoreEntry();
+    e->createMemObject();
+    slot->exportBasicsInto(*e);
+    SBuf content;
+    std::vector<Ipc::Mem::PageId> pages;
+    const auto copied = copyFromShmOptimistically(*slot, content, pages);
+
+    if (!map->closeForOptimisticReading(index, version) || !copied) {
+        debugs(20, 5, "falling back to locked reading of entry " << index);
+        destroyStoreEntry(e);
+        return nullptr;
+    }
+
+    // now we know that the snapshots are consistent
+    for (const auto &page: pages)
+        noteSliceRead(page);
+
+    try {
+        auto &reply = e->mem().adjustableBaseReply();
+        if (!reply.parseTerminatedPrefix(content.c_str(), content.length()))
+            throw TextException(ToSBuf("truncated mem-cached headers; accumulated: ", content.length()), Here());
+
+        copyFromShmSlice(*e, StoreIOBuffer(content.length(), 0, const_cast<char*>(content.rawContent())));
+
+        // from StoreEntry::complete()
+        e->mem_obj->object_sz = e->mem_obj->endOffset();
+        e->store_status = STORE_OK;
+        e->setMemStatus(IN_MEMORY);
+        EBIT_SET(e->flags, ENTRY_VALIDATED);
+        assert(static_cast<uint64_t>(e->mem_obj->object_sz) == e->swap_file_sz);
+
+        // we read the entire response into the local memory and hold no lock
+        e->mem_obj->memCache.io = Store::ioDone;
+        debugs(20, 5, "optimistically mem-loaded all " << e->mem_obj->object_sz << " bytes of " << *e);
+        return e;
+    } catch (...) {
+        // see store_client::parseHttpHeadersFromDisk() for problems this may log
+        debugs(20, DBG_IMPORTANT, "ERROR: Cannot load a cache hit from shared memory" <<
+               Debug::Extra << "exception: " << CurrentException <<
+               Debug::Extra << "cache_mem entry: " << *e);
+    }
+
+    // we hold no lock, so the index may point to another entry by now
+    map->freeEntryByKey(key); // do not let others into the same trap
+    destroyStoreEntry(e);
+    return nullptr;
+}
+
+/// copies the entire small entry from shared to local memory without locking
+/// it; the copied bytes are garbage unless closeForOptimisticReading() agrees
+/// \param pages receives the pages of the copied slices
+/// \returns false if the entry should not (or could not) be copied this way
+bool
+MemStore::copyFromShmOptimistically(const Ipc::StoreMapAnchor &anchor, SBuf &content, std::vector<Ipc::Mem::PageId> &pages) const
+{
+    const uint64_t size = anchor.basics.swap_file_sz;
+    if (!size || size > OptimisticReadMax)
+        return false;
+
+    auto sid = anchor.start.load();
+    // the caller does not know how to decompress
+    if (sid >= 0 && extras->items[sid].compressedBody)
+        return false;
+
+    const auto pageSize = Ipc::Mem::PageSize();
+    content.reserveCapacity(size);
+    // a concurrently modified chain may have loops
+    for (auto slices = map->sliceLimit(); sid >= 0; --slices) {
+        const auto slice = map->optimisticSlice(sid);
+        if (!slice || !slices)
+            return false;
+
+        const auto sliceSize = slice->size.load();
+        const auto page = extras->items[sid].page;
+        if (!page || sliceSize > pageSize || content.length() + sliceSize > size)
+            return false;
+
+        // PagePointer() throws on invalid pages
+        try {
+            content.append(static_cast<const char *>(Ipc::Mem::PagePointer(page)), sliceSize);
+            pages.push_back(page);
+        } catch (...) {
+            return false;
+        }
+        sid = slice->next;
+    }
+    return content.length() == size;
+}
+
 void
 MemStore::updateHeaders(StoreEntry *updatedE)
 {
@@ -399,6 +554,8 @@ MemStore::updateHeadersOrThrow(Ipc::StoreMapUpdate &update)
     debugs(20, 5, "appending same-slice payload: " << payloadInLastSlice);
     writer.append(page + headersInLastSlice, payloadInLastSlice);
     update.fresh.splicingPoint = writer.lastSlice;
+    // the body after the fresh headers is the same (possibly compressed) body
+    extras->items[writer.firstSlice].compressedBody = extras->items[update.stale.anchor->start].compressedBody;
 
     update.fresh.anchor->basics.swap_file_sz -= staleHdrSz;
     update.fresh.anchor->basics.swap_file_sz += freshHdrSz;
@@ -406,6 +563,96 @@ MemStore::updateHeadersOrThrow(Ipc::StoreMapUpdate &update)
     map->closeForUpdating(update);
 }
 
+/// copies metadata and stored content of the complete entry at the given
+/// position (if any) for MemStoreCheckpoint
+/// \returns false if there is no complete entry at that position
+bool
+MemStore::exportEntry(const sfileno index, MemStoreCheckpointEntry &entry, SBuf &content)
+{
+    const auto anchor = map->openCompleteForReadingAt(index);
+    if (!anchor)
+        return false;
+
+    entry = MemStoreCheckpointEntry();
+    memcpy(entry.key, anchor->key, sizeof(entry.key));
+    entry.timestamp = anchor->basics.timestamp;
+    entry.lastref = anchor->basics.lastref;
+    entry.expires = anchor->basics.expires;
+    entry.lastmod = anchor->basics.lastmod;
+    entry.swapFileSz = anchor->basics.swap_file_sz;
+    entry.refcount = anchor->basics.refcount;
+    entry.flags = anchor->basics.flags;
+    entry.compressedBody = extras->items[anchor->start].compressedBody;
+
+    content.clear();
+    try {
+        // compressed entries store fewer than swap_file_sz bytes
+        content.reserveCapacity(entry.swapFileSz);
+        for (auto sid = anchor->start.load(); sid >= 0;) {
+            const auto &slice = map->readableSlice(index, sid);
+            content.append(static_cast<const char *>(PagePointer(pageForSlice(sid))), slice.size);
+            sid = slice.next;
+        }
+    } catch (...) {
+        debugs(20, 2, "cannot export entry " << index << ": " << CurrentException);
+        map->closeForReading(index);
+        return false;
+    }
+    map->closeForReading(index);
+
+    entry.storedSize = content.length();
+    return entry.storedSize > 0;
+}
+
+/// adds a MemStoreCheckpoint entry unless an entry with the same key exists
+/// \returns whether the entry was added
+bool
+MemStore::importEntry(const MemStoreCheckpointEntry &entry, const SBuf &content)
+{
+    const auto key = reinterpret_cast<const cache_key *>(entry.key);
+    if (map->hasReadableEntry(key)) {
+        debugs(20, 5, "already cached: " << storeKeyText(key));
+        return false;
+    }
+
+    sfileno index = 0;
+    const auto slot = map->openForWriting(key, index);
+    if (!slot)
+        return false;
+
+    try {
+        slot->setKey(key);
+        slot->basics.timestamp = entry.timestamp;
+        slot->basics.lastref = entry.lastref;
+        slot->basics.expires = entry.expires;
+        slot->basics.lastmod = entry.lastmod;
+        slot->basics.swap_file_sz = entry.swapFileSz;
+        slot->basics.refcount = entry.refcount;
+        slot->basics.flags = entry.flags;
+
+        const size_t pageSize = Ipc::Mem::PageSize();
+        size_t written = 0;
+        sfileno sliceOffset = -1;
+        while (written < content.length()) {
+            auto &slice = nextAppendableSlice(index, sliceOffset);
+            const auto sliceOffsetBytes = written % pageSize;
+            const auto copySize = std::min(content.length() - written, pageSize - sliceOffsetBytes);
+            memcpy(static_cast<char *>(PagePointer(pageForSlice(sliceOffset))) + sliceOffsetBytes,
+                   content.rawContent() + written, copySize);
+            slice.size += copySize;
+            written += copySize;
+        }
+        extras->items[slot->start].compressedBody = entry.compressedBody;
+    } catch (...) {
+        debugs(20, 3, "cannot import " << storeKeyText(key) << ": " << CurrentException);
+        map->abortWriting(index);
+        return false;
+    }
+
+    map->closeForWriting(index);
+    return true;
+}
+
 bool
 MemStore::anchorToCache(StoreEntry &entry)
 {
@@ -481,6 +728,9 @@ MemStore::copyFromShm(StoreEntry &e, const sfileno index, const Ipc::StoreMapAnc
     debugs(20, 7, "mem-loading entry " << index << " from " << anchor.start);
     assert(e.mem_obj);
 
+    if (anchor.start >= 0 && extras->items[anchor.start].compressedBody)
+        return copyCompressedFromShm(e, index, anchor);
+
     // emulate the usual Store code but w/o inapplicable checks and callbacks:
 
     Ipc::StoreMapSliceId sid = anchor.start; // optimize: remember the last sid
@@ -512,6 +762,7 @@ MemStore::copyFromShm(StoreEntry &e, const sfileno index, const Ipc::StoreMapAnc
                                          page + prefixSize);
 
             copyFromShmSlice(e, sliceBuf);
+            noteSliceRead(extra.page);
             debugs(20, 8, "entry " << index << " copied slice " << sid <<
                    " from " << extra.page << '+' << prefixSize);
 
@@ -570,6 +821,84 @@ MemStore::copyFromShm(StoreEntry &e, const sfileno index, const Ipc::StoreMapAnc
     return true;
 }
 
+/// copies the entire compressed entry from shared to local memory,
+/// decompressing its body
+bool
+MemStore::copyCompressedFromShm(StoreEntry &e, const sfileno index, const Ipc::StoreMapAnchor &anchor)
+{
+    // we do not startAppending() compressed entries
+    Must(anchor.complete());
+    Must(e.mem_obj->endOffset() == 0);
+
+    MemStoreInflater inflater;
+    const auto consume = [this, &e](const char *buf, const size_t size) {
+        copyFromShmSlice(e, StoreIOBuffer(size, e.mem_obj->endOffset(), const_cast<char*>(buf)));
+    };
+
+    SBuf httpHeaderParsingBuffer;
+    uint64_t storedSize = 0;
+    Ipc::StoreMapSliceId sid = anchor.start;
+    while (sid >= 0) {
+        const Ipc::StoreMapSlice &slice = map->readableSlice(index, sid);
+        const MemStoreMapExtras::Item &extra = extras->items[sid];
+        const char *page = static_cast<const char*>(PagePointer(extra.page));
+        noteSliceRead(extra.page);
+        storedSize += slice.size;
+
+        if (e.hasParsedReplyHeader()) {
+            inflater.inflate(page, slice.size, consume);
+        } else {
+            // headers are stored as is, but they might span multiple slices
+            httpHeaderParsingBuffer.append(page, slice.size);
+            auto &reply = e.mem().adjustableBaseReply();
+            if (reply.parseTerminatedPrefix(httpHeaderParsingBuffer.c_str(), httpHeaderParsingBuffer.length())) {
+                consume(httpHeaderParsingBuffer.rawContent(), reply.hdr_sz);
+                const auto body = httpHeaderParsingBuffer.substr(reply.hdr_sz);
+                inflater.inflate(body.rawContent(), body.length(), consume);
+                httpHeaderParsingBuffer = SBuf(); // we do not need these bytes anymore
+            }
+        }
+        sid = slice.next;
+    }
+
+    if (!e.hasParsedReplyHeader())
+        throw TextException(ToSBuf("truncated mem-cached headers; accumulated: ", httpHeaderParsingBuffer.length()), Here());
+
+    if (!inflater.finished())
+        throw TextException(ToSBuf("truncated compressed mem-cached body; stored: ", storedSize), Here());
+
+    debugs(20, 5, "mem-loaded all " << e.mem_obj->endOffset() << '/' <<
+           anchor.basics.swap_file_sz << " bytes of " << e << " from " << storedSize);
+
+    // from StoreEntry::complete()
+    e.mem_obj->object_sz = e.mem_obj->endOffset();
+    e.store_status = STORE_OK;
+    e.setMemStatus(IN_MEMORY);
+    Must(static_cast<uint64_t>(e.mem_obj->object_sz) == anchor.basics.swap_file_sz);
+
+    const auto hdrSz = e.mem().baseReply().hdr_sz;
+    ++decompressionStats.entries;
+    decompressionStats.originalBytes += e.mem_obj->object_sz - hdrSz;
+    decompressionStats.compressedBytes += storedSize - hdrSz;
+    decompressionStats.time += inflater.stopwatch.total();
+
+    // we read the entire response into the local memory; no more need to lock
+    disconnect(e);
+    return true;
+}
+
+/// updates NUMA locality statistics after reading a slice stored in the page
+void
+MemStore::noteSliceRead(const Ipc::Mem::PageId &page) const
+{
+    if (Ipc::Mem::LocalPageNode() < 0)
+        return; // no pools or no locality
+    if (Ipc::Mem::PageIsLocal(page))
+        ++localSliceReads;
+    else
+        ++remoteSliceReads;
+}
+
 /// imports one shared memory slice into local memory
 void
 MemStore::copyFromShmSlice(StoreEntry &e, const StoreIOBuffer &buf)
@@ -649,9 +978,36 @@ MemStore::shouldCache(StoreEntry &e) const
         return false;
     }
 
+    if (!admits(e, ramSize)) {
+        debugs(20, 5, "admission filter rejected " << e);
+        return false;
+    }
+
     return true;
 }
 
+/// whether storing an entry of the given size is likely to evict others
+bool
+MemStore::needsEvictionFor(const int64_t ramSize) const
+{
+    const int64_t pageSize = Ipc::Mem::PageSize();
+    const auto pagesNeeded = std::max<int64_t>(1, (ramSize + pageSize - 1) / pageSize);
+    return Ipc::Mem::PagesAvailable(Ipc::Mem::PageId::cachePage) < static_cast<size_t>(pagesNeeded) ||
+           map->entryCount() >= map->entryLimit();
+}
+
+/// whether Store::AdmissionFilter lets the entry evict others (if needed)
+bool
+MemStore::admits(const StoreEntry &e, const int64_t ramSize) const
+{
+    if (!Store::AdmissionFilter::Enabled() || !needsEvictionFor(ramSize))
+        return true;
+
+    cache_key victim[SQUID_MD5_DIGEST_LENGTH];
+    const auto haveVictim = map->peekAtVictim(victim);
+    return Store::AdmissionFilter::Admits(e, Store::AdmissionFilter::MemoryCacheId, haveVictim ? victim : nullptr);
+}
+
 /// locks map anchor and preps to store the entry in shared memory
 bool
 MemStore::startCaching(StoreEntry &e)
@@ -667,9 +1023,21 @@ MemStore::startCaching(StoreEntry &e)
     e.mem_obj->memCache.index = index;
     e.mem_obj->memCache.io = Store::ioWriting;
     slot->set(e);
+
+    const auto &reply = e.mem().baseReply();
+    if (reply.hdr_sz > 0 && MemStoreDeflater::Eligible(reply, reply.content_length)) {
+        try {
+            e.mem_obj->memCache.deflater = std::make_shared<MemStoreDeflater>();
+            debugs(20, 5, "will compress " << e);
+        } catch (...) {
+            debugs(20, 2, "will not compress " << e << ": " << CurrentException);
+        }
+    }
+
     // Do not allow others to feed off an unknown-size entry because we will
-    // stop swapping it out if it grows too large.
-    if (e.mem_obj->expectedReplySize() >= 0)
+    // stop swapping it out if it grows too large. Others cannot decompress a
+    // partially stored body either.
+    if (e.mem_obj->expectedReplySize() >= 0 && !e.mem_obj->memCache.deflater)
         map->startAppending(index);
     e.memOutDecision(true);
     return true;
@@ -683,6 +1051,9 @@ MemStore::copyToShm(StoreEntry &e)
     assert(e.mem_obj);
     Must(!EBIT_TEST(e.flags, ENTRY_FWD_HDR_WAIT));
 
+    if (const auto deflater = e.mem_obj->memCache.deflater.get())
+        return copyCompressedToShm(e, *deflater);
+
     const int64_t eSize = e.mem_obj->endOffset();
     if (e.mem_obj->memCache.offset >= eSize) {
         debugs(20, 5, "postponing copying " << e << " for lack of news: " <<
@@ -711,6 +1082,63 @@ MemStore::copyToShm(StoreEntry &e)
     debugs(20, 7, "mem-cached available " << eSize << " bytes of " << e);
 }
 
+/// compresses and copies all new local body data to shared memory; copies
+/// headers as is so that readers can parse them without decompressing
+void
+MemStore::copyCompressedToShm(StoreEntry &e, MemStoreDeflater &deflater)
+{
+    // throw if an accepted unknown-size entry grew too big or max-size changed
+    const int64_t eSize = e.mem_obj->endOffset();
+    Must(eSize <= maxObjectSize());
+
+    const int32_t index = e.mem_obj->memCache.index;
+    assert(index >= 0);
+    Ipc::StoreMapAnchor &anchor = map->writeableEntry(index);
+
+    // resume appending where the previous call stopped
+    ShmWriter writer(*this, &e, index, anchor.start);
+    if (deflater.lastSlice >= 0)
+        writer.lastSlice = deflater.lastSlice;
+    writer.totalWritten = deflater.storedSize;
+
+    const int64_t hdrSz = e.mem().baseReply().hdr_sz;
+    auto &offset = e.mem_obj->memCache.offset;
+    SBuf compressed;
+    char buf[16*1024];
+    while (offset < eSize) {
+        auto size = std::min<int64_t>(eSize - offset, sizeof(buf));
+        if (offset < hdrSz)
+            size = std::min(size, hdrSz - offset);
+
+        const auto copied = e.mem_obj->data_hdr.copy(StoreIOBuffer(size, offset, buf));
+        if (copied <= 0) {
+            debugs(20, 2, "Failed to mem-cache " << size << " bytes of " << e << " from " << offset);
+            throw TexcHere("data_hdr.copy failure");
+        }
+
+        if (offset < hdrSz)
+            writer.append(buf, copied);
+        else
+            deflater.deflate(buf, copied, compressed);
+        offset += copied;
+    }
+
+    if (e.store_status == STORE_OK) // done receiving new content
+        deflater.finish(compressed);
+
+    if (!compressed.isEmpty())
+        writer.append(compressed.rawContent(), compressed.length());
+
+    if (writer.firstSlice >= 0)
+        extras->items[writer.firstSlice].compressedBody = true;
+    deflater.storedSize = writer.totalWritten;
+    deflater.lastSlice = writer.lastSlice;
+    anchor.basics.swap_file_sz = offset;
+
+    debugs(20, 7, "mem-cached available " << eSize << " bytes of " << e <<
+           " using " << deflater.storedSize);
+}
+
 /// copies at most one slice worth of local memory to shared memory
 void
 MemStore::copyToShmSlice(StoreEntry &e, Ipc::StoreMapAnchor &anchor, Ipc::StoreMap::Slice &slice)
@@ -753,6 +1181,7 @@ MemStore::nextAppendableSlice(const sfileno fileNo, sfileno &sliceOffset)
         Ipc::Mem::PageId page;
         sliceOffset = reserveSapForWriting(page); // throws
         extras->items[sliceOffset].page = page;
+        extras->items[sliceOffset].compressedBody = false;
         anchor.start = sliceOffset;
     }
 
@@ -769,6 +1198,7 @@ MemStore::nextAppendableSlice(const sfileno fileNo, sfileno &sliceOffset)
             Ipc::Mem::PageId page;
             slice.next = sliceOffset = reserveSapForWriting(page);
             extras->items[sliceOffset].page = page;
+            extras->items[sliceOffset].compressedBody = false;
             debugs(20, 7, "entry " << fileNo << " new slice: " << sliceOffset);
             continue; // to get and return the slice at the new sliceOffset
         }
@@ -845,6 +1275,8 @@ MemStore::noteFreeMapSlice(const Ipc::StoreMapSliceId sliceId)
     } else {
         *waitingFor.slot = slotId;
         *waitingFor.page = pageId;
+        // the purged entry page may be on another NUMA node
+        Ipc::Mem::PreferLocalPage(*waitingFor.page);
         waitingFor.slot = nullptr;
         waitingFor.page = nullptr;
         pageId = Ipc::Mem::PageId();
@@ -900,6 +1332,14 @@ MemStore::completeWriting(StoreEntry &e)
 
     debugs(20, 5, "mem-cached all " << e.mem_obj->memCache.offset << " bytes of " << e);
 
+    if (const auto deflater = e.mem_obj->memCache.deflater) {
+        ++compressionStats.entries;
+        compressionStats.originalBytes += deflater->inputSize;
+        compressionStats.compressedBytes += deflater->outputSize;
+        compressionStats.time += deflater->stopwatch.total();
+        e.mem_obj->memCache.deflater.reset();
+    }
+
     e.mem_obj->memCache.index = -1;
     e.mem_obj->memCache.io = Store::ioDone;
     map->closeForWriting(index);
@@ -941,6 +1381,7 @@ MemStore::disconnect(StoreEntry &e)
     MemObject &mem_obj = *e.mem_obj;
     if (e.hasMemStore()) {
         if (mem_obj.memCache.io == Store::ioWriting) {
+            mem_obj.memCache.deflater.reset();
             map->abortWriting(mem_obj.memCache.index);
             mem_obj.memCache.index = -1;
             mem_obj.memCache.io = Store::ioDone;
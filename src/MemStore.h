@@ -9,19 +9,29 @@
 #ifndef SQUID_SRC_MEMSTORE_H
 #define SQUID_SRC_MEMSTORE_H
 
+#include "base/Stopwatch.h"
 #include "ipc/mem/Page.h"
 #include "ipc/mem/PageStack.h"
 #include "ipc/StoreMap.h"
 #include "Store.h"
 #include "store/Controlled.h"
 
+#include <memory>
+#include <vector>
+
 // StoreEntry restoration info not already stored by Ipc::StoreMap
 struct MemStoreMapExtraItem {
     Ipc::Mem::PageId page; ///< shared memory page with entry slice content
+    /// whether the entry body is compressed (see memory_cache_compression);
+    /// only meaningful for the first slice of an entry
+    bool compressedBody = false;
 };
 typedef Ipc::StoreMapItems<MemStoreMapExtraItem> MemStoreMapExtras;
 typedef Ipc::StoreMap MemStoreMap;
 
+class MemStoreCheckpoint;
+class MemStoreCheckpointEntry;
+class MemStoreDeflater;
 class ShmWriter;
 
 /// Stores HTTP entities in RAM. Current implementation uses shared memory.
@@ -73,17 +83,28 @@ public:
 
 protected:
     friend ShmWriter;
+    friend MemStoreCheckpoint;
 
     bool shouldCache(StoreEntry &e) const;
+    bool needsEvictionFor(int64_t ramSize) const;
+    bool admits(const StoreEntry &e, int64_t ramSize) const;
     bool startCaching(StoreEntry &e);
 
     void copyToShm(StoreEntry &e);
+    void copyCompressedToShm(StoreEntry &e, MemStoreDeflater &);
     void copyToShmSlice(StoreEntry &e, Ipc::StoreMapAnchor &anchor, Ipc::StoreMap::Slice &slice);
     bool copyFromShm(StoreEntry &e, const sfileno index, const Ipc::StoreMapAnchor &anchor);
+    bool copyCompressedFromShm(StoreEntry &e, const sfileno index, const Ipc::StoreMapAnchor &anchor);
+    StoreEntry *getOptimistically(const cache_key *);
+    bool copyFromShmOptimistically(const Ipc::StoreMapAnchor &, SBuf &content, std::vector<Ipc::Mem::PageId> &pages) const;
     void copyFromShmSlice(StoreEntry &, const StoreIOBuffer &);
+    void noteSliceRead(const Ipc::Mem::PageId &) const;
 
     void updateHeadersOrThrow(Ipc::StoreMapUpdate &update);
 
+    bool exportEntry(const sfileno index, MemStoreCheckpointEntry &, SBuf &content);
+    bool importEntry(const MemStoreCheckpointEntry &, const SBuf &content);
+
     void anchorEntry(StoreEntry &e, const sfileno index, const Ipc::StoreMapAnchor &anchor);
     bool updateAnchoredWith(StoreEntry &, const sfileno, const Ipc::StoreMapAnchor &);
 
@@ -115,6 +136,29 @@ private:
         Ipc::Mem::PageId *page; ///< local page variable, waiting to be filled
     };
     SlotAndPage waitingFor; ///< a cache for a single "hot" free slot and page
+
+    /// the number of slices this kid has read from its NUMA-local page pool
+    mutable uint64_t localSliceReads = 0;
+    /// the number of slices this kid has read from other NUMA nodes
+    mutable uint64_t remoteSliceReads = 0;
+
+    /// (de)compression statistics for entries stored or loaded by this kid
+    class CompressionStats
+    {
+    public:
+        uint64_t entries = 0; ///< the number of (de)compressed entries
+        uint64_t originalBytes = 0; ///< uncompressed body bytes
+        uint64_t compressedBytes = 0; ///< compressed body bytes
+        Stopwatch::Clock::duration time = Stopwatch::Clock::duration::zero(); ///< (de)compression time
+
+        /// reports these statistics, starting each line with the given label
+        void dump(StoreEntry &, const char *label, const char *verb) const;
+    };
+    CompressionStats compressionStats; ///< for stored entries
+    CompressionStats decompressionStats; ///< for loaded entries
+
+    /// saves and loads memory_cache_checkpoint (if this kid is responsible)
+    std::unique_ptr<MemStoreCheckpoint> checkpoint;
 };
 
 // Why use Store as a base? MemStore and SwapDir are both "caches".
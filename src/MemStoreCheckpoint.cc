@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 20    Memory Cache */
+
+#include "squid.h"
+#include "debug/Stream.h"
+#include "event.h"
+#include "globals.h"
+#include "MemStore.h"
+#include "MemStoreCheckpoint.h"
+#include "sbuf/Stream.h"
+#include "SquidConfig.h"
+#include "Store.h"
+#include "store/FastKeyHash.h"
+#include "store_key_md5.h"
+#include "time/gadgets.h"
+#include "tools.h"
+
+#include <cerrno>
+#include <cstring>
+
+/// identifies memory cache checkpoint files
+static const char Magic[16] = "Squid cache_mem";
+
+/// checkpoint file header, followed by MemStoreCheckpointEntry records
+class MemStoreCheckpointHeader
+{
+public:
+    char magic[sizeof(Magic)] = {};
+    uint64_t fingerprint = 0; ///< MemStoreCheckpoint::fingerprint
+};
+
+// the file format does not depend on the compiler
+static_assert(sizeof(MemStoreCheckpointHeader) == 24, "no header padding");
+static_assert(sizeof(MemStoreCheckpointEntry) == 80, "no entry padding");
+
+/// the time loading or saving steps may take before yielding to other work;
+/// keep small because the kid serves requests while checkpointing
+static const int MaxStepMsec = 50;
+
+/// how often to check whether a periodic save is due
+static const double PeriodicSaveCheckDelay = 10;
+
+/// computes the first 64 bits of the FastKeyHash of the given buffers
+static uint64_t
+Hash64(const void *a, const size_t aSize, const void *b, const size_t bSize, const void *c, const size_t cSize)
+{
+    Store::FastKeyHash hash;
+    hash.update(a, aSize);
+    hash.update(b, bSize);
+    hash.update(c, cSize);
+    unsigned char digest[Store::FastKeyHash::DigestSize];
+    hash.final(digest);
+    uint64_t result;
+    memcpy(&result, digest, sizeof(result));
+    return result;
+}
+
+/// hashes configuration aspects that checkpointed entries depend on
+static uint64_t
+ConfigFingerprint()
+{
+    SBufStream description;
+    description << "format=1 key_hash=" << storeKeyHashName(storeKeyHash());
+#if HAVE_LIBZLIB
+    description << " zlib"; // compressed entries can be decompressed
+#endif
+    description << " time_t=" << sizeof(time_t);
+    const auto text = description.buf();
+    const uint32_t byteOrder = 0x01020304;
+    return Hash64(text.rawContent(), text.length(), &byteOrder, sizeof(byteOrder), nullptr, 0);
+}
+
+/// the checksum of the given entry metadata and content
+static uint64_t
+EntryChecksum(const uint64_t fingerprint, MemStoreCheckpointEntry entry, const SBuf &content)
+{
+    entry.checksum = 0;
+    return Hash64(&fingerprint, sizeof(fingerprint), &entry, sizeof(entry), content.rawContent(), content.length());
+}
+
+MemStoreCheckpoint::MemStoreCheckpoint(MemStore &aStore):
+    store(aStore),
+    fingerprint(ConfigFingerprint())
+{
+}
+
+MemStoreCheckpoint::~MemStoreCheckpoint()
+{
+    eventDelete(&LoadSteps, this);
+    eventDelete(&SaveSteps, this);
+    eventDelete(&PeriodicSave, this);
+    if (loadingFile)
+        fclose(loadingFile);
+    if (savingFile) {
+        fclose(savingFile);
+        (void)unlink(ToSBuf(savingPath, ".new").c_str());
+    }
+}
+
+bool
+MemStoreCheckpoint::Responsible()
+{
+    // all workers share the cache; avoid conflicting loads and saves
+    return IamWorkerProcess() && (!UsingSmp() || KidIdentifier == 1);
+}
+
+void
+MemStoreCheckpoint::start()
+{
+    registerRunner();
+    savingStart = squid_curtime;
+    eventAdd("MemStoreCheckpoint::PeriodicSave", &PeriodicSave, this, PeriodicSaveCheckDelay, 1, false);
+
+    if (!Config.memCheckpoint.path)
+        return;
+
+    loadingPath = SBuf(Config.memCheckpoint.path);
+
+    // for example, this kid was restarted after a crash
+    if (store.currentCount() > 0) {
+        debugs(20, 2, "will not load " << loadingPath << " into a non-empty memory cache");
+        return;
+    }
+
+    loadingFile = fopen(loadingPath.c_str(), "rb");
+    if (!loadingFile) {
+        const auto xerrno = errno;
+        debugs(20, (xerrno == ENOENT ? 2 : DBG_IMPORTANT), "WARNING: Cannot open memory cache checkpoint " << loadingPath <<
+               Debug::Extra << "fopen(3) error: " << xstrerr(xerrno));
+        return;
+    }
+
+    MemStoreCheckpointHeader header;
+    if (fread(&header, sizeof(header), 1, loadingFile) != 1 || memcmp(header.magic, Magic, sizeof(Magic)) != 0)
+        return finishLoading("unsupported file format");
+
+    if (header.fingerprint != fingerprint)
+        return finishLoading("saved with incompatible configuration or Squid build");
+
+    debugs(20, DBG_IMPORTANT, "Loading memory cache checkpoint " << loadingPath);
+    eventAdd("MemStoreCheckpoint::LoadSteps", &LoadSteps, this, 0.01, 1, false);
+}
+
+void
+MemStoreCheckpoint::LoadSteps(void *data)
+{
+    static_cast<MemStoreCheckpoint*>(data)->loadSteps();
+}
+
+/// loads entries for a while, leaving the rest for later
+void
+MemStoreCheckpoint::loadSteps()
+{
+    const timeval loopStart = current_time;
+    while (loadOne()) {
+        getCurrentTime();
+        const auto elapsedMsec = tvSubMsec(loopStart, current_time);
+        if (elapsedMsec > MaxStepMsec || elapsedMsec < 0) {
+            eventAdd("MemStoreCheckpoint::LoadSteps", &LoadSteps, this, 0.01, 1, false);
+            return;
+        }
+    }
+}
+
+/// loads the next checkpointed entry
+/// \returns whether loading should continue
+bool
+MemStoreCheckpoint::loadOne()
+{
+    Assure(loadingFile);
+
+    MemStoreCheckpointEntry entry;
+    const auto metadataSize = fread(&entry, 1, sizeof(entry), loadingFile);
+    if (!metadataSize && feof(loadingFile)) {
+        finishLoading("done");
+        return false;
+    }
+
+    // a bad size would desynchronize the rest of the file reading
+    const auto maxObjectSize = static_cast<uint64_t>(store.maxObjectSize());
+    if (metadataSize != sizeof(entry) || !entry.storedSize || entry.storedSize > 2*maxObjectSize + 1024) {
+        finishLoading("damaged or truncated file");
+        return false;
+    }
+
+    content.clear();
+    const auto space = content.rawAppendStart(entry.storedSize);
+    const auto contentSize = fread(space, 1, entry.storedSize, loadingFile);
+    content.rawAppendFinish(space, contentSize);
+    if (contentSize != entry.storedSize) {
+        finishLoading("truncated file");
+        return false;
+    }
+
+    if (EntryChecksum(fingerprint, entry, content) != entry.checksum) {
+        debugs(20, 3, "skipping a damaged entry");
+        ++skipped;
+        return true;
+    }
+
+    if (entry.swapFileSz > maxObjectSize) {
+        debugs(20, 3, "skipping an entry exceeding maximum_object_size_in_memory: " << entry.swapFileSz);
+        ++skipped;
+        return true;
+    }
+
+    // do not evict entries cached since startup or loaded earlier
+    if (store.needsEvictionFor(entry.storedSize)) {
+        finishLoading("the memory cache is full");
+        return false;
+    }
+
+    if (store.importEntry(entry, content))
+        ++loaded;
+    else
+        ++skipped;
+    return true;
+}
+
+/// stops loading and removes the loaded checkpoint
+void
+MemStoreCheckpoint::finishLoading(const char *outcome)
+{
+    Assure(loadingFile);
+    fclose(loadingFile);
+    loadingFile = nullptr;
+    content.clear();
+
+    debugs(20, DBG_IMPORTANT, "Finished loading memory cache checkpoint " << loadingPath << ": " << outcome <<
+           Debug::Extra << "loaded entries: " << loaded <<
+           Debug::Extra << "skipped entries: " << skipped);
+
+    // the checkpoint will be stale once we start modifying the cache
+    if (unlink(loadingPath.c_str()) != 0) {
+        const auto xerrno = errno;
+        debugs(20, DBG_IMPORTANT, "WARNING: Cannot remove loaded memory cache checkpoint " << loadingPath <<
+               Debug::Extra << "unlink(2) error: " << xstrerr(xerrno));
+    }
+}
+
+void
+MemStoreCheckpoint::PeriodicSave(void *data)
+{
+    const auto checkpoint = static_cast<MemStoreCheckpoint*>(data);
+    const auto period = Config.memCheckpoint.period;
+    if (period > 0 && !checkpoint->loadingFile && !checkpoint->savingFile &&
+            squid_curtime - checkpoint->savingStart >= period && checkpoint->startSaving())
+        eventAdd("MemStoreCheckpoint::SaveSteps", &SaveSteps, checkpoint, 0.01, 1, false);
+    eventAdd("MemStoreCheckpoint::PeriodicSave", &PeriodicSave, checkpoint, PeriodicSaveCheckDelay, 1, false);
+}
+
+/// starts writing a new checkpoint file
+/// \returns whether saveOne() may be called
+bool
+MemStoreCheckpoint::startSaving()
+{
+    Assure(!savingFile);
+    savingStart = squid_curtime;
+    if (!Config.memCheckpoint.path)
+        return false;
+
+    savingPath = SBuf(Config.memCheckpoint.path);
+    // do not damage the previous checkpoint until this one is complete
+    auto temporaryPath = ToSBuf(savingPath, ".new");
+    savingFile = fopen(temporaryPath.c_str(), "wb");
+    if (!savingFile) {
+        const auto xerrno = errno;
+        debugs(20, DBG_IMPORTANT, "ERROR: Cannot save memory cache checkpoint " << temporaryPath <<
+               Debug::Extra << "fopen(3) error: " << xstrerr(xerrno));
+        return false;
+    }
+
+    debugs(20, 2, "saving " << savingPath);
+    savingPos = 0;
+    saving = 0;
+
+    MemStoreCheckpointHeader header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.fingerprint = fingerprint;
+    if (fwrite(&header, sizeof(header), 1, savingFile) != 1) {
+        finishSaving(false);
+        return false;
+    }
+    return true;
+}
+
+void
+MemStoreCheckpoint::SaveSteps(void *data)
+{
+    static_cast<MemStoreCheckpoint*>(data)->saveSteps();
+}
+
+/// saves entries for a while, leaving the rest for later
+void
+MemStoreCheckpoint::saveSteps()
+{
+    const timeval loopStart = current_time;
+    while (saveOne()) {
+        getCurrentTime();
+        const auto elapsedMsec = tvSubMsec(loopStart, current_time);
+        if (elapsedMsec > MaxStepMsec || elapsedMsec < 0) {
+            eventAdd("MemStoreCheckpoint::SaveSteps", &SaveSteps, this, 0.01, 1, false);
+            return;
+        }
+    }
+}
+
+/// saves the entry at the next map position, if any
+/// \returns whether saving should continue
+bool
+MemStoreCheckpoint::saveOne()
+{
+    Assure(savingFile);
+
+    if (savingPos >= store.map->entryLimit()) {
+        finishSaving(true);
+        return false;
+    }
+
+    MemStoreCheckpointEntry entry;
+    if (!store.exportEntry(savingPos++, entry, content))
+        return true; // no complete entry at that position
+
+    entry.checksum = EntryChecksum(fingerprint, entry, content);
+    if (fwrite(&entry, sizeof(entry), 1, savingFile) != 1 ||
+            fwrite(content.rawContent(), content.length(), 1, savingFile) != 1) {
+        finishSaving(false);
+        return false;
+    }
+    ++saving;
+    return true;
+}
+
+/// closes the checkpoint being saved, replacing the old one on success
+void
+MemStoreCheckpoint::finishSaving(const bool success)
+{
+    Assure(savingFile);
+    auto temporaryPath = ToSBuf(savingPath, ".new");
+    auto failed = !success || ferror(savingFile);
+    int xerrno = errno;
+    if (fclose(savingFile) != 0 && !failed) {
+        xerrno = errno;
+        failed = true;
+    }
+    savingFile = nullptr;
+    content.clear();
+
+    if (!failed && rename(temporaryPath.c_str(), savingPath.c_str()) != 0) {
+        xerrno = errno;
+        failed = true;
+    }
+
+    if (failed) {
+        debugs(20, DBG_IMPORTANT, "ERROR: Cannot save memory cache checkpoint " << savingPath <<
+               Debug::Extra << "error: " << xstrerr(xerrno));
+        (void)unlink(temporaryPath.c_str());
+        return;
+    }
+
+    saved = saving;
+    lastSave = squid_curtime;
+    debugs(20, 2, "saved " << saved << " entries to " << savingPath);
+}
+
+void
+MemStoreCheckpoint::startShutdown()
+{
+    if (loadingFile) {
+        // keep the checkpoint: it has more entries than our partially loaded cache
+        fclose(loadingFile);
+        loadingFile = nullptr;
+        loadingInterrupted = true;
+        debugs(20, DBG_IMPORTANT, "Stopped loading memory cache checkpoint " << loadingPath << " due to shutdown" <<
+               Debug::Extra << "loaded entries: " << loaded);
+    }
+}
+
+void
+MemStoreCheckpoint::endingShutdown()
+{
+    if (loadingInterrupted)
+        return;
+
+    eventDelete(&SaveSteps, this);
+    if (!savingFile && !startSaving())
+        return;
+
+    // the main loop is about to stop; finish saving now
+    debugs(20, DBG_IMPORTANT, "Saving memory cache checkpoint " << savingPath);
+    while (saveOne()) {}
+    if (lastSave == squid_curtime)
+        debugs(20, DBG_IMPORTANT, "Saved " << saved << " memory cache entries to " << savingPath);
+}
+
+void
+MemStoreCheckpoint::stat(StoreEntry &e) const
+{
+    if (!Config.memCheckpoint.path && !loaded && !lastSave)
+        return;
+
+    storeAppendPrintf(&e, "Checkpoint %s: %" PRIu64 " entries loaded, %" PRIu64 " skipped\n",
+                      (loadingFile ? "loading" : "loaded"), loaded, skipped);
+    if (savingFile)
+        storeAppendPrintf(&e, "Checkpoint saving: %" PRIu64 " entries so far\n", saving);
+    if (lastSave)
+        storeAppendPrintf(&e, "Checkpoint saved: %" PRIu64 " entries at %s\n", saved, Time::FormatHttpd(lastSave));
+}
+
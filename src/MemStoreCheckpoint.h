@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_MEMSTORECHECKPOINT_H
+#define SQUID_SRC_MEMSTORECHECKPOINT_H
+
+#include "base/RunnersRegistry.h"
+#include "sbuf/SBuf.h"
+#include "store/forward.h"
+
+#include <cstdint>
+#include <cstdio>
+
+class MemStore;
+
+/// metadata of one memory cache entry in a checkpoint file; followed by
+/// storedSize bytes of entry content as it was stored in shared memory
+class MemStoreCheckpointEntry
+{
+public:
+    uint64_t key[2] = {0, 0}; ///< StoreEntry key
+    int64_t timestamp = 0;
+    int64_t lastref = 0;
+    int64_t expires = 0;
+    int64_t lastmod = 0;
+    uint64_t swapFileSz = 0; ///< headers and body size before compression
+    uint64_t storedSize = 0; ///< the number of stored content bytes
+    /// covers the checkpoint fingerprint, other fields, and stored content
+    uint64_t checksum = 0;
+    uint16_t refcount = 0;
+    uint16_t flags = 0;
+    uint8_t compressedBody = 0; ///< MemStoreMapExtraItem::compressedBody
+    uint8_t reserved[3] = {0, 0, 0};
+};
+
+/// Saves shared memory cache entries to the memory_cache_checkpoint file and
+/// loads them back after a restart, so that the memory cache hit ratio does
+/// not start from zero. Both actions happen in the background, a few entries
+/// at a time, except for the final save during shutdown. In SMP mode, only
+/// the first worker is responsible for the checkpoint.
+class MemStoreCheckpoint: private IndependentRunner
+{
+public:
+    explicit MemStoreCheckpoint(MemStore &);
+    ~MemStoreCheckpoint() override;
+
+    /// whether this kid should save and load the memory cache checkpoint
+    static bool Responsible();
+
+    /// starts loading the checkpoint (if any) and schedules periodic saves
+    void start();
+
+    /// reports checkpoint activity
+    void stat(StoreEntry &) const;
+
+protected:
+    /* RegisteredRunner API */
+    void startShutdown() override;
+    void endingShutdown() override;
+
+private:
+    static void LoadSteps(void *);
+    static void SaveSteps(void *);
+    static void PeriodicSave(void *);
+
+    void loadSteps();
+    bool loadOne();
+    void finishLoading(const char *outcome);
+
+    bool startSaving();
+    void saveSteps();
+    bool saveOne();
+    void finishSaving(bool success);
+
+    MemStore &store; ///< the memory cache we checkpoint
+
+    /// identifies configuration aspects that affect checkpointed entries
+    const uint64_t fingerprint;
+
+    SBuf content; ///< entry content buffer for loading and saving
+
+    FILE *loadingFile = nullptr; ///< checkpoint being loaded (or nil)
+    SBuf loadingPath; ///< the name of the checkpoint being loaded
+    uint64_t loaded = 0; ///< the number of entries added to the cache
+    uint64_t skipped = 0; ///< the number of checkpointed entries not added
+    /// whether shutdown interrupted loading (so that saving would lose entries)
+    bool loadingInterrupted = false;
+
+    FILE *savingFile = nullptr; ///< checkpoint being saved (or nil)
+    SBuf savingPath; ///< the name of the checkpoint being saved
+    int savingPos = 0; ///< the next map position to save
+    uint64_t saving = 0; ///< the number of entries saved so far
+    time_t savingStart = 0; ///< when the last save started
+    uint64_t saved = 0; ///< the number of entries in the last saved checkpoint
+    time_t lastSave = 0; ///< when the last successful save finished
+};
+
+#endif /* SQUID_SRC_MEMSTORECHECKPOINT_H */
+
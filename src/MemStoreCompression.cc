@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 20    Memory Cache */
+
+#include "squid.h"
+#include "base/TextException.h"
+#include "debug/Stream.h"
+#include "HttpReply.h"
+#include "MemStoreCompression.h"
+#include "sbuf/SBuf.h"
+#include "sbuf/Stream.h"
+#include "SquidConfig.h"
+#include "wordlist.h"
+
+#if HAVE_LIBZLIB
+#if HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+#endif
+
+#include <cstring>
+
+/// the size of the buffer receiving (de)compression output
+static const size_t OutputChunkSize = 16*1024;
+
+bool
+MemStoreDeflater::Eligible(const HttpReply &reply, const int64_t bodySize)
+{
+    if (!Config.memCompression.enabled)
+        return false;
+
+    if (bodySize >= 0 && static_cast<uint64_t>(bodySize) < Config.memCompression.minSize) {
+        debugs(20, 7, "small body: " << bodySize);
+        return false;
+    }
+
+    if (reply.header.has(Http::HdrType::CONTENT_ENCODING)) {
+        debugs(20, 7, "already encoded");
+        return false;
+    }
+
+    for (auto type = Config.memCompression.types; type; type = type->next) {
+        if (reply.content_type.caseCmp(type->key, strlen(type->key)) == 0)
+            return true;
+    }
+    debugs(20, 7, "ineligible Content-Type: " << reply.content_type);
+    return false;
+}
+
+#if HAVE_LIBZLIB
+
+/* MemStoreDeflater */
+
+MemStoreDeflater::MemStoreDeflater():
+    stream(new z_stream())
+{
+    // compression speed matters more than a few percent of cache_mem
+    const auto result = deflateInit(stream.get(), Z_BEST_SPEED);
+    if (result != Z_OK)
+        throw TextException(ToSBuf("deflateInit() failure: ", result), Here());
+}
+
+MemStoreDeflater::~MemStoreDeflater()
+{
+    deflateEnd(stream.get());
+}
+
+void
+MemStoreDeflater::deflate(const char * const buf, const size_t size, SBuf &out)
+{
+    stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(buf));
+    stream->avail_in = size;
+    inputSize += size;
+    run(Z_NO_FLUSH, out);
+}
+
+void
+MemStoreDeflater::finish(SBuf &out)
+{
+    stream->next_in = nullptr;
+    stream->avail_in = 0;
+    run(Z_FINISH, out);
+}
+
+/// feeds all pending input to zlib, collecting the output
+void
+MemStoreDeflater::run(const int flush, SBuf &out)
+{
+    stopwatch.resume();
+    int result = Z_OK;
+    do {
+        const auto space = out.rawAppendStart(OutputChunkSize);
+        stream->next_out = reinterpret_cast<Bytef *>(space);
+        stream->avail_out = OutputChunkSize;
+        result = ::deflate(stream.get(), flush);
+        if (result == Z_STREAM_ERROR) {
+            stopwatch.pause();
+            throw TextException("deflate() failure", Here());
+        }
+        const auto produced = OutputChunkSize - stream->avail_out;
+        out.rawAppendFinish(space, produced);
+        outputSize += produced;
+    } while (stream->avail_out == 0);
+    stopwatch.pause();
+
+    Must(stream->avail_in == 0);
+    Must(flush != Z_FINISH || result == Z_STREAM_END);
+}
+
+/* MemStoreInflater */
+
+MemStoreInflater::MemStoreInflater():
+    stream(new z_stream())
+{
+    const auto result = inflateInit(stream.get());
+    if (result != Z_OK)
+        throw TextException(ToSBuf("inflateInit() failure: ", result), Here());
+}
+
+MemStoreInflater::~MemStoreInflater()
+{
+    inflateEnd(stream.get());
+}
+
+void
+MemStoreInflater::inflate(const char * const buf, const size_t size, const Consumer &consumer)
+{
+    if (!size)
+        return;
+
+    if (finished_)
+        throw TextException("garbage after the compressed body", Here());
+
+    stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(buf));
+    stream->avail_in = size;
+
+    char output[OutputChunkSize];
+    do {
+        stream->next_out = reinterpret_cast<Bytef *>(output);
+        stream->avail_out = sizeof(output);
+        stopwatch.resume();
+        const auto result = ::inflate(stream.get(), Z_NO_FLUSH);
+        stopwatch.pause();
+        if (result == Z_STREAM_END)
+            finished_ = true;
+        else if (result != Z_OK && result != Z_BUF_ERROR)
+            throw TextException(ToSBuf("inflate() failure: ", result, ' ', (stream->msg ? stream->msg : "")), Here());
+
+        if (const auto produced = sizeof(output) - stream->avail_out)
+            consumer(output, produced);
+    } while (stream->avail_out == 0 && !finished_);
+
+    if (stream->avail_in)
+        throw TextException("garbage after the compressed body", Here());
+}
+
+#else /* HAVE_LIBZLIB */
+
+/// satisfies std::unique_ptr destruction requirements; never instantiated
+struct z_stream_s {};
+
+MemStoreDeflater::MemStoreDeflater()
+{
+    throw TextException("memory cache compression requires zlib support", Here());
+}
+
+MemStoreDeflater::~MemStoreDeflater() {}
+
+void
+MemStoreDeflater::deflate(const char *, size_t, SBuf &)
+{
+    throw TextException("memory cache compression requires zlib support", Here());
+}
+
+void
+MemStoreDeflater::finish(SBuf &)
+{
+    throw TextException("memory cache compression requires zlib support", Here());
+}
+
+MemStoreInflater::MemStoreInflater()
+{
+    throw TextException("compressed memory cache entries require zlib support", Here());
+}
+
+MemStoreInflater::~MemStoreInflater() {}
+
+void
+MemStoreInflater::inflate(const char *, size_t, const Consumer &)
+{
+    throw TextException("compressed memory cache entries require zlib support", Here());
+}
+
+#endif /* HAVE_LIBZLIB */
+
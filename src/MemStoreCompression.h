@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_MEMSTORECOMPRESSION_H
+#define SQUID_SRC_MEMSTORECOMPRESSION_H
+
+#include "base/Stopwatch.h"
+#include "sbuf/forward.h"
+#include "store/forward.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+class HttpReply;
+struct z_stream_s;
+
+/// Compresses the body of an entry being stored in the shared memory cache
+/// (see memory_cache_compression). The body is fed in pieces, as MemStore
+/// receives them, because local memory may be trimmed after each piece.
+class MemStoreDeflater
+{
+public:
+    MemStoreDeflater();
+    MemStoreDeflater(MemStoreDeflater &&) = delete; // no copying of any kind
+    ~MemStoreDeflater();
+
+    /// whether memory_cache_compression applies to an entry with this reply
+    /// \param bodySize the expected body size or a negative number if unknown
+    static bool Eligible(const HttpReply &, int64_t bodySize);
+
+    /// compresses the given body bytes, appending any output to `out`
+    void deflate(const char *buf, size_t size, SBuf &out);
+
+    /// flushes all remaining output after the last deflate() call
+    void finish(SBuf &out);
+
+    uint64_t inputSize = 0; ///< body bytes given to deflate()
+    uint64_t outputSize = 0; ///< compressed body bytes produced so far
+
+    /// the number of entry bytes (i.e. raw headers and compressed body)
+    /// already copied to shared memory
+    uint64_t storedSize = 0;
+
+    /// the shared memory slice with the last stored byte (or -1); lets the
+    /// next append resume there instead of walking the entire slice chain
+    sfileno lastSlice = -1;
+
+    Stopwatch stopwatch; ///< measures time spent compressing
+
+private:
+    void run(int flush, SBuf &out);
+
+    std::unique_ptr<z_stream_s> stream; ///< zlib compression state
+};
+
+/// Decompresses an entry body compressed by MemStoreDeflater.
+class MemStoreInflater
+{
+public:
+    /// receives decompressed body bytes
+    using Consumer = std::function<void (const char *buf, size_t size)>;
+
+    MemStoreInflater();
+    MemStoreInflater(MemStoreInflater &&) = delete; // no copying of any kind
+    ~MemStoreInflater();
+
+    /// decompresses the given bytes, giving all output to the consumer
+    void inflate(const char *buf, size_t size, const Consumer &);
+
+    /// whether we have seen the end of the compressed stream
+    bool finished() const { return finished_; }
+
+    Stopwatch stopwatch; ///< measures time spent decompressing
+
+private:
+    std::unique_ptr<z_stream_s> stream; ///< zlib decompression state
+    bool finished_ = false; ///< whether inflate() reached the stream end
+};
+
+#endif /* SQUID_SRC_MEMSTORECOMPRESSION_H */
+
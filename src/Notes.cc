@@ -13,6 +13,7 @@
 #include "acl/Tree.h"
 #include "client_side.h"
 #include "ConfigParser.h"
+#include "fatal.h"
 #include "globals.h"
 #include "http/Stream.h"
 #include "HttpReply.h"
@@ -88,8 +88,33 @@ public:
 
     YesNoNone memShared; ///< whether the memory cache is shared among workers
     YesNoNone shmLocking; ///< shared_memory_locking
+
+    /// shared_memory_huge_pages
+    class ShmHugePages
+    {
+    public:
+        /// how to back shared memory segments with huge pages
+        enum Mode { off, transparent, hugetlbfs };
+
+        Mode mode = off;
+        char *directory = nullptr; ///< hugetlbfs mount point in hugetlbfs mode
+    } shmHugePages;
+    int shmNuma; ///< shared_memory_numa
     size_t memMaxSize;
 
+    /// memory_cache_compression and related directives
+    struct {
+        int enabled;
+        wordlist *types; ///< eligible Content-Type prefixes
+        size_t minSize; ///< smallest eligible body of known size
+    } memCompression;
+
+    /// memory_cache_checkpoint and related directives
+    struct {
+        char *path; ///< checkpoint file name or nil
+        time_t period; ///< time between periodic saves or zero
+    } memCheckpoint;
+
     struct {
         int64_t min;
         int pct;
@@ -266,6 +291,8 @@ public:
         int64_t maxObjectSize;
         int64_t minObjectSize;
         size_t maxInMemObjSize;
+        int keyHash; ///< KeyHash
+        int admissionFilter; ///< whether to use Store::AdmissionFilter
     } Store;
 
     struct {
@@ -336,6 +363,9 @@ public:
         int memory_cache_disk;
         int hostStrictVerify;
         int client_dst_passthru;
+        int tunnel_splice;
+        int cache_hit_sendfile;
+        int tcp_outgoing_fast_open;
         int dns_mdns;
 #if USE_OPENSSL
         bool logTlsServerHelloDetails;
@@ -167,6 +167,13 @@ public:
         uint64_t failures = 0;
     } hitValidation;
 
+    struct {
+        uint64_t accepts = 0; ///< accepted client connections with data in SYN
+        uint64_t attempts = 0; ///< server connections that tried to put data in SYN
+        uint64_t successes = 0; ///< server connections with acknowledged SYN data
+        uint64_t fallbacks = 0; ///< server connections without acknowledged SYN data
+    } tcpFastOpen;
+
 };
 
 extern StatCounters statCounter;
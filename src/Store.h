@@ -14,7 +14,6 @@
 #include "base/Range.h"
 #include "base/RefCount.h"
 #include "comm/forward.h"
-#include "hash.h"
 #include "http/forward.h"
 #include "http/RequestMethod.h"
 #include "HttpReply.h"
@@ -34,7 +33,7 @@ class RequestFlags;
 
 extern StoreIoStats store_io_stats;
 
-class StoreEntry : public hash_link, public Packable
+class StoreEntry : public Packable
 {
 
 public:
@@ -217,6 +216,9 @@ public:
     /// allow or forbid collapsed requests feeding
     void setCollapsingRequirement(const bool required);
 
+    /// the entry key (a cache_key); indexed by store_table after hashInsert()
+    void *key = nullptr;
+
     MemObject *mem_obj;
     RemovalPolicyNode repl;
     /* START OF ON-DISK STORE_META_STD TLV field */
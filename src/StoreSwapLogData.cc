@@ -9,6 +9,7 @@
 /* DEBUG: section 47    Store Directory Routines */
 
 #include "squid.h"
+#include "store_key_md5.h"
 #include "StoreSwapLogData.h"
 #include "swap_log_op.h"
 
@@ -76,16 +77,17 @@ StoreSwapLogData::finalize()
 }
 
 StoreSwapLogHeader::StoreSwapLogHeader(): op(SWAP_LOG_VERSION), version(2),
-    record_size(sizeof(StoreSwapLogData))
+    record_size(sizeof(StoreSwapLogData)),
+    keyHash(storeKeyHash())
 {
-    checksum.set(version, record_size, 0);
+    checksum.set(version, record_size, keyHash);
 }
 
 bool
 StoreSwapLogHeader::sane() const
 {
     SwapChecksum24 actualSum;
-    actualSum.set(version, record_size, 0);
+    actualSum.set(version, record_size, keyHash);
     if (checksum != actualSum)
         return false;
 
@@ -189,6 +189,9 @@ public:
     SwapChecksum24 checksum; // follows "op" because compiler will pad anyway
     int32_t version;
     int32_t record_size;
+    /// KeyHash used for entry keys; zero (i.e. khMd5) in logs written
+    /// before store_key_hash existed because they padded the header with zeros
+    int32_t keyHash;
 };
 
 #endif /* SQUID_SRC_STORESWAPLOGDATA_H */
@@ -17,6 +17,7 @@
 #include "cache_cf.h"
 #include "ConfigParser.h"
 #include "debug/Messages.h"
+#include "fatal.h"
 #include "globals.h"
 #include "HttpReply.h"
 #include "HttpRequest.h"
@@ -56,6 +56,13 @@ public:
     int vport;               ///< virtual port support. -1 if dynamic, >0 static
     int disable_pmtu_discovery;
     bool workerQueues; ///< whether listening queues should be worker-specific
+    bool cpuSteering; ///< whether worker queues should be fed by the worker CPU
+
+    /// maximum number of connections accepted per listening socket readiness event
+    int acceptBatch;
+
+    /// TCP Fast Open queue length for the listening socket; zero disables TFO
+    int tcpFastOpenQueue;
 
     Comm::TcpKeepAlive tcp_keepalive;
 
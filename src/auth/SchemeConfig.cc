@@ -17,6 +17,7 @@
 #include "ConfigParser.h"
 #include "debug/Stream.h"
 #include "errorpage.h"
+#include "fatal.h"
 #include "format/Format.h"
 #include "globals.h"
 #include "Store.h"
@@ -37,6 +37,7 @@
 #include "DiskIO/DiskIOModule.h"
 #include "eui/Config.h"
 #include "ExternalACL.h"
+#include "fatal.h"
 #include "format/Format.h"
 #include "fqdncache.h"
 #include "ftp/Elements.h"
@@ -71,6 +72,7 @@
 #include "ssl/ProxyCerts.h"
 #include "Store.h"
 #include "store/Disks.h"
+#include "store_key_md5.h"
 #include "tools.h"
 #include "util.h"
 #include "wordlist.h"
@@ -106,6 +108,9 @@
 #if HAVE_GRP_H
 #include <grp.h>
 #endif
+#if HAVE_NETINET_TCP_H
+#include <netinet/tcp.h>
+#endif
 #if HAVE_SYS_STAT_H
 #include <sys/stat.h>
 #endif
@@ -765,6 +770,14 @@ configDoConfigure(void)
 
     storeConfigure();
 
+#if USE_CACHE_DIGESTS
+    if (Config.onoff.digest_generation && Config.Store.keyHash != khMd5) {
+        debugs(3, DBG_IMPORTANT, "WARNING: Disabling digest_generation because cache digests require MD5 keys" <<
+               Debug::Extra << "store_key_hash: " << storeKeyHashName(static_cast<KeyHash>(Config.Store.keyHash)));
+        Config.onoff.digest_generation = 0;
+    }
+#endif
+
     snprintf(ThisCache, sizeof(ThisCache), "%s (%s)",
              uniqueHostname(),
              visible_appname_string);
@@ -3126,6 +3139,14 @@ parse_wordlist(wordlist ** list)
         wordlistAdd(list, token);
 }
 
+#if HAVE_LIBZLIB // currently only used by memory_cache_compression_types
+static int
+check_null_wordlist(wordlist * list)
+{
+    return list == nullptr;
+}
+#endif
+
 static int
 check_null_acl_access(acl_access * a)
 {
@@ -3180,6 +3201,33 @@ dump_uri_whitespace(StoreEntry * entry, const char *name, int var)
     storeAppendPrintf(entry, "%s %s\n", name, s);
 }
 
+#define free_store_key_hash free_int
+
+static void
+parse_store_key_hash(int *var)
+{
+    const auto token = ConfigParser::NextToken();
+    if (!token) {
+        self_destruct();
+        return;
+    }
+
+    if (!strcmp(token, "md5"))
+        *var = khMd5;
+    else if (!strcmp(token, "fast"))
+        *var = khFast;
+    else {
+        debugs(0, DBG_PARSE_NOTE(2), "ERROR: Invalid option '" << token << "': 'store_key_hash' accepts 'md5' and 'fast'.");
+        self_destruct();
+    }
+}
+
+static void
+dump_store_key_hash(StoreEntry * entry, const char *name, int var)
+{
+    storeAppendPrintf(entry, "%s %s\n", name, storeKeyHashName(static_cast<KeyHash>(var)));
+}
+
 static void
 free_removalpolicy(RemovalPolicySettings ** settings)
 {
@@ -3242,6 +3290,53 @@ dump_YesNoNone(StoreEntry * entry, const char *name, YesNoNone &option)
         dump_onoff(entry, name, option ? 1 : 0);
 }
 
+static void
+free_shm_huge_pages(SquidConfig::ShmHugePages *cfg)
+{
+    cfg->mode = SquidConfig::ShmHugePages::off;
+    safe_free(cfg->directory);
+}
+
+static void
+parse_shm_huge_pages(SquidConfig::ShmHugePages *cfg)
+{
+    const auto token = ConfigParser::NextToken();
+    if (!token) {
+        self_destruct();
+        return;
+    }
+
+    free_shm_huge_pages(cfg);
+    if (!strcmp(token, "off")) {
+        cfg->mode = SquidConfig::ShmHugePages::off;
+    } else if (!strcmp(token, "transparent")) {
+        cfg->mode = SquidConfig::ShmHugePages::transparent;
+    } else if (!strcmp(token, "hugetlbfs")) {
+        cfg->mode = SquidConfig::ShmHugePages::hugetlbfs;
+        const auto directory = ConfigParser::NextToken();
+        cfg->directory = xstrdup(directory ? directory : "/dev/hugepages");
+    } else {
+        throw TextException(ToSBuf("unsupported ", cfg_directive, " value: ", token,
+                                   "; expected off, transparent, or hugetlbfs"), Here());
+    }
+}
+
+static void
+dump_shm_huge_pages(StoreEntry *entry, const char *name, const SquidConfig::ShmHugePages &cfg)
+{
+    switch (cfg.mode) {
+    case SquidConfig::ShmHugePages::off:
+        storeAppendPrintf(entry, "%s off\n", name);
+        break;
+    case SquidConfig::ShmHugePages::transparent:
+        storeAppendPrintf(entry, "%s transparent\n", name);
+        break;
+    case SquidConfig::ShmHugePages::hugetlbfs:
+        storeAppendPrintf(entry, "%s hugetlbfs %s\n", name, cfg.directory);
+        break;
+    }
+}
+
 static void
 free_memcachemode(SquidConfig *)
 {}
@@ -3688,6 +3783,25 @@ parse_port_option(AnyP::PortCfgPointer &s, char *token)
         throw TexcHere(ToSBuf(cfg_directive, ' ', token, " option requires building Squid where SO_REUSEPORT is supported by the TCP stack"));
 #endif
         s->workerQueues = true;
+    } else if (strcmp(token, "worker-queues=cpu") == 0) {
+#if !defined(SO_REUSEPORT) || !defined(SO_INCOMING_CPU)
+        throw TexcHere(ToSBuf(cfg_directive, ' ', token, " option requires building Squid where SO_REUSEPORT and SO_INCOMING_CPU are supported by the TCP stack"));
+#endif
+        s->workerQueues = true;
+        s->cpuSteering = true;
+    } else if (strncmp(token, "accept-batch=", 13) == 0) {
+        const auto batch = xatoi(token + 13);
+        if (batch < 1)
+            throw TexcHere(ToSBuf(cfg_directive, ' ', token, " option requires a positive number"));
+        s->acceptBatch = batch;
+    } else if (strncmp(token, "tfo=", 4) == 0) {
+#if !defined(TCP_FASTOPEN)
+        throw TexcHere(ToSBuf(cfg_directive, ' ', token, " option requires building Squid where TCP_FASTOPEN is supported by the TCP stack"));
+#endif
+        const auto queueLength = xatoi(token + 4);
+        if (queueLength < 1)
+            throw TexcHere(ToSBuf(cfg_directive, ' ', token, " option requires a positive number"));
+        s->tcpFastOpenQueue = queueLength;
     } else {
         debugs(3, DBG_CRITICAL, "FATAL: Unknown " << cfg_directive << " option '" << token << "'.");
         self_destruct();
@@ -3870,6 +3984,17 @@ dump_generic_port(StoreEntry * e, const char *n, const AnyP::PortCfgPointer &s)
     if (s->s.isAnyAddr() && !s->s.isIPv6())
         storeAppendPrintf(e, " ipv4");
 
+    if (s->cpuSteering)
+        storeAppendPrintf(e, " worker-queues=cpu");
+    else if (s->workerQueues)
+        storeAppendPrintf(e, " worker-queues");
+
+    if (s->acceptBatch != 1)
+        storeAppendPrintf(e, " accept-batch=%d", s->acceptBatch);
+
+    if (s->tcpFastOpenQueue)
+        storeAppendPrintf(e, " tfo=%d", s->tcpFastOpenQueue);
+
     if (s->tcp_keepalive.enabled) {
         if (s->tcp_keepalive.idle || s->tcp_keepalive.interval || s->tcp_keepalive.timeout) {
             storeAppendPrintf(e, " tcpkeepalive=%d,%d,%d", s->tcp_keepalive.idle, s->tcp_keepalive.interval, s->tcp_keepalive.timeout);
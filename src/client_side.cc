@@ -78,10 +78,12 @@
 #include "comm/TcpAcceptor.h"
 #include "comm/Write.h"
 #include "CommCalls.h"
+#include "compat/cpu.h"
 #include "compat/socket.h"
 #include "debug/Messages.h"
 #include "error/ExceptionErrorDetail.h"
 #include "errorpage.h"
+#include "fatal.h"
 #include "fd.h"
 #include "fde.h"
 #include "fqdncache.h"
@@ -864,6 +866,11 @@ ConnStateData::readNextRequest()
      */
     resetReadTimeout(clientConnection->timeLeft(idleTimeout()));
 
+    // Do not keep a drained read buffer while the client thinks about its
+    // next request; the buffer pool will give us another one when needed.
+    if (inBuf.isEmpty())
+        inBuf = SBuf();
+
     readSomeData();
     /** Please don't do anything with the FD past here! */
 }
@@ -3317,6 +3324,38 @@ clientStartListeningOn(AnyP::PortCfgPointer &port, const RefCount< CommCbFunPtrC
     ++NHttpSockets;
 }
 
+/// asks the TCP stack to feed our worker-specific listening queue with
+/// connections received by the CPU this worker is pinned to
+static void
+clientSteerListenerToCpu(const AnyP::PortCfgPointer &s)
+{
+#if defined(SO_INCOMING_CPU)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) != 0 || CPU_COUNT(&cpuSet) != 1) {
+        debugs(1, DBG_IMPORTANT, "WARNING: Not steering connections to " << s->listenConn <<
+               " because this process is not pinned to a single CPU" <<
+               Debug::Extra << "advice: use cpu_affinity_map to pin each worker to one CPU");
+        return;
+    }
+
+    int cpu = 0;
+    while (!CPU_ISSET(cpu, &cpuSet))
+        ++cpu;
+
+    if (xsetsockopt(s->listenConn->fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) < 0) {
+        const auto xerrno = errno;
+        debugs(1, DBG_IMPORTANT, "ERROR: Cannot steer connections to " << s->listenConn << " to CPU " << cpu <<
+               Debug::Extra << "setsockopt(SO_INCOMING_CPU) error: " << xstrerr(xerrno));
+        return;
+    }
+
+    debugs(1, 2, "steering " << s->listenConn << " to CPU " << cpu);
+#else
+    (void)s;
+#endif
+}
+
 /// process clientHttpConnectionsOpen result
 static void
 clientListenerConnectionOpened(AnyP::PortCfgPointer &s, const Ipc::FdNoteId portTypeNote, const Subscription::Pointer &sub)
@@ -3328,6 +3367,9 @@ clientListenerConnectionOpened(AnyP::PortCfgPointer &s, const Ipc::FdNoteId port
 
     Must(Comm::IsConnOpen(s->listenConn));
 
+    if (s->cpuSteering)
+        clientSteerListenerToCpu(s);
+
     // TCP: setup a job to handle accept() with subscribed handler
     AsyncJob::Start(new Comm::TcpAcceptor(s, FdNote(portTypeNote), sub));
 
@@ -37,6 +37,8 @@
 #include "SquidConfig.h"
 #include "SquidMath.h"
 #include "Store.h"
+#include "store/AdmissionFilter.h"
+#include "store_key_md5.h"
 #include "StrList.h"
 #include "tools.h"
 #if USE_AUTH
@@ -1482,6 +1484,9 @@ clientReplyContext::identifyStoreObject()
 {
     HttpRequest *r = http->request;
 
+    // count each client request once, whether or not we look it up
+    Store::AdmissionFilter::NoteRequest(storeKeyPublicByRequest(r));
+
     // client sent CC:no-cache or some other condition has been
     // encountered which prevents delivering a public/cached object.
     // XXX: The above text does not match the condition below. It might describe
@@ -18,13 +18,17 @@
 #include "comm/IoCallback.h"
 #include "comm/Loops.h"
 #include "comm/Read.h"
+#include "comm/Tcp.h"
 #include "comm/TcpAcceptor.h"
+#include "comm/TimeoutWheel.h"
+#include "comm/UdpBatch.h"
 #include "comm/Write.h"
 #include "compat/cmsg.h"
 #include "compat/socket.h"
 #include "compat/unistd.h"
 #include "DescriptorSet.h"
 #include "event.h"
+#include "fatal.h"
 #include "fd.h"
 #include "fde.h"
 #include "globals.h"
@@ -46,6 +50,7 @@
 
 #include <cerrno>
 #include <cmath>
+#include <vector>
 #if _SQUID_CYGWIN_
 #include <sys/ioctl.h>
 #endif
@@ -74,6 +79,8 @@ static void commHandleWriteHelper(void * data);
 /* STATIC */
 
 static DescriptorSet *TheHalfClosed = nullptr; /// the set of half-closed FDs
+/// descriptors that checkTimeouts() should examine, ordered by deadline
+static Comm::TimeoutWheel *TheTimeoutWheel = nullptr;
 static bool WillCheckHalfClosed = false; /// true if check is scheduled
 static EVH commHalfClosedCheck;
 static void commPlanHalfClosedCheck();
@@ -610,10 +617,25 @@ commSetConnTimeout(const Comm::ConnectionPointer &conn, time_t timeout, AsyncCal
             F->timeoutHandler = callback;
         }
 
-        F->timeout = squid_curtime + timeout;
+        commSetFdTimeout(conn->fd, squid_curtime + timeout);
     }
 }
 
+void
+commSetFdTimeout(const int fd, const time_t deadline)
+{
+    fd_table[fd].timeout = deadline;
+    if (deadline)
+        commScheduleTimeoutCheck(fd, deadline);
+}
+
+void
+commScheduleTimeoutCheck(const int fd, const time_t when)
+{
+    assert(TheTimeoutWheel);
+    TheTimeoutWheel->schedule(fd, when);
+}
+
 void
 commUnsetConnTimeout(const Comm::ConnectionPointer &conn)
 {
@@ -815,6 +837,12 @@ comm_close_complete(const int fd)
     auto F = &fd_table[fd];
     F->ssl.reset();
     F->dynamicTlsContext.reset();
+    if (F->flags.tcpFastOpen) {
+        if (Comm::TcpFastOpenUsed(fd))
+            ++statCounter.tcpFastOpen.successes;
+        else
+            ++statCounter.tcpFastOpen.fallbacks;
+    }
     fd_close(fd); /* update fdstat */
     xclose(fd);
 
@@ -1149,9 +1177,12 @@ comm_init(void)
     RESERVED_FD = min(100, Squid_MaxFD / 4);
 
     TheHalfClosed = new DescriptorSet;
+    TheTimeoutWheel = new Comm::TimeoutWheel(Squid_MaxFD, squid_curtime);
 
     /* setup the select loop module */
     Comm::SelectLoopInit();
+
+    Comm::UdpBatchStats::RegisterWithCacheManager();
 }
 
 void
@@ -1159,6 +1190,8 @@ comm_exit(void)
 {
     delete TheHalfClosed;
     TheHalfClosed = nullptr;
+    delete TheTimeoutWheel;
+    TheTimeoutWheel = nullptr;
 }
 
 #if USE_DELAY_POOLS
@@ -1490,14 +1523,38 @@ writeTimedOut(int fd)
     return true;
 }
 
+/// makes sure checkTimeouts() examines the descriptor again if it still
+/// has a timeout or a pending write
+static void
+commScheduleNextTimeoutCheck(const int fd)
+{
+    const auto F = &fd_table[fd];
+    if (!F->flags.open)
+        return;
+
+    if (F->timeout)
+        commScheduleTimeoutCheck(fd, F->timeout);
+
+    if (COMMIO_FD_WRITECB(fd)->active())
+        commScheduleTimeoutCheck(fd, F->writeStart + Config.Timeout.write);
+}
+
 void
 checkTimeouts(void)
 {
-    int fd;
     fde *F = nullptr;
     AsyncCall::Pointer callback;
 
-    for (fd = 0; fd <= Biggest_FD; ++fd) {
+    // Instead of scanning the whole fd_table, we only look at descriptors
+    // that are due according to TheTimeoutWheel. Their deadlines may have
+    // moved since they were scheduled; commScheduleNextTimeoutCheck() puts
+    // such descriptors back.
+    static std::vector<int> due;
+    due.clear();
+    assert(TheTimeoutWheel);
+    TheTimeoutWheel->expire(squid_curtime, due);
+
+    for (const auto fd: due) {
         F = &fd_table[fd];
 
         if (writeTimedOut(fd)) {
@@ -1507,6 +1564,7 @@ checkTimeouts(void)
             Comm::SetSelect(fd, COMM_SELECT_WRITE, nullptr, nullptr, 0);
             COMMIO_FD_WRITECB(fd)->finish(Comm::COMM_ERROR, ETIMEDOUT);
             CodeContext::Reset();
+            commScheduleNextTimeoutCheck(fd);
             continue;
 #if USE_DELAY_POOLS
         } else if (F->writeQuotaHandler != nullptr && COMMIO_FD_WRITECB(fd)->conn != nullptr) {
@@ -1517,11 +1575,15 @@ checkTimeouts(void)
                 Comm::SetSelect(fd, COMM_SELECT_WRITE, Comm::HandleWrite, COMMIO_FD_WRITECB(fd), 0);
                 CodeContext::Reset();
             }
+            // keep checking the bucket every second while this write lasts
+            commScheduleTimeoutCheck(fd, squid_curtime + 1);
             continue;
 #endif
         }
-        else if (AlreadyTimedOut(F))
+        else if (AlreadyTimedOut(F)) {
+            commScheduleNextTimeoutCheck(fd);
             continue;
+        }
 
         CodeContext::Reset(F->codeContext);
         debugs(5, 5, "checkTimeouts: FD " << fd << " Expired");
@@ -1537,6 +1599,9 @@ checkTimeouts(void)
         }
 
         CodeContext::Reset();
+
+        // if the handler does not set a new timeout, we will close next time
+        commScheduleNextTimeoutCheck(fd);
     }
 }
 
@@ -78,6 +78,14 @@ void commUnsetFdTimeout(int fd);
 void commSetConnTimeout(const Comm::ConnectionPointer &, time_t seconds, AsyncCall::Pointer &);
 void commUnsetConnTimeout(const Comm::ConnectionPointer &);
 
+/// sets fde::timeout to the given absolute time (or clears it if zero)
+/// without changing the timeout handler
+void commSetFdTimeout(int fd, time_t deadline);
+
+/// makes sure checkTimeouts() examines the descriptor no later than the given
+/// time; the descriptor timeout and write deadline are not changed
+void commScheduleTimeoutCheck(int fd, time_t when);
+
 int ignoreErrno(int);
 void commCloseAllSockets(void);
 void checkTimeouts(void);
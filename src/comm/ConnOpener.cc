@@ -14,6 +14,7 @@
 #include "comm/Connection.h"
 #include "comm/ConnOpener.h"
 #include "comm/Loops.h"
+#include "comm/Tcp.h"
 #include "compat/socket.h"
 #include "fd.h"
 #include "fde.h"
@@ -23,6 +24,7 @@
 #include "ip/tools.h"
 #include "ipcache.h"
 #include "SquidConfig.h"
+#include "StatCounters.h"
 
 #include <cerrno>
 
@@ -38,7 +40,8 @@ Comm::ConnOpener::ConnOpener(const Comm::ConnectionPointer &c, const AsyncCall::
     callback_(handler),
     totalTries_(0),
     failRetries_(0),
-    deadline_(squid_curtime + static_cast<time_t>(ctimeout))
+    deadline_(squid_curtime + static_cast<time_t>(ctimeout)),
+    fastOpen_(false)
 {
     debugs(5, 3, "will connect to " << c << " with " << ctimeout << " timeout");
     assert(conn_); // we know where to go
@@ -304,6 +307,11 @@ Comm::ConnOpener::createFd()
     fd_table[temporaryFd_].tosToServer = conn_->tos;
     fd_table[temporaryFd_].nfmarkToServer = conn_->nfmark;
 
+    if (fastOpen_ && Config.onoff.tcp_outgoing_fast_open && Comm::EnableTcpFastOpenConnect(temporaryFd_)) {
+        fd_table[temporaryFd_].flags.tcpFastOpen = true;
+        ++statCounter.tcpFastOpen.attempts;
+    }
+
     typedef CommCbMemFunT<Comm::ConnOpener, CommCloseCbParams> abortDialer;
     calls_.earlyAbort_ = JobCallback(5, 4, abortDialer, this, Comm::ConnOpener::earlyAbort);
     comm_add_close_handler(temporaryFd_, calls_.earlyAbort_);
@@ -319,7 +327,7 @@ Comm::ConnOpener::createFd()
     Params &params = GetCommParams<Params>(calls_.timeout_);
     params.conn = conn_;
     fd_table[temporaryFd_].timeoutHandler = calls_.timeout_;
-    fd_table[temporaryFd_].timeout = deadline_;
+    commSetFdTimeout(temporaryFd_, deadline_);
 
     return true;
 }
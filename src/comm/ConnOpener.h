@@ -36,6 +36,11 @@ public:
     void setHost(const char *);    ///< set the hostname note for this connection
     const char * getHost() const;  ///< get the hostname noted for this connection
 
+    /// allows deferring the TCP handshake until the first write so that the
+    /// written bytes may be sent with our SYN (see tcp_outgoing_fast_open);
+    /// callers must tolerate connect errors reported by later I/O
+    void allowFastOpen() { fastOpen_ = true; }
+
 protected:
     void start() override;
     void swanSong() override;
@@ -76,6 +81,9 @@ private:
     /// if we are not done by then, we will call back with Comm::TIMEOUT
     time_t deadline_;
 
+    /// whether allowFastOpen() has been called
+    bool fastOpen_;
+
     /// handles to calls which we may need to cancel.
     struct Calls {
         AsyncCall::Pointer earlyAbort_;
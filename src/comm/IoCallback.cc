@@ -68,6 +68,10 @@ Comm::IoCallback::setCallback(Comm::iocb_type t, AsyncCall::Pointer &cb, char *b
     freefunc = f;
     size = sz;
     offset = 0;
+    more.clear();
+    moreOffset = 0;
+    fileFd = -1;
+    fileOffset = 0;
 }
 
 void
@@ -12,6 +12,7 @@
 #include "base/AsyncCall.h"
 #include "comm/Flag.h"
 #include "comm/forward.h"
+#include "comm/Write.h"
 #include "mem/forward.h"
 #include "sbuf/forward.h"
 
@@ -36,6 +37,17 @@ public:
     FREE *freefunc;
     int size;
     int offset;
+
+    /// extra buffers of a vectored write, written after the first moreOffset buf bytes
+    WriteVector more;
+    /// the size of the buf part of a vectored write
+    int moreOffset;
+
+    /// the file we write from using sendfile(2) or -1
+    int fileFd;
+    /// the offset of the first file byte we write
+    off_t fileOffset;
+
     Comm::Flag errcode;
     int xerrno;
 #if USE_DELAY_POOLS
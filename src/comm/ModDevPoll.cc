@@ -29,6 +29,7 @@
 #if USE_DEVPOLL
 
 #include "base/IoManip.h"
+#include "comm.h"
 #include "comm/Loops.h"
 #include "compat/unistd.h"
 #include "fd.h"
@@ -288,7 +289,7 @@ Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time
     }
 
     if (timeout)
-        F->timeout = squid_curtime + timeout;
+        commSetFdTimeout(fd, squid_curtime + timeout);
 }
 
 /** \brief Do poll and trigger callback functions as appropriate
@@ -34,7 +34,9 @@
 
 #include "base/CodeContext.h"
 #include "base/IoManip.h"
+#include "comm.h"
 #include "comm/Loops.h"
+#include "fatal.h"
 #include "fde.h"
 #include "globals.h"
 #include "mgr/Registration.h"
@@ -177,7 +179,7 @@ Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time
     }
 
     if (timeout)
-        F->timeout = squid_curtime + timeout;
+        commSetFdTimeout(fd, squid_curtime + timeout);
 
     if (timeout || handler) // all non-cleanup requests
         F->codeContext = CodeContext::Current(); // TODO: Avoid clearing if set?
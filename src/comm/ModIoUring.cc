@@ -0,0 +1,537 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 05    Socket Functions */
+
+/*
+ * Linux io_uring(7) network I/O loop.
+ *
+ * This is a readiness loop, like ModEpoll: io_uring(7) only replaces
+ * epoll_ctl(2) and epoll_wait(2). Interest in FD readiness is expressed as
+ * one-shot IORING_OP_POLL_ADD requests. Instead of one epoll_ctl(2) system
+ * call per interest change, Comm::SetSelect() only queues submission queue
+ * entries (SQEs), including IORING_OP_POLL_REMOVE requests that cancel old
+ * interest. All queued entries are handed to the kernel by the same
+ * io_uring_enter(2) call that waits for completions in Comm::DoSelect().
+ * Readiness handlers registered by comm.cc, Comm::Read, Comm::Write, and
+ * Comm::TcpAcceptor are called exactly as they are called by the other loops,
+ * so callers are not affected.
+ *
+ * Every armed poll request is tagged with the FD and a per-FD generation
+ * number. A completion for an older generation is stale (the FD interest has
+ * changed or the FD has been closed and reused) and is ignored.
+ *
+ * XXX Currently not implemented / supported by this module XXX
+ *
+ * - delay pools
+ * - deferred reads
+ * - reads, writes, accepts, and connects as io_uring operations; handlers
+ *   still make those system calls after a readiness completion
+ *
+ */
+
+#include "squid.h"
+
+#if USE_IO_URING
+
+#include "base/CodeContext.h"
+#include "base/IoManip.h"
+#include "comm.h"
+#include "comm/Loops.h"
+#include "fatal.h"
+#include "fde.h"
+#include "globals.h"
+#include "mgr/Registration.h"
+#include "StatCounters.h"
+#include "StatHist.h"
+#include "Store.h"
+
+#define DEBUG_IO_URING 0
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <vector>
+#if HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#endif
+#if HAVE_POLL_H
+#include <poll.h>
+#endif
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#if HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+/// the number of SQEs we may queue before forcing an early submission
+static const unsigned SubmissionQueueSize = 4096;
+
+/// user_data tag for IORING_OP_POLL_REMOVE requests; their completions are ignored
+static const uint64_t RemovalTag = UINT64_MAX;
+
+/// io_uring state of a single FD
+class IoUringFdState
+{
+public:
+    /// poll events of the currently armed IORING_OP_POLL_ADD request (or zero)
+    unsigned armed = 0;
+    /// distinguishes the currently armed poll request from the earlier ones
+    uint32_t generation = 0;
+};
+
+static int ringFd = -1;
+static int max_poll_time = 1000;
+
+/* mmap(2)ed submission queue ring */
+static void *sqRing = nullptr;
+static size_t sqRingSize = 0;
+static unsigned *sqHead = nullptr;
+static unsigned *sqTail = nullptr;
+static unsigned *sqMask = nullptr;
+static unsigned *sqArray = nullptr;
+static unsigned sqEntries = 0;
+static struct io_uring_sqe *sqes = nullptr;
+/// our copy of the SQ tail; differs from *sqTail while SQEs await submission
+static unsigned sqLocalTail = 0;
+
+/* mmap(2)ed completion queue ring */
+static void *cqRing = nullptr;
+static size_t cqRingSize = 0;
+static unsigned *cqHead = nullptr;
+static unsigned *cqTail = nullptr;
+static unsigned *cqMask = nullptr;
+static struct io_uring_cqe *cqes = nullptr;
+
+static IoUringFdState *fdStates = nullptr;
+
+/// completions harvested from the CQ ring before calling FD handlers
+static std::vector<struct io_uring_cqe> harvested;
+
+/* statistics */
+static uint64_t sqesQueued = 0;
+static uint64_t sqesSubmitted = 0;
+static uint64_t enterCalls = 0;
+static uint64_t staleCompletions = 0;
+
+static void commIoUringRegisterWithCacheManager(void);
+
+static int
+sys_io_uring_setup(const unsigned entries, struct io_uring_params *params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int
+sys_io_uring_enter(const unsigned toSubmit, const unsigned minComplete, const unsigned flags, void *arg, const size_t argSize)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, arg, argSize));
+}
+
+template <class Value>
+static Value *
+RingField(void *ring, const unsigned offset)
+{
+    return reinterpret_cast<Value *>(static_cast<char *>(ring) + offset);
+}
+
+/// the number of queued SQEs that the kernel has not seen yet
+static unsigned
+unsubmittedEntries()
+{
+    return sqLocalTail - __atomic_load_n(sqTail, __ATOMIC_RELAXED);
+}
+
+/// publishes queued SQEs and, optionally, waits for at least one completion
+/// \returns io_uring_enter(2) result
+static int
+enterRing(const bool wait, struct __kernel_timespec *timeout)
+{
+    __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+    const auto toSubmit = sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+
+    unsigned flags = 0;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    if (wait) {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        arg.ts = reinterpret_cast<uint64_t>(timeout);
+    }
+
+    ++enterCalls;
+    const auto result = sys_io_uring_enter(toSubmit, wait ? 1 : 0, flags, wait ? &arg : nullptr, wait ? sizeof(arg) : 0);
+    if (result > 0)
+        sqesSubmitted += result;
+    return result;
+}
+
+/// submits all queued SQEs without waiting for completions
+static void
+flushSubmissions()
+{
+    while (unsubmittedEntries()) {
+        if (enterRing(false, nullptr) >= 0)
+            return;
+        const auto xerrno = errno;
+        if (xerrno == EINTR)
+            continue;
+        if (xerrno == EAGAIN || xerrno == EBUSY) {
+            // the kernel needs us to reap completions first; DoSelect() will retry
+            debugs(5, 3, "postponing submission: " << xstrerr(xerrno));
+            return;
+        }
+        fatalf("io_uring_enter(2) submission failure: %s\n", xstrerr(xerrno));
+    }
+}
+
+/// \returns a zeroed SQE ready to be filled, flushing the queue if needed
+static struct io_uring_sqe *
+nextSqe()
+{
+    if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+        flushSubmissions();
+    if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+        fatalf("io_uring submission queue overflow (%u entries)\n", sqEntries);
+
+    const auto index = sqLocalTail & *sqMask;
+    auto *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    ++sqLocalTail;
+    ++sqesQueued;
+    return sqe;
+}
+
+static uint64_t
+pollTag(const int fd, const uint32_t generation)
+{
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+/// cancels the currently armed poll request (if any) and arms a new one for
+/// the given poll events (if any)
+static void
+rearm(const int fd, const unsigned events)
+{
+    auto &state = fdStates[fd];
+
+    if (state.armed == events)
+        return;
+
+    if (state.armed) {
+        auto *sqe = nextSqe();
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = pollTag(fd, state.generation);
+        sqe->user_data = RemovalTag;
+    }
+
+    ++state.generation; // invalidates completions of the old request
+    state.armed = events;
+
+    // A removal queued here waits for the next DoSelect() submission. If the
+    // caller closes the FD meanwhile, the poll request keeps the underlying
+    // file open until then, and a request queued for the closed FD number
+    // may poll its next user; such completions are stale and ignored.
+    if (events) {
+        auto *sqe = nextSqe();
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = fd;
+        sqe->poll32_events = events;
+        sqe->user_data = pollTag(fd, state.generation);
+    }
+}
+
+/// poll events matching the current FD handlers
+static unsigned
+wantedEvents(const fde &F)
+{
+    if (!F.flags.open)
+        return 0;
+
+    unsigned events = 0;
+
+    if (F.read_handler) {
+        // Hack to keep the events flowing if there is data immediately ready
+        if (F.flags.read_pending)
+            events |= POLLOUT;
+        events |= POLLIN;
+    }
+
+    if (F.write_handler)
+        events |= POLLOUT;
+
+    if (events)
+        events |= POLLHUP | POLLERR;
+
+    return events;
+}
+
+/* XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX */
+/* Public functions */
+
+/*
+ * This is a needed exported function which will be called to initialise
+ * the network loop code.
+ */
+void
+Comm::SelectLoopInit(void)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    // room for a poll completion per FD plus removal completions
+    params.cq_entries = (SQUID_MAXFD > INT_MAX/2) ? INT_MAX : 2*SQUID_MAXFD;
+
+    ringFd = sys_io_uring_setup(SubmissionQueueSize, &params);
+    if (ringFd < 0) {
+        int xerrno = errno;
+        fatalf("comm_select_init: io_uring_setup(): %s\n", xstrerr(xerrno));
+    }
+
+    if (!(params.features & IORING_FEAT_EXT_ARG))
+        fatal("comm_select_init: io_uring lacks IORING_FEAT_EXT_ARG support; Linux v5.11 or later is required\n");
+    if (!(params.features & IORING_FEAT_NODROP))
+        fatal("comm_select_init: io_uring lacks IORING_FEAT_NODROP support; Linux v5.5 or later is required\n");
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    const auto singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap)
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        int xerrno = errno;
+        fatalf("comm_select_init: mmap(IORING_OFF_SQ_RING): %s\n", xstrerr(xerrno));
+    }
+
+    if (singleMmap) {
+        cqRing = sqRing;
+    } else {
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            int xerrno = errno;
+            fatalf("comm_select_init: mmap(IORING_OFF_CQ_RING): %s\n", xstrerr(xerrno));
+        }
+    }
+
+    const auto sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    auto *sqesMap = mmap(nullptr, sqesSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqesMap == MAP_FAILED) {
+        int xerrno = errno;
+        fatalf("comm_select_init: mmap(IORING_OFF_SQES): %s\n", xstrerr(xerrno));
+    }
+    sqes = static_cast<struct io_uring_sqe *>(sqesMap);
+
+    sqHead = RingField<unsigned>(sqRing, params.sq_off.head);
+    sqTail = RingField<unsigned>(sqRing, params.sq_off.tail);
+    sqMask = RingField<unsigned>(sqRing, params.sq_off.ring_mask);
+    sqArray = RingField<unsigned>(sqRing, params.sq_off.array);
+    sqEntries = params.sq_entries;
+    sqLocalTail = *sqTail;
+
+    cqHead = RingField<unsigned>(cqRing, params.cq_off.head);
+    cqTail = RingField<unsigned>(cqRing, params.cq_off.tail);
+    cqMask = RingField<unsigned>(cqRing, params.cq_off.ring_mask);
+    cqes = RingField<struct io_uring_cqe>(cqRing, params.cq_off.cqes);
+
+    fdStates = new IoUringFdState[SQUID_MAXFD];
+    harvested.reserve(params.cq_entries);
+
+    debugs(5, 2, "io_uring ring FD " << ringFd << " with " << params.sq_entries <<
+           " SQEs and " << params.cq_entries << " CQEs");
+
+    commIoUringRegisterWithCacheManager();
+}
+
+/**
+ * This is a needed exported function which will be called to register
+ * and deregister interest in a pending IO state for a given FD.
+ */
+void
+Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time_t timeout)
+{
+    fde *F = &fd_table[fd];
+
+    assert(fd >= 0);
+    debugs(5, 5, "FD " << fd << ", type=" << type <<
+           ", handler=" << handler << ", client_data=" << client_data <<
+           ", timeout=" << timeout);
+
+    if (type & COMM_SELECT_READ) {
+        F->read_handler = handler;
+        F->read_data = client_data;
+    }
+
+    if (type & COMM_SELECT_WRITE) {
+        F->write_handler = handler;
+        F->write_data = client_data;
+    }
+
+    const auto events = wantedEvents(*F);
+    rearm(fd, events);
+
+    if (timeout)
+        commSetFdTimeout(fd, squid_curtime + timeout);
+
+    if (timeout || handler) // all non-cleanup requests
+        F->codeContext = CodeContext::Current(); // TODO: Avoid clearing if set?
+    else if (!events) // full cleanup: no more FD-associated work expected
+        F->codeContext = nullptr;
+    // else: direction-specific/timeout cleanup requests preserve F->codeContext
+}
+
+static void commIncomingStats(StoreEntry * sentry);
+
+static void
+commIoUringRegisterWithCacheManager(void)
+{
+    Mgr::RegisterAction("comm_io_uring_incoming",
+                        "comm_incoming() stats",
+                        commIncomingStats, 0, 1);
+}
+
+static void
+commIncomingStats(StoreEntry * sentry)
+{
+    StatCounters *f = &statCounter;
+    storeAppendPrintf(sentry, "Total number of io_uring(7) loops: %ld\n", statCounter.select_loops);
+    storeAppendPrintf(sentry, "Total number of io_uring_enter(2) calls: %" PRIu64 "\n", enterCalls);
+    storeAppendPrintf(sentry, "Total number of queued SQEs: %" PRIu64 "\n", sqesQueued);
+    storeAppendPrintf(sentry, "Total number of submitted SQEs: %" PRIu64 "\n", sqesSubmitted);
+    storeAppendPrintf(sentry, "Total number of stale completions: %" PRIu64 "\n", staleCompletions);
+    storeAppendPrintf(sentry, "Histogram of returned filedescriptors\n");
+    f->select_fds_hist.dump(sentry, statHistIntDumper);
+}
+
+/// moves all available CQEs into the harvested array
+static void
+harvestCompletions()
+{
+    harvested.clear();
+    auto head = *cqHead;
+    const auto tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+        harvested.push_back(cqes[head & *cqMask]);
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+}
+
+/// calls FD handlers (if any) for the given poll completion
+static void
+handleCompletion(const struct io_uring_cqe &cqe)
+{
+    if (cqe.user_data == RemovalTag)
+        return;
+
+    const auto fd = static_cast<int>(cqe.user_data & 0xFFFFFFFF);
+    const auto generation = static_cast<uint32_t>(cqe.user_data >> 32);
+    assert(fd >= 0 && fd < SQUID_MAXFD);
+    auto &state = fdStates[fd];
+
+    if (state.generation != generation || cqe.res == -ECANCELED) {
+        ++staleCompletions;
+        return;
+    }
+
+    state.armed = 0; // one-shot poll requests are done after a completion
+
+    fde *F = &fd_table[fd];
+    CodeContext::Reset(F->codeContext);
+
+    const unsigned events = cqe.res < 0 ? POLLERR : static_cast<unsigned>(cqe.res);
+    debugs(5, DEBUG_IO_URING ? 0 : 8, "got FD " << fd << " events=" << asHex(events) <<
+           " F->read_handler=" << F->read_handler << " F->write_handler=" << F->write_handler);
+
+    PF *hdl;
+    if ((events & (POLLIN|POLLHUP|POLLERR)) || F->flags.read_pending) {
+        if ((hdl = F->read_handler) != nullptr) {
+            debugs(5, DEBUG_IO_URING ? 0 : 8, "Calling read handler on FD " << fd);
+            F->read_handler = nullptr;
+            hdl(fd, F->read_data);
+            ++ statCounter.select_fds;
+        }
+    }
+
+    if (events & (POLLOUT|POLLHUP|POLLERR)) {
+        if ((hdl = F->write_handler) != nullptr) {
+            debugs(5, DEBUG_IO_URING ? 0 : 8, "Calling write handler on FD " << fd);
+            F->write_handler = nullptr;
+            hdl(fd, F->write_data);
+            ++ statCounter.select_fds;
+        }
+    }
+
+    // keep watching for the events that the handlers did not consume, unless
+    // the handlers have already re-armed (or closed) the FD
+    if (state.generation == generation)
+        rearm(fd, wantedEvents(*F));
+}
+
+/**
+ * Check all connections for new connections and input data that is to be
+ * processed. Also check for connections with data queued and whether we can
+ * write it out.
+ *
+ * Submits all SQEs queued by Comm::SetSelect() since the last call and
+ * collects readiness completions using a single io_uring_enter(2) call.
+ */
+Comm::Flag
+Comm::DoSelect(int msec)
+{
+    if (msec > max_poll_time)
+        msec = max_poll_time;
+
+    struct __kernel_timespec timeout;
+    timeout.tv_sec = msec / 1000;
+    timeout.tv_nsec = (msec % 1000) * 1000000L;
+
+    for (;;) {
+        const auto result = enterRing(true, &timeout);
+        ++ statCounter.select_loops;
+
+        if (result >= 0)
+            break;
+
+        const auto xerrno = errno;
+        if (xerrno == ETIME || xerrno == EBUSY || ignoreErrno(xerrno))
+            break;
+
+        getCurrentTime();
+
+        return Comm::COMM_ERROR;
+    }
+
+    getCurrentTime();
+
+    harvestCompletions();
+
+    statCounter.select_fds_hist.count(harvested.size());
+
+    if (harvested.empty())
+        return Comm::TIMEOUT;       /* No error.. */
+
+    for (const auto &cqe: harvested)
+        handleCompletion(cqe);
+
+    CodeContext::Reset();
+
+    return Comm::OK;
+}
+
+void
+Comm::QuickPollRequired(void)
+{
+    max_poll_time = 10;
+}
+
+#endif /* USE_IO_URING */
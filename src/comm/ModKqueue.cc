@@ -32,6 +32,7 @@
 #include "squid.h"
 
 #if USE_KQUEUE
+#include "comm.h"
 #include "comm/Loops.h"
 #include "fde.h"
 #include "globals.h"
@@ -176,7 +177,7 @@ Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time
     }
 
     if (timeout)
-        F->timeout = squid_curtime + timeout;
+        commSetFdTimeout(fd, squid_curtime + timeout);
 
 }
 
@@ -12,6 +12,7 @@
 
 #if USE_POLL
 #include "anyp/PortCfg.h"
+#include "comm.h"
 #include "comm/Connection.h"
 #include "comm/Loops.h"
 #include "fd.h"
@@ -78,7 +79,7 @@ Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time
     }
 
     if (timeout)
-        F->timeout = squid_curtime + timeout;
+        commSetFdTimeout(fd, squid_curtime + timeout);
 }
 
 static int
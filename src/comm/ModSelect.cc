@@ -13,6 +13,7 @@
 #if USE_SELECT
 
 #include "anyp/PortCfg.h"
+#include "comm.h"
 #include "comm/Connection.h"
 #include "comm/Loops.h"
 #include "compat/select.h"
@@ -81,7 +82,7 @@ Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time
     }
 
     if (timeout)
-        F->timeout = squid_curtime + timeout;
+        commSetFdTimeout(fd, squid_curtime + timeout);
 }
 
 static int
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 05    Socket Functions */
+
+#include "squid.h"
+#include "comm.h"
+#include "comm/Connection.h"
+#include "comm/Splice.h"
+#include "compat/unistd.h"
+#include "debug/Stream.h"
+#include "fd.h"
+#include "fde.h"
+#include "StatCounters.h"
+
+#include <cerrno>
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+bool
+Comm::SpliceSupported()
+{
+#if HAVE_SPLICE
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool
+Comm::SplicePipe::open()
+{
+    if (isOpen())
+        return true;
+
+#if HAVE_SPLICE
+    int fds[2];
+    if (pipe2(fds, O_NONBLOCK|O_CLOEXEC) != 0) {
+        const auto xerrno = errno;
+        debugs(5, 2, "cannot create a splice(2) pipe: " << xstrerr(xerrno));
+        return false;
+    }
+
+    readFd = fds[0];
+    writeFd = fds[1];
+    fd_open(readFd, FD_PIPE, "splice pipe output");
+    fd_open(writeFd, FD_PIPE, "splice pipe input");
+
+    const auto pipeSize = fcntl(writeFd, F_GETPIPE_SZ);
+    capacity_ = pipeSize > 0 ? pipeSize : 65536;
+    buffered_ = 0;
+    debugs(5, 5, "FDs " << readFd << ',' << writeFd << " capacity " << capacity_);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void
+Comm::SplicePipe::close()
+{
+    if (!isOpen())
+        return;
+
+    debugs(5, 5, "FDs " << readFd << ',' << writeFd << " discarding " << buffered_);
+    xclose(readFd);
+    fd_close(readFd);
+    xclose(writeFd);
+    fd_close(writeFd);
+    readFd = writeFd = -1;
+    buffered_ = capacity_ = 0;
+}
+
+/// converts splice(2) result into Comm::Flag, updating params
+static Comm::Flag
+SpliceResult(CommIoCbParams &params, const ssize_t result, const int xerrno)
+{
+    params.xerrno = xerrno;
+
+    if (result > 0) {
+        params.flag = Comm::OK;
+        params.size = result;
+    } else if (result == 0) {
+        params.flag = Comm::ENDFILE;
+        params.size = 0;
+    } else {
+        debugs(5, 3, params.conn << " splice failure: " << xstrerr(xerrno));
+        params.flag = ignoreErrno(xerrno) ? Comm::INPROGRESS : Comm::COMM_ERROR;
+        params.size = 0;
+    }
+
+    return params.flag;
+}
+
+Comm::Flag
+Comm::SpliceIn(CommIoCbParams &params, SplicePipe &pipe)
+{
+    assert(pipe.isOpen());
+    assert(pipe.buffered_ < pipe.capacity_);
+
+    auto sz = pipe.capacity_ - pipe.buffered_;
+    if (params.size > 0 && static_cast<size_t>(params.size) < sz)
+        sz = params.size;
+
+    ++ statCounter.syscalls.sock.reads;
+#if HAVE_SPLICE
+    errno = 0;
+    const auto result = splice(params.conn->fd, nullptr, pipe.writeFd, nullptr, sz, SPLICE_F_MOVE|SPLICE_F_NONBLOCK);
+    const auto xerrno = errno;
+#else
+    const ssize_t result = -1;
+    const auto xerrno = ENOSYS;
+#endif
+    debugs(5, 3, params.conn << ", size " << sz << ", retval " << result << ", errno " << xerrno);
+
+    if (result > 0) {
+        pipe.buffered_ += result;
+        fd_bytes(params.conn->fd, result, IoDirection::Read);
+    }
+
+    return SpliceResult(params, result, xerrno);
+}
+
+Comm::Flag
+Comm::SpliceOut(CommIoCbParams &params, SplicePipe &pipe)
+{
+    assert(pipe.isOpen());
+    assert(pipe.buffered_ > 0);
+
+    ++ statCounter.syscalls.sock.writes;
+#if HAVE_SPLICE
+    errno = 0;
+    const auto result = splice(pipe.readFd, nullptr, params.conn->fd, nullptr, pipe.buffered_, SPLICE_F_MOVE|SPLICE_F_NONBLOCK);
+    const auto xerrno = errno;
+#else
+    const ssize_t result = -1;
+    const auto xerrno = ENOSYS;
+#endif
+    debugs(5, 3, params.conn << ", size " << pipe.buffered_ << ", retval " << result << ", errno " << xerrno);
+
+    if (result > 0) {
+        assert(static_cast<size_t>(result) <= pipe.buffered_);
+        pipe.buffered_ -= result;
+        fd_bytes(params.conn->fd, result, IoDirection::Write);
+        fd_table[params.conn->fd].writeStart = squid_curtime;
+    }
+
+    // we never ask splice(2) to move zero bytes, so zero is not an EOF here
+    if (SpliceResult(params, result, xerrno) == Comm::ENDFILE)
+        params.flag = Comm::INPROGRESS;
+    return params.flag;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_COMM_SPLICE_H
+#define SQUID_SRC_COMM_SPLICE_H
+
+#include "comm/Flag.h"
+#include "comm/forward.h"
+#include "CommCalls.h"
+
+#include <cstddef>
+
+namespace Comm
+{
+
+/// A kernel pipe for moving bytes from one socket to another with splice(2),
+/// without copying those bytes into Squid memory.
+class SplicePipe
+{
+public:
+    SplicePipe() = default;
+    ~SplicePipe() { close(); }
+
+    SplicePipe(SplicePipe &&) = delete; // no copying or moving of any kind
+
+    /// creates the pipe if needed
+    /// \returns whether the pipe is usable
+    bool open();
+
+    /// destroys the pipe, discarding any bytes still buffered in it
+    void close();
+
+    /// whether open() has created the pipe
+    bool isOpen() const { return writeFd >= 0; }
+
+    /// the number of bytes moved into the pipe but not yet moved out of it
+    size_t buffered() const { return buffered_; }
+
+    /// the maximum number of bytes the pipe can hold
+    size_t capacity() const { return capacity_; }
+
+private:
+    friend Comm::Flag SpliceIn(CommIoCbParams &, SplicePipe &);
+    friend Comm::Flag SpliceOut(CommIoCbParams &, SplicePipe &);
+
+    int readFd = -1; ///< pipe end we splice(2) from
+    int writeFd = -1; ///< pipe end we splice(2) to
+    size_t buffered_ = 0; ///< see buffered()
+    size_t capacity_ = 0; ///< see capacity()
+};
+
+/// whether splice(2)-based forwarding is supported by this Squid build
+bool SpliceSupported();
+
+/**
+ * Perform a splice(2) from params.conn into the pipe immediately.
+ *
+ * If params.size is non-zero will limit the number of moved bytes to either
+ * the pipe free space or params.size, whichever is smallest.
+ *
+ * \retval Comm::OK          params.size bytes have been moved into the pipe
+ * \retval Comm::COMM_ERROR  an error occurred, the code is placed in params.xerrno
+ * \retval Comm::INPROGRESS  unable to read at this time, or a minor error occurred
+ * \retval Comm::ENDFILE     0-byte read has occurred.
+ */
+Comm::Flag SpliceIn(CommIoCbParams &params, SplicePipe &pipe);
+
+/**
+ * Perform a splice(2) of the bytes buffered in the pipe into params.conn
+ * immediately. Some bytes may remain buffered after a successful call.
+ *
+ * \retval Comm::OK          params.size bytes have been moved out of the pipe
+ * \retval Comm::COMM_ERROR  an error occurred, the code is placed in params.xerrno
+ * \retval Comm::INPROGRESS  unable to write at this time, or a minor error occurred
+ */
+Comm::Flag SpliceOut(CommIoCbParams &params, SplicePipe &pipe);
+
+} // namespace Comm
+
+#endif /* SQUID_SRC_COMM_SPLICE_H */
@@ -71,3 +71,48 @@ Comm::ApplyTcpKeepAlive(int fd, const TcpKeepAlive &cfg)
 #endif
     (void)SetBooleanSocketOption(fd, SOL_SOCKET, SO_KEEPALIVE, true);
 }
+
+void
+Comm::ApplyTcpFastOpenListener(const int fd, const int queueLength)
+{
+#if defined(TCP_FASTOPEN)
+    if (SetSocketOption(fd, IPPROTO_TCP, TCP_FASTOPEN, queueLength))
+        debugs(5, 3, "FD " << fd << " queue length " << queueLength);
+#else
+    (void)fd;
+    (void)queueLength;
+    debugs(5, DBG_IMPORTANT, "WARNING: TCP Fast Open is not supported on your OS");
+#endif
+}
+
+bool
+Comm::EnableTcpFastOpenConnect(const int fd)
+{
+#if defined(TCP_FASTOPEN_CONNECT)
+    const int enable = 1;
+    if (xsetsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &enable, sizeof(enable)) < 0) {
+        // quietly fall back to regular connections on older kernels
+        const auto xerrno = errno;
+        debugs(5, 3, "FD " << fd << " TCP_FASTOPEN_CONNECT failure: " << xstrerr(xerrno));
+        return false;
+    }
+    return true;
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+bool
+Comm::TcpFastOpenUsed(const int fd)
+{
+#if defined(TCP_INFO) && defined(TCPI_OPT_SYN_DATA)
+    struct tcp_info info;
+    socklen_t len = sizeof(info);
+    if (xgetsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) == 0)
+        return info.tcpi_options & TCPI_OPT_SYN_DATA;
+#else
+    (void)fd;
+#endif
+    return false;
+}
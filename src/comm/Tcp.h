@@ -25,6 +25,20 @@ public:
 /// apply configured TCP keep-alive settings to the given FD socket
 void ApplyTcpKeepAlive(int fd, const TcpKeepAlive &);
 
+/// enables TCP Fast Open on the given listening socket, limiting the number
+/// of pending connections that carried data in their SYN to queueLength
+void ApplyTcpFastOpenListener(int fd, int queueLength);
+
+/// asks the kernel to send the first bytes written to the given unconnected
+/// socket together with its SYN if a TCP Fast Open cookie is cached for the
+/// destination; the kernel performs a regular handshake otherwise
+/// \returns whether the kernel accepted the request
+bool EnableTcpFastOpenConnect(int fd);
+
+/// whether the SYN exchange on the given connected socket carried data and
+/// that data was acknowledged by the peer
+bool TcpFastOpenUsed(int fd);
+
 } // namespace Comm
 
 #endif /* SQUID_SRC_COMM_TCP_H */
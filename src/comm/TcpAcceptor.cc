@@ -18,10 +18,12 @@
 #include "comm/comm_internal.h"
 #include "comm/Connection.h"
 #include "comm/Loops.h"
+#include "comm/Tcp.h"
 #include "comm/TcpAcceptor.h"
 #include "CommCalls.h"
 #include "compat/socket.h"
 #include "eui/Config.h"
+#include "fatal.h"
 #include "fd.h"
 #include "fde.h"
 #include "globals.h"
@@ -151,6 +153,11 @@ void
 Comm::TcpAcceptor::setListen()
 {
     errcode = errno = 0;
+
+    // must be set before listen(2) for the kernel to size the SYN data queue
+    if (listenPort_ && listenPort_->tcpFastOpenQueue)
+        Comm::ApplyTcpFastOpenListener(conn->fd, listenPort_->tcpFastOpenQueue);
+
     if (xlisten(conn->fd, Squid_MaxFD >> 2) < 0) {
         errcode = errno;
         debugs(50, DBG_CRITICAL, "ERROR: listen(..., " << (Squid_MaxFD >> 2) << ") system call failed: " << xstrerr(errcode));
@@ -261,7 +268,9 @@ Comm::TcpAcceptor::logAcceptError(const ConnectionPointer &tcpClient) const
     });
 }
 
-void
+/// accepts one connection and announces it to the subscriber
+/// \returns whether the listening queue may have more connections for us
+bool
 Comm::TcpAcceptor::acceptOne()
 {
     /*
@@ -281,13 +290,13 @@ Comm::TcpAcceptor::acceptOne()
                        " handler Subscription: " << theCallSub);
                 notify(Comm::OK, newConnDetails);
             });
-        } else {
-            debugs(5, 5, "try later: " << conn << " handler Subscription: " << theCallSub);
-            newConnDetails->close(); // paranoid manual closure (and may already be closed)
+            return true;
         }
 
-        SetSelect(conn->fd, COMM_SELECT_READ, doAccept, this, 0);
-        return;
+        debugs(5, 5, "try later: " << conn << " handler Subscription: " << theCallSub);
+        newConnDetails->close(); // paranoid manual closure (and may already be closed)
+        // a zero errcode means accept(2) worked, but we rejected the connection
+        return !errcode;
     } catch (...) {
         const auto debugLevel = intendedForUserConnections() ? DBG_CRITICAL : 3;
         debugs(5, debugLevel, "ERROR: Stopped accepting connections:" <<
@@ -307,6 +316,7 @@ Comm::TcpAcceptor::acceptOne()
     // XXX: Not under AsyncJob call protections but, if placed there, may cause
     // problems like making the corresponding HttpSockets entry (if any) stale.
     mustStop("unrecoverable accept failure");
+    return false;
 }
 
 void
@@ -314,7 +324,14 @@ Comm::TcpAcceptor::acceptNext()
 {
     Must(IsConnOpen(conn));
     debugs(5, 2, "connection on " << conn);
-    acceptOne();
+
+    // drain up to acceptBatch queued connections while we have spare FDs
+    const auto batchSize = listenPort_ ? listenPort_->acceptBatch : 1;
+    auto accepted = 0;
+    while (acceptOne() && ++accepted < batchSize && okToAccept()) {}
+
+    if (!stopReason)
+        SetSelect(conn->fd, COMM_SELECT_READ, doAccept, this, 0);
 }
 
 void
@@ -349,7 +366,14 @@ Comm::TcpAcceptor::acceptInto(Comm::ConnectionPointer &details)
     errcode = 0; // reset local errno copy.
     struct sockaddr_storage remoteAddress = {};
     socklen_t remoteAddressSize = sizeof(remoteAddress);
+#if HAVE_ACCEPT4 && defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+    // saves the fcntl(2) calls we would otherwise make below
+    const auto rawSock = accept4(conn->fd, reinterpret_cast<struct sockaddr *>(&remoteAddress), &remoteAddressSize, SOCK_NONBLOCK|SOCK_CLOEXEC);
+    const auto socketFlagsSet = true;
+#else
     const auto rawSock = xaccept(conn->fd, reinterpret_cast<struct sockaddr *>(&remoteAddress), &remoteAddressSize);
+    const auto socketFlagsSet = false;
+#endif
     if (rawSock < 0) {
         errcode = errno; // store last accept errno locally.
         if (ignoreErrno(errcode) || errcode == ECONNABORTED) {
@@ -413,6 +437,9 @@ Comm::TcpAcceptor::acceptInto(Comm::ConnectionPointer &details)
 
     details->nfConnmark = Ip::Qos::getNfConnmark(details, Ip::Qos::dirAccepted);
 
+    if (listenPort_ && listenPort_->tcpFastOpenQueue && Comm::TcpFastOpenUsed(sock))
+        ++statCounter.tcpFastOpen.accepts;
+
     if (Config.client_ip_max_connections >= 0) {
         if (clientdbEstablished(details->remote, 0) >= Config.client_ip_max_connections) {
             debugs(50, DBG_IMPORTANT, "WARNING: " << details->remote << " attempting more than " << Config.client_ip_max_connections << " connections.");
@@ -427,8 +454,12 @@ Comm::TcpAcceptor::acceptInto(Comm::ConnectionPointer &details)
     F->sock_family = details->local.isIPv6()?AF_INET6:AF_INET;
 
     // set socket flags
-    commSetCloseOnExec(sock);
-    commSetNonBlocking(sock);
+    if (socketFlagsSet) {
+        F->flags.nonblocking = true;
+    } else {
+        commSetCloseOnExec(sock);
+        commSetNonBlocking(sock);
+    }
     if (listenPort_)
         Comm::ApplyTcpKeepAlive(sock, listenPort_->tcp_keepalive);
 
@@ -65,9 +65,9 @@ protected:
      */
     void unsubscribe(const char *reason);
 
-    /** Try and accept another connection (synchronous).
-     * If one is pending already the subscribed callback handler will be scheduled
-     * to handle it before this method returns.
+    /** Try and accept more connections (synchronous).
+     * If some are pending already the subscribed callback handler will be scheduled
+     * to handle up to PortCfg::acceptBatch of them before this method returns.
      */
     void acceptNext();
 
@@ -99,7 +99,7 @@ private:
     /// Method callback for whenever an FD is ready to accept a client connection.
     static void doAccept(int fd, void *data);
 
-    void acceptOne();
+    bool acceptOne();
     bool acceptInto(Comm::ConnectionPointer &);
     void setListen();
     void handleClosure(const CommCloseCbParams &io);
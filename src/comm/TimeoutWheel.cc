@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 05    Socket Functions */
+
+#include "squid.h"
+#include "comm/TimeoutWheel.h"
+
+Comm::TimeoutWheel::TimeoutWheel(const int capacity, const time_t now):
+    nodes_(capacity),
+    heads_(Slots, -1),
+    current_(now)
+{
+}
+
+void
+Comm::TimeoutWheel::schedule(const int fd, time_t when)
+{
+    assert(0 <= fd && static_cast<size_t>(fd) < nodes_.size());
+
+    // we cannot return descriptors in the past or beyond our farthest slot
+    if (when < current_)
+        when = current_;
+    else if (when >= current_ + Slots)
+        when = current_ + Slots - 1;
+
+    auto &node = nodes_[fd];
+    if (node.linked) {
+        if (node.when <= when)
+            return;
+        unlink(fd);
+    }
+    link(fd, when);
+}
+
+void
+Comm::TimeoutWheel::forget(const int fd)
+{
+    assert(0 <= fd && static_cast<size_t>(fd) < nodes_.size());
+    if (nodes_[fd].linked)
+        unlink(fd);
+}
+
+void
+Comm::TimeoutWheel::expire(const time_t now, std::vector<int> &due)
+{
+    if (now < current_)
+        return;
+
+    // after a long pause, every slot is due, but each slot is drained once
+    const auto last = (now - current_ >= Slots) ? current_ + Slots - 1 : now;
+    for (auto when = current_; when <= last; ++when)
+        drainSlot(when, due);
+    current_ = now + 1;
+}
+
+void
+Comm::TimeoutWheel::link(const int fd, const time_t when)
+{
+    auto &node = nodes_[fd];
+    assert(!node.linked);
+    auto &head = slotHead(when);
+    node.prev = -1;
+    node.next = head;
+    node.when = when;
+    node.linked = true;
+    if (head >= 0)
+        nodes_[head].prev = fd;
+    head = fd;
+    ++size_;
+}
+
+void
+Comm::TimeoutWheel::unlink(const int fd)
+{
+    auto &node = nodes_[fd];
+    assert(node.linked);
+    if (node.prev >= 0)
+        nodes_[node.prev].next = node.next;
+    else
+        slotHead(node.when) = node.next;
+    if (node.next >= 0)
+        nodes_[node.next].prev = node.prev;
+    node.prev = node.next = -1;
+    node.linked = false;
+    --size_;
+}
+
+void
+Comm::TimeoutWheel::drainSlot(const time_t when, std::vector<int> &due)
+{
+    auto &head = slotHead(when);
+    while (head >= 0) {
+        const auto fd = head;
+        // schedule() never places descriptors beyond the farthest slot so
+        // all descriptors in this slot are due at this very second
+        assert(nodes_[fd].when == when);
+        unlink(fd);
+        due.push_back(fd);
+    }
+}
+
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_COMM_TIMEOUTWHEEL_H
+#define SQUID_SRC_COMM_TIMEOUTWHEEL_H
+
+#include <ctime>
+#include <vector>
+
+namespace Comm
+{
+
+/// A timer wheel of descriptors that checkTimeouts() should examine, with one
+/// slot per second. Scheduling, rescheduling, and forgetting a descriptor are
+/// O(1). Expiring costs O(returned descriptors) plus O(elapsed seconds).
+///
+/// The wheel may return a descriptor earlier than asked: Descriptors
+/// scheduled further than Slots seconds into the future wait in the farthest
+/// slot, and schedule() keeps the earlier of the old and the new time. The
+/// caller is expected to check the descriptor state and reschedule it if
+/// nothing has expired yet. This lets callers extend timeouts (the common
+/// case) without touching the wheel at all.
+class TimeoutWheel
+{
+public:
+    /// the number of one-second slots
+    static constexpr time_t Slots = 4096;
+
+    /// \param capacity the maximum descriptor value plus one
+    /// \param now the current time; expire() must not go back beyond it
+    TimeoutWheel(int capacity, time_t now);
+
+    /// makes sure expire() returns the descriptor no later than at the given
+    /// time; does nothing if the descriptor is already scheduled to be
+    /// returned at or before that time
+    void schedule(int fd, time_t when);
+
+    /// stops tracking the descriptor, if it was tracked
+    void forget(int fd);
+
+    /// whether the descriptor is waiting to be returned by expire()
+    bool scheduled(const int fd) const { return nodes_[fd].linked; }
+
+    /// removes all descriptors scheduled at or before the given time and
+    /// appends them to the given container
+    void expire(time_t now, std::vector<int> &due);
+
+    /// the number of scheduled descriptors
+    size_t size() const { return size_; }
+
+private:
+    /// the wheel state of one descriptor
+    class Node
+    {
+    public:
+        int prev = -1; ///< the previous descriptor in the same slot
+        int next = -1; ///< the next descriptor in the same slot
+        time_t when = 0; ///< when expire() should return the descriptor
+        bool linked = false; ///< whether the descriptor is in a slot
+    };
+
+    int &slotHead(const time_t when) { return heads_[when % Slots]; }
+    void link(int fd, time_t when);
+    void unlink(int fd);
+    void drainSlot(time_t when, std::vector<int> &due);
+
+    std::vector<Node> nodes_; ///< indexed by descriptor
+    std::vector<int> heads_; ///< the first descriptor of each slot or -1
+    time_t current_; ///< the earliest second that expire() has not drained
+    size_t size_ = 0; ///< the number of linked nodes
+};
+
+} // namespace Comm
+
+#endif /* SQUID_SRC_COMM_TIMEOUTWHEEL_H */
+
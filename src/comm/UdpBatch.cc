@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 05    Socket Functions */
+
+#include "squid.h"
+#include "comm.h"
+#include "comm/UdpBatch.h"
+#include "compat/socket.h"
+#include "debug/Stream.h"
+#include "fde.h"
+#include "mgr/Registration.h"
+#include "StatCounters.h"
+#include "Store.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+#include <vector>
+
+/// all UdpBatchStats objects, in their creation order
+static std::vector<Comm::UdpBatchStats*> &
+UdpBatchStatsRegistry()
+{
+    static const auto registry = new std::vector<Comm::UdpBatchStats*>();
+    return *registry;
+}
+
+bool
+Comm::UdpBatchingSupported()
+{
+#if HAVE_RECVMMSG && HAVE_SENDMMSG
+    return true;
+#else
+    return false;
+#endif
+}
+
+/* Comm::UdpBatchStats */
+
+Comm::UdpBatchStats::UdpBatchStats(const char * const aLabel):
+    label(aLabel)
+{
+    UdpBatchStatsRegistry().push_back(this);
+}
+
+void
+Comm::UdpBatchStats::count(const int datagrams, uint64_t &calls, uint64_t &total, uint64_t * const histogram)
+{
+    assert(0 <= datagrams && datagrams <= UdpBatchMax);
+    ++calls;
+    total += datagrams;
+    ++histogram[datagrams];
+}
+
+/// reports one direction of UdpBatchStats
+static void
+UdpBatchDirectionReport(StoreEntry * const sentry, const char * const direction, const uint64_t calls, const uint64_t datagrams, const uint64_t * const histogram)
+{
+    storeAppendPrintf(sentry, "\t%s calls: %" PRIu64 "\n", direction, calls);
+    storeAppendPrintf(sentry, "\t%s datagrams: %" PRIu64 "\n", direction, datagrams);
+    storeAppendPrintf(sentry, "\tmean datagrams per %s call: %.2f\n", direction,
+                      calls ? static_cast<double>(datagrams) / calls : 0.0);
+    storeAppendPrintf(sentry, "\tdatagrams per %s call histogram:\n", direction);
+    for (int n = 0; n <= Comm::UdpBatchMax; ++n) {
+        if (histogram[n])
+            storeAppendPrintf(sentry, "\t\t%2d: %" PRIu64 "\n", n, histogram[n]);
+    }
+}
+
+/// the comm_udp_batches cache manager report
+static void
+UdpBatchStatsReport(StoreEntry * const sentry)
+{
+    storeAppendPrintf(sentry, "Batched UDP I/O: %s\n", Comm::UdpBatchingSupported() ?
+                      "recvmmsg(2) and sendmmsg(2)" : "not supported, using recvfrom(2) and sendto(2)");
+    storeAppendPrintf(sentry, "Maximum batch size: %d datagrams\n", Comm::UdpBatchMax);
+
+    for (const auto stats: UdpBatchStatsRegistry()) {
+        storeAppendPrintf(sentry, "\n%s sockets:\n", stats->label);
+        UdpBatchDirectionReport(sentry, "receiving", stats->recvCalls, stats->recvDatagrams, stats->recvBatches);
+        UdpBatchDirectionReport(sentry, "sending", stats->sendCalls, stats->sendDatagrams, stats->sendBatches);
+    }
+}
+
+void
+Comm::UdpBatchStats::RegisterWithCacheManager()
+{
+    Mgr::RegisterAction("comm_udp_batches",
+                        "Batched UDP I/O Statistics",
+                        UdpBatchStatsReport, 0, 1);
+}
+
+/* Comm::UdpReceiveRing */
+
+Comm::UdpReceiveRing::UdpReceiveRing(const size_t maxDatagramSize, UdpBatchStats &stats):
+    maxDatagramSize_(maxDatagramSize),
+    buffers_(static_cast<char*>(xmalloc(UdpBatchMax * (maxDatagramSize + 1)))),
+    stats_(stats)
+{
+}
+
+Comm::UdpReceiveRing::~UdpReceiveRing()
+{
+    xfree(buffers_);
+}
+
+int
+Comm::UdpReceiveRing::receive(const int fd, const int limit)
+{
+    const auto wanted = std::min(limit, UdpBatchMax);
+    assert(wanted > 0);
+
+#if HAVE_RECVMMSG
+    struct mmsghdr headers[UdpBatchMax];
+    struct iovec iovs[UdpBatchMax];
+    struct sockaddr_storage addrs[UdpBatchMax];
+    memset(headers, 0, sizeof(headers));
+    for (int i = 0; i < wanted; ++i) {
+        iovs[i].iov_base = data(i);
+        iovs[i].iov_len = maxDatagramSize_;
+        headers[i].msg_hdr.msg_name = &addrs[i];
+        headers[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        headers[i].msg_hdr.msg_iov = &iovs[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    ++ statCounter.syscalls.sock.recvfroms;
+    const auto received = recvmmsg(fd, headers, wanted, MSG_DONTWAIT, nullptr);
+    const auto xerrno = errno;
+    debugs(5, 8, "FD " << fd << " wanted " << wanted << " got " << received);
+
+    if (received < 0) {
+        stats_.countReceived(0);
+        drained_ = true;
+        errno = xerrno; // restore for caller to use
+        return -1;
+    }
+
+    for (int i = 0; i < received; ++i) {
+        sizes_[i] = headers[i].msg_len;
+        froms_[i] = addrs[i];
+    }
+    stats_.countReceived(received);
+    drained_ = received < wanted;
+    return received;
+#else
+    const auto len = comm_udp_recvfrom(fd, data(0), maxDatagramSize_, 0, froms_[0]);
+    const auto xerrno = errno;
+    drained_ = false; // we asked for one datagram and cannot tell
+    if (len < 0) {
+        stats_.countReceived(0);
+        errno = xerrno; // restore for caller to use
+        return -1;
+    }
+    sizes_[0] = len;
+    stats_.countReceived(1);
+    return 1;
+#endif
+}
+
+/* Comm::UdpSendBatch */
+
+void
+Comm::UdpSendBatch::add(const Ip::Address &to, const void * const buf, const size_t len)
+{
+    assert(!full());
+    tos_[size_] = to;
+    buffers_[size_] = buf;
+    sizes_[size_] = len;
+    ++size_;
+}
+
+int
+Comm::UdpSendBatch::send(const int fd)
+{
+    const auto queued = size_;
+    size_ = 0;
+    if (!queued)
+        return 0;
+
+#if HAVE_SENDMMSG
+    struct mmsghdr headers[UdpBatchMax];
+    struct iovec iovs[UdpBatchMax];
+    struct sockaddr_storage addrs[UdpBatchMax];
+    memset(headers, 0, sizeof(headers));
+    for (int i = 0; i < queued; ++i) {
+        memset(&addrs[i], 0, sizeof(addrs[i]));
+        tos_[i].getSockAddr(addrs[i], fd_table[fd].sock_family);
+        iovs[i].iov_base = const_cast<void*>(buffers_[i]);
+        iovs[i].iov_len = sizes_[i];
+        headers[i].msg_hdr.msg_name = &addrs[i];
+        headers[i].msg_hdr.msg_namelen = addrs[i].ss_family == AF_INET ?
+                                         sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6);
+        headers[i].msg_hdr.msg_iov = &iovs[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    ++ statCounter.syscalls.sock.sendtos;
+    auto sent = sendmmsg(fd, headers, queued, MSG_DONTWAIT);
+    auto xerrno = errno;
+    debugs(5, 8, "FD " << fd << " queued " << queued << " sent " << sent);
+
+    if (sent < 0)
+        sent = 0;
+    else if (sent < queued)
+        xerrno = EAGAIN; // sendmmsg(2) reports the error on the next call
+    stats_.countSent(sent);
+
+    if (!sent) {
+#if _SQUID_LINUX_
+        if (ECONNREFUSED != xerrno)
+#endif
+            debugs(50, DBG_IMPORTANT, "FD " << fd << ", " << tos_[0] << ": " << xstrerr(xerrno));
+    } else if (sent < queued) {
+        debugs(50, 3, "FD " << fd << " sent " << sent << " out of " << queued << " datagrams");
+    }
+    errno = xerrno; // restore for caller to use
+    return sent;
+#else
+    int sent = 0;
+    while (sent < queued) {
+        const auto result = comm_udp_sendto(fd, tos_[sent], buffers_[sent], sizes_[sent]);
+        const auto xerrno = errno;
+        stats_.countSent(result >= 0 ? 1 : 0);
+        errno = xerrno; // restore for caller to use
+        if (result < 0)
+            break;
+        ++sent;
+    }
+    return sent;
+#endif
+}
+
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_COMM_UDPBATCH_H
+#define SQUID_SRC_COMM_UDPBATCH_H
+
+#include "ip/Address.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Comm
+{
+
+/// the maximum number of datagrams handled by one recvmmsg(2) or sendmmsg(2) call
+constexpr int UdpBatchMax = 16;
+
+/// whether recvmmsg(2) and sendmmsg(2) are available
+bool UdpBatchingSupported();
+
+/// batched UDP I/O statistics for one kind of sockets (e.g., ICP sockets)
+class UdpBatchStats
+{
+public:
+    /// registers the new object for the comm_udp_batches cache manager report
+    explicit UdpBatchStats(const char *aLabel);
+
+    UdpBatchStats(UdpBatchStats &&) = delete; // no copying or moving of any kind
+
+    /// accounts for one receiving call that returned the given number of datagrams
+    void countReceived(int datagrams) { count(datagrams, recvCalls, recvDatagrams, recvBatches); }
+
+    /// accounts for one sending call that sent the given number of datagrams
+    void countSent(int datagrams) { count(datagrams, sendCalls, sendDatagrams, sendBatches); }
+
+    /// reports statistics of all UdpBatchStats objects
+    static void RegisterWithCacheManager();
+
+    const char *label; ///< report section name
+
+    uint64_t recvCalls = 0; ///< recvmmsg(2) or recvfrom(2) calls
+    uint64_t recvDatagrams = 0; ///< datagrams returned by those calls
+    uint64_t sendCalls = 0; ///< sendmmsg(2) or sendto(2) calls
+    uint64_t sendDatagrams = 0; ///< datagrams accepted by those calls
+
+    /// the number of calls that returned N datagrams, indexed by N
+    uint64_t recvBatches[UdpBatchMax + 1] = {};
+    /// the number of calls that sent N datagrams, indexed by N
+    uint64_t sendBatches[UdpBatchMax + 1] = {};
+
+private:
+    void count(int datagrams, uint64_t &calls, uint64_t &total, uint64_t *histogram);
+};
+
+/// A small per-socket ring of datagram buffers, refilled by one recvmmsg(2)
+/// call (or, where that call is not available, by one recvfrom(2) call).
+class UdpReceiveRing
+{
+public:
+    /// \param maxDatagramSize the largest datagram a ring slot may hold
+    UdpReceiveRing(size_t maxDatagramSize, UdpBatchStats &);
+    ~UdpReceiveRing();
+
+    UdpReceiveRing(UdpReceiveRing &&) = delete; // no copying or moving of any kind
+
+    /// replaces ring contents with up to min(limit, UdpBatchMax) datagrams
+    /// waiting on the given non-blocking UDP socket
+    /// \returns the number of received datagrams or -1 (with errno set)
+    int receive(int fd, int limit);
+
+    /// whether the last receive() got fewer datagrams than it asked for,
+    /// implying that the socket has no more datagrams waiting
+    bool drained() const { return drained_; }
+
+    /// the i-th received datagram, followed by one spare byte that the caller
+    /// may use for 0-termination
+    char *data(int i) { return buffers_ + i * (maxDatagramSize_ + 1); }
+
+    /// the size of the i-th received datagram
+    size_t size(int i) const { return sizes_[i]; }
+
+    /// the sender of the i-th received datagram
+    const Ip::Address &from(int i) const { return froms_[i]; }
+
+private:
+    const size_t maxDatagramSize_;
+    char *buffers_; ///< UdpBatchMax slots of maxDatagramSize_+1 bytes each
+    size_t sizes_[UdpBatchMax] = {};
+    Ip::Address froms_[UdpBatchMax];
+    bool drained_ = false;
+
+    UdpBatchStats &stats_;
+};
+
+/// Outgoing datagrams accumulated for a single sendmmsg(2) call. Without
+/// sendmmsg(2) support, send() falls back to one sendto(2) call per datagram.
+class UdpSendBatch
+{
+public:
+    explicit UdpSendBatch(UdpBatchStats &stats): stats_(stats) {}
+
+    UdpSendBatch(UdpSendBatch &&) = delete; // no copying or moving of any kind
+
+    /// queues a datagram for sending; the caller keeps the buffer intact
+    /// until the next send() call
+    void add(const Ip::Address &to, const void *buf, size_t len);
+
+    /// the number of queued datagrams
+    int size() const { return size_; }
+
+    bool empty() const { return !size_; }
+    bool full() const { return size_ >= UdpBatchMax; }
+
+    /// sends queued datagrams using the given UDP socket and empties the batch
+    /// \returns the number of leading queued datagrams that were sent; if not
+    /// all datagrams were sent, errno describes why the next one was not
+    int send(int fd);
+
+private:
+    const void *buffers_[UdpBatchMax] = {};
+    size_t sizes_[UdpBatchMax] = {};
+    Ip::Address tos_[UdpBatchMax];
+    int size_ = 0;
+
+    UdpBatchStats &stats_;
+};
+
+} // namespace Comm
+
+#endif /* SQUID_SRC_COMM_UDPBATCH_H */
+
@@ -8,6 +8,7 @@
 
 #include "squid.h"
 #include "cbdata.h"
+#include "comm.h"
 #include "comm/Connection.h"
 #include "comm/IoCallback.h"
 #include "comm/Loops.h"
@@ -16,12 +17,40 @@
 #include "fde.h"
 #include "globals.h"
 #include "MemBuf.h"
+#include "SquidConfig.h"
 #include "StatCounters.h"
 #if USE_DELAY_POOLS
 #include "ClientInfo.h"
 #endif
 
+#include <algorithm>
 #include <cerrno>
+#if HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
+void
+Comm::WriteVector::add(const char *buf, const size_t size)
+{
+    if (!size)
+        return;
+    assert(count < Max);
+    segments[count].buf = buf;
+    segments[count].size = size;
+    ++count;
+}
+
+size_t
+Comm::WriteVector::size() const
+{
+    size_t total = 0;
+    for (int i = 0; i < count; ++i)
+        total += segments[i].size;
+    return total;
+}
 
 void
 Comm::Write(const Comm::ConnectionPointer &conn, MemBuf *mb, AsyncCall::Pointer &callback)
@@ -41,12 +70,139 @@ Comm::Write(const Comm::ConnectionPointer &conn, const char *buf, int size, Asyn
     assert(!ccb->active());
 
     fd_table[conn->fd].writeStart = squid_curtime;
+    commScheduleTimeoutCheck(conn->fd, squid_curtime + Config.Timeout.write);
     ccb->conn = conn;
     /* Queue the write */
     ccb->setCallback(IOCB_WRITE, callback, (char *)buf, free_func, size);
     ccb->selectOrQueueWrite();
 }
 
+void
+Comm::Write(const Comm::ConnectionPointer &conn, MemBuf *mb, const WriteVector &more, AsyncCall::Pointer &callback)
+{
+    debugs(5, 5, conn << ": sz " << mb->size << '+' << more.size() << ": asynCall " << callback);
+
+    /* Make sure we are open, not closing, and not writing */
+    assert(fd_table[conn->fd].flags.open);
+    assert(!fd_table[conn->fd].closing());
+    Comm::IoCallback *ccb = COMMIO_FD_WRITECB(conn->fd);
+    assert(!ccb->active());
+
+    fd_table[conn->fd].writeStart = squid_curtime;
+    commScheduleTimeoutCheck(conn->fd, squid_curtime + Config.Timeout.write);
+    ccb->conn = conn;
+    /* Queue the write */
+    const auto size = mb->size;
+    const auto freeFunc = mb->freeFunc();
+    ccb->setCallback(IOCB_WRITE, callback, mb->buf, freeFunc, size + more.size());
+    ccb->more = more;
+    ccb->moreOffset = size;
+    ccb->selectOrQueueWrite();
+}
+
+void
+Comm::WriteFile(const Comm::ConnectionPointer &conn, const int fileFd, const off_t fileOffset, const int size, AsyncCall::Pointer &callback)
+{
+    debugs(5, 5, conn << ": file FD " << fileFd << " offset " << fileOffset << ": sz " << size << ": asynCall " << callback);
+
+    assert(WriteFileSupported());
+    assert(fileFd >= 0);
+
+    /* Make sure we are open, not closing, and not writing */
+    assert(fd_table[conn->fd].flags.open);
+    assert(!fd_table[conn->fd].closing());
+    assert(fd_table[conn->fd].usesDefaultIo());
+    Comm::IoCallback *ccb = COMMIO_FD_WRITECB(conn->fd);
+    assert(!ccb->active());
+
+    fd_table[conn->fd].writeStart = squid_curtime;
+    commScheduleTimeoutCheck(conn->fd, squid_curtime + Config.Timeout.write);
+    ccb->conn = conn;
+    /* Queue the write */
+    ccb->setCallback(IOCB_WRITE, callback, nullptr, nullptr, size);
+    ccb->fileFd = fileFd;
+    ccb->fileOffset = fileOffset;
+    ccb->selectOrQueueWrite();
+}
+
+bool
+Comm::WriteFileSupported()
+{
+#if HAVE_SENDFILE && HAVE_SYS_SENDFILE_H
+    return true;
+#else
+    return false;
+#endif
+}
+
+void
+Comm::Write(const Comm::ConnectionPointer &conn, AsyncCall::Pointer &callback)
+{
+    Comm::Write(conn, nullptr, 0, callback, nullptr);
+}
+
+/// Writes up to nleft bytes of a vectored write, starting at state.offset.
+/// \returns the number of bytes written, like write(2) does
+static int
+WriteVectorNow(const int fd, const Comm::IoCallback &state, const int nleft)
+{
+    struct iovec pending[1 + Comm::WriteVector::Max];
+    int pendingCount = 0;
+    size_t budget = nleft;
+
+    // the first segment is the buffer part preceding the extra buffers
+    if (state.offset < state.moreOffset) {
+        const auto len = std::min<size_t>(state.moreOffset - state.offset, budget);
+        pending[pendingCount].iov_base = state.buf + state.offset;
+        pending[pendingCount].iov_len = len;
+        ++pendingCount;
+        budget -= len;
+    }
+
+    auto skip = state.offset > state.moreOffset ? static_cast<size_t>(state.offset - state.moreOffset) : 0;
+    for (int i = 0; i < state.more.count && budget > 0; ++i) {
+        const auto &segment = state.more.segments[i];
+        if (skip >= segment.size) {
+            skip -= segment.size;
+            continue;
+        }
+        const auto len = std::min(segment.size - skip, budget);
+        pending[pendingCount].iov_base = const_cast<char *>(segment.buf) + skip;
+        pending[pendingCount].iov_len = len;
+        ++pendingCount;
+        budget -= len;
+        skip = 0;
+    }
+
+    if (!pendingCount)
+        return FD_WRITE_METHOD(fd, state.buf, 0);
+
+#if HAVE_WRITEV
+    // TLS and other I/O layers only accept one buffer at a time
+    if (pendingCount > 1 && fd_table[fd].usesDefaultIo())
+        return writev(fd, pending, pendingCount);
+#endif
+
+    return FD_WRITE_METHOD(fd, static_cast<char *>(pending[0].iov_base), pending[0].iov_len);
+}
+
+/// Writes up to nleft file bytes, starting at state.offset, using sendfile(2).
+/// \returns the number of bytes written, like write(2) does
+static int
+WriteFileNow(const int fd, const Comm::IoCallback &state, const int nleft)
+{
+#if HAVE_SENDFILE && HAVE_SYS_SENDFILE_H
+    off_t fileOffset = state.fileOffset + state.offset;
+    return sendfile(fd, state.fileFd, &fileOffset, nleft);
+#else
+    (void)fd;
+    (void)state;
+    (void)nleft;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
 /** Write to FD.
  * This function is used by the lowest level of IO loop which only has access to FD numbers.
  * We have to use the Comm::ioCallbacks() to map FD numbers to waiting data and Comm::Connections.
@@ -73,14 +229,29 @@ Comm::HandleWrite(int fd, void *data)
         assert(bucket->selectWaiting);
         bucket->selectWaiting = false;
         if (nleft > 0 && !bucket->applyQuota(nleft, state)) {
+            // message delay pools resume this write; see checkTimeouts()
+            if (fd_table[fd].writeQuotaHandler)
+                commScheduleTimeoutCheck(fd, squid_curtime + 1);
             return;
         }
     }
 #endif /* USE_DELAY_POOLS */
 
+    // Without a buffer or a file, just call back.
+    // The callee may write the data itself.
+    if (!state->buf && state->fileFd < 0) {
+        state->finish(Comm::OK, 0);
+        return;
+    }
+
     /* actually WRITE data */
     int xerrno = errno = 0;
-    len = FD_WRITE_METHOD(fd, state->buf + state->offset, nleft);
+    if (state->fileFd >= 0)
+        len = WriteFileNow(fd, *state, nleft);
+    else if (state->more.count)
+        len = WriteVectorNow(fd, *state, nleft);
+    else
+        len = FD_WRITE_METHOD(fd, state->buf + state->offset, nleft);
     xerrno = errno;
     debugs(5, 5, "write() returns " << len);
 
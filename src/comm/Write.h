@@ -13,10 +13,42 @@
 #include "comm/forward.h"
 #include "mem/forward.h"
 
+#include <cstddef>
+
 class MemBuf;
 namespace Comm
 {
 
+/// Extra buffers written by a single vectored Comm::Write(), in order.
+/// The buffers are not copied; they must remain valid until the write
+/// callback is called or the write is cancelled.
+class WriteVector
+{
+public:
+    /// the maximum number of extra buffers
+    static const int Max = 4;
+
+    /// appends a buffer to the vector; empty buffers are ignored
+    void add(const char *buf, size_t size);
+
+    /// forgets all buffers
+    void clear() { count = 0; }
+
+    /// the total number of bytes in all buffers
+    size_t size() const;
+
+    /// a buffer to write
+    class Segment
+    {
+    public:
+        const char *buf = nullptr;
+        size_t size = 0;
+    };
+
+    Segment segments[Max];
+    int count = 0; ///< the number of used segments[] entries
+};
+
 /**
  * Queue a write. callback is scheduled when the write
  * completes, on error, or on file descriptor close.
@@ -31,6 +63,37 @@ void Write(const Comm::ConnectionPointer &conn, const char *buf, int size, Async
  */
 void Write(const Comm::ConnectionPointer &conn, MemBuf *mb, AsyncCall::Pointer &callback);
 
+/**
+ * Queue a write of mb contents followed by the given extra buffers, using
+ * a single writev(2) call where possible. callback is scheduled when all
+ * the bytes are written, on error, or on file descriptor close.
+ *
+ * Like Write(conn, mb, callback), takes over the mb buffer. The extra
+ * buffers are not copied.
+ */
+void Write(const Comm::ConnectionPointer &conn, MemBuf *mb, const WriteVector &more, AsyncCall::Pointer &callback);
+
+/**
+ * Queue a write of size bytes of an open file, starting at fileOffset,
+ * using sendfile(2). callback is scheduled when all the bytes are
+ * written, on error (including premature end of file), or on file
+ * descriptor close. The caller keeps fileFd open until then.
+ *
+ * Requires WriteFileSupported() and a socket without a custom I/O layer.
+ */
+void WriteFile(const Comm::ConnectionPointer &conn, int fileFd, off_t fileOffset, int size, AsyncCall::Pointer &callback);
+
+/// whether WriteFile() may be used on this platform
+bool WriteFileSupported();
+
+/**
+ * Start monitoring for write.
+ *
+ * callback is scheduled when the write is possible,
+ * or on file descriptor close.
+ */
+void Write(const Comm::ConnectionPointer &conn, AsyncCall::Pointer &callback);
+
 /// Cancel the write pending on FD. No action if none pending.
 void WriteCancel(const Comm::ConnectionPointer &conn, const char *reason);
 
@@ -24,6 +24,7 @@ namespace Comm
 class Connection;
 class ConnOpener;
 class TcpKeepAlive;
+class WriteVector;
 
 typedef RefCount<Comm::Connection> ConnectionPointer;
 
@@ -19,12 +19,14 @@
 #include "comm/ConnOpener.h"
 #include "comm/Loops.h"
 #include "comm/Read.h"
+#include "comm/UdpBatch.h"
 #include "comm/Write.h"
 #include "debug/Messages.h"
 #include "dlink.h"
 #include "dns/forward.h"
 #include "dns/rfc3596.h"
 #include "event.h"
+#include "fatal.h"
 #include "fd.h"
 #include "fde.h"
 #include "ip/tools.h"
@@ -229,6 +231,8 @@ static int ndots = 1;
 static dlink_list lru_list;
 static int event_queued = 0;
 static hash_table *idns_lookup_hash = nullptr;
+/// batched UDP I/O statistics for DNS sockets
+static Comm::UdpBatchStats DnsUdpBatchStats("DNS");
 
 /*
  * Notes on EDNS:
@@ -989,10 +993,13 @@ idnsSendQuery(idns_query * q)
             idnsSendQueryVC(q, nsn);
             x = y = 0;
         } else {
-            if (DnsSocketB >= 0 && nameservers[nsn].S.isIPv6())
+            if (DnsSocketB >= 0 && nameservers[nsn].S.isIPv6()) {
                 y = comm_udp_sendto(DnsSocketB, nameservers[nsn].S, q->buf, q->sz);
-            else if (DnsSocketA >= 0)
+                DnsUdpBatchStats.countSent(y >= 0 ? 1 : 0);
+            } else if (DnsSocketA >= 0) {
                 x = comm_udp_sendto(DnsSocketA, nameservers[nsn].S, q->buf, q->sz);
+                DnsUdpBatchStats.countSent(x >= 0 ? 1 : 0);
+            }
         }
         int xerrno = errno;
 
@@ -1320,10 +1327,8 @@ static void
 idnsRead(int fd, void *)
 {
     int *N = &incoming_sockets_accepted;
-    int len;
     int max = INCOMING_DNS_MAX;
-    static char rbuf[SQUID_UDP_SO_RCVBUF];
-    Ip::Address from;
+    static Comm::UdpReceiveRing ring(SQUID_UDP_SO_RCVBUF, DnsUdpBatchStats);
 
     debugs(78, 3, "idnsRead: starting with FD " << fd);
 
@@ -1331,25 +1336,10 @@ idnsRead(int fd, void *)
     // attacks on the DNS client.
     Comm::SetSelect(fd, COMM_SELECT_READ, idnsRead, nullptr, 0);
 
-    /* BUG (UNRESOLVED)
-     *  two code lines after returning from comm_udprecvfrom()
-     *  something overwrites the memory behind the from parameter.
-     *  NO matter where in the stack declaration list above it is placed
-     *  The cause of this is still unknown, however copying the data appears
-     *  to allow it to be passed further without this erasure.
-     */
-    Ip::Address bugbypass;
-
-    while (max) {
-        --max;
-        len = comm_udp_recvfrom(fd, rbuf, SQUID_UDP_SO_RCVBUF, 0, bugbypass);
-
-        from = bugbypass; // BUG BYPASS. see notes above.
-
-        if (len == 0)
-            break;
+    while (max > 0) {
+        const auto received = ring.receive(fd, max);
 
-        if (len < 0) {
+        if (received < 0) {
             int xerrno = errno;
             if (ignoreErrno(xerrno))
                 break;
@@ -1366,38 +1356,50 @@ idnsRead(int fd, void *)
             break;
         }
 
-        fd_bytes(fd, len, IoDirection::Read);
+        max -= received;
 
-        assert(N);
-        ++(*N);
+        for (int i = 0; i < received; ++i) {
+            const int len = ring.size(i);
+            if (!len)
+                continue;
 
-        debugs(78, 3, "idnsRead: FD " << fd << ": received " << len << " bytes from " << from);
+            const auto &from = ring.from(i);
 
-        /* BUG: see above. Its here that it becomes apparent that the content of bugbypass is gone. */
-        int nsn = idnsFromKnownNameserver(from);
+            fd_bytes(fd, len, IoDirection::Read);
 
-        if (nsn >= 0) {
-            ++ nameservers[nsn].nreplies;
-        }
+            assert(N);
+            ++(*N);
 
-        // Before unknown_nameservers check to avoid flooding cache.log on attacks,
-        // but after the ++ above to keep statistics right.
-        if (!lru_list.head)
-            continue; // Don't process replies if there is no pending query.
+            debugs(78, 3, "idnsRead: FD " << fd << ": received " << len << " bytes from " << from);
 
-        if (nsn < 0 && Config.onoff.ignore_unknown_nameservers) {
-            static time_t last_warning = 0;
+            int nsn = idnsFromKnownNameserver(from);
 
-            if (squid_curtime - last_warning > 60) {
-                debugs(78, DBG_IMPORTANT, "WARNING: Reply from unknown nameserver " << from);
-                last_warning = squid_curtime;
-            } else {
-                debugs(78, DBG_IMPORTANT, "WARNING: Reply from unknown nameserver " << from << " (retrying..." <<  (squid_curtime-last_warning) << "<=60)" );
+            if (nsn >= 0) {
+                ++ nameservers[nsn].nreplies;
             }
-            continue;
+
+            // Before unknown_nameservers check to avoid flooding cache.log on attacks,
+            // but after the ++ above to keep statistics right.
+            if (!lru_list.head)
+                continue; // Don't process replies if there is no pending query.
+
+            if (nsn < 0 && Config.onoff.ignore_unknown_nameservers) {
+                static time_t last_warning = 0;
+
+                if (squid_curtime - last_warning > 60) {
+                    debugs(78, DBG_IMPORTANT, "WARNING: Reply from unknown nameserver " << from);
+                    last_warning = squid_curtime;
+                } else {
+                    debugs(78, DBG_IMPORTANT, "WARNING: Reply from unknown nameserver " << from << " (retrying..." <<  (squid_curtime-last_warning) << "<=60)" );
+                }
+                continue;
+            }
+
+            idnsGrokReply(ring.data(i), len, nsn);
         }
 
-        idnsGrokReply(rbuf, len, nsn);
+        if (ring.drained())
+            break;
     }
 }
 
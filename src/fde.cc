@@ -44,6 +44,12 @@ fde::useDefaultIo()
     writeMethod_ = default_write_method;
 }
 
+bool
+fde::usesDefaultIo() const
+{
+    return readMethod_ == default_read_method && writeMethod_ == default_write_method;
+}
+
 /// use I/O methods that maintain an internal-to-them buffer
 void
 fde::useBufferedIo(READ_HANDLER *bufferingReader, WRITE_HANDLER *bufferingWriter)
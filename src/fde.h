@@ -84,6 +84,10 @@ public:
     /// use I/O methods that maintain an internal-to-them buffer
     void useBufferedIo(READ_HANDLER *, WRITE_HANDLER *);
 
+    /// whether socket bytes go through default I/O methods, unseen by any
+    /// buffering or transforming (e.g., TLS) I/O layer
+    bool usesDefaultIo() const;
+
     int read(int fd, char *buf, int len) { return readMethod_(fd, buf, len); }
     int write(int fd, const char *buf, int len) { return writeMethod_(fd, buf, len); }
 
@@ -129,6 +133,8 @@ public:
         bool transparent = false;
         /// whether comm_reset_close() (or old_comm_reset_close()) has been called
         bool harshClosureRequested = false;
+        /// whether we asked the kernel to send data with our SYN
+        bool tcpFastOpen = false;
     } flags;
 
     int64_t bytes_read = 0;
@@ -10,9 +10,16 @@
 
 #include "squid.h"
 #include "fs/rock/RockDbCell.h"
+#include "store_key_md5.h"
 
 Rock::DbCellHeader::DbCellHeader()
 {
     memset(this, 0, sizeof(*this));
 }
 
+Rock::DbHeader::DbHeader()
+{
+    memset(this, 0, sizeof(*this));
+    keyHash = storeKeyHash();
+}
+
@@ -46,6 +46,20 @@ public:
     sfileno nextSlot; ///< slot ID of the next slot occupied by the entry
 };
 
+/** \ingroup Rock
+ * Meta-information at the beginning of the db file header area (see
+ * SwapDir::HeaderSize). Stored on disk so it must remain POD. Db files
+ * created before this class existed have an all-zeros header.
+ */
+class DbHeader
+{
+public:
+    /// describes a db created by this Squid instance now
+    DbHeader();
+
+    uint32_t keyHash; ///< KeyHash used for slot and entry keys
+};
+
 } // namespace Rock
 
 #endif /* SQUID_SRC_FS_ROCK_ROCKDBCELL_H */
@@ -0,0 +1,422 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 47    Store Directory Routines */
+
+#include "squid.h"
+#include "compat/unistd.h"
+#include "debug/Stream.h"
+#include "event.h"
+#include "fatal.h"
+#include "fs/rock/RockIndexCheckpoint.h"
+#include "fs/rock/RockSwapDir.h"
+#include "globals.h"
+#include "sbuf/Stream.h"
+#include "Store.h"
+#include "store_key_md5.h"
+#include "time/gadgets.h"
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#if HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+/// IndexCheckpointHeader::magic value
+static const char CheckpointMagic[16] = "Squid rock idx";
+/// IndexJournalHeader::magic value
+static const char JournalMagic[16] = "Squid rock jrnl";
+
+/// the time saving steps may take before yielding to other work
+static const int MaxStepMsec = 50;
+
+/// how often to check whether a periodic save is due
+static const double PeriodicSaveCheckDelay = 10;
+
+// the file format does not depend on the compiler
+static_assert(sizeof(Rock::IndexCheckpointHeader) == 48, "no checkpoint header padding");
+static_assert(sizeof(Rock::IndexCheckpointEntry) == 64, "no checkpoint entry padding");
+static_assert(sizeof(Rock::IndexCheckpointSlice) == 8, "no checkpoint slice padding");
+static_assert(sizeof(std::atomic<uint8_t>) == 1, "one journal byte per range");
+
+Rock::IndexCheckpoint::IndexCheckpoint(SwapDir &aDir):
+    sd(aDir),
+    checkpointPath(ToSBuf(aDir.filePath, ".index")),
+    journalPath(ToSBuf(aDir.filePath, ".journal"))
+{
+}
+
+Rock::IndexCheckpoint::~IndexCheckpoint()
+{
+    eventDelete(&SaveSteps, this);
+    eventDelete(&PeriodicSave, this);
+    if (savingFile) {
+        fclose(savingFile);
+        (void)unlink(ToSBuf(checkpointPath, ".new").c_str());
+    }
+    if (journal)
+        munmap(journal, journalSize);
+}
+
+void
+Rock::IndexCheckpoint::Forget(const SwapDir &dir)
+{
+    (void)unlink(ToSBuf(dir.filePath, ".index").c_str());
+    (void)unlink(ToSBuf(dir.filePath, ".journal").c_str());
+}
+
+void
+Rock::IndexCheckpoint::init(const bool responsible)
+{
+    const auto rangeCount = (sd.slotLimitActual() + SlotsPerRange - 1) / SlotsPerRange;
+    journalSize = sizeof(IndexJournalHeader) + rangeCount;
+
+    // all kids share the same file, so it is created (and sized) but never
+    // replaced; the responsible kid initializes its header
+    auto path = journalPath;
+    const auto fd = xopen(path.c_str(), O_RDWR | O_CREAT | O_BINARY, 0600);
+    if (fd < 0) {
+        const auto xerrno = errno;
+        fatalf("cannot open rock cache_dir index journal %s: %s", path.c_str(), xstrerr(xerrno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (static_cast<size_t>(st.st_size) != journalSize && ftruncate(fd, journalSize) != 0)) {
+        const auto xerrno = errno;
+        fatalf("cannot resize rock cache_dir index journal %s: %s", path.c_str(), xstrerr(xerrno));
+    }
+
+    const auto mem = mmap(nullptr, journalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        const auto xerrno = errno;
+        fatalf("cannot mmap rock cache_dir index journal %s: %s", path.c_str(), xstrerr(xerrno));
+    }
+    xclose(fd);
+
+    journal = static_cast<IndexJournalHeader*>(mem);
+    ranges = reinterpret_cast<std::atomic<uint8_t>*>(static_cast<char*>(mem) + sizeof(IndexJournalHeader));
+
+    if (!responsible)
+        return;
+
+    if (journal->rangeCount != static_cast<uint64_t>(rangeCount) || memcmp(journal->magic, JournalMagic, sizeof(JournalMagic)) != 0) {
+        // a new or resized db; no checkpoint can match this journal
+        journal->generation = 0;
+        memcpy(journal->magic, JournalMagic, sizeof(JournalMagic));
+        journal->rangeCount = rangeCount;
+        for (int64_t i = 0; i < rangeCount; ++i)
+            ranges[i] = 1;
+    }
+
+    registerRunner();
+    savingStart = squid_curtime;
+    eventAdd("Rock::IndexCheckpoint::PeriodicSave", &PeriodicSave, this, PeriodicSaveCheckDelay, 1, false);
+}
+
+/// marks the given journal range and waits for the mark to reach the disk
+void
+Rock::IndexCheckpoint::syncRangeMark(std::atomic<uint8_t> &range)
+{
+    // another kid may be flushing the same mark; we still wait for it
+    uint8_t expected = 0;
+    (void)range.compare_exchange_strong(expected, RangeMarked);
+    if (syncJournal(&range, sizeof(range)))
+        range = RangeSynced;
+}
+
+/// flushes the given mapped journal bytes to disk
+/// \returns whether the flush succeeded
+bool
+Rock::IndexCheckpoint::syncJournal(const void * const start, const size_t size)
+{
+    static const auto pageSize = static_cast<size_t>(getpagesize());
+    const auto base = reinterpret_cast<char*>(journal);
+    const auto offset = static_cast<size_t>(static_cast<const char*>(start) - base);
+    const auto pageOffset = offset / pageSize * pageSize; // msync(2) needs page alignment
+    if (msync(base + pageOffset, offset + size - pageOffset, MS_SYNC) != 0) {
+        const auto xerrno = errno;
+        debugs(47, DBG_IMPORTANT, "ERROR: Cannot flush cache_dir #" << sd.index << " index journal " << journalPath <<
+               Debug::Extra << "msync(2) error: " << xstrerr(xerrno));
+        return false;
+    }
+    return true;
+}
+
+FILE *
+Rock::IndexCheckpoint::openForLoading() const
+{
+    auto path = checkpointPath;
+    const auto file = fopen(path.c_str(), "rb");
+    if (!file) {
+        const auto xerrno = errno;
+        debugs(47, (xerrno == ENOENT ? 2 : DBG_IMPORTANT), "WARNING: Cannot open cache_dir #" << sd.index <<
+               " index checkpoint " << path << Debug::Extra << "fopen(3) error: " << xstrerr(xerrno));
+        return nullptr;
+    }
+
+    const char *problem = nullptr;
+    IndexCheckpointHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, CheckpointMagic, sizeof(CheckpointMagic)) != 0)
+        problem = "unsupported file format";
+    else if (header.keyHash != static_cast<uint32_t>(storeKeyHash()))
+        problem = "different store_key_hash";
+    else if (header.slotSize != sd.slotSize || header.slotLimit != sd.slotLimitActual() || header.entryLimit != sd.entryLimitActual())
+        problem = "different cache_dir size or slot-size";
+    else if (!header.generation || header.generation != journal->generation)
+        problem = "stale checkpoint";
+
+    if (problem) {
+        debugs(47, DBG_IMPORTANT, "WARNING: Ignoring cache_dir #" << sd.index << " index checkpoint " << path <<
+               Debug::Extra << "problem: " << problem);
+        fclose(file);
+        return nullptr;
+    }
+
+    return file;
+}
+
+void
+Rock::IndexCheckpoint::PeriodicSave(void *data)
+{
+    const auto checkpoint = static_cast<IndexCheckpoint*>(data);
+    const auto period = checkpoint->sd.indexCheckpointPeriod;
+    if (period > 0 && !checkpoint->savingFile && squid_curtime - checkpoint->savingStart >= period &&
+            checkpoint->startSaving())
+        eventAdd("Rock::IndexCheckpoint::SaveSteps", &SaveSteps, checkpoint, 0.01, 1, false);
+    eventAdd("Rock::IndexCheckpoint::PeriodicSave", &PeriodicSave, checkpoint, PeriodicSaveCheckDelay, 1, false);
+}
+
+/// starts a new journal generation and writes the checkpoint header
+/// \returns whether saveOne() may be called
+bool
+Rock::IndexCheckpoint::startSaving()
+{
+    Assure(!savingFile);
+    savingStart = squid_curtime;
+
+    // the existing checkpoint is usable until we modify the journal
+    if (!indexed) {
+        debugs(47, 3, "cache_dir #" << sd.index << " is not fully indexed yet");
+        return false;
+    }
+
+    auto temporaryPath = ToSBuf(checkpointPath, ".new");
+    savingFile = fopen(temporaryPath.c_str(), "wb");
+    if (!savingFile) {
+        const auto xerrno = errno;
+        debugs(47, DBG_IMPORTANT, "ERROR: Cannot save cache_dir #" << sd.index << " index checkpoint " << temporaryPath <<
+               Debug::Extra << "fopen(3) error: " << xstrerr(xerrno));
+        return false;
+    }
+
+    // Invalidate the old checkpoint and forget old changes. Slots written to
+    // from now on will be journaled as changes to the new checkpoint. Slots
+    // written to earlier either belong to complete entries that we are going
+    // to save or will not be referenced by the new checkpoint.
+    savingGeneration = std::max(journal->generation.load(), savingGeneration) + 1;
+    journal->generation = 0;
+    // the old checkpoint must stay disabled if we crash after clearing marks
+    if (!syncJournal(journal, sizeof(*journal))) {
+        finishSaving(false);
+        return false;
+    }
+    for (uint64_t i = 0; i < journal->rangeCount; ++i)
+        ranges[i] = 0;
+
+    debugs(47, 2, "saving cache_dir #" << sd.index << " index generation " << savingGeneration);
+    savingPos = 0;
+    saving = 0;
+
+    IndexCheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CheckpointMagic, sizeof(CheckpointMagic));
+    header.keyHash = static_cast<uint32_t>(storeKeyHash());
+    header.slotSize = sd.slotSize;
+    header.slotLimit = sd.slotLimitActual();
+    header.entryLimit = sd.entryLimitActual();
+    header.generation = savingGeneration;
+    if (fwrite(&header, sizeof(header), 1, savingFile) != 1) {
+        finishSaving(false);
+        return false;
+    }
+    return true;
+}
+
+void
+Rock::IndexCheckpoint::SaveSteps(void *data)
+{
+    static_cast<IndexCheckpoint*>(data)->saveSteps();
+}
+
+/// saves entries for a while, leaving the rest for later
+void
+Rock::IndexCheckpoint::saveSteps()
+{
+    const timeval loopStart = current_time;
+    while (saveOne()) {
+        getCurrentTime();
+        const auto elapsedMsec = tvSubMsec(loopStart, current_time);
+        if (elapsedMsec > MaxStepMsec || elapsedMsec < 0) {
+            eventAdd("Rock::IndexCheckpoint::SaveSteps", &SaveSteps, this, 0.01, 1, false);
+            return;
+        }
+    }
+}
+
+/// saves the entry at the next map position, if any
+/// \returns whether saving should continue
+bool
+Rock::IndexCheckpoint::saveOne()
+{
+    Assure(savingFile);
+
+    if (savingPos >= sd.map->entryLimit()) {
+        finishSaving(true);
+        return false;
+    }
+
+    const auto fileno = savingPos++;
+    const auto anchor = sd.map->openCompleteForReadingAt(fileno);
+    if (!anchor)
+        return true;
+
+    IndexCheckpointEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    memcpy(entry.key, anchor->key, sizeof(entry.key));
+    entry.timestamp = anchor->basics.timestamp;
+    entry.lastref = anchor->basics.lastref;
+    entry.expires = anchor->basics.expires;
+    entry.lastmod = anchor->basics.lastmod;
+    entry.swapFileSz = anchor->basics.swap_file_sz;
+    entry.refcount = anchor->basics.refcount;
+    entry.flags = anchor->basics.flags;
+
+    std::vector<IndexCheckpointSlice> slices;
+    auto sliceId = anchor->start.load();
+    // a read lock prevents chain modifications, but be paranoid about loops
+    for (auto slicesLeft = sd.map->sliceLimit(); sliceId >= 0 && slicesLeft > 0; --slicesLeft) {
+        const auto &slice = sd.map->readableSlice(fileno, sliceId);
+        slices.push_back(IndexCheckpointSlice{sliceId, slice.size.load()});
+        sliceId = slice.next;
+    }
+    sd.map->closeForReading(fileno);
+
+    if (sliceId >= 0) {
+        debugs(47, DBG_IMPORTANT, "WARNING: Not saving cache_dir #" << sd.index << " entry " << fileno << " with a slot chain loop");
+        return true;
+    }
+
+    entry.sliceCount = slices.size();
+    if (fwrite(&entry, sizeof(entry), 1, savingFile) != 1 ||
+            fwrite(slices.data(), sizeof(IndexCheckpointSlice), slices.size(), savingFile) != slices.size()) {
+        finishSaving(false);
+        return false;
+    }
+    ++saving;
+    return true;
+}
+
+/// flushes db file contents written by any kid to disk
+/// \returns whether the flush succeeded, setting errno on failures
+bool
+Rock::IndexCheckpoint::syncDb() const
+{
+    const auto fd = xopen(sd.filePath, O_RDONLY | O_BINARY);
+    if (fd < 0)
+        return false;
+#if HAVE_FDATASYNC
+    const auto synced = fdatasync(fd) == 0;
+#else
+    const auto synced = fsync(fd) == 0;
+#endif
+    const auto xerrno = errno;
+    xclose(fd);
+    errno = xerrno;
+    return synced;
+}
+
+/// closes the checkpoint being saved, replacing the old one on success
+void
+Rock::IndexCheckpoint::finishSaving(const bool success)
+{
+    Assure(savingFile);
+    auto temporaryPath = ToSBuf(checkpointPath, ".new");
+    auto failed = !success || ferror(savingFile);
+    int xerrno = errno;
+    // the new checkpoint must reach the disk before the journal refers to it
+    if (!failed && (fflush(savingFile) != 0 || fsync(fileno(savingFile)) != 0)) {
+        xerrno = errno;
+        failed = true;
+    }
+    // The checkpoint must not be newer than the db data it references: slots
+    // of saved entries may still sit in the OS page cache after pwrite(2).
+    if (!failed && !syncDb()) {
+        xerrno = errno;
+        failed = true;
+    }
+    if (fclose(savingFile) != 0 && !failed) {
+        xerrno = errno;
+        failed = true;
+    }
+    savingFile = nullptr;
+
+    auto path = checkpointPath;
+    if (!failed && rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        xerrno = errno;
+        failed = true;
+    }
+
+    if (failed) {
+        debugs(47, DBG_IMPORTANT, "ERROR: Cannot save cache_dir #" << sd.index << " index checkpoint " << path <<
+               Debug::Extra << "error: " << xstrerr(xerrno));
+        (void)unlink(temporaryPath.c_str());
+        return; // the journal generation stays zero, disabling the old checkpoint
+    }
+
+    // the new checkpoint is usable now
+    journal->generation = savingGeneration;
+    saved = saving;
+    lastSave = squid_curtime;
+    debugs(47, 2, "saved " << saved << " cache_dir #" << sd.index << " entries to " << path);
+}
+
+void
+Rock::IndexCheckpoint::endingShutdown()
+{
+    eventDelete(&SaveSteps, this);
+    if (!savingFile && !startSaving())
+        return;
+
+    // the main loop is about to stop; finish saving now
+    debugs(47, DBG_IMPORTANT, "Saving cache_dir #" << sd.index << " index checkpoint " << checkpointPath);
+    while (saveOne()) {}
+    debugs(47, DBG_IMPORTANT, "Saved " << saved << " cache_dir #" << sd.index << " entries");
+}
+
+void
+Rock::IndexCheckpoint::stat(StoreEntry &e) const
+{
+    uint64_t dirtyRanges = 0;
+    for (uint64_t i = 0; i < journal->rangeCount; ++i) {
+        if (ranges[i].load())
+            ++dirtyRanges;
+    }
+    storeAppendPrintf(&e, "Index checkpoint: %s\n", (savingFile ? "saving" : (journal->generation ? "usable" : "none")));
+    if (lastSave)
+        storeAppendPrintf(&e, "Index checkpoint saved: %" PRIu64 " entries at %s\n", saved, Time::FormatHttpd(lastSave));
+    storeAppendPrintf(&e, "Index journal: %" PRIu64 " out of %" PRIu64 " slot ranges modified\n",
+                      dirtyRanges, journal->rangeCount);
+}
+
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_FS_ROCK_ROCKINDEXCHECKPOINT_H
+#define SQUID_SRC_FS_ROCK_ROCKINDEXCHECKPOINT_H
+
+#include "base/RunnersRegistry.h"
+#include "fs/rock/forward.h"
+#include "sbuf/SBuf.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+namespace Rock
+{
+
+/// Meta-information at the beginning of an index checkpoint file. Stored on
+/// disk so it must remain POD.
+class IndexCheckpointHeader
+{
+public:
+    char magic[16]; ///< identifies index checkpoint files
+    uint32_t keyHash; ///< KeyHash used for entry keys
+    uint32_t slotSize; ///< db slot size, including DbCellHeader
+    int64_t slotLimit; ///< the number of db slots
+    int64_t entryLimit; ///< the maximum number of db entries
+    /// matches IndexJournalHeader::generation while the checkpoint is usable
+    uint64_t generation;
+};
+
+/// A checkpointed store entry (i.e. a StoreMapAnchor), followed by
+/// sliceCount IndexCheckpointSlice records describing its slot chain.
+/// Stored on disk so it must remain POD.
+class IndexCheckpointEntry
+{
+public:
+    uint64_t key[2]; ///< StoreEntry key
+    int64_t timestamp;
+    int64_t lastref;
+    int64_t expires;
+    int64_t lastmod;
+    uint64_t swapFileSz;
+    uint32_t sliceCount; ///< the number of slots in the entry chain
+    uint16_t refcount;
+    uint16_t flags;
+};
+
+/// one slot of a checkpointed entry chain (in chain order);
+/// stored on disk so it must remain POD
+class IndexCheckpointSlice
+{
+public:
+    SlotId slotId;
+    uint32_t size; ///< slot payload size
+};
+
+/// Meta-information at the beginning of an index journal file, followed by
+/// one byte for each range of SlotsPerRange db slots. A non-zero byte marks a
+/// range that may have been written to since the last index checkpoint (see
+/// IndexCheckpoint::RangeMarked and IndexCheckpoint::RangeSynced).
+class IndexJournalHeader
+{
+public:
+    char magic[16]; ///< identifies index journal files
+    uint64_t rangeCount; ///< the number of range bytes after this header
+    /// matches IndexCheckpointHeader::generation of the checkpoint that this
+    /// journal tracks changes for; zero while a new checkpoint is being saved
+    std::atomic<uint64_t> generation;
+};
+
+/// Maintains a compact copy of the rock cache_dir index (entry anchors and
+/// their slot chains) in an index checkpoint file, so that Rebuild does not
+/// have to read every db slot after a restart. The checkpoint is saved by the
+/// kid responsible for indexing the cache_dir, periodically and at shutdown.
+///
+/// All kids writing to the db record written slot ranges in a memory-mapped
+/// index journal file before writing. Rebuild trusts checkpointed entries
+/// located in unmodified ranges and reads slots in modified ranges from disk.
+/// To survive crashes, a range mark reaches the disk before the first db
+/// write to that range (in each checkpoint generation) is started.
+class IndexCheckpoint: private IndependentRunner
+{
+public:
+    /// the number of db slots covered by one journal byte
+    static const int64_t SlotsPerRange = 256;
+
+    explicit IndexCheckpoint(SwapDir &);
+    ~IndexCheckpoint() override;
+
+    /// removes the checkpoint and journal files of the given cache_dir
+    static void Forget(const SwapDir &);
+
+    /// maps the journal file; the responsible kid also starts periodic saves
+    void init(bool responsible);
+
+    /// a journal range byte value: the range mark may not be on disk yet
+    static const uint8_t RangeMarked = 2;
+    /// a journal range byte value: the range mark is on disk
+    static const uint8_t RangeSynced = 1;
+
+    /// marks the journal range containing the given slot; must be called
+    /// before writing to the slot
+    void noteSlotWrite(const SlotId slotId) {
+        auto &range = ranges[slotId / SlotsPerRange];
+        if (range.load() != RangeSynced)
+            syncRangeMark(range);
+    }
+
+    /// whether the given slot may have been written to since the checkpoint
+    bool dirty(const SlotId slotId) const { return ranges[slotId / SlotsPerRange].load(); }
+
+    /// opens the checkpoint file for Rebuild if it is consistent with our db
+    /// and journal, positioning it at the first IndexCheckpointEntry
+    /// \returns nil if the checkpoint cannot be used
+    FILE *openForLoading() const;
+
+    /// Rebuild has indexed all db slots; checkpoint saves may start
+    void noteIndexed() { indexed = true; }
+
+    /// reports checkpoint activity
+    void stat(StoreEntry &) const;
+
+protected:
+    /* RegisteredRunner API */
+    void endingShutdown() override;
+
+private:
+    static void SaveSteps(void *);
+    static void PeriodicSave(void *);
+
+    void syncRangeMark(std::atomic<uint8_t> &range);
+    bool syncJournal(const void *start, size_t size);
+    bool syncDb() const;
+
+    bool startSaving();
+    void saveSteps();
+    bool saveOne();
+    void finishSaving(bool success);
+
+    SwapDir &sd; ///< the cache_dir we checkpoint
+
+    const SBuf checkpointPath; ///< the index checkpoint file name
+    const SBuf journalPath; ///< the index journal file name
+
+    IndexJournalHeader *journal = nullptr; ///< the mapped journal file
+    std::atomic<uint8_t> *ranges = nullptr; ///< journal bytes after the header
+    size_t journalSize = 0; ///< the size of the mapped journal file
+
+    /// whether all db slots were indexed, making the index worth saving
+    bool indexed = false;
+
+    FILE *savingFile = nullptr; ///< checkpoint being saved (or nil)
+    uint64_t savingGeneration = 0; ///< the generation of the checkpoint being saved
+    sfileno savingPos = 0; ///< the next map position to save
+    uint64_t saving = 0; ///< the number of entries saved so far
+    time_t savingStart = 0; ///< when the last save started
+    uint64_t saved = 0; ///< the number of entries in the last saved checkpoint
+    time_t lastSave = 0; ///< when the last successful save finished
+};
+
+} // namespace Rock
+
+#endif /* SQUID_SRC_FS_ROCK_ROCKINDEXCHECKPOINT_H */
+
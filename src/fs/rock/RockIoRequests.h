@@ -29,6 +29,10 @@ public:
 
     /// identifies this read transaction for the requesting IoState
     IoXactionId id;
+
+    /// For IoState read-ahead requests, the buffer we are reading into. The
+    /// IoState may abandon the read-ahead before we are done with the buffer.
+    MemBlob::Pointer readAheadBuf;
 };
 
 class WriteRequest: public ::WriteRequest
@@ -14,6 +14,7 @@
 #include "DiskIO/DiskIOModule.h"
 #include "DiskIO/DiskIOStrategy.h"
 #include "DiskIO/WriteRequest.h"
+#include "fs/rock/RockIndexCheckpoint.h"
 #include "fs/rock/RockIoRequests.h"
 #include "fs/rock/RockIoState.h"
 #include "fs/rock/RockSwapDir.h"
@@ -22,6 +23,11 @@
 #include "Parsing.h"
 #include "Transients.h"
 
+#include <algorithm>
+
+/// the maximum number of entry slots read ahead of a reader
+static const size_t MaxReadAheadWindow = 8;
+
 Rock::IoState::IoState(Rock::SwapDir::Pointer &aDir,
                        StoreEntry *anEntry,
                        StoreIOState::STIOCB *cbIo,
@@ -40,7 +46,11 @@ Rock::IoState::IoState(Rock::SwapDir::Pointer &aDir,
     sidNext(-1),
     requestsSent(0),
     repliesReceived(0),
-    theBuf(dir->slotSize)
+    theBuf(dir->slotSize),
+    readAheadWindow(dir->readAheadUseful() ? 1 : 0),
+    readAheadReaderSid(-1),
+    readAheadWaitingBuf(nullptr),
+    readAheadWaitingLen(0)
 {
     e = anEntry;
     e->lock("rock I/O");
@@ -139,6 +149,13 @@ Rock::IoState::read_(char *buf, size_t len, off_t coreOff, STRCB *cb, void *data
     offset_ = coreOff;
     len = min(len,
               static_cast<size_t>(objOffset + currentReadableSlice().size - coreOff));
+
+    // slots of entries still being written may change after we read them
+    if (readAheadWindow && readAnchor().complete()) {
+        readWithReadAhead(buf, len);
+        return;
+    }
+
     const uint64_t diskOffset = dir->diskOffset(sidCurrent);
     const auto start = diskOffset + sizeof(DbCellHeader) + coreOff - objOffset;
     const auto id = ++requestsSent;
@@ -146,9 +163,125 @@ Rock::IoState::read_(char *buf, size_t len, off_t coreOff, STRCB *cb, void *data
     theFile->read(request);
 }
 
+/// satisfies the reader request for sidCurrent payload bytes at offset_,
+/// reading that slot and the next slots (if needed) into readAheads
+void
+Rock::IoState::readWithReadAhead(char *buf, const size_t len)
+{
+    // forget slots the reader is done with; start over after reader jumps
+    while (!readAheads.empty() && readAheads.front().sid != sidCurrent)
+        readAheads.pop_front();
+
+    if (sidCurrent != readAheadReaderSid) {
+        // the reader has moved to another slot; adapt to its speed
+        if (readAheadReaderSid >= 0) {
+            if (readAheads.empty() || !readAheads.front().finished)
+                readAheadWindow = min(readAheadWindow * 2, MaxReadAheadWindow); // the reader waits for us
+            else if (readAheads.back().finished && readAheadWindow > 1)
+                --readAheadWindow; // all our slots wait for the reader
+        }
+        readAheadReaderSid = sidCurrent;
+    }
+
+    if (readAheads.empty())
+        startReadAhead(sidCurrent, objOffset);
+
+    while (readAheads.size() <= readAheadWindow) {
+        const auto lastSid = readAheads.back().sid;
+        const auto lastObjOffset = readAheads.back().objOffset;
+        const auto &lastSlice = dir->map->readableSlice(swap_filen, lastSid);
+        if (lastSlice.next < 0)
+            break; // no more entry slots
+        if (!theFile->canReadAhead()) {
+            debugs(79, 5, "the disk is too busy to read slot " << lastSlice.next << " ahead for " << *e);
+            break; // the reader will try again when it needs the next slot
+        }
+        startReadAhead(lastSlice.next, lastObjOffset + lastSlice.size);
+    }
+
+    readAheadWaitingBuf = buf;
+    readAheadWaitingLen = len;
+    if (readAheads.front().finished)
+        callReaderBackWithReadAhead();
+    // else handleReadAheadCompletion() will call the reader back
+}
+
+/// starts reading the payload of the given entry slot into a new readAheads
+/// slot; sidObjOffset is the entry offset of the first slot payload byte
+void
+Rock::IoState::startReadAhead(const SlotId sid, const int64_t sidObjOffset)
+{
+    const size_t size = dir->map->readableSlice(swap_filen, sid).size;
+
+    ReadAhead readAhead;
+    readAhead.sid = sid;
+    readAhead.objOffset = sidObjOffset;
+    readAhead.id = ++requestsSent;
+    readAhead.buf = new MemBlob(size);
+    readAheads.push_back(readAhead);
+
+    debugs(79, 7, '#' << readAhead.id << " reads slot " << sid << " ahead for " << *e);
+    const auto start = dir->diskOffset(sid) + sizeof(DbCellHeader);
+    const auto request = new ReadRequest(::ReadRequest(readAhead.buf->mem, start, size), this, readAhead.id);
+    request->readAheadBuf = readAhead.buf;
+    theFile->read(request);
+}
+
+/// remembers read-ahead results and calls back the reader waiting for them
+void
+Rock::IoState::handleReadAheadCompletion(Rock::ReadRequest &request, const int rlen, const int errFlag)
+{
+    const auto failed = errFlag != DISK_OK || rlen < 0 || !expectedReply(request.id);
+
+    const auto readAhead = std::find_if(readAheads.begin(), readAheads.end(), [&request](const ReadAhead &r) {
+        return r.id == request.id;
+    });
+    if (readAhead == readAheads.end()) {
+        debugs(79, 5, "ignoring #" << request.id << " read ahead for a jumping reader of " << *e);
+        return;
+    }
+
+    debugs(79, 5, '#' << request.id << (failed ? " failed to read" : " read") << " slot " << readAhead->sid << " for " << *e);
+    readAhead->finished = true;
+    readAhead->failed = failed;
+    if (!failed)
+        readAhead->buf->appended(min(static_cast<size_t>(rlen), static_cast<size_t>(readAhead->buf->spaceSize())));
+
+    if (readAheadWaitingBuf && readAhead == readAheads.begin())
+        callReaderBackWithReadAhead();
+}
+
+/// gives the waiting reader the requested bytes from the first readAheads slot
+void
+Rock::IoState::callReaderBackWithReadAhead()
+{
+    const auto buf = readAheadWaitingBuf;
+    const auto len = readAheadWaitingLen;
+    readAheadWaitingBuf = nullptr;
+    readAheadWaitingLen = 0;
+
+    const auto &readAhead = readAheads.front();
+    assert(readAhead.finished);
+    if (readAhead.failed)
+        return callReaderBack(buf, -1);
+
+    const auto skip = static_cast<size_t>(offset_ - readAhead.objOffset);
+    const auto available = skip < readAhead.buf->size ? readAhead.buf->size - skip : 0;
+    const auto rlen = min(len, static_cast<size_t>(available));
+    if (rlen)
+        memcpy(buf, readAhead.buf->mem + skip, rlen);
+
+    debugs(79, 5, "got " << rlen << " bytes at " << offset_ << " from slot " << readAhead.sid << " for " << *e);
+    offset_ += rlen;
+    callReaderBack(buf, static_cast<int>(rlen));
+}
+
 void
 Rock::IoState::handleReadCompletion(Rock::ReadRequest &request, const int rlen, const int errFlag)
 {
+    if (request.readAheadBuf)
+        return handleReadAheadCompletion(request, rlen, errFlag);
+
     if (errFlag != DISK_OK || rlen < 0) {
         debugs(79, 3, errFlag << " failure for " << *e);
         return callReaderBack(request.buf, -1);
@@ -325,6 +458,10 @@ Rock::IoState::writeToDisk()
 
     theBuf.clear();
 
+    // Rebuild must not trust the index checkpoint for this slot
+    if (dir->indexCheckpoint)
+        dir->indexCheckpoint->noteSlotWrite(r->sidCurrent);
+
     // theFile->write may call writeCompleted immediately
     theFile->write(r);
 }
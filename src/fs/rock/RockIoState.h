@@ -13,6 +13,8 @@
 #include "fs/rock/RockSwapDir.h"
 #include "sbuf/MemBlob.h"
 
+#include <deque>
+
 class DiskFile;
 
 namespace Rock
@@ -67,6 +69,11 @@ private:
     Ipc::StoreMapAnchor &writeAnchor();
     const Ipc::StoreMapSlice &currentReadableSlice() const;
 
+    void readWithReadAhead(char *buf, size_t len);
+    void startReadAhead(SlotId sid, int64_t sidObjOffset);
+    void handleReadAheadCompletion(Rock::ReadRequest &request, const int rlen, const int errFlag);
+    void callReaderBackWithReadAhead();
+
     void tryWrite(char const *buf, size_t size, off_t offset);
     size_t writeToBuffer(char const *buf, size_t size);
     void writeToDisk();
@@ -102,6 +109,37 @@ private:
 
     RefCount<DiskFile> theFile; // "file" responsible for this I/O
     MemBlob theBuf; // use for write content accumulation only
+
+    /// A db slot payload read (or being read) before the reader asked for it.
+    /// Readers of complete entries get whole slots read ahead of them so that
+    /// reads of the next slots do not wait for earlier reads to complete.
+    class ReadAhead
+    {
+    public:
+        SlotId sid = -1; ///< the db slot being read
+        int64_t objOffset = 0; ///< entry offset of the first slot payload byte
+        IoXactionId id = 0; ///< the read request ID
+        MemBlob::Pointer buf; ///< the slot payload; shared with ReadRequest
+        bool finished = false; ///< whether theFile has responded
+        bool failed = false; ///< whether the read has failed
+    };
+
+    /// slots being read or already read for the reader, in slot chain order;
+    /// the first one (if any) is sidCurrent
+    std::deque<ReadAhead> readAheads;
+
+    /// The current maximum number of slots read ahead of sidCurrent (or zero
+    /// if read-ahead is disabled). Grows when the reader has to wait for disk
+    /// reads and shrinks when read-ahead slots wait for a slow reader.
+    size_t readAheadWindow;
+
+    /// the sidCurrent of the last reader request handled by readAheads
+    SlotId readAheadReaderSid;
+
+    /// the reader buffer waiting for the first readAheads slot (or nil)
+    char *readAheadWaitingBuf;
+    /// the size of readAheadWaitingBuf
+    size_t readAheadWaitingLen;
 };
 
 } // namespace Rock
@@ -13,6 +13,7 @@
 #include "compat/unistd.h"
 #include "debug/Messages.h"
 #include "fs/rock/RockDbCell.h"
+#include "fs/rock/RockIndexCheckpoint.h"
 #include "fs/rock/RockRebuild.h"
 #include "fs/rock/RockSwapDir.h"
 #include "fs_io.h"
@@ -21,8 +22,11 @@
 #include "sbuf/Stream.h"
 #include "SquidMath.h"
 #include "Store.h"
+#include "store/SwapMetaIn.h"
+#include "store_key_md5.h"
 #include "tools.h"
 
+#include <algorithm>
 #include <array>
 #include <cerrno>
 #include <cstring>
@@ -91,6 +95,28 @@ DoneValidating(const int64_t validationPos, const int64_t dbSlotLimit, const int
     return validationPos >= (dbEntryLimit + extraWork);
 }
 
+/// Balances our desire to maximize the number of items processed at once
+/// (and, hence, minimize overheads and total rebuild time) with a
+/// requirement to also process Coordinator events, disk I/Os, etc.
+/// \param processed the number of items processed since loopStart
+/// \returns whether the current processing loop may continue
+static bool
+KeepStepping(const timeval &loopStart, const int64_t processed)
+{
+    if (opt_foreground_rebuild)
+        return true; // skip "few items at a time" check below
+
+    const int maxSpentMsec = 50; // keep small: most RAM I/Os are under 1ms
+    getCurrentTime();
+    const double elapsedMsec = tvSubMsec(loopStart, current_time);
+    if (elapsedMsec > maxSpentMsec || elapsedMsec < 0) {
+        debugs(47, 5, "pausing after " << processed << " items in " <<
+               elapsedMsec << "ms; " << (elapsedMsec/processed) << "ms per item");
+        return false;
+    }
+    return true;
+}
+
 /// low-level anti-padding storage class for LoadingEntry and LoadingSlot flags
 class LoadingFlags
 {
@@ -271,10 +297,10 @@ Rock::Rebuild::Stats::completed(const SwapDir &dir) const
 /* Rebuild */
 
 bool
-Rock::Rebuild::IsResponsible(const SwapDir &)
+Rock::Rebuild::IsResponsible(const SwapDir &dir)
 {
-    // in SMP mode, only the disker is responsible for populating the map
-    return !UsingSmp() || IamDiskProcess();
+    // in SMP mode, only the (first) disker is responsible for populating the map
+    return !UsingSmp() || (IamDiskProcess() && KidIdentifier == dir.disker);
 }
 
 bool
@@ -309,6 +335,11 @@ Rock::Rebuild::Rebuild(SwapDir *dir, const Ipc::Mem::Pointer<Stats> &s): AsyncJo
     dbOffset(0),
     loadingPos(stats->counts.scancount),
     validationPos(stats->counts.validations),
+    checkpointFile(nullptr),
+    checkpointImported(0),
+    checkpointSkipped(0),
+    convertingKeys(false),
+    convertedFirstSlot(-1),
     counts(stats->counts),
     resuming(stats->counts.started())
 {
@@ -325,6 +356,8 @@ Rock::Rebuild::~Rebuild()
 {
     if (fd >= 0)
         file_close(fd);
+    if (checkpointFile)
+        fclose(checkpointFile);
     // normally, segments are used until the Squid instance quits,
     // but these indexing-only segments are no longer needed
     delete parts;
@@ -358,6 +391,22 @@ Rock::Rebuild::start()
     if (xread(fd, hdrBuf, sizeof(hdrBuf)) != SwapDir::HeaderSize)
         failure("cannot read db header", errno);
 
+    DbHeader dbHeader;
+    memcpy(&dbHeader, hdrBuf, sizeof(dbHeader));
+    if (dbHeader.keyHash != static_cast<uint32_t>(storeKeyHash())) {
+        debugs(47, DBG_IMPORTANT, "Converting " <<
+               storeKeyHashName(static_cast<KeyHash>(dbHeader.keyHash)) << " keys of cache_dir #" <<
+               sd->index << " to " << storeKeyHashName(storeKeyHash()) << " (store_key_hash)");
+        // we will rewrite slot headers
+        file_close(fd);
+        fd = file_open(sd->filePath, O_RDWR | O_BINARY);
+        if (fd < 0)
+            failure("cannot open db for key conversion", errno);
+        convertingKeys = true;
+        if (doneLoading()) // converted by our predecessor
+            finishKeyConversion();
+    }
+
     // slot prefix of SM_PAGE_SIZE should fit both core entry header and ours
     assert(sizeof(DbCellHeader) < SM_PAGE_SIZE);
     buf.init(SM_PAGE_SIZE, SM_PAGE_SIZE);
@@ -369,9 +418,47 @@ Rock::Rebuild::start()
 
     counts.updateStartTime(current_time);
 
+    startImporting();
+
     checkpoint();
 }
 
+/// opens the index checkpoint for importing if it can be used
+void
+Rock::Rebuild::startImporting()
+{
+    if (!sd->indexCheckpoint)
+        return;
+
+    if (!resuming) {
+        // key conversion rewrites slot headers without journaling them
+        if (convertingKeys)
+            return;
+
+        checkpointFile = sd->indexCheckpoint->openForLoading();
+        if (!checkpointFile)
+            return;
+
+        stats->usingCheckpoint = true;
+        stats->checkpointOffset = ftell(checkpointFile);
+        debugs(47, DBG_IMPORTANT, "Importing cache_dir #" << sd->index << " index checkpoint");
+        return;
+    }
+
+    if (!stats->usingCheckpoint || stats->checkpointOffset < 0)
+        return; // not using the checkpoint or done importing it
+
+    checkpointFile = sd->indexCheckpoint->openForLoading();
+    if (!checkpointFile || fseek(checkpointFile, stats->checkpointOffset, SEEK_SET) != 0) {
+        // the slots of entries we have not imported will be freed
+        debugs(47, DBG_IMPORTANT, "WARNING: Cannot resume importing cache_dir #" << sd->index << " index checkpoint");
+        if (checkpointFile)
+            finishImporting();
+        else
+            stats->checkpointOffset = -1;
+    }
+}
+
 /// continues after a pause if not done
 void
 Rock::Rebuild::checkpoint()
@@ -408,10 +495,15 @@ Rock::Rebuild::Steps(void *data)
 void
 Rock::Rebuild::steps()
 {
-    if (!doneLoading())
+    if (!doneImporting()) {
+        importingSteps();
+    } else if (!doneLoading()) {
         loadingSteps();
-    else
+        if (doneLoading() && convertingKeys)
+            finishKeyConversion();
+    } else {
         validationSteps();
+    }
 
     checkpoint();
 }
@@ -422,10 +514,6 @@ Rock::Rebuild::loadingSteps()
     debugs(47,5, sd->index << " slot " << loadingPos << " at " <<
            dbOffset << " <= " << dbSize);
 
-    // Balance our desire to maximize the number of entries processed at once
-    // (and, hence, minimize overheads and total rebuild time) with a
-    // requirement to also process Coordinator events, disk I/Os, etc.
-    const int maxSpentMsec = 50; // keep small: most RAM I/Os are under 1ms
     const timeval loopStart = current_time;
 
     int64_t loaded = 0;
@@ -438,17 +526,155 @@ Rock::Rebuild::loadingSteps()
         if (counts.scancount % 1000 == 0)
             storeRebuildProgress(sd->index, dbSlotLimit, counts.scancount);
 
-        if (opt_foreground_rebuild)
-            continue; // skip "few entries at a time" check below
+        if (!KeepStepping(loopStart, loaded))
+            break;
+    }
+}
+
+void
+Rock::Rebuild::importingSteps()
+{
+    const timeval loopStart = current_time;
+
+    int64_t imported = 0;
+    while (!doneImporting()) {
+        importOneEntry();
+        ++imported;
 
-        getCurrentTime();
-        const double elapsedMsec = tvSubMsec(loopStart, current_time);
-        if (elapsedMsec > maxSpentMsec || elapsedMsec < 0) {
-            debugs(47, 5, "pausing after " << loaded << " entries in " <<
-                   elapsedMsec << "ms; " << (elapsedMsec/loaded) << "ms per entry");
+        if (!KeepStepping(loopStart, imported))
             break;
+    }
+}
+
+/// imports the next index checkpoint entry, if any
+void
+Rock::Rebuild::importOneEntry()
+{
+    IndexCheckpointEntry entry;
+    const auto entrySize = fread(&entry, 1, sizeof(entry), checkpointFile);
+    if (!entrySize && feof(checkpointFile))
+        return finishImporting();
+
+    std::vector<IndexCheckpointSlice> slices;
+    if (entrySize == sizeof(entry) && 0 < entry.sliceCount && entry.sliceCount <= dbSlotLimit) {
+        slices.resize(entry.sliceCount);
+        if (fread(slices.data(), sizeof(IndexCheckpointSlice), slices.size(), checkpointFile) != slices.size())
+            slices.clear();
+    }
+
+    if (slices.empty()) {
+        debugs(47, DBG_IMPORTANT, "WARNING: cache_dir[" << sd->index << "]: " <<
+               "Ignoring the rest of the truncated or damaged index checkpoint");
+        return finishImporting();
+    }
+
+    // advance before importing to avoid getting stuck at an entry
+    // in a case of crash
+    stats->checkpointOffset = ftell(checkpointFile);
+
+    if (importCheckpointedEntry(entry, slices))
+        ++checkpointImported;
+    else
+        ++checkpointSkipped;
+}
+
+/// adds a checkpointed entry to the map if none of its slots have changed
+/// \returns whether the entry was added
+bool
+Rock::Rebuild::importCheckpointedEntry(const IndexCheckpointEntry &entry, const std::vector<IndexCheckpointSlice> &slices)
+{
+    const auto key = reinterpret_cast<const cache_key*>(entry.key);
+
+    uint64_t size = 0;
+    std::vector<SlotId> slotIds;
+    slotIds.reserve(slices.size());
+    for (const auto &slice: slices) {
+        if (!sd->validSlotId(slice.slotId) || !slice.size || slice.size > dbSlotSize - sizeof(DbCellHeader)) {
+            debugs(47, 3, "malformed slot " << slice.slotId << " of " << storeKeyText(key));
+            return false;
+        }
+
+        // the checkpoint may not describe modified slots correctly;
+        // loadingSteps() will load them from disk instead
+        if (sd->indexCheckpoint->dirty(slice.slotId)) {
+            debugs(47, 5, "modified slot " << slice.slotId << " of " << storeKeyText(key));
+            return false;
+        }
+
+        if (LoadingSlot(slice.slotId, *parts).used()) {
+            debugs(47, 3, "slot " << slice.slotId << " of " << storeKeyText(key) << " is already used");
+            return false;
         }
+
+        size += slice.size;
+        slotIds.push_back(slice.slotId);
+    }
+
+    std::sort(slotIds.begin(), slotIds.end());
+    if (std::adjacent_find(slotIds.begin(), slotIds.end()) != slotIds.end()) {
+        debugs(47, 3, "slot chain loop in " << storeKeyText(key));
+        return false;
+    }
+
+    if (size != entry.swapFileSz) {
+        debugs(47, 3, "size mismatch in " << storeKeyText(key) << ": " << size << " != " << entry.swapFileSz);
+        return false;
+    }
+
+    const auto fileno = sd->map->fileNoByKey(key);
+    LoadingEntry le = loadingEntry(fileno);
+    if (le.state() != LoadingEntry::leEmpty)
+        return false;
+
+    // a miss may have been stored at our fileno already
+    const bool overwriteExisting = false;
+    const auto anchor = sd->map->openForWritingAt(fileno, overwriteExisting);
+    if (!anchor) {
+        le.state(LoadingEntry::leIgnored);
+        return false;
     }
+
+    anchor->setKey(key);
+    anchor->basics.timestamp = entry.timestamp;
+    anchor->basics.lastref = entry.lastref;
+    anchor->basics.expires = entry.expires;
+    anchor->basics.lastmod = entry.lastmod;
+    anchor->basics.swap_file_sz = entry.swapFileSz;
+    anchor->basics.refcount = entry.refcount;
+    anchor->basics.flags = entry.flags;
+    EBIT_SET(anchor->basics.flags, ENTRY_VALIDATED);
+    anchor->start = slices.front().slotId;
+
+    for (size_t i = 0; i < slices.size(); ++i) {
+        LoadingSlot slot(slices[i].slotId, *parts);
+        slot.mapped(true);
+        slot.finalized(true);
+
+        Ipc::StoreMapSlice mapSlice;
+        mapSlice.size = slices[i].size;
+        mapSlice.next = i + 1 < slices.size() ? slices[i + 1].slotId : -1;
+        sd->map->importSlice(slices[i].slotId, mapSlice);
+    }
+
+    le.state(LoadingEntry::leLoaded);
+    le.anchored(true);
+    le.version = entry.timestamp;
+    le.size = size;
+    sd->map->closeForWriting(fileno);
+    ++counts.objcount;
+    return true;
+}
+
+/// stops importing the index checkpoint
+void
+Rock::Rebuild::finishImporting()
+{
+    fclose(checkpointFile);
+    checkpointFile = nullptr;
+    stats->checkpointOffset = -1;
+    debugs(47, DBG_IMPORTANT, "Imported cache_dir #" << sd->index << " index checkpoint" <<
+           Debug::Extra << "imported entries: " << checkpointImported <<
+           Debug::Extra << "ignored entries: " << checkpointSkipped);
 }
 
 Rock::LoadingEntry
@@ -476,6 +702,18 @@ Rock::Rebuild::loadOneSlot()
     // in a case of crash
     ++counts.scancount;
 
+    if (stats->usingCheckpoint) {
+        const SlotId slotId = loadingPos;
+        if (loadingSlot(slotId).mapped())
+            return; // imported from the index checkpoint
+
+        // unmodified slots that no imported entry uses are free
+        if (!sd->indexCheckpoint->dirty(slotId)) {
+            freeUnusedSlot(slotId, false);
+            return;
+        }
+    }
+
     if (lseek(fd, dbOffset, SEEK_SET) < 0)
         failure("cannot seek to db entry", errno);
 
@@ -508,9 +746,90 @@ Rock::Rebuild::loadOneSlot()
     }
     buf.consume(sizeof(header)); // optimize to avoid memmove()
 
+    if (convertingKeys && !convertSlotKey(slotId, header)) {
+        freeUnusedSlot(slotId, true);
+        return;
+    }
+
     useNewSlot(slotId, header);
 }
 
+/// Replaces the slot key computed using another store_key_hash algorithm,
+/// updating the slot header on disk. Keys of all entry slots are converted
+/// using the metadata in the first entry slot.
+/// \returns whether the slot key uses the configured algorithm now
+bool
+Rock::Rebuild::convertSlotKey(const SlotId slotId, DbCellHeader &header)
+{
+    uint64_t key[2];
+    memcpy(key, header.key, sizeof(key));
+
+    if (convertedFirstSlot == header.firstSlot && memcmp(key, convertedOldKey, sizeof(key)) == 0) {
+        memcpy(key, convertedNewKey, sizeof(key)); // a common case optimization
+    } else {
+        if (!convertKey(header.firstSlot, key)) {
+            debugs(47, 3, "cannot convert slot " << slotId << " key " << storeKeyText(reinterpret_cast<const cache_key*>(header.key)));
+            return false;
+        }
+        convertedFirstSlot = header.firstSlot;
+        memcpy(convertedOldKey, header.key, sizeof(convertedOldKey));
+        memcpy(convertedNewKey, key, sizeof(convertedNewKey));
+    }
+
+    if (memcmp(key, header.key, sizeof(key)) == 0)
+        return true; // already converted (e.g., before a restart)
+
+    memcpy(header.key, key, sizeof(header.key));
+    if (pwrite(fd, &header, sizeof(header), dbOffset) != static_cast<ssize_t>(sizeof(header)))
+        failure("cannot update db slot header", errno);
+    return true;
+}
+
+/// converts the given key of the entry starting at the given slot
+/// \returns whether the key uses the configured algorithm now
+bool
+Rock::Rebuild::convertKey(const SlotId firstSlot, uint64_t * const key)
+{
+    const auto cacheKey = reinterpret_cast<cache_key*>(key);
+
+    if (firstSlot == loadingPos) // the entry metadata is in our buffer
+        return Store::ConvertSwapMetaKey(buf.content(), buf.contentSize(), cacheKey);
+
+    // Load the entry metadata from the first slot. That slot may have been
+    // reused by another entry, but then our key will not match its metadata.
+    MemBuf firstBuf;
+    firstBuf.init(SM_PAGE_SIZE, SM_PAGE_SIZE);
+    const auto firstOffset = SwapDir::HeaderSize + firstSlot*dbSlotSize;
+    const auto loaded = pread(fd, firstBuf.space(), firstBuf.spaceSize(), firstOffset);
+    if (loaded < 0)
+        failure("cannot read the first slot of an entry", errno);
+    if (static_cast<size_t>(loaded) < sizeof(DbCellHeader))
+        return false;
+    firstBuf.appended(loaded);
+
+    DbCellHeader firstHeader;
+    memcpy(&firstHeader, firstBuf.content(), sizeof(firstHeader));
+    if (firstHeader.empty() || firstHeader.firstSlot != firstSlot)
+        return false;
+    firstBuf.consume(sizeof(firstHeader));
+    return Store::ConvertSwapMetaKey(firstBuf.content(), firstBuf.contentSize(), cacheKey);
+}
+
+/// records the configured store_key_hash in the db header after all slot
+/// keys were converted
+void
+Rock::Rebuild::finishKeyConversion()
+{
+    char hdrBuf[SwapDir::HeaderSize];
+    memset(hdrBuf, 0, sizeof(hdrBuf));
+    const DbHeader dbHeader;
+    memcpy(hdrBuf, &dbHeader, sizeof(dbHeader));
+    if (pwrite(fd, hdrBuf, sizeof(hdrBuf), 0) != SwapDir::HeaderSize)
+        failure("cannot update db header", errno);
+    convertingKeys = false;
+    debugs(47, DBG_IMPORTANT, "Converted keys of cache_dir #" << sd->index << " to " << storeKeyHashName(storeKeyHash()));
+}
+
 /// whether the given slot buffer is likely to have nothing but zeros, as is
 /// common to slots in pre-initialized (with zeros) db files
 static bool
@@ -562,8 +881,6 @@ Rock::Rebuild::validationSteps()
 {
     debugs(47, 5, sd->index << " validating from " << validationPos);
 
-    // see loadingSteps() for the rationale; TODO: avoid duplication
-    const int maxSpentMsec = 50; // keep small: validation does not do I/O
     const timeval loopStart = current_time;
 
     int64_t validated = 0;
@@ -581,16 +898,8 @@ Rock::Rebuild::validationSteps()
         if (validationPos % 1000 == 0)
             debugs(20, 2, "validated: " << validationPos);
 
-        if (opt_foreground_rebuild)
-            continue; // skip "few entries at a time" check below
-
-        getCurrentTime();
-        const double elapsedMsec = tvSubMsec(loopStart, current_time);
-        if (elapsedMsec > maxSpentMsec || elapsedMsec < 0) {
-            debugs(47, 5, "pausing after " << validated << " entries in " <<
-                   elapsedMsec << "ms; " << (elapsedMsec/validated) << "ms per entry");
+        if (!KeepStepping(loopStart, validated))
             break;
-        }
     }
 }
 
@@ -602,6 +911,7 @@ Rock::Rebuild::finalizeOrThrow(const sfileno fileNo, LoadingEntry &le)
     // walk all map-linked slots, starting from inode, and mark each
     Ipc::StoreMapAnchor &anchor = sd->map->writeableEntry(fileNo);
     Must(le.size > 0); // paranoid
+    Must(le.anchored()); // no entries without metadata
     uint64_t mappedSize = 0;
     SlotId slotId = anchor.start;
     while (slotId >= 0 && mappedSize < le.size) {
@@ -693,6 +1003,8 @@ Rock::Rebuild::swanSong()
 {
     debugs(47,3, "cache_dir #" << sd->index << " rebuild level: " <<
            StoreController::store_dirs_rebuilding);
+    if (doneLoading() && doneValidating() && sd->indexCheckpoint)
+        sd->indexCheckpoint->noteIndexed();
     storeRebuildComplete(&counts);
 }
 
@@ -18,9 +18,14 @@
 #include "MemBuf.h"
 #include "store_rebuild.h"
 
+#include <cstdio>
+#include <vector>
+
 namespace Rock
 {
 
+class IndexCheckpointEntry;
+class IndexCheckpointSlice;
 class LoadingEntry;
 class LoadingSlot;
 class LoadingParts;
@@ -46,18 +51,25 @@ public:
         bool completed(const SwapDir &) const;
 
         StoreRebuildData counts;
+
+        /// whether this rebuild uses the cache_dir index checkpoint
+        bool usingCheckpoint = false;
+        /// the index checkpoint file offset of the next entry to import or,
+        /// after all checkpointed entries were imported, -1
+        int64_t checkpointOffset = 0;
     };
 
     /// starts indexing the given cache_dir if that indexing is necessary
     /// \returns whether the indexing was necessary (and, hence, started)
     static bool Start(SwapDir &dir);
 
+    /// whether the current kid is responsible for rebuilding the given cache_dir
+    static bool IsResponsible(const SwapDir &);
+
     /* AsyncJob API */
     virtual void callException(const std::exception &) override;
 
 protected:
-    /// whether the current kid is responsible for rebuilding the given cache_dir
-    static bool IsResponsible(const SwapDir &);
 
     Rebuild(SwapDir *dir, const Ipc::Mem::Pointer<Stats> &);
     ~Rebuild() override;
@@ -70,12 +82,18 @@ protected:
     bool doneAll() const override;
     void swanSong() override;
 
+    bool doneImporting() const { return !checkpointFile; }
     bool doneLoading() const;
     bool doneValidating() const;
 
 private:
     void checkpoint();
     void steps();
+    void startImporting();
+    void importingSteps();
+    void importOneEntry();
+    bool importCheckpointedEntry(const IndexCheckpointEntry &, const std::vector<IndexCheckpointSlice> &);
+    void finishImporting();
     void loadingSteps();
     void validationSteps();
     void loadOneSlot();
@@ -93,6 +111,9 @@ private:
     void finalizeOrThrow(const sfileno fileNo, LoadingEntry &le);
     void addSlotToEntry(const sfileno fileno, const SlotId slotId, const DbCellHeader &header);
     void useNewSlot(const SlotId slotId, const DbCellHeader &header);
+    bool convertSlotKey(const SlotId slotId, DbCellHeader &header);
+    bool convertKey(const SlotId firstSlot, uint64_t *key);
+    void finishKeyConversion();
 
     LoadingSlot loadingSlot(const SlotId slotId);
     void mapSlot(const SlotId slotId, const DbCellHeader &header);
@@ -122,6 +143,17 @@ private:
     int64_t validationPos; ///< index of the loaded db slot being validated now
     MemBuf buf; ///< space to load current db slot (and entry metadata) into
 
+    FILE *checkpointFile; ///< index checkpoint being imported (or nil)
+    uint64_t checkpointImported; ///< the number of imported checkpoint entries
+    uint64_t checkpointSkipped; ///< the number of ignored checkpoint entries
+
+    /// whether slot keys were computed using another store_key_hash algorithm
+    bool convertingKeys;
+    /// the first slot of the last entry with a converted key (or -1)
+    SlotId convertedFirstSlot;
+    uint64_t convertedOldKey[2]; ///< convertedFirstSlot entry key before conversion
+    uint64_t convertedNewKey[2]; ///< convertedFirstSlot entry key after conversion
+
     StoreRebuildData &counts; ///< a reference to the shared memory counters
 
     /// whether we have started indexing this cache_dir before,
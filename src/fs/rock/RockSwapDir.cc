@@ -19,7 +19,9 @@
 #include "DiskIO/DiskIOStrategy.h"
 #include "DiskIO/ReadRequest.h"
 #include "DiskIO/WriteRequest.h"
+#include "fatal.h"
 #include "fs/rock/RockHeaderUpdater.h"
+#include "fs/rock/RockIndexCheckpoint.h"
 #include "fs/rock/RockIoRequests.h"
 #include "fs/rock/RockIoState.h"
 #include "fs/rock/RockSwapDir.h"
@@ -40,13 +42,14 @@
 #endif
 
 Rock::SwapDir::SwapDir(): ::SwapDir("rock"),
-    slotSize(HeaderSize), filePath(nullptr), map(nullptr), io(nullptr),
-    waitingForPage(nullptr)
+    slotSize(HeaderSize), filePath(nullptr), map(nullptr), indexCheckpoint(nullptr),
+    io(nullptr), waitingForPage(nullptr), indexCheckpointPeriod(-1)
 {
 }
 
 Rock::SwapDir::~SwapDir()
 {
+    delete indexCheckpoint;
     delete io;
     delete map;
     safe_free(filePath);
@@ -159,12 +162,12 @@ Rock::SwapDir::currentCount() const
     return map ? map->entryCount() : 0;
 }
 
-/// In SMP mode only the disker process reports stats to avoid
+/// In SMP mode only the (first) disker process reports stats to avoid
 /// counting the same stats by multiple processes.
 bool
 Rock::SwapDir::doReportStat() const
 {
-    return ::SwapDir::doReportStat() && (!UsingSmp() || IamDiskProcess());
+    return ::SwapDir::doReportStat() && (!UsingSmp() || (IamDiskProcess() && KidIdentifier == disker));
 }
 
 void
@@ -214,8 +217,8 @@ Rock::SwapDir::create()
     assert(path);
     assert(filePath);
 
-    if (UsingSmp() && !IamDiskProcess()) {
-        debugs (47,3, "disker will create in " << path);
+    if (UsingSmp() && !(IamDiskProcess() && KidIdentifier == disker)) {
+        debugs (47,3, "the first disker will create in " << path);
         return;
     }
 
@@ -245,6 +248,9 @@ Rock::SwapDir::create()
     if (swap < 0)
         createError("create");
 
+    // they describe the old db
+    IndexCheckpoint::Forget(*this);
+
 #if SLOWLY_FILL_WITH_ZEROS
     char block[1024];
     Must(maxSize() % sizeof(block) == 0);
@@ -254,15 +260,19 @@ Rock::SwapDir::create()
         if (xwrite(swap, block, sizeof(block)) != sizeof(block))
             createError("write");
     }
+    if (lseek(swap, 0, SEEK_SET) < 0)
+        createError("seek");
 #else
     if (ftruncate(swap, maxSize()) != 0)
         createError("truncate");
+#endif
 
     char header[HeaderSize];
     memset(header, '\0', sizeof(header));
+    const DbHeader dbHeader;
+    memcpy(header, &dbHeader, sizeof(dbHeader));
     if (xwrite(swap, header, sizeof(header)) != sizeof(header))
         createError("write");
-#endif
 
     xclose(swap);
 }
@@ -292,7 +302,17 @@ Rock::SwapDir::init()
     map = new DirMap(inodeMapPath());
     map->cleaner = this;
 
-    const char *ioModule = needsDiskStrand() ? "IpcIo" : "Blocking";
+    if (indexCheckpointPeriod >= 0) {
+        indexCheckpoint = new IndexCheckpoint(*this);
+        indexCheckpoint->init(Rebuild::IsResponsible(*this));
+    } else if (Rebuild::IsResponsible(*this)) {
+        // db changes will not be journaled, making any old checkpoint stale
+        IndexCheckpoint::Forget(*this);
+    }
+
+    // with a disker, fileConfig.ioUring affects disker I/O instead
+    const char *ioModule = needsDiskStrand() ? "IpcIo" :
+                           (fileConfig.ioUring ? "IoUring" : "Blocking");
     if (DiskIOModule *m = DiskIOModule::Find(ioModule)) {
         debugs(47,2, "Using DiskIO module: " << ioModule);
         io = m->createStrategy();
@@ -303,11 +323,27 @@ Rock::SwapDir::init()
         fatal("Rock Store missing a required DiskIO module");
     }
 
+    if (IamDiskProcess())
+        fileConfig.diskerIndex = KidIdentifier - disker;
+
     theFile = io->newFile(filePath);
     theFile->configure(fileConfig);
     theFile->open(O_RDWR, 0644, this);
 }
 
+bool
+Rock::SwapDir::readAheadUseful() const
+{
+    // blocking reads complete before the next read can be sent
+    return needsDiskStrand() || fileConfig.ioUring;
+}
+
+int
+Rock::SwapDir::diskStrandCount() const
+{
+    return fileConfig.diskers;
+}
+
 bool
 Rock::SwapDir::needsDiskStrand() const
 {
@@ -376,6 +412,9 @@ Rock::SwapDir::getOptionTree() const
         vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseSizeOption, &SwapDir::dumpSizeOption));
         vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseTimeOption, &SwapDir::dumpTimeOption));
         vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseRateOption, &SwapDir::dumpRateOption));
+        vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseIoEngineOption, &SwapDir::dumpIoEngineOption));
+        vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseDirectIoOption, &SwapDir::dumpDirectIoOption));
+        vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseDiskersOption, &SwapDir::dumpDiskersOption));
     } else {
         // we don't know how to handle copt, as it's not a ConfigOptionVector.
         // free it (and return nullptr)
@@ -389,6 +428,10 @@ bool
 Rock::SwapDir::allowOptionReconfigure(const char *const option) const
 {
     return strcmp(option, "slot-size") != 0 &&
+           strcmp(option, "index-checkpoint") != 0 &&
+           strcmp(option, "IOEngine") != 0 &&
+           strcmp(option, "direct-io") != 0 &&
+           strcmp(option, "diskers") != 0 &&
            ::SwapDir::allowOptionReconfigure(option);
 }
 
@@ -399,9 +442,13 @@ Rock::SwapDir::parseTimeOption(char const *option, const char *value, int reconf
     // TODO: ::SwapDir or, better, Config should provide time-parsing routines,
     // including time unit handling. Same for size and rate.
 
-    time_msec_t *storedTime;
+    // index-checkpoint is measured in seconds rather than milliseconds
+    time_msec_t *storedTime = nullptr;
+    int64_t *storedSeconds = nullptr;
     if (strcmp(option, "swap-timeout") == 0)
         storedTime = &fileConfig.ioTimeout;
+    else if (strcmp(option, "index-checkpoint") == 0)
+        storedSeconds = &indexCheckpointPeriod;
     else
         return false;
 
@@ -418,6 +465,17 @@ Rock::SwapDir::parseTimeOption(char const *option, const char *value, int reconf
         return false;
     }
 
+    if (storedSeconds) {
+        if (!reconfig)
+            *storedSeconds = parsedValue;
+        else if (*storedSeconds != parsedValue) {
+            debugs(3, DBG_IMPORTANT, "WARNING: cache_dir " << path << ' ' << option
+                   << " cannot be changed dynamically, value left unchanged: " <<
+                   *storedSeconds);
+        }
+        return true;
+    }
+
     const time_msec_t newTime = static_cast<time_msec_t>(parsedValue);
 
     if (!reconfig)
@@ -438,6 +496,9 @@ Rock::SwapDir::dumpTimeOption(StoreEntry * e) const
     if (fileConfig.ioTimeout)
         storeAppendPrintf(e, " swap-timeout=%" PRId64,
                           static_cast<int64_t>(fileConfig.ioTimeout));
+
+    if (indexCheckpointPeriod >= 0)
+        storeAppendPrintf(e, " index-checkpoint=%" PRId64, indexCheckpointPeriod);
 }
 
 /// parses rate-specific options; mimics ::SwapDir::optionObjectSizeParse()
@@ -537,6 +598,128 @@ Rock::SwapDir::dumpSizeOption(StoreEntry * e) const
     storeAppendPrintf(e, " slot-size=%" PRId64, slotSize);
 }
 
+/// parses the IOEngine option; mimics Fs::Ufs::UFSSwapDir::optionIOParse()
+bool
+Rock::SwapDir::parseIoEngineOption(char const *option, const char *value, int reconfig)
+{
+    if (strcmp(option, "IOEngine") != 0)
+        return false;
+
+    if (!value) {
+        self_destruct();
+        return false;
+    }
+
+    // diskers and other kids doing the actual disk I/O support these engines
+    bool ioUring = false;
+    if (strcasecmp(value, "IoUring") == 0) {
+        if (!DiskIOModule::Find(value)) {
+            debugs(3, DBG_CRITICAL, "FATAL: cache_dir " << path << ' ' << option << '=' << value <<
+                   " requires Squid built with the IoUring DiskIO module");
+            self_destruct();
+            return false;
+        }
+        ioUring = true;
+    } else if (strcasecmp(value, "Blocking") != 0) {
+        debugs(3, DBG_CRITICAL, "FATAL: cache_dir " << path << ' ' << option << " must be Blocking or IoUring but is: " << value);
+        self_destruct();
+        return false;
+    }
+
+    if (!reconfig)
+        fileConfig.ioUring = ioUring;
+    else if (fileConfig.ioUring != ioUring) {
+        debugs(3, DBG_IMPORTANT, "WARNING: cache_dir " << path << ' ' << option
+               << " cannot be changed dynamically, value left unchanged: " <<
+               (fileConfig.ioUring ? "IoUring" : "Blocking"));
+    }
+
+    return true;
+}
+
+/// reports the IOEngine option; mimics dumpTimeOption()
+void
+Rock::SwapDir::dumpIoEngineOption(StoreEntry * e) const
+{
+    if (fileConfig.ioUring)
+        storeAppendPrintf(e, " IOEngine=IoUring");
+}
+
+/// parses the direct-io option; mimics ::SwapDir::optionReadOnlyParse()
+bool
+Rock::SwapDir::parseDirectIoOption(char const *option, const char *value, int reconfig)
+{
+    if (strcmp(option, "direct-io") != 0)
+        return false;
+
+    const auto directIo = value ? (xatoi(value) != 0) : true;
+
+#if !defined(O_DIRECT)
+    if (directIo) {
+        debugs(3, DBG_CRITICAL, "FATAL: cache_dir " << path << ' ' << option <<
+               " requires O_DIRECT support that this OS lacks");
+        self_destruct();
+        return false;
+    }
+#endif
+
+    if (!reconfig)
+        fileConfig.directIo = directIo;
+    else if (fileConfig.directIo != directIo) {
+        debugs(3, DBG_IMPORTANT, "WARNING: cache_dir " << path << ' ' << option
+               << " cannot be changed dynamically, value left unchanged: " <<
+               (fileConfig.directIo ? "on" : "off"));
+    }
+
+    return true;
+}
+
+/// reports the direct-io option; mimics ::SwapDir::optionReadOnlyDump()
+void
+Rock::SwapDir::dumpDirectIoOption(StoreEntry * e) const
+{
+    if (fileConfig.directIo)
+        storeAppendPrintf(e, " direct-io");
+}
+
+/// parses the diskers option; mimics parseTimeOption()
+bool
+Rock::SwapDir::parseDiskersOption(char const *option, const char *value, int reconfig)
+{
+    if (strcmp(option, "diskers") != 0)
+        return false;
+
+    if (!value) {
+        self_destruct();
+        return false;
+    }
+
+    const auto parsedValue = xatoi(value);
+    if (parsedValue < 1) {
+        debugs(3, DBG_CRITICAL, "FATAL: cache_dir " << path << ' ' << option << " must be positive but is: " << parsedValue);
+        self_destruct();
+        return false;
+    }
+
+    if (!reconfig)
+        fileConfig.diskers = parsedValue;
+    else if (fileConfig.diskers != parsedValue) {
+        debugs(3, DBG_IMPORTANT, "WARNING: cache_dir " << path << ' ' << option
+               << " cannot be changed dynamically, value left unchanged: " <<
+               fileConfig.diskers);
+    }
+
+    return true;
+}
+
+/// reports the diskers option; mimics dumpTimeOption()
+void
+Rock::SwapDir::dumpDiskersOption(StoreEntry * e) const
+{
+    if (fileConfig.diskers != 1)
+        storeAppendPrintf(e, " diskers=%d", fileConfig.diskers);
+}
+
 /// check the results of the configuration; only level-0 debugging works here
 void
 Rock::SwapDir::validateOptions()
@@ -544,6 +727,12 @@ Rock::SwapDir::validateOptions()
     if (slotSize <= 0)
         fatal("Rock store requires a positive slot-size");
 
+    // O_DIRECT writes are padded to the alignment boundary (see DirectIoArea)
+    // and must not spill into the next db slot
+    if (fileConfig.directIo && slotSize % Ipc::Mem::PageAlignment() != 0)
+        fatalf("Rock cache_dir %s direct-io requires slot-size to be a multiple of %zu bytes; got: %" PRIu64,
+               path, Ipc::Mem::PageAlignment(), slotSize);
+
     const int64_t maxSizeRoundingWaste = 1024 * 1024; // size is configured in MB
     const int64_t slotSizeRoundingWaste = slotSize;
     const int64_t maxRoundingWaste =
@@ -609,6 +798,19 @@ Rock::SwapDir::canStore(const StoreEntry &e, int64_t diskSpaceNeeded, int &load)
     return true;
 }
 
+bool
+Rock::SwapDir::needsEvictionFor(const int64_t diskSpaceNeeded) const
+{
+    // unlike ufs, rock purges entries only when it runs out of free slots
+    return currentSize() + diskSpaceNeeded + sizeof(DbCellHeader) > maxSize();
+}
+
+bool
+Rock::SwapDir::peekAtVictim(cache_key * const key) const
+{
+    return map && map->peekAtVictim(key);
+}
+
 StoreIOState::Pointer
 Rock::SwapDir::createStoreIO(StoreEntry &e, StoreIOState::STIOCB * const cbIo, void * const cbData)
 {
@@ -824,8 +1026,11 @@ Rock::SwapDir::ioCompletedNotification()
            std::setw(7) << map->entryLimit() << " entries, and " <<
            std::setw(7) << map->sliceLimit() << " slots");
 
-    if (!Rebuild::Start(*this))
+    if (!Rebuild::Start(*this)) {
         storeRebuildComplete(nullptr);
+        if (indexCheckpoint)
+            indexCheckpoint->noteIndexed();
+    }
 }
 
 void
@@ -1079,6 +1284,9 @@ Rock::SwapDir::statfs(StoreEntry &e) const
         }
     }
 
+    if (indexCheckpoint)
+        indexCheckpoint->stat(e);
+
     storeAppendPrintf(&e, "Pending operations: %d out of %d\n",
                       store_open_disk_fd, Config.max_open_disk_fds);
 
@@ -1115,6 +1323,13 @@ Rock::SwapDir::hasReadableEntry(const StoreEntry &e) const
     return map->hasReadableEntry(reinterpret_cast<const cache_key*>(e.key));
 }
 
+/// lets asynchronous DiskIO modules submit queued I/O and report completions
+int
+Rock::SwapDir::callback()
+{
+    return io ? io->callback() : 0;
+}
+
 DefineRunnerRegistratorIn(Rock, SwapDirRr);
 
 void Rock::SwapDirRr::create()
@@ -53,6 +53,7 @@ public:
     void parse(int index, char *path) override;
     bool smpAware() const override { return true; }
     bool hasReadableEntry(const StoreEntry &) const override;
+    int callback() override;
 
     // temporary path to the shared memory map of first slots of cached entries
     SBuf inodeMapPath() const;
@@ -73,6 +74,10 @@ public:
     /// purges one or more entries to make full() false and free some slots
     void purgeSome();
 
+    /// whether readers may benefit from IoState reading entry slots ahead of
+    /// them, in parallel (i.e. whether our db reads are asynchronous)
+    bool readAheadUseful() const;
+
     int64_t diskOffset(Ipc::Mem::PageId &pageId) const;
     int64_t diskOffset(int filen) const;
     void writeError(StoreIOState &sio);
@@ -89,10 +94,13 @@ protected:
 
     /* protected ::SwapDir API */
     bool needsDiskStrand() const override;
+    int diskStrandCount() const override;
     void init() override;
     ConfigOption *getOptionTree() const override;
     bool allowOptionReconfigure(const char *const option) const override;
     bool canStore(const StoreEntry &e, int64_t diskSpaceNeeded, int &load) const override;
+    bool needsEvictionFor(int64_t diskSpaceNeeded) const override;
+    bool peekAtVictim(cache_key *key) const override;
     StoreIOState::Pointer createStoreIO(StoreEntry &, StoreIOState::STIOCB *, void *) override;
     StoreIOState::Pointer openStoreIO(StoreEntry &, StoreIOState::STIOCB *, void *) override;
     void maintain() override;
@@ -117,6 +125,12 @@ protected:
     void dumpRateOption(StoreEntry * e) const;
     bool parseSizeOption(char const *option, const char *value, int reconfiguring);
     void dumpSizeOption(StoreEntry * e) const;
+    bool parseIoEngineOption(char const *option, const char *value, int reconfiguring);
+    void dumpIoEngineOption(StoreEntry * e) const;
+    bool parseDirectIoOption(char const *option, const char *value, int reconfiguring);
+    void dumpDirectIoOption(StoreEntry * e) const;
+    bool parseDiskersOption(char const *option, const char *value, int reconfiguring);
+    void dumpDiskersOption(StoreEntry * e) const;
 
     bool full() const; ///< no more entries can be stored without purging
     void trackReferences(StoreEntry &e); ///< add to replacement policy scope
@@ -132,9 +146,13 @@ protected:
     friend class Rebuild;
     friend class IoState;
     friend class HeaderUpdater;
+    friend class IndexCheckpoint;
     const char *filePath; ///< location of cache storage file inside path/
     DirMap *map; ///< entry key/sfileno to MaxExtras/inode mapping
 
+    /// maintains the index checkpoint and journal (or nil if disabled)
+    IndexCheckpoint *indexCheckpoint;
+
 private:
     void createError(const char *const msg);
     void handleWriteCompletionSuccess(const WriteRequest &request);
@@ -147,6 +165,9 @@ private:
 
     /* configurable options */
     DiskFile::Config fileConfig; ///< file-level configuration options
+    /// seconds between periodic index checkpoints, zero for shutdown-only
+    /// checkpoints, or -1 if index checkpoints are disabled
+    int64_t indexCheckpointPeriod;
 
     static const int64_t HeaderSize = 16*1024; ///< on-disk db header size
 };
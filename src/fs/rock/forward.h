@@ -41,6 +41,8 @@ class IoState;
 
 class HeaderUpdater;
 
+class IndexCheckpoint;
+
 class DbCellHeader;
 
 class ReadRequest;
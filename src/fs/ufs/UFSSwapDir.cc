@@ -17,6 +17,7 @@
 #include "ConfigOption.h"
 #include "DiskIO/DiskIOModule.h"
 #include "DiskIO/DiskIOStrategy.h"
+#include "fatal.h"
 #include "fde.h"
 #include "FileMap.h"
 #include "fs_io.h"
@@ -554,6 +555,13 @@ Fs::Ufs::UFSSwapDir::openStoreIO(StoreEntry &e, StoreIOState::STIOCB * const aCa
     return IO->open(this, &e, aCallback, callback_data);
 }
 
+int
+Fs::Ufs::UFSSwapDir::openSwapFile(const StoreEntry &e) const
+{
+    assert(e.swap_filen >= 0);
+    return file_open(fullPath(e.swap_filen, nullptr), O_RDONLY | O_BINARY);
+}
+
 int
 Fs::Ufs::UFSSwapDir::mapBitTest(sfileno filn)
 {
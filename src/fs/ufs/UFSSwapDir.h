@@ -58,6 +58,7 @@ public:
     bool dereference(StoreEntry &) override;
     StoreIOState::Pointer createStoreIO(StoreEntry &, StoreIOState::STIOCB *, void *) override;
     StoreIOState::Pointer openStoreIO(StoreEntry &, StoreIOState::STIOCB *, void *) override;
+    int openSwapFile(const StoreEntry &) const override;
     void openLog() override;
     void closeLog() override;
     int writeCleanStart() override;
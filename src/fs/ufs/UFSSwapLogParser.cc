@@ -9,6 +9,7 @@
 #include "squid.h"
 #include "debug/Stream.h"
 #include "md5.h"
+#include "store_key_md5.h"
 #include "StoreSwapLogData.h"
 #include "swap_log_op.h"
 #include "UFSSwapLogParser.h"
@@ -112,6 +113,14 @@ Fs::Ufs::UFSSwapLogParser::GetUFSSwapLogParser(FILE *fp)
             return nullptr;
         }
 
+        if (header.keyHash != storeKeyHash()) {
+            debugs(47, DBG_IMPORTANT, "Rejecting swap file with " <<
+                   storeKeyHashName(static_cast<KeyHash>(header.keyHash)) <<
+                   " store keys because store_key_hash is " << storeKeyHashName(storeKeyHash()) <<
+                   ". Forcing a full cache index rebuild that converts the keys.");
+            return nullptr;
+        }
+
         if (fseek(fp, header.record_size, SEEK_SET) != 0)
             return nullptr;
 
@@ -19,8 +19,10 @@
 #include "comm.h"
 #include "comm/Connection.h"
 #include "comm/Loops.h"
+#include "comm/UdpBatch.h"
 #include "compat/xalloc.h"
 #include "debug/Messages.h"
+#include "fatal.h"
 #include "globals.h"
 #include "htcp.h"
 #include "http.h"
@@ -613,6 +615,9 @@ htcpBuildPacket(char *buf, size_t buflen, htcpStuff * stuff)
     return off;
 }
 
+/// batched UDP I/O statistics for HTCP sockets
+static Comm::UdpBatchStats HtcpUdpBatchStats("HTCP");
+
 static void
 htcpSend(const char *buf, int len, Ip::Address &to)
 {
@@ -622,8 +627,11 @@ htcpSend(const char *buf, int len, Ip::Address &to)
     if (comm_udp_sendto(htcpOutgoingConn->fd, to, buf, len) < 0) {
         int xerrno = errno;
         debugs(31, 3, htcpOutgoingConn << " sendto: " << xstrerr(xerrno));
-    } else
+        HtcpUdpBatchStats.countSent(0);
+    } else {
         ++statCounter.htcp.pkts_sent;
+        HtcpUdpBatchStats.countSent(1);
+    }
 }
 
 /*
@@ -1460,22 +1468,38 @@ htcpHandleMsg(char *buf, int sz, Ip::Address &from)
 static void
 htcpRecv(int fd, void *)
 {
-    static char buf[8192];
-    int len;
-    static Ip::Address from;
-
     /* Receive up to 8191 bytes, leaving room for a null */
+    static Comm::UdpReceiveRing ring(8191, HtcpUdpBatchStats);
+    int max = INCOMING_UDP_MAX;
 
-    len = comm_udp_recvfrom(fd, buf, sizeof(buf) - 1, 0, from);
+    Comm::SetSelect(fd, COMM_SELECT_READ, htcpRecv, nullptr, 0);
 
-    debugs(31, 3, "htcpRecv: FD " << fd << ", " << len << " bytes from " << from );
+    while (max > 0) {
+        const auto received = ring.receive(fd, max);
 
-    if (len)
-        ++statCounter.htcp.pkts_recv;
+        if (received < 0) {
+            const auto xerrno = errno;
+            debugs(31, 3, "htcpRecv: FD " << fd << ": " << xstrerr(xerrno));
+            break;
+        }
 
-    htcpHandleMsg(buf, len, from);
+        max -= received;
 
-    Comm::SetSelect(fd, COMM_SELECT_READ, htcpRecv, nullptr, 0);
+        for (int i = 0; i < received; ++i) {
+            const int len = ring.size(i);
+            auto from = ring.from(i);
+
+            debugs(31, 3, "htcpRecv: FD " << fd << ", " << len << " bytes from " << from );
+
+            if (len)
+                ++statCounter.htcp.pkts_recv;
+
+            htcpHandleMsg(ring.data(i), len, from);
+        }
+
+        if (ring.drained())
+            break;
+    }
 }
 
 static void
@@ -7,27 +7,50 @@
  */
 
 #include "squid.h"
+#include "anyp/PortCfg.h"
+#include "client_side.h"
 #include "client_side_request.h"
 #include "clientStream.h"
+#include "comm/Write.h"
+#include "fatal.h"
+#include "fde.h"
+#include "fs_io.h"
 #include "http/Stream.h"
 #include "HttpHdrContRange.h"
 #include "HttpHeaderTools.h"
+#include "MemObject.h"
+#include "SquidConfig.h"
 #include "Store.h"
+#include "store/Disk.h"
 #include "TimeOrTag.h"
 #if USE_DELAY_POOLS
 #include "acl/FilledChecklist.h"
 #include "ClientInfo.h"
-#include "fde.h"
 #include "MessageDelayPools.h"
 #endif
 
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#if HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+/// the smallest remaining cached body worth sending with sendBodyFromFile()
+static const int64_t BodyFileMinSize = 64*1024;
+
+/// the maximum number of body bytes sent by one sendBodyFromFile() write
+static const int BodyFileChunkSize = 1024*1024;
+
 Http::Stream::Stream(const Comm::ConnectionPointer &aConn, ClientHttpRequest *aReq) :
     clientConnection(aConn),
     http(aReq),
     reply(nullptr),
     writtenToSocket(0),
     mayUseConnection_(false),
-    connRegistered_(false)
+    connRegistered_(false),
+    bodyFile_(-1),
+    bodyFileChecked_(false)
 {
     assert(http != nullptr);
     memset(reqbuf, '\0', sizeof (reqbuf));
@@ -46,6 +69,8 @@ Http::Stream::~Stream()
             node->data = nullptr;
         }
     }
+    if (bodyFile_ >= 0)
+        file_close(bodyFile_);
     httpRequestFree(http);
 }
 
@@ -77,7 +102,8 @@ Http::Stream::writeComplete(size_t size)
     switch (socketState()) {
 
     case STREAM_NONE:
-        pullData();
+        if (!sendBodyFromFile())
+            pullData();
         break;
 
     case STREAM_COMPLETE: {
@@ -122,6 +148,98 @@ Http::Stream::pullData()
     clientStreamRead(getTail(), http, readBuffer);
 }
 
+bool
+Http::Stream::sendBodyFromFile()
+{
+    if (bodyFile_ < 0) {
+        if (bodyFileChecked_)
+            return false;
+        bodyFileChecked_ = true;
+        if (!mayUseBodyFile() || !openBodyFile())
+            return false;
+    }
+
+    const auto entry = http->storeEntry();
+    const auto headersSize = entry->mem().baseReply().hdr_sz;
+    const auto bodyLeft = entry->objectLen() - headersSize - http->out.offset;
+    if (bodyLeft <= 0)
+        return false; // let Store tell us that the body is over
+
+    const auto size = static_cast<int>(std::min<int64_t>(bodyLeft, BodyFileChunkSize));
+    const off_t fileOffset = entry->mem().swap_hdr_sz + headersSize + http->out.offset;
+    debugs(33, 5, "sending " << size << " body bytes from file FD " << bodyFile_ << " offset " << fileOffset);
+
+#if HAVE_POSIX_FADVISE
+    // let the kernel read the next chunk while we are sending this one
+    if (bodyLeft > size)
+        (void)posix_fadvise(bodyFile_, fileOffset + size, BodyFileChunkSize, POSIX_FADV_WILLNEED);
+#endif
+
+    noteSentBodyBytes(size);
+    getConn()->writeFile(bodyFile_, fileOffset, size);
+    return true;
+}
+
+/// whether the rest of the response body may be sent from the cache file as is
+bool
+Http::Stream::mayUseBodyFile() const
+{
+    if (!Config.onoff.cache_hit_sendfile || !Comm::WriteFileSupported())
+        return false;
+
+    // the client must get the stored body bytes unchanged
+    if (http->request->range || http->request->flags.chunkedReply || !reply || reply->contentRange())
+        return false;
+
+    // no body-altering clientStream nodes (e.g., ESI) between Store and us
+    if (http->client_stream.tail->prev != http->client_stream.head)
+        return false;
+
+    // HTTP/1 clients without TLS or other custom I/O layers
+    const auto &port = getConn()->port;
+    if (!port || port->transport.protocol != AnyP::PROTO_HTTP || !fd_table[clientConnection->fd].usesDefaultIo())
+        return false;
+
+    // a disk hit on a complete entry that Store will not change under us
+    const auto entry = http->storeEntry();
+    if (!entry || !entry->mem_obj || entry->mem_status == IN_MEMORY || !entry->swappedOut() ||
+            entry->store_status != STORE_OK || EBIT_TEST(entry->flags, ENTRY_ABORTED) ||
+            !entry->mem().swap_hdr_sz)
+        return false;
+
+    const auto bodyLeft = entry->objectLen() - entry->mem().baseReply().hdr_sz - http->out.offset;
+    return bodyLeft >= BodyFileMinSize;
+}
+
+/// opens the cache file of our entry for sendBodyFromFile()
+bool
+Http::Stream::openBodyFile()
+{
+    const auto entry = http->storeEntry();
+    const auto fd = entry->disk().openSwapFile(*entry);
+    if (fd < 0) {
+        debugs(33, 5, "cannot open the cache file of " << *entry);
+        return false;
+    }
+
+    // paranoid: make sure the file has the expected layout
+    const auto expectedSize = static_cast<int64_t>(entry->mem().swap_hdr_sz) + entry->objectLen();
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || static_cast<int64_t>(sb.st_size) != expectedSize) {
+        debugs(33, 2, "unexpected cache file size for " << *entry << "; wanted " << expectedSize);
+        file_close(fd);
+        return false;
+    }
+
+#if HAVE_POSIX_FADVISE
+    (void)posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    debugs(33, 3, "will send " << *entry << " body from file FD " << fd);
+    bodyFile_ = fd;
+    return true;
+}
+
 bool
 Http::Stream::multipartRangeRequest() const
 {
@@ -277,15 +395,17 @@ Http::Stream::sendStartOfMessage(HttpReply *rep, StoreIOBuffer bodyData)
     /* Save length of headers for persistent conn checks */
     http->out.headers_sz = mb->contentSize();
 
+    // body bytes are written together with the headers, without copying
+    Comm::WriteVector body;
     if (bodyData.data && bodyData.length) {
         if (multipartRangeRequest())
             packRange(bodyData, mb);
         else if (http->request->flags.chunkedReply) {
-            packChunk(bodyData, *mb);
+            packChunk(bodyData, *mb, body);
         } else {
             size_t length = lengthToSend(bodyData.range());
             noteSentBodyBytes(length);
-            mb->append(bodyData.data, length);
+            body.add(bodyData.data, length);
         }
     }
 #if USE_DELAY_POOLS
@@ -307,7 +427,7 @@ Http::Stream::sendStartOfMessage(HttpReply *rep, StoreIOBuffer bodyData)
     }
 #endif
 
-    getConn()->write(mb);
+    getConn()->write(mb, body);
     delete mb;
 }
 
@@ -323,13 +443,14 @@ Http::Stream::sendBody(StoreIOBuffer bodyData)
 
     MemBuf mb;
     mb.init();
+    Comm::WriteVector chunk;
     if (multipartRangeRequest())
         packRange(bodyData, &mb);
     else
-        packChunk(bodyData, mb);
+        packChunk(bodyData, mb, chunk);
 
     if (mb.contentSize())
-        getConn()->write(&mb);
+        getConn()->write(&mb, chunk);
     else
         writeComplete(0);
 }
@@ -572,19 +693,21 @@ Http::Stream::prepareReply(HttpReply *rep)
 }
 
 /**
- * Packs bodyData into mb using chunked encoding.
+ * Packs bodyData using chunked encoding: the chunk-size line goes into mb
+ * while chunk-data and its CRLF are added to the more buffers.
  * Packs the last-chunk if bodyData is empty.
  */
 void
-Http::Stream::packChunk(const StoreIOBuffer &bodyData, MemBuf &mb)
+Http::Stream::packChunk(const StoreIOBuffer &bodyData, MemBuf &mb, Comm::WriteVector &more)
 {
     const uint64_t length =
         static_cast<uint64_t>(lengthToSend(bodyData.range()));
     noteSentBodyBytes(length);
 
+    // chunk-size line is packed while chunk-data and its CRLF are referenced
     mb.appendf("%" PRIX64 "\r\n", length);
-    mb.append(bodyData.data, length);
-    mb.append("\r\n", 2);
+    more.add(bodyData.data, length);
+    more.add("\r\n", 2);
 }
 
 /**
@@ -93,6 +93,10 @@ public:
     /// get more data to send
     void pullData();
 
+    /// send more cached body bytes straight from the cache file, if possible
+    /// \returns false if the caller should pullData() instead
+    bool sendBodyFromFile();
+
     /// \return true if the HTTP request is for multiple ranges
     bool multipartRangeRequest() const;
 
@@ -161,12 +165,19 @@ public: // HTTP/1.x state data
 
 private:
     void prepareReply(HttpReply *);
-    void packChunk(const StoreIOBuffer &bodyData, MemBuf &);
+    void packChunk(const StoreIOBuffer &bodyData, MemBuf &, Comm::WriteVector &);
     void packRange(StoreIOBuffer const &, MemBuf *);
     void doClose();
+    bool mayUseBodyFile() const;
+    bool openBodyFile();
 
     bool mayUseConnection_; /* This request may use the connection. Don't read anymore requests for now */
     bool connRegistered_;
+
+    /// cache file descriptor for sendBodyFromFile() or -1
+    int bodyFile_;
+    /// whether we have decided whether to use sendBodyFromFile()
+    bool bodyFileChecked_;
 #if USE_DELAY_POOLS
     MessageBucket::Pointer writeQuotaHandler; ///< response write limiter, if configured
 #endif
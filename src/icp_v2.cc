@@ -22,6 +22,8 @@
 #include "comm.h"
 #include "comm/Connection.h"
 #include "comm/Loops.h"
+#include "comm/UdpBatch.h"
+#include "fatal.h"
 #include "fd.h"
 #include "HttpRequest.h"
 #include "icmp/net_db.h"
@@ -95,6 +97,22 @@ static DelayedUdpSend *IcpQueueHead = nullptr;
 /// \ingroup ServerProtocolICPInternal2
 static DelayedUdpSend *IcpQueueTail = nullptr;
 
+/// batched UDP I/O statistics for ICP sockets
+static Comm::UdpBatchStats IcpUdpBatchStats("ICP");
+
+/// icpUdpSend() calls accumulated between icpBeginSendBatch() and
+/// icpFlushSendBatch() for a single sendmmsg(2) call
+class IcpSendBatch
+{
+public:
+    int fd = -1; ///< the socket we are batching messages for or -1
+    Comm::UdpSendBatch datagrams{IcpUdpBatchStats}; ///< batched message bytes
+    DelayedUdpSend messages[Comm::UdpBatchMax]; ///< batched message details
+};
+
+/// \ingroup ServerProtocolICPInternal2
+static IcpSendBatch TheIcpSendBatch;
+
 /// \ingroup ServerProtocolICPInternal2
 Comm::ConnectionPointer icpIncomingConn = nullptr;
 /// \ingroup ServerProtocolICPInternal2
@@ -312,9 +330,45 @@ icp_common_t::CreateMessage(
     return (icp_common_t *)buf;
 }
 
+/// logs and counts a successfully written ICP message, freeing it
+static void
+icpUdpSent(const Ip::Address &to, icp_common_t *msg, const int len, const int delay, AccessLogEntryPointer &al)
+{
+    const auto logcode = icpLogFromICPCode(static_cast<icp_opcode>(msg->opcode));
+    icpLogIcp(to, logcode, len, (char *) (msg + 1), delay, al);
+    icpCount(msg, SENT, (size_t) len, delay);
+    safe_free(msg);
+}
+
+/// queues an ICP message that we failed to write for a later icpUdpSendQueue() retry
+static void
+icpUdpQueue(const int fd, const Ip::Address &to, icp_common_t *msg, const AccessLogEntryPointer &al)
+{
+    const auto queue = new DelayedUdpSend();
+    queue->address = to;
+    queue->msg = msg;
+    queue->queue_time = current_time;
+    queue->ale = al;
+
+    if (IcpQueueHead == nullptr) {
+        IcpQueueHead = queue;
+        IcpQueueTail = queue;
+    } else if (IcpQueueTail == IcpQueueHead) {
+        IcpQueueTail = queue;
+        IcpQueueHead->next = queue;
+    } else {
+        IcpQueueTail->next = queue;
+        IcpQueueTail = queue;
+    }
+
+    Comm::SetSelect(fd, COMM_SELECT_WRITE, icpUdpSendQueue, nullptr, 0);
+    ++statCounter.icp.replies_queued;
+}
+
 // TODO: Move retries to icpCreateAndSend(); the other caller does not retry.
 /// writes the given UDP msg to the socket; queues a retry on the first failure
-/// \returns a negative number on failures
+/// \returns a negative number on failures or zero for messages added to the
+/// send batch; icpFlushSendBatch() reports batched message failures
 static int
 icpUdpSend(int fd,
            const Ip::Address &to,
@@ -328,35 +382,27 @@ icpUdpSend(int fd,
     debugs(12, 5, "icpUdpSend: FD " << fd << " sending " <<
            icp_opcode_str[msg->opcode] << ", " << len << " bytes to " << to);
 
+    // batch fresh messages unless older ones are still waiting in the queue
+    if (0 == delay && fd == TheIcpSendBatch.fd && !IcpQueueHead) {
+        auto &batch = TheIcpSendBatch;
+        auto &batched = batch.messages[batch.datagrams.size()];
+        batched.address = to;
+        batched.msg = msg;
+        batched.ale = al;
+        batch.datagrams.add(to, msg, len);
+        if (batch.datagrams.full())
+            icpFlushSendBatch();
+        return 0; // nothing was written yet
+    }
+
     x = comm_udp_sendto(fd, to, msg, len);
 
     if (x >= 0) {
         /* successfully written */
-        const auto logcode = icpLogFromICPCode(static_cast<icp_opcode>(msg->opcode));
-        icpLogIcp(to, logcode, len, (char *) (msg + 1), delay, al);
-        icpCount(msg, SENT, (size_t) len, delay);
-        safe_free(msg);
+        icpUdpSent(to, msg, len, delay, al);
     } else if (0 == delay) {
         /* send failed, but queue it */
-        const auto queue = new DelayedUdpSend();
-        queue->address = to;
-        queue->msg = msg;
-        queue->queue_time = current_time;
-        queue->ale = al;
-
-        if (IcpQueueHead == nullptr) {
-            IcpQueueHead = queue;
-            IcpQueueTail = queue;
-        } else if (IcpQueueTail == IcpQueueHead) {
-            IcpQueueTail = queue;
-            IcpQueueHead->next = queue;
-        } else {
-            IcpQueueTail->next = queue;
-            IcpQueueTail = queue;
-        }
-
-        Comm::SetSelect(fd, COMM_SELECT_WRITE, icpUdpSendQueue, nullptr, 0);
-        ++statCounter.icp.replies_queued;
+        icpUdpQueue(fd, to, msg, al);
     } else {
         /* don't queue it */
         // XXX: safe_free(msg)
@@ -366,6 +412,46 @@ icpUdpSend(int fd,
     return x;
 }
 
+void
+icpBeginSendBatch(const int fd)
+{
+    icpFlushSendBatch();
+    TheIcpSendBatch.fd = fd;
+}
+
+int
+icpFlushSendBatch()
+{
+    auto &batch = TheIcpSendBatch;
+    const auto queued = batch.datagrams.size();
+    if (!queued)
+        return 0;
+
+    const auto sent = batch.datagrams.send(batch.fd);
+    debugs(12, 5, "FD " << batch.fd << " sent " << sent << " out of " << queued << " ICP messages");
+
+    for (int i = 0; i < queued; ++i) {
+        auto &batched = batch.messages[i];
+        if (i < sent)
+            icpUdpSent(batched.address, batched.msg, (int) ntohs(batched.msg->length), 0, batched.ale);
+        else
+            icpUdpQueue(batch.fd, batched.address, batched.msg, batched.ale);
+        batched.msg = nullptr;
+        batched.ale = nullptr;
+    }
+
+    // like icpUdpSend() failures, each unsent message was queued for a retry
+    // and counted as such
+    return queued - sent;
+}
+
+void
+icpEndSendBatch()
+{
+    icpFlushSendBatch();
+    TheIcpSendBatch.fd = -1;
+}
+
 /**
  * This routine selects an ICP opcode for ICP misses.
  *
@@ -649,25 +735,18 @@ icpHandleUdp(int sock, void *)
 {
     int *N = &incoming_sockets_accepted;
 
-    Ip::Address from;
-    LOCAL_ARRAY(char, buf, SQUID_UDP_SO_RCVBUF);
-    int len;
+    static Comm::UdpReceiveRing ring(SQUID_UDP_SO_RCVBUF - 1, IcpUdpBatchStats);
     int icp_version;
     int max = INCOMING_UDP_MAX;
     Comm::SetSelect(sock, COMM_SELECT_READ, icpHandleUdp, nullptr, 0);
 
-    while (max) {
-        --max;
-        len = comm_udp_recvfrom(sock,
-                                buf,
-                                SQUID_UDP_SO_RCVBUF - 1,
-                                0,
-                                from);
+    // replies to the queries we are about to receive go out in batches
+    icpBeginSendBatch(sock);
 
-        if (len == 0)
-            break;
+    while (max > 0) {
+        const auto received = ring.receive(sock, max);
 
-        if (len < 0) {
+        if (received < 0) {
             int xerrno = errno;
             if (ignoreErrno(xerrno))
                 break;
@@ -684,33 +763,49 @@ icpHandleUdp(int sock, void *)
             break;
         }
 
-        ++(*N);
-        icpCount(buf, RECV, (size_t) len, 0);
-        buf[len] = '\0';
-        debugs(12, 4, "icpHandleUdp: FD " << sock << ": received " <<
-               (unsigned long int)len << " bytes from " << from);
-
-        if ((size_t) len < sizeof(icp_common_t)) {
-            debugs(12, 4, "icpHandleUdp: Ignoring too-small UDP packet");
-            break;
+        max -= received;
+
+        for (int i = 0; i < received; ++i) {
+            const auto len = ring.size(i);
+            if (!len)
+                continue;
+
+            auto buf = ring.data(i);
+            auto from = ring.from(i);
+
+            ++(*N);
+            icpCount(buf, RECV, len, 0);
+            buf[len] = '\0';
+            debugs(12, 4, "icpHandleUdp: FD " << sock << ": received " <<
+                   (unsigned long int)len << " bytes from " << from);
+
+            if (len < sizeof(icp_common_t)) {
+                debugs(12, 4, "icpHandleUdp: Ignoring too-small UDP packet");
+                continue;
+            }
+
+            icp_version = (int) buf[1]; /* cheat! */
+
+            // XXX: The IP equality comparison below ignores port differences but
+            // should not. It also fails to detect loops when `local` is a wildcard
+            // address (e.g., [::]:3130) because `from` address is never a wildcard.
+            if (icpOutgoingConn && icpOutgoingConn->local == from)
+                // ignore ICP packets which loop back (multicast usually)
+                debugs(12, 4, "icpHandleUdp: Ignoring UDP packet sent by myself");
+            else if (icp_version == ICP_VERSION_2)
+                icpHandleIcpV2(sock, from, buf, len);
+            else if (icp_version == ICP_VERSION_3)
+                icpHandleIcpV3(sock, from, buf, len);
+            else
+                debugs(12, DBG_IMPORTANT, "WARNING: Unused ICP version " << icp_version <<
+                       " received from " << from);
         }
 
-        icp_version = (int) buf[1]; /* cheat! */
-
-        // XXX: The IP equality comparison below ignores port differences but
-        // should not. It also fails to detect loops when `local` is a wildcard
-        // address (e.g., [::]:3130) because `from` address is never a wildcard.
-        if (icpOutgoingConn && icpOutgoingConn->local == from)
-            // ignore ICP packets which loop back (multicast usually)
-            debugs(12, 4, "icpHandleUdp: Ignoring UDP packet sent by myself");
-        else if (icp_version == ICP_VERSION_2)
-            icpHandleIcpV2(sock, from, buf, len);
-        else if (icp_version == ICP_VERSION_3)
-            icpHandleIcpV3(sock, from, buf, len);
-        else
-            debugs(12, DBG_IMPORTANT, "WARNING: Unused ICP version " << icp_version <<
-                   " received from " << from);
+        if (ring.drained())
+            break;
     }
+
+    icpEndSendBatch();
 }
 
 void
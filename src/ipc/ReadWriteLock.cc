@@ -31,6 +31,7 @@ Ipc::ReadWriteLock::finalizeExclusive()
     assert(!appending); // nobody can be appending without an exclusive lock
     if (!readLevel) { // no old readers and nobody is becoming a reader
         writing = true;
+        ++version; // invalidate optimistic reads before we modify anything
         return true;
     }
     --writeLevel;
@@ -144,6 +145,22 @@ Ipc::ReadWriteLock::stopAppendingAndRestoreExclusive()
     return !readLevel;
 }
 
+bool
+Ipc::ReadWriteLock::startOptimisticRead(uint32_t &snapshot) const
+{
+    snapshot = version;
+    // writeLevel covers writers that have the lock or are getting it
+    return !writeLevel;
+}
+
+bool
+Ipc::ReadWriteLock::finishOptimisticRead(const uint32_t snapshot) const
+{
+    // do not let the caller's data reads drift below our checks
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return !writeLevel && version == snapshot;
+}
+
 void
 Ipc::ReadWriteLock::updateStats(ReadWriteLockStats &stats) const
 {
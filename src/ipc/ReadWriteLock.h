@@ -23,10 +23,17 @@ class ReadWriteLockStats;
 /// Also supports reading-while-appending mode when readers and writer are
 /// allowed to access the same locked object because the writer promises
 /// to only append new data and all size-related object properties are atomic.
+///
+/// Short reads may also be optimistic (seqlock-style): Instead of changing
+/// the lock, such readers remember the lock version, read the object, and
+/// then check whether any writer has locked the object in the meantime.
+/// Optimistic readers do not modify the shared lock, so many concurrent
+/// readers do not fight over the lock cache line, but they must be prepared
+/// to discard inconsistent data and to read garbage without crashing.
 class ReadWriteLock
 {
 public:
-    ReadWriteLock() : readers(0), writing(false), appending(false), readLevel(0), writeLevel(0)
+    ReadWriteLock() : readers(0), writing(false), appending(false), readLevel(0), writeLevel(0), version(0)
     {}
 
     bool lockShared(); ///< lock for reading or return false
@@ -47,6 +54,16 @@ public:
     /// \prec appending is true
     bool stopAppendingAndRestoreExclusive();
 
+    /// starts an optimistic read (without locking)
+    /// \returns false if somebody is writing (or is about to write)
+    /// \param snapshot will be given to finishOptimisticRead()
+    bool startOptimisticRead(uint32_t &snapshot) const;
+
+    /// \returns whether the data read since the successful
+    /// startOptimisticRead() call that returned the given snapshot is
+    /// consistent (i.e. nobody could have modified it in the meantime)
+    bool finishOptimisticRead(uint32_t snapshot) const;
+
     /// adds approximate current stats to the supplied ones
     void updateStats(ReadWriteLockStats &stats) const;
 
@@ -61,6 +78,8 @@ private:
 
     mutable std::atomic<uint32_t> readLevel; ///< number of users reading (or trying to)
     std::atomic<uint32_t> writeLevel; ///< number of users writing (or trying to write)
+    /// the number of successful exclusive lock acquisitions (wraps around)
+    std::atomic<uint32_t> version;
 };
 
 /// dumps approximate lock state (for debugging)
@@ -493,6 +493,62 @@ Ipc::StoreMap::openForReadingAt(const sfileno fileno, const cache_key *const key
     return &s;
 }
 
+const Ipc::StoreMap::Anchor *
+Ipc::StoreMap::openForOptimisticReading(const cache_key *const key, sfileno &fileno, uint32_t &version)
+{
+    // validateHit() needs a lock
+    if (Config.paranoid_hit_validation.count() && hitValidation)
+        return nullptr;
+
+    const auto idx = fileNoByKey(key);
+    const auto &s = anchorAt(idx);
+    if (!s.lock.startOptimisticRead(version)) {
+        debugs(54, 5, "cannot optimistically open busy entry " << idx << " in " << path);
+        return nullptr;
+    }
+
+    // these checks may see inconsistent state, but then
+    // closeForOptimisticReading() will fail
+    if (s.empty() || s.waitingToBeFreed || !s.sameKey(key)) {
+        debugs(54, 7, "cannot optimistically open entry " << idx << " in " << path);
+        return nullptr;
+    }
+
+    debugs(54, 5, "optimistically opened entry " << idx << " for reading " << path);
+    fileno = idx;
+    return &s;
+}
+
+bool
+Ipc::StoreMap::closeForOptimisticReading(const sfileno fileno, const uint32_t version) const
+{
+    const auto consistent = anchorAt(fileno).lock.finishOptimisticRead(version);
+    debugs(54, 5, "closed entry " << fileno << " for optimistic reading " << path << ": " << consistent);
+    return consistent;
+}
+
+const Ipc::StoreMap::Slice *
+Ipc::StoreMap::optimisticSlice(const SliceId sliceId) const
+{
+    return validSlice(sliceId) ? &sliceAt(sliceId) : nullptr;
+}
+
+const Ipc::StoreMap::Anchor *
+Ipc::StoreMap::openCompleteForReadingAt(const sfileno fileno)
+{
+    Anchor &s = anchorAt(fileno);
+    if (!s.lock.lockShared())
+        return nullptr;
+
+    if (!s.complete() || s.waitingToBeFreed || s.start < 0) {
+        s.lock.unlockShared();
+        return nullptr;
+    }
+
+    debugs(54, 7, "opened complete entry " << fileno << " for reading " << path);
+    return &s;
+}
+
 void
 Ipc::StoreMap::closeForReading(const sfileno fileno)
 {
@@ -718,6 +774,27 @@ Ipc::StoreMap::purgeOne()
     });
 }
 
+bool
+Ipc::StoreMap::peekAtVictim(cache_key * const key) const
+{
+    // mimics visitVictims() search but does not move anchors->victim
+    const int searchLimit = min(100, entryLimit());
+    const auto start = anchors->victim.load();
+    for (int tries = 0; tries < searchLimit; ++tries) {
+        const sfileno name = static_cast<sfileno>((start + 1 + tries) % entryLimit());
+        const Anchor &s = anchorAt(fileNoByName(name));
+        if (s.lock.lockShared()) {
+            const auto found = s.complete() && s.start >= 0;
+            if (found)
+                memcpy(key, s.key, sizeof(s.key));
+            s.lock.unlockShared();
+            if (found)
+                return true;
+        }
+    }
+    return false;
+}
+
 void
 Ipc::StoreMap::importSlice(const SliceId sliceId, const Slice &slice)
 {
@@ -979,6 +1056,12 @@ void
 Ipc::StoreMapAnchor::exportInto(StoreEntry &into) const
 {
     assert(reading());
+    exportBasicsInto(into);
+}
+
+void
+Ipc::StoreMapAnchor::exportBasicsInto(StoreEntry &into) const
+{
     into.timestamp = basics.timestamp;
     into.lastref = basics.lastref;
     into.expires = basics.expires;
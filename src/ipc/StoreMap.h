@@ -62,6 +62,8 @@ public:
     void set(const StoreEntry &anEntry, const cache_key *aKey = nullptr);
     /// load StoreEntry basics that were previously stored with set()
     void exportInto(StoreEntry &) const;
+    /// exportInto() for optimistic readers that do not lock the anchor
+    void exportBasicsInto(StoreEntry &) const;
 
     void setKey(const cache_key *const aKey);
     bool sameKey(const cache_key *const aKey) const;
@@ -308,11 +310,25 @@ public:
     const Anchor *openForReading(const cache_key *const key, sfileno &fileno);
     /// opens entry (identified by sfileno) for reading, increments read level
     const Anchor *openForReadingAt(const sfileno, const cache_key *const);
+    /// opens the complete entry at the given position for reading, if any;
+    /// useful for visiting all entries without knowing their keys
+    const Anchor *openCompleteForReadingAt(const sfileno);
     /// closes open entry after reading, decrements read level
     void closeForReading(const sfileno fileno);
     /// same as closeForReading() but also frees the entry if it is unlocked
     void closeForReadingAndFreeIdle(const sfileno fileno);
 
+    /// Starts reading a complete entry without locking it (see ReadWriteLock).
+    /// Anchor fields and slices may change while the caller is reading them.
+    /// \returns nil if the entry cannot be read optimistically right now
+    const Anchor *openForOptimisticReading(const cache_key *const key, sfileno &fileno, uint32_t &version);
+    /// \returns whether everything read since openForOptimisticReading() is
+    /// consistent; the caller must discard what it has read otherwise
+    bool closeForOptimisticReading(const sfileno fileno, const uint32_t version) const;
+    /// a slice of an entry opened by openForOptimisticReading()
+    /// \returns nil if the slice ID is invalid (e.g., due to a concurrent change)
+    const Slice *optimisticSlice(const SliceId sliceId) const;
+
     /// openForReading() but creates a new entry if there is no old one
     const Anchor *openOrCreateForReading(const cache_key *, sfileno &);
 
@@ -339,6 +355,11 @@ public:
     /// either finds and frees an entry with at least 1 slice or returns false
     bool purgeOne();
 
+    /// copies the key of a complete entry that purgeOne() is likely to free
+    /// next, without changing purgeOne() state
+    /// \returns false if no such entry was found nearby
+    bool peekAtVictim(cache_key *key) const;
+
     /// validates locked hit metadata and calls freeEntry() for invalid entries
     /// \returns whether hit metadata is correct
     bool validateHit(const sfileno);
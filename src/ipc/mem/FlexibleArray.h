@@ -31,8 +31,10 @@ public:
     }
 
     Item &operator [](const int idx) { return *(raw() + idx); }
+    const Item &operator [](const int idx) const { return *(raw() + idx); }
 
     Item *raw() { return reinterpret_cast<Item*>(&start_); }
+    const Item *raw() const { return reinterpret_cast<const Item*>(&start_); }
 
 private:
     alignas(Item) std::byte start_; ///< the first byte of the first array item
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 54    Interprocess Communication */
+
+#include "squid.h"
+#include "compat/cpu.h"
+#include "debug/Stream.h"
+#include "ipc/mem/Numa.h"
+
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <string>
+#if HAVE_LINUX_MEMPOLICY_H
+#include <linux/mempolicy.h>
+#endif
+#if HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+/// where Linux describes NUMA nodes
+static const char *NodesDir = "/sys/devices/system/node";
+
+/// Parses a Linux sysfs list of numbers (e.g., "0-3,8,10-11").
+/// \returns false if the file is missing or malformed
+static bool
+ReadSysfsList(const std::string &fileName, std::vector<int> &values)
+{
+    std::ifstream in(fileName);
+    std::string line;
+    if (!std::getline(in, line))
+        return false;
+
+    std::istringstream list(line);
+    std::string range;
+    while (std::getline(list, range, ',')) {
+        if (range.empty())
+            continue;
+        int first = -1;
+        int last = -1;
+        char dash = 0;
+        std::istringstream rangeIn(range);
+        if (!(rangeIn >> first) || first < 0)
+            return false;
+        if (rangeIn >> dash) {
+            if (dash != '-' || !(rangeIn >> last) || last < first)
+                return false;
+        } else {
+            last = first;
+        }
+        for (auto value = first; value <= last; ++value)
+            values.push_back(value);
+    }
+    return true;
+}
+
+const Ipc::Mem::NumaTopology &
+Ipc::Mem::NumaTopology::Current()
+{
+    static const auto topology = new NumaTopology();
+    return *topology;
+}
+
+Ipc::Mem::NumaTopology::NumaTopology()
+{
+    if (!ReadSysfsList(std::string(NodesDir) + "/online", nodes_) || nodes_.empty()) {
+        debugs(54, 3, "no NUMA topology information in " << NodesDir);
+        nodes_.assign(1, 0);
+        return;
+    }
+
+    for (const auto node: nodes_) {
+        std::vector<int> cpus;
+        const auto fileName = std::string(NodesDir) + "/node" + std::to_string(node) + "/cpulist";
+        if (!ReadSysfsList(fileName, cpus))
+            debugs(54, 3, "cannot read " << fileName);
+        for (const auto cpu: cpus) {
+            if (static_cast<size_t>(cpu) >= cpuNodes_.size())
+                cpuNodes_.resize(cpu + 1, -1);
+            cpuNodes_[cpu] = node;
+        }
+    }
+    debugs(54, 3, "NUMA nodes: " << nodes_.size() << "; CPUs: " << cpuNodes_.size());
+}
+
+int
+Ipc::Mem::NumaTopology::nodeOfCpu(const int cpu) const
+{
+    if (nodes_.size() == 1)
+        return nodes_.front();
+    return (0 <= cpu && static_cast<size_t>(cpu) < cpuNodes_.size()) ? cpuNodes_[cpu] : -1;
+}
+
+int
+Ipc::Mem::NumaTopology::nodeOfThisProcess() const
+{
+    if (nodes_.size() == 1)
+        return nodes_.front();
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+        const auto xerrno = errno;
+        debugs(54, 3, "sched_getaffinity: " << xstrerr(xerrno));
+        return -1;
+    }
+
+    int result = -1;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &cpuSet))
+            continue;
+        const auto node = nodeOfCpu(cpu);
+        if (node < 0 || (result >= 0 && node != result))
+            return -1; // unknown or multiple nodes
+        result = node;
+    }
+    return result;
+}
+
+bool
+Ipc::Mem::NumaTopology::Prefer(void * const mem, const size_t size, const int node)
+{
+#if HAVE_LINUX_MEMPOLICY_H && defined(SYS_mbind)
+    const auto bitsPerMask = 8*sizeof(unsigned long);
+    if (node < 0 || static_cast<size_t>(node) >= bitsPerMask)
+        return false;
+    const unsigned long nodeMask = 1UL << node;
+    // the kernel ignores the last bit of the given maximum node count
+    if (syscall(SYS_mbind, mem, size, MPOL_PREFERRED, &nodeMask, bitsPerMask + 1, MPOL_MF_MOVE) != 0) {
+        const auto xerrno = errno;
+        debugs(54, 2, "mbind(" << size << " bytes, node " << node << "): " << xstrerr(xerrno));
+        return false;
+    }
+    return true;
+#else
+    (void)mem;
+    (void)size;
+    (void)node;
+    return false;
+#endif
+}
+
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_IPC_MEM_NUMA_H
+#define SQUID_SRC_IPC_MEM_NUMA_H
+
+#include <cstddef>
+#include <vector>
+
+namespace Ipc
+{
+
+namespace Mem
+{
+
+/// NUMA nodes of this machine and the CPUs they contain, as reported by the
+/// OS. Machines without (visible) NUMA support have a single node zero.
+class NumaTopology
+{
+public:
+    /// the topology of this machine, discovered on the first call
+    static const NumaTopology &Current();
+
+    /// online node IDs in ascending order; never empty
+    const std::vector<int> &nodes() const { return nodes_; }
+
+    /// \returns the node containing the given CPU or -1 if it is unknown
+    int nodeOfCpu(int cpu) const;
+
+    /// \returns the only node containing all CPUs this process may run on
+    /// (e.g., due to cpu_affinity_map) or -1 if there is no such node
+    int nodeOfThisProcess() const;
+
+    /// Asks the OS to allocate the given shared memory (and move its already
+    /// allocated pages) on the given node, falling back to other nodes when
+    /// that node runs out of memory.
+    /// \returns false if the OS lacks the necessary support or refused
+    static bool Prefer(void *mem, size_t size, int node);
+
+private:
+    NumaTopology();
+
+    std::vector<int> nodes_; ///< online node IDs
+    std::vector<int> cpuNodes_; ///< node IDs indexed by CPU number
+};
+
+} // namespace Mem
+
+} // namespace Ipc
+
+#endif /* SQUID_SRC_IPC_MEM_NUMA_H */
+
@@ -13,6 +13,15 @@
 #include "ipc/mem/Page.h"
 #include "ipc/mem/PagePool.h"
 
+/// \returns the first address at or after the given one that is suitable
+/// for storing page data; see PageStack::PagesAlignment
+static char *
+AlignPages(char * const raw)
+{
+    const auto misalignment = reinterpret_cast<uintptr_t>(raw) % Ipc::Mem::PageStack::PagesAlignment;
+    return misalignment ? raw + (Ipc::Mem::PageStack::PagesAlignment - misalignment) : raw;
+}
+
 // Ipc::Mem::PagePool
 
 Ipc::Mem::PagePool::Owner *
@@ -31,7 +40,10 @@ Ipc::Mem::PagePool::PagePool(const char *const id):
     theLevels(reinterpret_cast<Levels_t *>(
                   reinterpret_cast<char *>(pageIndex.getRaw()) +
                   pageIndex->stackSize() + pageIndex->levelsPaddingSize())),
-    theBuf(reinterpret_cast<char *>(theLevels + PageId::maxPurpose))
+    // Segments are mapped at OS page boundaries, so all processes agree on
+    // this padding (except for single-process fake segments, where any
+    // padding works)
+    theBuf(AlignPages(reinterpret_cast<char *>(theLevels + PageId::maxPurpose)))
 {
 }
 
@@ -497,7 +497,9 @@ Ipc::Mem::PageStack::SharedMemorySize(const Config &cfg)
 {
     const auto levelsSize = PageId::maxPurpose * sizeof(Levels_t);
     const size_t pagesDataSize = cfg.capacity * cfg.pageSize;
-    return StackSize(cfg.capacity) + pagesDataSize + levelsSize;
+    // room for aligning page data; see PagePool::PagePool()
+    const size_t pagesPaddingSize = cfg.pageSize ? PagesAlignment : 0;
+    return StackSize(cfg.capacity) + pagesDataSize + levelsSize + pagesPaddingSize;
 }
 
 size_t
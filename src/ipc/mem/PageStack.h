@@ -157,6 +157,9 @@ public:
     static size_t LevelsPaddingSize(const PageCount capacity);
     size_t levelsPaddingSize() const { return LevelsPaddingSize(config_.capacity); }
 
+    /// PagePool page data alignment; suitable for O_DIRECT disk I/O
+    static const size_t PagesAlignment = 4096;
+
     /**
      * The following functions return PageStack IDs for the corresponding
      * PagePool or a similar PageStack user. The exact values are unimportant,
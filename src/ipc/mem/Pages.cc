@@ -11,18 +11,79 @@
 #include "squid.h"
 #include "base/RunnersRegistry.h"
 #include "base/TextException.h"
+#include "debug/Stream.h"
+#include "globals.h"
+#include "ipc/mem/Numa.h"
 #include "ipc/mem/PagePool.h"
 #include "ipc/mem/Pages.h"
+#include "ipc/mem/Segment.h"
+#include "sbuf/SBuf.h"
+#include "sbuf/Stream.h"
+#include "SquidConfig.h"
 #include "tools.h"
 
-// Uses a single PagePool instance, for now.
+#include <vector>
+
+// Uses a single PagePool instance or, with shared_memory_numa, one PagePool
+// per NUMA node. Each process allocates pages from its local pool first.
 // Eventually, we may have pools dedicated to memory caching, disk I/O, etc.
 
 // TODO: make pool id more unique so it does not conflict with other Squids?
 static const char *PagePoolId = "squid-page-pool";
-static Ipc::Mem::PagePool *ThePagePool = nullptr;
+/// pools indexed by their PoolId offset from IdForMultipurposePool()
+static std::vector<Ipc::Mem::PagePool*> ThePagePools;
+/// the NUMA node of each pool or, for a single pool, -1; same in all processes
+static std::vector<int> ThePoolNodes;
+/// the index of the pool this process gets pages from first; -1 if unknown
+static int TheLocalPool = -1;
+/// whether TheLocalPool is on the NUMA node of this process
+static bool TheLocalPoolIsNumaLocal = false;
 static int TheLimits[Ipc::Mem::PageId::maxPurpose+1];
 
+/// the index of the pool this process should get pages from first
+static size_t
+LocalPool()
+{
+    if (TheLocalPool < 0) {
+        // We are called after cpu_affinity_map has been applied.
+        TheLocalPool = 0;
+        TheLocalPoolIsNumaLocal = false;
+        if (ThePoolNodes.size() > 1) {
+            const auto node = Ipc::Mem::NumaTopology::Current().nodeOfThisProcess();
+            for (size_t i = 0; i < ThePoolNodes.size(); ++i) {
+                if (ThePoolNodes[i] == node) {
+                    TheLocalPool = i;
+                    TheLocalPoolIsNumaLocal = true;
+                }
+            }
+            // spread processes without a NUMA node among pools
+            if (!TheLocalPoolIsNumaLocal)
+                TheLocalPool = KidIdentifier % ThePoolNodes.size();
+            debugs(54, 3, "prefer pages from pool " << TheLocalPool << " on NUMA node " <<
+                   ThePoolNodes[TheLocalPool] << (TheLocalPoolIsNumaLocal ? "" : " (not local)"));
+        }
+    }
+    return TheLocalPool;
+}
+
+/// the pool the given page belongs to
+static Ipc::Mem::PagePool &
+PoolOf(const Ipc::Mem::PageId &page)
+{
+    const auto base = Ipc::Mem::PageStack::IdForMultipurposePool();
+    Must(base <= page.pool && page.pool - base < ThePagePools.size());
+    return *ThePagePools[page.pool - base];
+}
+
+/// the shared memory segment name of the given pool
+static SBuf
+PoolSegmentId(const size_t pool)
+{
+    if (ThePoolNodes.size() <= 1)
+        return SBuf(PagePoolId);
+    return Ipc::Mem::Segment::Name(SBuf(PagePoolId), ToSBuf("node", ThePoolNodes[pool]).c_str());
+}
+
 // TODO: make configurable to avoid waste when mem-cached objects are small/big
 size_t
 Ipc::Mem::PageSize()
@@ -30,25 +91,80 @@ Ipc::Mem::PageSize()
     return 32*1024;
 }
 
+size_t
+Ipc::Mem::PageAlignment()
+{
+    return PageStack::PagesAlignment;
+}
+
 bool
 Ipc::Mem::GetPage(const PageId::Purpose purpose, PageId &page)
 {
-    return ThePagePool && PagesAvailable(purpose) > 0 ?
-           ThePagePool->get(purpose, page) : false;
+    if (ThePagePools.empty() || PagesAvailable(purpose) <= 0)
+        return false;
+
+    // prefer local pages but use remote ones rather than failing
+    const auto local = LocalPool();
+    for (size_t i = 0; i < ThePagePools.size(); ++i) {
+        if (ThePagePools[(local + i) % ThePagePools.size()]->get(purpose, page))
+            return true;
+    }
+    return false;
 }
 
 void
 Ipc::Mem::PutPage(PageId &page)
 {
-    Must(ThePagePool);
-    ThePagePool->put(page);
+    Must(!ThePagePools.empty());
+    if (!page)
+        return;
+    PoolOf(page).put(page);
 }
 
 char *
 Ipc::Mem::PagePointer(const PageId &page)
 {
-    Must(ThePagePool);
-    return ThePagePool->pagePointer(page);
+    Must(!ThePagePools.empty());
+    return PoolOf(page).pagePointer(page);
+}
+
+size_t
+Ipc::Mem::PagePoolCount()
+{
+    return ThePagePools.size();
+}
+
+int
+Ipc::Mem::LocalPageNode()
+{
+    if (ThePagePools.empty())
+        return -1;
+    const auto local = LocalPool();
+    return TheLocalPoolIsNumaLocal ? ThePoolNodes[local] : -1;
+}
+
+bool
+Ipc::Mem::PageIsLocal(const PageId &page)
+{
+    if (ThePagePools.size() <= 1)
+        return true;
+    return TheLocalPoolIsNumaLocal && &PoolOf(page) == ThePagePools[LocalPool()];
+}
+
+void
+Ipc::Mem::PreferLocalPage(PageId &page)
+{
+    if (!page || PageIsLocal(page) || LocalPageNode() < 0)
+        return;
+
+    // swap pages without changing levels, ignoring limits for a moment
+    const auto purpose = page.purpose;
+    PageId localPage;
+    if (ThePagePools[LocalPool()]->get(purpose, localPage)) {
+        debugs(54, 7, "replacing " << page << " with " << localPage);
+        PoolOf(page).put(page);
+        page = localPage;
+    }
 }
 
 size_t
@@ -79,13 +195,19 @@ Ipc::Mem::NotePageNeed(const int purpose, const int count)
 size_t
 Ipc::Mem::PageLevel()
 {
-    return ThePagePool ? ThePagePool->level() : 0;
+    size_t level = 0;
+    for (const auto pool: ThePagePools)
+        level += pool->level();
+    return level;
 }
 
 size_t
 Ipc::Mem::PageLevel(const int purpose)
 {
-    return ThePagePool ? ThePagePool->level(purpose) : 0;
+    size_t level = 0;
+    for (const auto pool: ThePagePools)
+        level += pool->level(purpose);
+    return level;
 }
 
 /// initializes shared memory pages
@@ -93,14 +215,14 @@ class SharedMemPagesRr: public Ipc::Mem::RegisteredRunner
 {
 public:
     /* RegisteredRunner API */
-    SharedMemPagesRr(): owner(nullptr) {}
     void useConfig() override;
+    void syncConfig() override;
     void create() override;
     void open() override;
     ~SharedMemPagesRr() override;
 
 private:
-    Ipc::Mem::PagePool::Owner *owner;
+    std::vector<Ipc::Mem::PagePool::Owner *> owners;
 };
 
 DefineRunnerRegistrator(SharedMemPagesRr);
@@ -111,30 +233,64 @@ SharedMemPagesRr::useConfig()
     if (Ipc::Mem::PageLimit() <= 0)
         return;
 
+    // all processes must agree on the pools, so we only use config and
+    // machine topology here
+    const auto &nodes = Ipc::Mem::NumaTopology::Current().nodes();
+    if (Config.shmNuma && nodes.size() > 1 && Ipc::Mem::PageLimit() >= nodes.size())
+        ThePoolNodes = nodes;
+    else
+        ThePoolNodes.assign(1, -1);
+
+    if (Config.shmNuma && ThePoolNodes.size() <= 1)
+        debugs(54, 2, "using a single page pool; NUMA nodes: " << nodes.size());
+
     Ipc::Mem::RegisteredRunner::useConfig();
 }
 
+void
+SharedMemPagesRr::syncConfig()
+{
+    // cpu_affinity_map may have changed
+    TheLocalPool = -1;
+}
+
 void
 SharedMemPagesRr::create()
 {
-    Must(!owner);
-    owner = Ipc::Mem::PagePool::Init(PagePoolId,
-                                     Ipc::Mem::PageStack::IdForMultipurposePool(),
-                                     Ipc::Mem::PageLimit(),
-                                     Ipc::Mem::PageSize());
+    Must(owners.empty());
+    const auto pools = ThePoolNodes.size();
+    const auto limit = Ipc::Mem::PageLimit();
+    for (size_t i = 0; i < pools; ++i) {
+        const auto capacity = limit/pools + (i < limit % pools ? 1 : 0);
+        const auto owner = Ipc::Mem::PagePool::Init(PoolSegmentId(i).c_str(),
+                           Ipc::Mem::PageStack::IdForMultipurposePool() + i,
+                           capacity,
+                           Ipc::Mem::PageSize());
+        owners.push_back(owner);
+
+        const auto node = ThePoolNodes[i];
+        if (node >= 0 && !Ipc::Mem::NumaTopology::Prefer(owner->object(), owner->object()->sharedMemorySize(), node)) {
+            static bool warnedOnce = false;
+            debugs(54, (warnedOnce ? 2 : DBG_IMPORTANT), "WARNING: Cannot place shared memory pages on NUMA node " << node <<
+                   Debug::Extra << "pages will be allocated wherever the OS decides");
+            warnedOnce = true;
+        }
+    }
 }
 
 void
 SharedMemPagesRr::open()
 {
-    Must(!ThePagePool);
-    ThePagePool = new Ipc::Mem::PagePool(PagePoolId);
+    Must(ThePagePools.empty());
+    for (size_t i = 0; i < ThePoolNodes.size(); ++i)
+        ThePagePools.push_back(new Ipc::Mem::PagePool(PoolSegmentId(i).c_str()));
 }
 
 SharedMemPagesRr::~SharedMemPagesRr()
 {
-    delete ThePagePool;
-    ThePagePool = nullptr;
-    delete owner;
+    for (const auto pool: ThePagePools)
+        delete pool;
+    ThePagePools.clear();
+    for (const auto owner: owners)
+        delete owner;
 }
-
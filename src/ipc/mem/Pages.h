@@ -28,6 +28,23 @@ void PutPage(PageId &page);
 /// converts page handler into a temporary writeable shared memory pointer
 char *PagePointer(const PageId &page);
 
+/* NUMA-aware page placement (see shared_memory_numa) */
+
+/// the number of page pools; GetPage() prefers the pool local to this process
+size_t PagePoolCount();
+
+/// the NUMA node of the page pool local to this process or -1 if this process
+/// is not bound to a single node with a page pool
+int LocalPageNode();
+
+/// whether the page belongs to the page pool local to this process;
+/// always true when there is only one page pool
+bool PageIsLocal(const PageId &page);
+
+/// replaces a page from a remote pool with a free page of the same purpose
+/// from the local pool, if possible
+void PreferLocalPage(PageId &page);
+
 /* Limits and statistics */
 
 /// the total number of shared memory pages that can be in use at any time
@@ -53,6 +70,10 @@ inline size_t PagesAvailable(const int purpose) { return PageLimit(purpose) - Pa
 /// returns page size in bytes; all pages are assumed to be the same size
 size_t PageSize();
 
+/// the alignment of PagePointer() buffers in bytes; pages are suitable for
+/// O_DIRECT disk I/O that requires this (or smaller) alignment
+size_t PageAlignment();
+
 /// claim the need for a number of pages for a given purpose
 void NotePageNeed(const int purpose, const int count);
 
@@ -18,8 +18,14 @@
 #include "ipc/mem/Segment.h"
 #include "sbuf/SBuf.h"
 #include "SquidConfig.h"
+#include "Store.h"
 #include "tools.h"
 
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
 #if HAVE_FCNTL_H
 #include <fcntl.h>
 #endif
@@ -29,10 +35,47 @@
 #if HAVE_SYS_STAT_H
 #include <sys/stat.h>
 #endif
+#if HAVE_SYS_VFS_H
+#include <sys/vfs.h>
+#endif
 
 // test cases change this
 const char *Ipc::Mem::Segment::BasePath = DEFAULT_STATEDIR;
 
+/// all Segment objects in this process
+static std::vector<const Ipc::Mem::Segment*> &
+SegmentRegistry()
+{
+    static const auto registry = new std::vector<const Ipc::Mem::Segment*>();
+    return *registry;
+}
+
+/// the size of regular memory pages
+static size_t
+RegularPageSize()
+{
+    static const auto pageSize = [] {
+        const auto value = sysconf(_SC_PAGESIZE);
+        return value > 0 ? static_cast<size_t>(value) : size_t(4096);
+    }();
+    return pageSize;
+}
+
+void
+Ipc::Mem::Segment::Report(StoreEntry * const sentry)
+{
+    static const char *modes[] = { "off", "transparent", "hugetlbfs" };
+    storeAppendPrintf(sentry, "shared_memory_huge_pages: %s\n", modes[Config.shmHugePages.mode]);
+    storeAppendPrintf(sentry, "%-48s %14s %12s %s\n", "Segment", "Size (bytes)", "Page size", "Backing");
+    for (const auto segment: SegmentRegistry()) {
+        if (!segment->theMem)
+            continue;
+        storeAppendPrintf(sentry, "%-48s %14" PRId64 " %12zu %s\n",
+                          segment->theName.termedBuf(), static_cast<int64_t>(segment->theSize),
+                          segment->thePageSize, segment->theBacking);
+    }
+}
+
 void *
 Ipc::Mem::Segment::reserve(size_t chunkSize)
 {
@@ -59,13 +102,18 @@ Ipc::Mem::Segment::Name(const SBuf &prefix, const char *suffix)
 #if HAVE_SHM
 
 Ipc::Mem::Segment::Segment(const char *const id):
-    theFD(-1), theName(GenerateName(id)), theMem(nullptr),
-    theSize(0), theReserved(0), doUnlink(false)
+    theFD(-1), inHugetlbfs(false), theName(GenerateName(id)), theMem(nullptr),
+    theSize(0), theReserved(0), doUnlink(false),
+    thePageSize(RegularPageSize()), theBacking("regular pages")
 {
+    SegmentRegistry().push_back(this);
 }
 
 Ipc::Mem::Segment::~Segment()
 {
+    auto &registry = SegmentRegistry();
+    registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+
     if (theFD >= 0) {
         detach();
         if (xclose(theFD) != 0) {
@@ -90,6 +138,9 @@ Ipc::Mem::Segment::create(const off_t aSize)
     assert(aSize > 0);
     assert(theFD < 0);
 
+    if (Config.shmHugePages.mode == SquidConfig::ShmHugePages::hugetlbfs && createInHugetlbfs(aSize))
+        return;
+
     int xerrno = 0;
 
     // Why a brand new segment? A Squid crash may leave a reusable segment, but
@@ -133,7 +184,9 @@ Ipc::Mem::Segment::open(const bool unlinkWhenDone)
 {
     assert(theFD < 0);
 
-    theFD = shm_open(theName.termedBuf(), O_RDWR, 0);
+    // the creator falls back to regular pages when hugetlbfs does not work
+    if (Config.shmHugePages.mode != SquidConfig::ShmHugePages::hugetlbfs || !openInHugetlbfs())
+        theFD = shm_open(theName.termedBuf(), O_RDWR, 0);
     if (theFD < 0) {
         int xerrno = errno;
         debugs(54, 5, "shm_open " << theName << ": " << xstrerr(xerrno));
@@ -182,6 +235,9 @@ Ipc::Mem::Segment::attach()
     }
     theMem = p;
 
+    if (Config.shmHugePages.mode == SquidConfig::ShmHugePages::transparent)
+        adviseHugePages();
+
     lock();
 }
 
@@ -237,6 +293,16 @@ Ipc::Mem::Segment::lock()
 void
 Ipc::Mem::Segment::unlink()
 {
+    if (inHugetlbfs) {
+        auto path = hugetlbfsPath();
+        if (::unlink(path.c_str()) != 0) {
+            const auto xerrno = errno;
+            debugs(54, 5, "unlink(" << path << "): " << xstrerr(xerrno));
+        } else
+            debugs(54, 3, "unlinked " << path << " segment");
+        return;
+    }
+
     if (shm_unlink(theName.termedBuf()) != 0) {
         int xerrno = errno;
         debugs(54, 5, "shm_unlink(" << theName << "): " << xstrerr(xerrno));
@@ -263,6 +329,166 @@ Ipc::Mem::Segment::statSize(const char *context) const
     return s.st_size;
 }
 
+/// the hugetlbfs magic number, as in Linux include/uapi/linux/magic.h
+static const unsigned long HugetlbfsMagic = 0x958458f6;
+
+/// Creates, sizes, and maps a brand new segment file in the configured
+/// hugetlbfs directory. Cleans up and returns false on failures; the caller
+/// then falls back to a regular shared memory segment.
+bool
+Ipc::Mem::Segment::createInHugetlbfs(const off_t aSize)
+{
+#if _SQUID_LINUX_ && HAVE_SYS_VFS_H
+    auto path = hugetlbfsPath();
+
+    // see create() for why we want a brand new file
+    (void)::unlink(path.c_str());
+    theFD = xopen(path.c_str(), O_EXCL | O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+    if (theFD < 0) {
+        cannotUseHugePages("cannot create a hugetlbfs file", errno);
+        return false;
+    }
+
+    const char *problem = nullptr;
+    int xerrno = 0;
+    void *p = MAP_FAILED;
+    off_t size = 0;
+    struct statfs fs;
+    memset(&fs, 0, sizeof(fs));
+    if (fstatfs(theFD, &fs) != 0) {
+        xerrno = errno;
+        problem = "fstatfs(2) failure";
+    } else if (static_cast<unsigned long>(fs.f_type) != HugetlbfsMagic || fs.f_bsize <= 0) {
+        problem = "shared_memory_huge_pages directory is not a hugetlbfs mount point";
+    } else {
+        // hugetlbfs files are made of whole huge pages
+        const off_t hugePageSize = fs.f_bsize;
+        size = ((aSize + hugePageSize - 1) / hugePageSize) * hugePageSize;
+        if (ftruncate(theFD, size) != 0) {
+            xerrno = errno;
+            problem = "ftruncate(2) failure";
+        } else if (size != static_cast<off_t>(static_cast<size_t>(size))) {
+            problem = "segment is too big";
+        } else {
+            // the kernel reserves huge pages here and fails if there are not enough
+            p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, theFD, 0);
+            if (p == MAP_FAILED) {
+                xerrno = errno;
+                problem = "mmap(2) failure; are there enough huge pages reserved?";
+            }
+        }
+    }
+
+    if (problem) {
+        (void)xclose(theFD);
+        theFD = -1;
+        (void)::unlink(path.c_str());
+        cannotUseHugePages(problem, xerrno);
+        return false;
+    }
+
+    inHugetlbfs = true;
+    theMem = p;
+    theSize = size;
+    theReserved = 0;
+    doUnlink = true;
+    thePageSize = fs.f_bsize;
+    theBacking = "hugetlbfs";
+    debugs(54, 3, "created " << path << " segment: " << theSize);
+
+    lock();
+    return true;
+#else
+    (void)aSize;
+    cannotUseHugePages("hugetlbfs is not supported on this platform");
+    return false;
+#endif
+}
+
+/// Opens a segment file that create() has placed in the configured hugetlbfs
+/// directory, if any. Does not attach() to the segment.
+bool
+Ipc::Mem::Segment::openInHugetlbfs()
+{
+#if _SQUID_LINUX_ && HAVE_SYS_VFS_H
+    auto path = hugetlbfsPath();
+    theFD = xopen(path.c_str(), O_RDWR, 0);
+    if (theFD < 0) {
+        const auto xerrno = errno;
+        debugs(54, 5, "will use shm_open() after open(" << path << "): " << xstrerr(xerrno));
+        return false;
+    }
+
+    struct statfs fs;
+    memset(&fs, 0, sizeof(fs));
+    if (fstatfs(theFD, &fs) == 0 && fs.f_bsize > 0)
+        thePageSize = fs.f_bsize;
+    inHugetlbfs = true;
+    theBacking = "hugetlbfs";
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// the name of the segment file in the configured hugetlbfs directory
+SBuf
+Ipc::Mem::Segment::hugetlbfsPath() const
+{
+    const char *directory = Config.shmHugePages.directory;
+    SBuf path(directory ? directory : "/dev/hugepages");
+    if (!path.isEmpty() && *path.rbegin() != '/')
+        path.append('/');
+    const auto name = theName.termedBuf();
+    const auto slash = strrchr(name, '/');
+    path.append(slash ? slash + 1 : name);
+    return path;
+}
+
+/// asks the kernel to back the attached segment with transparent huge pages
+void
+Ipc::Mem::Segment::adviseHugePages()
+{
+#if defined(MADV_HUGEPAGE)
+    if (madvise(theMem, theSize, MADV_HUGEPAGE) != 0) {
+        cannotUseHugePages("madvise(MADV_HUGEPAGE) failure", errno);
+        return;
+    }
+
+    // On Linux, the shared memory policy may ignore our advice. Missing files
+    // mean that the kernel lacks shmem THP support and will ignore it as well.
+    std::ifstream enabled("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+    std::string policy;
+    if (!std::getline(enabled, policy) ||
+            policy.find("[never]") != std::string::npos ||
+            policy.find("[deny]") != std::string::npos) {
+        cannotUseHugePages("transparent huge pages are disabled for shared memory (see /sys/kernel/mm/transparent_hugepage/shmem_enabled)");
+        return;
+    }
+
+    size_t hugePageSize = 0;
+    std::ifstream pmdSize("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+    if (pmdSize >> hugePageSize && hugePageSize > thePageSize)
+        thePageSize = hugePageSize;
+    theBacking = "transparent huge pages (advised)";
+    debugs(54, 5, "advised " << theName << " to use transparent huge pages; policy: " << policy);
+#else
+    cannotUseHugePages("no madvise(MADV_HUGEPAGE) support");
+#endif
+}
+
+/// reports a failure to back this segment with huge pages
+void
+Ipc::Mem::Segment::cannotUseHugePages(const char * const reason, const int xerrno) const
+{
+    static bool warnedOnce = false;
+    debugs(54, (warnedOnce ? 2 : DBG_IMPORTANT), "WARNING: Cannot use huge pages for shared memory segment " <<
+           theName << "; using regular pages" <<
+           Debug::Extra << "problem: " << reason <<
+           (xerrno ? ": " : "") << (xerrno ? xstrerr(xerrno) : ""));
+    warnedOnce = true;
+}
+
 /// Generate name for shared memory segment. Starts with a prefix required
 /// for cross-platform portability and replaces all slashes in ID with dots.
 String
@@ -302,12 +528,17 @@ typedef std::map<String, Ipc::Mem::Segment *> SegmentMap;
 static SegmentMap Segments;
 
 Ipc::Mem::Segment::Segment(const char *const id):
-    theName(id), theMem(NULL), theSize(0), theReserved(0), doUnlink(false)
+    theName(id), theMem(NULL), theSize(0), theReserved(0), doUnlink(false),
+    thePageSize(RegularPageSize()), theBacking("regular pages (fake segment)")
 {
+    SegmentRegistry().push_back(this);
 }
 
 Ipc::Mem::Segment::~Segment()
 {
+    auto &registry = SegmentRegistry();
+    registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+
     if (doUnlink) {
         delete [] static_cast<char *>(theMem);
         theMem = nullptr;
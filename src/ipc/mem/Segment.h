@@ -12,6 +12,7 @@
 #include "base/RunnersRegistry.h"
 #include "sbuf/forward.h"
 #include "SquidString.h"
+#include "store/forward.h"
 
 namespace Ipc
 {
@@ -41,6 +42,14 @@ public:
     void *mem() { return reserve(0); } ///< pointer to the next chunk
     void *reserve(size_t chunkSize); ///< reserve and return the next chunk
 
+    /// the size of memory pages backing this segment
+    size_t pageSize() const { return thePageSize; }
+    /// a human-friendly description of memory pages backing this segment
+    const char *backing() const { return theBacking; }
+
+    /// reports all attached segments (the shm_segments cache manager action)
+    static void Report(StoreEntry *);
+
     /// common path of all segment names in path-based environments
     static const char *BasePath;
 
@@ -62,9 +71,16 @@ private:
     void unlink(); ///< unlink the segment
     off_t statSize(const char *context) const;
 
+    bool createInHugetlbfs(off_t aSize);
+    bool openInHugetlbfs();
+    SBuf hugetlbfsPath() const;
+    void adviseHugePages();
+    void cannotUseHugePages(const char *reason, int xerrno = 0) const;
+
     static String GenerateName(const char *id);
 
     int theFD; ///< shared memory segment file descriptor
+    bool inHugetlbfs; ///< whether theFD refers to a hugetlbfs file
 
 #else // HAVE_SHM
 
@@ -77,6 +93,8 @@ private:
     off_t theSize; ///< shared memory segment size
     off_t theReserved; ///< the total number of reserve()d bytes
     bool doUnlink; ///< whether the segment should be unlinked on destruction
+    size_t thePageSize; ///< the size of pages backing the segment
+    const char *theBacking; ///< the kind of pages backing the segment
 };
 
 /// Base class for runners that create and open shared memory segments.
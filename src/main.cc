@@ -35,6 +35,7 @@
 #include "event.h"
 #include "EventLoop.h"
 #include "ExternalACL.h"
+#include "fatal.h"
 #include "fd.h"
 #include "format/Token.h"
 #include "fqdncache.h"
@@ -854,6 +855,8 @@ mainReconfigureFinish(void *)
         Config2.onoff.enable_purge = 2;
 
     const int oldWorkers = Config.workers;
+    const auto oldKeyHash = Config.Store.keyHash;
+    const auto oldAdmissionFilter = Config.Store.admissionFilter;
 
     try {
         Configuration::Parse();
@@ -869,6 +872,16 @@ mainReconfigureFinish(void *)
         Config.workers = oldWorkers;
     }
 
+    if (oldKeyHash != Config.Store.keyHash) {
+        debugs(1, DBG_CRITICAL, "WARNING: Changing 'store_key_hash' requires a full restart. It has been ignored by reconfigure.");
+        Config.Store.keyHash = oldKeyHash;
+    }
+
+    if (oldAdmissionFilter != Config.Store.admissionFilter) {
+        debugs(1, DBG_CRITICAL, "WARNING: Changing 'store_admission_filter' requires a full restart. It has been ignored by reconfigure.");
+        Config.Store.admissionFilter = oldAdmissionFilter;
+    }
+
     RunRegisteredHere(RegisteredRunner::syncConfig);
 
     if (IamPrimaryProcess())
@@ -1381,6 +1394,7 @@ RegisterModules()
     CallRunnerRegistrator(SharedSessionCacheRr);
     CallRunnerRegistrator(TransientsRr);
     CallRunnerRegistratorIn(Dns, ConfigRr);
+    CallRunnerRegistratorIn(Store, AdmissionFilterRr);
 
 #if HAVE_DISKIO_MODULE_IPCIO
     CallRunnerRegistrator(IpcIoRr);
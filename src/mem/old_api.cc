@@ -73,6 +73,27 @@ GetPool(size_t type)
     return pools[type];
 }
 
+/// reports how often memAllocBuf() pools, including those supplying I/O
+/// read buffers, recycled idle buffers instead of allocating new ones
+static void
+BufPoolsReport(std::ostream &stream)
+{
+    stream.setf(std::ios_base::fixed);
+    stream << "Buffer pools:\n";
+    stream << "Pool\t Allocations\t Recycled\t New\t %Recycled\n";
+    for (int type = MEM_32B_BUF; type <= MEM_64K_BUF; ++type) {
+        const auto pool = GetPool(type);
+        pool->flushCounters();
+        const auto allocations = pool->meter.gb_allocated.count;
+        const auto hits = pool->meter.gb_saved.count;
+        stream << pool->label << "\t " <<
+               std::setprecision(0) << allocations << "\t " <<
+               hits << "\t " <<
+               (allocations - hits) << "\t " <<
+               std::setprecision(2) << xpercent(hits, allocations) << "\n";
+    }
+}
+
 void
 Mem::Stats(StoreEntry * sentry)
 {
@@ -83,6 +104,8 @@ Mem::Stats(StoreEntry * sentry)
            HugeBufCountMeter.currentLevel() << " (" <<
            HugeBufVolumeMeter.currentLevel() / 1024 << " KB)\n";
 
+    BufPoolsReport(stream);
+
 #if WITH_VALGRIND
     if (RUNNING_ON_VALGRIND) {
         long int leaked = 0, dubious = 0, reachable = 0, suppressed = 0;
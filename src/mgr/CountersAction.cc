@@ -89,6 +89,10 @@ Mgr::CountersActionData::operator += (const CountersActionData& stats)
     hitValidationRefusalsDueToZeroSize += stats.hitValidationRefusalsDueToZeroSize;
     hitValidationRefusalsDueToTimeLimit += stats.hitValidationRefusalsDueToTimeLimit;
     hitValidationFailures += stats.hitValidationFailures;
+    tcpFastOpenAccepts += stats.tcpFastOpenAccepts;
+    tcpFastOpenAttempts += stats.tcpFastOpenAttempts;
+    tcpFastOpenSuccesses += stats.tcpFastOpenSuccesses;
+    tcpFastOpenFallbacks += stats.tcpFastOpenFallbacks;
 
     return *this;
 }
@@ -85,6 +85,10 @@ public:
     double hitValidationRefusalsDueToZeroSize;
     double hitValidationRefusalsDueToTimeLimit;
     double hitValidationFailures;
+    double tcpFastOpenAccepts;
+    double tcpFastOpenAttempts;
+    double tcpFastOpenSuccesses;
+    double tcpFastOpenFallbacks;
 };
 
 /// implement aggregated 'counters' action
@@ -90,6 +90,10 @@ Mgr::IntervalActionData::operator += (const IntervalActionData& stats)
     hitValidationRefusalsDueToZeroSize += stats.hitValidationRefusalsDueToZeroSize;
     hitValidationRefusalsDueToTimeLimit += stats.hitValidationRefusalsDueToTimeLimit;
     hitValidationFailures += stats.hitValidationFailures;
+    tcpFastOpenAccepts += stats.tcpFastOpenAccepts;
+    tcpFastOpenAttempts += stats.tcpFastOpenAttempts;
+    tcpFastOpenSuccesses += stats.tcpFastOpenSuccesses;
+    tcpFastOpenFallbacks += stats.tcpFastOpenFallbacks;
     syscalls_disk_opens += stats.syscalls_disk_opens;
     syscalls_disk_closes += stats.syscalls_disk_closes;
     syscalls_disk_reads += stats.syscalls_disk_reads;
@@ -85,6 +85,10 @@ public:
     double hitValidationRefusalsDueToZeroSize;
     double hitValidationRefusalsDueToTimeLimit;
     double hitValidationFailures;
+    double tcpFastOpenAccepts;
+    double tcpFastOpenAttempts;
+    double tcpFastOpenSuccesses;
+    double tcpFastOpenFallbacks;
     double syscalls_disk_opens;
     double syscalls_disk_closes;
     double syscalls_disk_reads;
@@ -570,6 +570,10 @@ neighborsUdpPing(HttpRequest * request,
 
     reqnum = icpSetCacheKey((const cache_key *)entry->key);
 
+    // send all ICP queries for this entry using one sendmmsg(2) call
+    if (Comm::IsConnOpen(icpOutgoingConn))
+        icpBeginSendBatch(icpOutgoingConn->fd);
+
     const auto savedContext = CodeContext::Current();
     for (size_t i = 0; i < Config.peers->size(); ++i) {
         const auto p = &Config.peers->nextPeerToPing(i);
@@ -607,8 +611,11 @@ neighborsUdpPing(HttpRequest * request,
                 continue;
             } else {
 
-                if (p->type == PEER_MULTICAST)
+                if (p->type == PEER_MULTICAST) {
+                    // the TTL applies to all datagrams in the next sendmmsg(2)
+                    icpFlushSendBatch();
                     mcastSetTtl(icpOutgoingConn->fd, p->mcast.ttl);
+                }
 
                 if (p->icp.port == echo_port) {
                     debugs(15, 4, "neighborsUdpPing: Looks like a dumb cache, send DECHO ping");
@@ -665,6 +672,7 @@ neighborsUdpPing(HttpRequest * request,
             p->stats.probe_start = squid_curtime;
     }
     CodeContext::Reset(savedContext);
+    icpEndSendBatch();
 
     /*
      * How many replies to expect?
@@ -730,7 +738,8 @@ peerDigestLookup(CachePeer * p, PeerSelector * ps)
     assert(p->digest->cd);
     /* does digest predict a hit? */
 
-    if (!p->digest->cd->contains(storeKeyPublicByRequest(request)))
+    // digests always use MD5 keys, regardless of store_key_hash
+    if (!p->digest->cd->contains(storeKeyPublicByRequestMethod(request, request->method, ksDefault, khMd5)))
         return LOOKUP_MISS;
 
     debugs(15, 5, "HIT for cache_peer " << *p);
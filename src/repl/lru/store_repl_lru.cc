@@ -9,6 +9,7 @@
 /* DEBUG: none          LRU Removal Policy */
 
 #include "squid.h"
+#include "fatal.h"
 #include "MemObject.h"
 #include "Store.h"
 
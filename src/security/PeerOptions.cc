@@ -16,6 +16,7 @@
 #include "security/PeerOptions.h"
 
 #if USE_OPENSSL
+#include "ssl/bio.h"
 #include "ssl/support.h"
 #endif
 
@@ -429,6 +430,13 @@ static struct ssl_option {
     {
         "SINGLE_ECDH_USE", SSL_OP_SINGLE_ECDH_USE
     },
+#endif
+#if defined(SSL_OP_ENABLE_KTLS) && SQUID_BIO_KTLS
+    {
+        "ENABLE_KTLS", SSL_OP_ENABLE_KTLS
+    },
+#else
+    { "ENABLE_KTLS", 0 },
 #endif
     {
         "", 0
@@ -22,6 +22,7 @@
 #include "comm/TcpAcceptor.h"
 #include "comm/Write.h"
 #include "errorpage.h"
+#include "fatal.h"
 #include "fd.h"
 #include "ftp/Elements.h"
 #include "ftp/Parsing.h"
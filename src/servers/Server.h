@@ -75,6 +75,20 @@ public:
         Comm::Write(clientConnection, mb, writer);
     }
 
+    /// schedule a vectored Comm::Write() of mb contents followed by more buffers
+    void write(MemBuf *mb, const Comm::WriteVector &more) {
+        typedef CommCbMemFunT<Server, CommIoCbParams> Dialer;
+        writer = JobCallback(33, 5, Dialer, this, Server::clientWriteDone);
+        Comm::Write(clientConnection, mb, more, writer);
+    }
+
+    /// schedule a Comm::WriteFile() of size bytes starting at fileOffset
+    void writeFile(const int fileFd, const off_t fileOffset, const int size) {
+        typedef CommCbMemFunT<Server, CommIoCbParams> Dialer;
+        writer = JobCallback(33, 5, Dialer, this, Server::clientWriteDone);
+        Comm::WriteFile(clientConnection, fileFd, fileOffset, size, writer);
+    }
+
     /// schedule some data for a Comm::Write()
     void write(char *buf, int len) {
         typedef CommCbMemFunT<Server, CommIoCbParams> Dialer;
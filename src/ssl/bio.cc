@@ -100,10 +100,16 @@ Ssl::Bio::Bio(const int anFd): fd_(anFd)
 Ssl::Bio::~Bio()
 {
     debugs(83, 7, "Bio destructing, this=" << this << " FD " << fd_);
+    if (kernelTls_)
+        BIO_free(kernelTls_); // BIO_NOCLOSE: does not close fd_
 }
 
 int Ssl::Bio::write(const char *buf, int size, BIO *table)
 {
+    // the kernel encrypts; kernelTls_ also sends OpenSSL control records
+    if (kernelTlsSending())
+        return kernelTlsIo(BIO_write(kernelTls_, buf, size), table);
+
     errno = 0;
 #if _SQUID_WINDOWS_
     const int result = socket_write_method(fd_, buf, size);
@@ -127,6 +133,10 @@ int Ssl::Bio::write(const char *buf, int size, BIO *table)
 int
 Ssl::Bio::read(char *buf, int size, BIO *table)
 {
+    // the kernel decrypts; kernelTls_ reassembles records OpenSSL expects
+    if (kernelTlsReceiving())
+        return kernelTlsIo(BIO_read(kernelTls_, buf, size), table);
+
     errno = 0;
 #if _SQUID_WINDOWS_
     const int result = socket_read_method(fd_, buf, size);
@@ -147,6 +157,67 @@ Ssl::Bio::read(char *buf, int size, BIO *table)
     return result;
 }
 
+long
+Ssl::Bio::kernelTlsCtrl(const int cmd, const long arg1, void *arg2)
+{
+#if SQUID_BIO_KTLS
+    if (cmd == BIO_CTRL_SET_KTLS) {
+        const auto sending = arg1 != 0;
+        if (kernelTlsUnsafe(sending)) {
+            debugs(83, 3, "FD " << fd_ << " keeps TLS " << (sending ? "encryption" : "decryption") << " in OpenSSL due to buffered data");
+            return 0;
+        }
+        if (!kernelTls_ && !(kernelTls_ = BIO_new_socket(fd_, BIO_NOCLOSE))) {
+            debugs(83, 2, "FD " << fd_ << " cannot create a socket BIO: " << Ssl::ReportAndForgetErrors);
+            return 0;
+        }
+        const auto result = BIO_ctrl(kernelTls_, cmd, arg1, arg2);
+        debugs(83, 3, "FD " << fd_ << (result > 0 ? " offloaded" : " failed to offload") <<
+               " TLS " << (sending ? "encryption" : "decryption") << " to the kernel");
+        return result;
+    }
+
+    if (!kernelTls_)
+        return 0; // OpenSSL has not asked us to use kTLS yet
+
+    return BIO_ctrl(kernelTls_, cmd, arg1, arg2);
+#else
+    (void)cmd;
+    (void)arg1;
+    (void)arg2;
+    return 0;
+#endif
+}
+
+/// whether OpenSSL gave the kernel our TLS record encryption duties
+bool
+Ssl::Bio::kernelTlsSending() const
+{
+    return kernelTls_ && BIO_get_ktls_send(kernelTls_);
+}
+
+/// whether OpenSSL gave the kernel our TLS record decryption duties
+bool
+Ssl::Bio::kernelTlsReceiving() const
+{
+    return kernelTls_ && BIO_get_ktls_recv(kernelTls_);
+}
+
+/// relays kernelTls_ I/O result and retry flags to OpenSSL
+int
+Ssl::Bio::kernelTlsIo(const int result, BIO *table)
+{
+    debugs(83, 5, "FD " << fd_ << " kTLS I/O result: " << result);
+    BIO_clear_retry_flags(table);
+    if (result <= 0 && BIO_should_retry(kernelTls_)) {
+        if (BIO_should_read(kernelTls_))
+            BIO_set_retry_read(table);
+        if (BIO_should_write(kernelTls_))
+            BIO_set_retry_write(table);
+    }
+    return result;
+}
+
 /// Called whenever the SSL connection state changes, an alert appears, or an
 /// error occurs. See SSL_set_info_callback().
 void
@@ -238,6 +309,12 @@ Ssl::ClientBio::read(char *buf, int size, BIO *table)
     return -1;
 }
 
+bool
+Ssl::ClientBio::kernelTlsUnsafe(const bool sending) const
+{
+    return abortReason || holdRead_ || holdWrite_ || Ssl::Bio::kernelTlsUnsafe(sending);
+}
+
 Ssl::ServerBio::ServerBio(const int anFd):
     Bio(anFd),
     helloMsgSize(0),
@@ -429,6 +506,14 @@ Ssl::ServerBio::flush(BIO *table)
     }
 }
 
+bool
+Ssl::ServerBio::kernelTlsUnsafe(const bool sending) const
+{
+    if (sending)
+        return holdWrite_ || !helloMsg.isEmpty();
+    return record_ || rbufConsumePos < rbuf.length();
+}
+
 bool
 Ssl::ServerBio::resumingSession()
 {
@@ -538,6 +623,20 @@ squid_bio_ctrl(BIO *table, int cmd, long arg1, void *arg2)
         }
         return 0;
 
+#if SQUID_BIO_KTLS
+    case BIO_CTRL_SET_KTLS:
+    case BIO_CTRL_SET_KTLS_TX_SEND_CTRL_MSG:
+    case BIO_CTRL_CLEAR_KTLS_TX_CTRL_MSG:
+    case BIO_CTRL_GET_KTLS_SEND:
+    case BIO_CTRL_GET_KTLS_RECV:
+        if (BIO_get_init(table)) {
+            Ssl::Bio *bio = static_cast<Ssl::Bio*>(BIO_get_data(table));
+            assert(bio);
+            return bio->kernelTlsCtrl(cmd, arg1, arg2);
+        }
+        return 0;
+#endif
+
     /*  we may also need to implement these:
         case BIO_CTRL_RESET:
         case BIO_C_FILE_SEEK:
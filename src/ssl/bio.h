@@ -26,6 +26,17 @@
 #include <string>
 #include <type_traits>
 
+/// Whether OpenSSL headers define all BIO_ctrl() commands sent by kTLS code.
+/// Stock OpenSSL v3 keeps some of them private; kTLS cannot work through
+/// Squid BIOs without them, so ENABLE_KTLS is rejected as unsupported.
+#if defined(BIO_CTRL_SET_KTLS) && defined(BIO_CTRL_SET_KTLS_TX_SEND_CTRL_MSG) && \
+    defined(BIO_CTRL_CLEAR_KTLS_TX_CTRL_MSG) && defined(BIO_CTRL_GET_KTLS_SEND) && \
+    defined(BIO_CTRL_GET_KTLS_RECV)
+#define SQUID_BIO_KTLS 1
+#else
+#define SQUID_BIO_KTLS 0
+#endif
+
 namespace Ssl
 {
 
@@ -59,9 +70,27 @@ public:
     static void Link(SSL *ssl, BIO *bio);
 
     const SBuf &rBufData() {return rbuf;} ///< The buffered input data
+
+    /// Handles OpenSSL requests to offload TLS record encryption or
+    /// decryption to the kernel (kTLS) and related kTLS state queries.
+    /// \returns BIO_ctrl() result for the given kTLS command
+    long kernelTlsCtrl(int cmd, long arg1, void *arg2);
+
 protected:
+    /// whether we buffer or rewrite bytes in the given direction and,
+    /// hence, cannot let the kernel take over TLS records in that direction
+    virtual bool kernelTlsUnsafe(const bool sending) const { return !sending && !rbuf.isEmpty(); }
+
     const int fd_; ///< the SSL socket we are reading and writing
     SBuf rbuf;  ///< Used to buffer input data.
+
+private:
+    bool kernelTlsSending() const;
+    bool kernelTlsReceiving() const;
+    int kernelTlsIo(int result, BIO *table);
+
+    /// OpenSSL socket BIO for fd_, configured by OpenSSL for kTLS (or nil)
+    BIO *kernelTls_ = nullptr;
 };
 
 /// BIO node to handle socket IO for squid client side
@@ -89,6 +118,11 @@ public:
     /// Used to pass payload data (normally client HELLO data) retrieved
     /// by the caller.
     void setReadBufData(SBuf &data) {rbuf = data;}
+
+protected:
+    /* Bio API */
+    bool kernelTlsUnsafe(bool sending) const override;
+
 private:
     /// approximate size of a time window for computing client-initiated renegotiation rate (in seconds)
     static const time_t RenegotiationsWindow = 10;
@@ -169,6 +203,10 @@ public:
     /// \return the TLS Details advertised by TLS server.
     const Security::TlsDetails::Pointer &receivedHelloDetails() const {return parser_.details;}
 
+protected:
+    /* Bio API */
+    bool kernelTlsUnsafe(bool sending) const override;
+
 private:
     int readAndGive(char *buf, const int size, BIO *table);
     int readAndParse(char *buf, const int size, BIO *table);
@@ -25,6 +25,7 @@
 #include "http/Stream.h"
 #include "HttpRequest.h"
 #include "IoStats.h"
+#include "ipc/mem/Segment.h"
 #include "mem/Pool.h"
 #include "mem/Stats.h"
 #include "mem_node.h"
@@ -976,6 +977,11 @@ GetAvgStat(Mgr::IntervalActionData& stats, int minutes, int hours)
     stats.hitValidationRefusalsDueToTimeLimit = XAVG(hitValidation.refusalsDueToTimeLimit);
     stats.hitValidationFailures = XAVG(hitValidation.failures);
 
+    stats.tcpFastOpenAccepts = XAVG(tcpFastOpen.accepts);
+    stats.tcpFastOpenAttempts = XAVG(tcpFastOpen.attempts);
+    stats.tcpFastOpenSuccesses = XAVG(tcpFastOpen.successes);
+    stats.tcpFastOpenFallbacks = XAVG(tcpFastOpen.fallbacks);
+
     stats.syscalls_disk_opens = XAVG(syscalls.disk.opens);
     stats.syscalls_disk_closes = XAVG(syscalls.disk.closes);
     stats.syscalls_disk_reads = XAVG(syscalls.disk.reads);
@@ -1134,6 +1140,15 @@ DumpAvgStat(Mgr::IntervalActionData& stats, StoreEntry* sentry)
     storeAppendPrintf(sentry, "hit_validation.failures = %f/sec\n",
                       stats.hitValidationFailures);
 
+    storeAppendPrintf(sentry, "tcp_fast_open.accepts = %f/sec\n",
+                      stats.tcpFastOpenAccepts);
+    storeAppendPrintf(sentry, "tcp_fast_open.attempts = %f/sec\n",
+                      stats.tcpFastOpenAttempts);
+    storeAppendPrintf(sentry, "tcp_fast_open.successes = %f/sec\n",
+                      stats.tcpFastOpenSuccesses);
+    storeAppendPrintf(sentry, "tcp_fast_open.fallbacks = %f/sec\n",
+                      stats.tcpFastOpenFallbacks);
+
 #if USE_POLL
     storeAppendPrintf(sentry, "syscalls.polls = %f/sec\n", stats.syscalls_selects);
 #elif USE_SELECT
@@ -1199,6 +1214,8 @@ statRegisterWithCacheManager(void)
 #endif
     Mgr::RegisterAction("openfd_objects", "Objects with Swapout files open",
                         statOpenfdObj, 0, 0);
+    Mgr::RegisterAction("shm_segments", "Shared Memory Segments",
+                        Ipc::Mem::Segment::Report, 0, 1);
 #if STAT_GRAPHS
     Mgr::RegisterAction("graph_variables", "Display cache metrics graphically",
                         statGraphDump, 0, 1);
@@ -1434,6 +1451,11 @@ GetCountersStats(Mgr::CountersActionData& stats)
     stats.hitValidationRefusalsDueToZeroSize = f->hitValidation.refusalsDueToZeroSize;
     stats.hitValidationRefusalsDueToTimeLimit = f->hitValidation.refusalsDueToTimeLimit;
     stats.hitValidationFailures = f->hitValidation.failures;
+
+    stats.tcpFastOpenAccepts = f->tcpFastOpen.accepts;
+    stats.tcpFastOpenAttempts = f->tcpFastOpen.attempts;
+    stats.tcpFastOpenSuccesses = f->tcpFastOpen.successes;
+    stats.tcpFastOpenFallbacks = f->tcpFastOpen.fallbacks;
 }
 
 void
@@ -1570,6 +1592,15 @@ DumpCountersStats(Mgr::CountersActionData& stats, StoreEntry* sentry)
                       stats.hitValidationRefusalsDueToTimeLimit);
     storeAppendPrintf(sentry, "hit_validation.failures = %.0f\n",
                       stats.hitValidationFailures);
+
+    storeAppendPrintf(sentry, "tcp_fast_open.accepts = %.0f\n",
+                      stats.tcpFastOpenAccepts);
+    storeAppendPrintf(sentry, "tcp_fast_open.attempts = %.0f\n",
+                      stats.tcpFastOpenAttempts);
+    storeAppendPrintf(sentry, "tcp_fast_open.successes = %.0f\n",
+                      stats.tcpFastOpenSuccesses);
+    storeAppendPrintf(sentry, "tcp_fast_open.fallbacks = %.0f\n",
+                      stats.tcpFastOpenFallbacks);
 }
 
 static void
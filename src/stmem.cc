@@ -9,12 +9,15 @@
 /* DEBUG: section 19    Store Memory Primitives */
 
 #include "squid.h"
+#include "fatal.h"
 #include "Generic.h"
 #include "HttpReply.h"
 #include "mem_node.h"
 #include "MemObject.h"
 #include "stmem.h"
 
+#include <algorithm>
+
 /*
  * NodeGet() is called to get the data buffer to pass to storeIOWrite().
  * By setting the write_pending flag here we are assuming that there
@@ -33,10 +36,8 @@ mem_hdr::NodeGet(mem_node * aNode)
 int64_t
 mem_hdr::lowestOffset () const
 {
-    const SplayNode<mem_node *> *theStart = nodes.start();
-
-    if (theStart)
-        return theStart->data->nodeBuffer.offset;
+    if (!nodes.empty())
+        return nodes.front()->nodeBuffer.offset;
 
     return 0;
 }
@@ -45,10 +46,9 @@ int64_t
 mem_hdr::endOffset () const
 {
     int64_t result = 0;
-    const SplayNode<mem_node *> *theEnd = nodes.finish();
 
-    if (theEnd)
-        result = theEnd->data->dataRange().end;
+    if (!nodes.empty())
+        result = nodes.back()->dataRange().end;
 
     assert (result == inmem_hi);
 
@@ -58,21 +58,25 @@ mem_hdr::endOffset () const
 void
 mem_hdr::freeContent()
 {
-    nodes.destroy();
+    for (const auto node: nodes)
+        delete node;
+    nodes.clear();
     inmem_hi = 0;
     debugs(19, 9, this << " hi: " << inmem_hi);
 }
 
+/// removes and destroys the lowest node unless it is still being written
 bool
-mem_hdr::unlink(mem_node *aNode)
+mem_hdr::unlinkFirst()
 {
+    const auto aNode = nodes.front();
     if (aNode->write_pending) {
         debugs(0, DBG_CRITICAL, "ERROR: cannot unlink mem_node " << aNode << " while write_pending");
         return false;
     }
 
     debugs(19, 8, this << " removing " << aNode);
-    nodes.remove (aNode, NodeCompare);
+    nodes.pop_front();
     delete aNode;
     return true;
 }
@@ -82,16 +86,11 @@ mem_hdr::freeDataUpto(int64_t target_offset)
 {
     debugs(19, 8, this << " up to " << target_offset);
     /* keep the last one to avoid change to other part of code */
-    SplayNode<mem_node*> const * theStart;
-
-    while ((theStart = nodes.start())) {
-        if (theStart == nodes.finish())
+    while (nodes.size() > 1) {
+        if (nodes.front()->end() > target_offset)
             break;
 
-        if (theStart->data->end() > target_offset )
-            break;
-
-        if (!unlink(theStart->data))
+        if (!unlinkFirst())
             break;
     }
 
@@ -124,10 +123,48 @@ mem_hdr::writeAvailable(mem_node *aNode, int64_t location, size_t amount, char c
     return copyLen;
 }
 
+/// the last node that starts at or before the given location (or nodes.end())
+static mem_hdr::Nodes::const_iterator
+LastNodeStartingAtOrBefore(const mem_hdr::Nodes &nodes, const int64_t location)
+{
+    auto pos = std::upper_bound(nodes.begin(), nodes.end(), location,
+    [](const int64_t loc, const mem_node * const node) {
+        return loc < node->start();
+    });
+    return pos == nodes.begin() ? nodes.end() : --pos;
+}
+
+/// inserts a node that does not overlap with others, preserving the order
 void
 mem_hdr::appendNode (mem_node *aNode)
 {
-    nodes.insert (aNode, NodeCompare);
+    // optimization: new nodes usually go to the end
+    if (nodes.empty() || nodes.back()->start() < aNode->start()) {
+        nodes.push_back(aNode);
+        return;
+    }
+
+    const auto pos = std::upper_bound(nodes.begin(), nodes.end(), aNode->start(),
+    [](const int64_t loc, const mem_node * const node) {
+        return loc < node->start();
+    });
+    nodes.insert(pos, aNode);
+}
+
+/// the node containing the given location (or nodes.end())
+mem_hdr::Nodes::const_iterator
+mem_hdr::findNode(const int64_t location) const
+{
+    if (nodes.empty() || location < nodes.front()->start())
+        return nodes.end();
+
+    // optimization: appended content nodes are full and adjacent
+    const auto guess = (location - nodes.front()->start()) / SM_PAGE_SIZE;
+    if (guess < static_cast<int64_t>(nodes.size()) && nodes[guess]->contains(location))
+        return nodes.begin() + guess;
+
+    const auto pos = LastNodeStartingAtOrBefore(nodes, location);
+    return (pos != nodes.end() && (*pos)->contains(location)) ? pos : nodes.end();
 }
 
 /* returns a mem_node that contains location..
@@ -136,15 +173,8 @@ mem_hdr::appendNode (mem_node *aNode)
 mem_node *
 mem_hdr::getBlockContainingLocation (int64_t location) const
 {
-    // Optimize: do not create a whole mem_node just to store location
-    mem_node target (location);
-    target.nodeBuffer.length = 1;
-    mem_node *const *result = nodes.find (&target, NodeCompare);
-
-    if (result)
-        return *result;
-
-    return nullptr;
+    const auto pos = findNode(location);
+    return pos == nodes.end() ? nullptr : *pos;
 }
 
 size_t
@@ -172,7 +202,7 @@ mem_hdr::debugDump() const
     debugs (19, 0, "mem_hdr::debugDump: lowest offset: " << lowestOffset() << " highest offset + 1: " << endOffset() << ".");
     std::ostringstream result;
     PointerPrinter<mem_node *> foo(result, " - ");
-    getNodes().visit(foo);
+    std::for_each(nodes.begin(), nodes.end(), foo);
     debugs (19, 0, "mem_hdr::debugDump: Current available data is: " << result.str() << ".");
 }
 
@@ -203,9 +233,9 @@ mem_hdr::copy(StoreIOBuffer const &target) const
     assert(target.length > 0);
 
     /* Seek our way into store */
-    mem_node *p = getBlockContainingLocation(target.offset);
+    auto pos = findNode(target.offset);
 
-    if (!p) {
+    if (pos == nodes.end()) {
         debugs(19, DBG_IMPORTANT, "ERROR: memCopy: could not find start of " << target.range() <<
                " in memory.");
         debugDump();
@@ -220,8 +250,8 @@ mem_hdr::copy(StoreIOBuffer const &target) const
     /* Start copying beginning with this block until
      * we're satiated */
 
-    while (p && bytes_to_go > 0) {
-        size_t bytes_to_copy = copyAvailable (p,
+    while (pos != nodes.end() && bytes_to_go > 0) {
+        size_t bytes_to_copy = copyAvailable (*pos,
                                               location, bytes_to_go, ptr_to_buf);
 
         /* hit a sparse patch */
@@ -235,7 +265,8 @@ mem_hdr::copy(StoreIOBuffer const &target) const
 
         bytes_to_go -= bytes_to_copy;
 
-        p = getBlockContainingLocation(location);
+        // the next node, if any, starts at or after location
+        ++pos;
     }
 
     return target.length - bytes_to_go;
@@ -246,8 +277,8 @@ mem_hdr::hasContigousContentRange(Range<int64_t> const & range) const
 {
     int64_t currentStart = range.start;
 
-    while (mem_node *curr = getBlockContainingLocation(currentStart)) {
-        currentStart = curr->end();
+    for (auto pos = findNode(currentStart); pos != nodes.end() && (*pos)->contains(currentStart); ++pos) {
+        currentStart = (*pos)->end();
 
         if (currentStart >= range.end)
             return true;
@@ -260,9 +291,18 @@ bool
 mem_hdr::unionNotEmpty(StoreIOBuffer const &candidate)
 {
     assert (candidate.offset >= 0);
-    mem_node target(candidate.offset);
-    target.nodeBuffer.length = candidate.length;
-    return nodes.find (&target, NodeCompare);
+    const auto candidateRange = candidate.range();
+    if (!candidateRange.size())
+        return false;
+
+    // the node preceding or containing the candidate start
+    auto pos = LastNodeStartingAtOrBefore(nodes, candidateRange.start);
+    if (pos != nodes.end() && (*pos)->end() > candidateRange.start)
+        return true;
+
+    // the node following the candidate start
+    pos = (pos == nodes.end()) ? nodes.begin() : pos + 1;
+    return pos != nodes.end() && (*pos)->start() < candidateRange.end;
 }
 
 mem_node *
@@ -270,21 +310,20 @@ mem_hdr::nodeToRecieve(int64_t offset)
 {
     /* case 1: Nothing in memory */
 
-    if (!nodes.size()) {
+    if (nodes.empty()) {
         appendNode (new mem_node(offset));
-        return nodes.start()->data;
+        return nodes.front();
     }
 
     mem_node *candidate = nullptr;
     /* case 2: location fits within an extant node */
 
     if (offset > 0) {
-        mem_node search (offset - 1);
-        search.nodeBuffer.length = 1;
-        mem_node *const *leadup =  nodes.find (&search, NodeCompare);
-
-        if (leadup)
-            candidate = *leadup;
+        // optimization: appending writes usually extend the last node
+        if (nodes.back()->contains(offset - 1))
+            candidate = nodes.back();
+        else
+            candidate = getBlockContainingLocation(offset - 1);
     }
 
     if (candidate && candidate->canAccept(offset))
@@ -339,27 +378,11 @@ mem_hdr::~mem_hdr()
     freeContent();
 }
 
-/* splay of mem nodes:
- * conditions:
- * a = b if a.intersection(b).size > 0;
- * a < b if a < b
- */
-int
-mem_hdr::NodeCompare(mem_node * const &left, mem_node * const &right)
-{
-    // possibly Range can help us at some point.
-
-    if (left->dataRange().intersection(right->dataRange()).size() > 0)
-        return 0;
-
-    return *left < *right ? -1 : 1;
-}
-
 void
 mem_hdr::dump() const
 {
-    debugs(20, DBG_IMPORTANT, "mem_hdr: " << (void *)this << " nodes.start() " << nodes.start());
-    debugs(20, DBG_IMPORTANT, "mem_hdr: " << (void *)this << " nodes.finish() " << nodes.finish());
+    debugs(20, DBG_IMPORTANT, "mem_hdr: " << (void *)this << " nodes.front() " << (nodes.empty() ? nullptr : nodes.front()));
+    debugs(20, DBG_IMPORTANT, "mem_hdr: " << (void *)this << " nodes.back() " << (nodes.empty() ? nullptr : nodes.back()));
 }
 
 size_t
@@ -368,7 +391,7 @@ mem_hdr::size() const
     return nodes.size();
 }
 
-const Splay<mem_node *> &
+const mem_hdr::Nodes &
 mem_hdr::getNodes() const
 {
     return nodes;
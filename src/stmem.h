@@ -10,16 +10,24 @@
 #define SQUID_SRC_STMEM_H
 
 #include "base/Range.h"
-#include "splay.h"
+
+#include <deque>
 
 class mem_node;
 
 class StoreIOBuffer;
 
+/// In-memory object content: a sequence of non-overlapping mem_nodes ordered
+/// by their offsets. Content is usually appended (and freed from the front),
+/// so nodes are usually full and adjacent; lookups of such content compute
+/// the node position from the offset. Other lookups use a binary search.
 class mem_hdr
 {
 
 public:
+    /// mem_nodes ordered by their start offsets
+    typedef std::deque<mem_node *> Nodes;
+
     mem_hdr();
     ~mem_hdr();
     void freeContent();
@@ -36,21 +44,20 @@ public:
     /* access the contained nodes - easier than punning
      * as a container ourselves
      */
-    const Splay<mem_node *> &getNodes() const;
+    const Nodes &getNodes() const;
     char * NodeGet(mem_node * aNode);
 
-    static Splay<mem_node *>::SPLAYCMP NodeCompare;
-
 private:
     void debugDump() const;
-    bool unlink(mem_node *aNode);
+    bool unlinkFirst();
     void appendNode (mem_node *aNode);
+    Nodes::const_iterator findNode(int64_t location) const;
     size_t copyAvailable(mem_node *aNode, int64_t location, size_t amount, char *target) const;
     bool unionNotEmpty (StoreIOBuffer const &);
     mem_node *nodeToRecieve(int64_t offset);
     size_t writeAvailable(mem_node *aNode, int64_t location, size_t amount, char const *source);
     int64_t inmem_hi;
-    Splay<mem_node *> nodes;
+    Nodes nodes;
 };
 
 #endif /* SQUID_SRC_STMEM_H */
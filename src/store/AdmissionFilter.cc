@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 20    Storage Manager */
+
+#include "squid.h"
+#include "base/Random.h"
+#include "base/RunnersRegistry.h"
+#include "debug/Stream.h"
+#include "ipc/mem/Pointer.h"
+#include "ipc/mem/Segment.h"
+#include "SquidConfig.h"
+#include "SquidMath.h"
+#include "Store.h"
+#include "store/AdmissionFilter.h"
+#include "store/Disk.h"
+#include "store/FrequencySketch.h"
+#include "tools.h"
+
+#include <limits>
+#include <vector>
+
+/// shared memory segment path for the FrequencySketch
+static const char *SketchLabel = "store_admission_sketch";
+
+/// a warm candidate that lost to a victim may still be admitted with this
+/// probability, so that an attacker cannot keep a victim "hot" forever by
+/// requesting URLs with colliding sketch counters
+static const int WarmCandidateAdmissionOdds = 128;
+
+/// the minimum estimate of a warm candidate
+static const int WarmCandidateFrequency = 6;
+
+/// admission decisions for one store
+class AdmissionCounters
+{
+public:
+    uint64_t admitted = 0; ///< candidates allowed to evict a victim
+    uint64_t rejected = 0; ///< candidates not allowed to evict a victim
+};
+
+/// the sketch shared by all workers; nil unless the filter is Enabled()
+static Ipc::Mem::Pointer<Store::FrequencySketch> TheSketch;
+
+/// per-store admission decisions made by this process, indexed by storeId+1
+static std::vector<AdmissionCounters> TheCounters;
+
+/// the admission decision counters for the given store
+static AdmissionCounters &
+CountersFor(const int storeId)
+{
+    assert(storeId >= Store::AdmissionFilter::MemoryCacheId);
+    const auto position = static_cast<size_t>(storeId + 1);
+    if (position >= TheCounters.size())
+        TheCounters.resize(position + 1);
+    return TheCounters[position];
+}
+
+/// the number of entries all stores may hold, estimated like
+/// Store::Disks::init() does when sizing the local store index
+static uint32_t
+ExpectedEntryCount()
+{
+    uint64_t totalSize = Config.memMaxSize;
+    for (size_t i = 0; i < Config.cacheSwap.n_configured; ++i) {
+        if (const auto dir = INDEXSD(i))
+            totalSize += dir->maxSize();
+    }
+    const auto entries = totalSize / std::max<int64_t>(Config.Store.avgObjectSize, 1);
+    return static_cast<uint32_t>(std::min<uint64_t>(entries, std::numeric_limits<uint32_t>::max()));
+}
+
+bool
+Store::AdmissionFilter::Enabled()
+{
+    return static_cast<bool>(TheSketch);
+}
+
+void
+Store::AdmissionFilter::NoteRequest(const cache_key * const key)
+{
+    if (Enabled())
+        TheSketch->increment(key);
+}
+
+bool
+Store::AdmissionFilter::Admits(const StoreEntry &candidate, const int storeId, const cache_key * const victim)
+{
+    const auto candidateKey = candidate.publicKey();
+    if (!Enabled() || !victim || !candidateKey)
+        return true;
+
+    const auto candidateFrequency = TheSketch->estimate(candidateKey);
+    const auto victimFrequency = TheSketch->estimate(victim);
+    auto admitted = candidateFrequency > victimFrequency;
+    if (!admitted && candidateFrequency >= WarmCandidateFrequency) {
+        static std::mt19937 rng(RandomSeed32());
+        admitted = (rng() % WarmCandidateAdmissionOdds) == 0;
+    }
+
+    debugs(20, 5, (admitted ? "admitted " : "rejected ") << candidate <<
+           " frequency " << candidateFrequency << " vs. " << victimFrequency <<
+           " in store " << storeId);
+
+    auto &counters = CountersFor(storeId);
+    if (admitted)
+        ++counters.admitted;
+    else
+        ++counters.rejected;
+    return admitted;
+}
+
+void
+Store::AdmissionFilter::Stat(StoreEntry &output)
+{
+    if (!Enabled())
+        return;
+
+    storeAppendPrintf(&output, "Admission filter sketch: %u counters x %d rows, %.0f KB\n",
+                      TheSketch->width(), FrequencySketch::Depth,
+                      TheSketch->sharedMemorySize() / 1024.0);
+    storeAppendPrintf(&output, "Admission filter decays: %" PRIu64 " (one per %" PRIu64 " requests)\n",
+                      TheSketch->decays(), TheSketch->sampleSize);
+}
+
+void
+Store::AdmissionFilter::StatStore(StoreEntry &output, const int storeId)
+{
+    if (!Enabled())
+        return;
+
+    const auto &counters = CountersFor(storeId);
+    const auto decisions = counters.admitted + counters.rejected;
+    storeAppendPrintf(&output, "Admission filter: %" PRIu64 " admitted, %" PRIu64 " rejected %.2f%%\n",
+                      counters.admitted, counters.rejected,
+                      Math::doublePercent(counters.rejected, decisions));
+}
+
+namespace Store {
+
+/// initializes shared memory segment used by AdmissionFilter
+class AdmissionFilterRr: public Ipc::Mem::RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    AdmissionFilterRr(): owner(nullptr) {}
+    ~AdmissionFilterRr() override;
+
+protected:
+    /* Ipc::Mem::RegisteredRunner API */
+    void create() override;
+    void open() override;
+
+private:
+    Ipc::Mem::Owner<FrequencySketch> *owner;
+};
+
+} // namespace Store
+
+DefineRunnerRegistratorIn(Store, AdmissionFilterRr);
+
+void
+Store::AdmissionFilterRr::create()
+{
+    if (!Config.Store.admissionFilter)
+        return;
+
+    const auto entries = ExpectedEntryCount();
+    Must(!owner);
+    owner = shm_new(FrequencySketch)(SketchLabel, entries);
+    debugs(20, 3, "sketch for " << entries << " entries: " <<
+           FrequencySketch::SharedMemorySize(entries) << " bytes");
+}
+
+void
+Store::AdmissionFilterRr::open()
+{
+    if (Config.Store.admissionFilter && IamWorkerProcess())
+        TheSketch = shm_old(FrequencySketch)(SketchLabel);
+}
+
+Store::AdmissionFilterRr::~AdmissionFilterRr()
+{
+    delete owner;
+}
+
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_STORE_ADMISSIONFILTER_H
+#define SQUID_SRC_STORE_ADMISSIONFILTER_H
+
+#include "store/forward.h"
+
+namespace Store {
+
+/// A TinyLFU cache admission policy (see store_admission_filter). Estimates
+/// recent request frequencies of public store keys using a FrequencySketch
+/// shared by all workers. When storing a new entry would evict an existing
+/// one, admits the new entry only if it was requested more often than that
+/// eviction victim, protecting popular entries from one-hit wonders.
+class AdmissionFilter
+{
+public:
+    /// identifies the shared memory cache in storeId parameters below;
+    /// other storeId values are cache_dir indexes
+    static const int MemoryCacheId = -1;
+
+    /// whether store_admission_filter is on and usable by this process
+    static bool Enabled();
+
+    /// records a client request for the entry with the given public key; call
+    /// once per client request, not for internal Store lookups
+    static void NoteRequest(const cache_key *);
+
+    /// Whether the given store may evict the given victim to make room for
+    /// the candidate entry. Call only when the store needs to evict. A nil
+    /// victim means that the store cannot tell which entry it would evict.
+    static bool Admits(const StoreEntry &candidate, int storeId, const cache_key *victim);
+
+    /// reports sketch configuration and state
+    static void Stat(StoreEntry &);
+
+    /// reports admission decisions made for the given store by this process
+    static void StatStore(StoreEntry &, int storeId);
+};
+
+} // namespace Store
+
+#endif /* SQUID_SRC_STORE_ADMISSIONFILTER_H */
+
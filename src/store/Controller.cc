@@ -13,9 +13,11 @@
 #include "MemStore.h"
 #include "SquidConfig.h"
 #include "SquidMath.h"
+#include "store/AdmissionFilter.h"
 #include "store/Controller.h"
 #include "store/Disks.h"
 #include "store/forward.h"
+#include "store/LocalIndex.h"
 #include "store/LocalSearch.h"
 #include "tools.h"
 #include "Transients.h"
@@ -141,6 +143,7 @@ Store::Controller::stat(StoreEntry &output) const
     storeAppendPrintf(&output, "Current Capacity       : %.2f%% used, %.2f%% free\n",
                       Math::doublePercent(currentSize(), maxSize()),
                       Math::doublePercent((maxSize() - currentSize()), maxSize()));
+    AdmissionFilter::Stat(output);
 
     if (sharedMemStore)
         sharedMemStore->stat(output);
@@ -395,7 +398,7 @@ Store::Controller::findCallbackXXX(const cache_key *key)
     // member or use an HTCP/ICP-specific index rather than store_table.
 
     // cannot reuse peekAtLocal() because HTCP/ICP callbacks may use private keys
-    return static_cast<StoreEntry*>(hash_lookup(store_table, key));
+    return store_table->find(key);
 }
 
 /// \returns either an existing local reusable StoreEntry object or nil
@@ -404,7 +407,7 @@ Store::Controller::findCallbackXXX(const cache_key *key)
 StoreEntry *
 Store::Controller::peekAtLocal(const cache_key *key)
 {
-    if (StoreEntry *e = static_cast<StoreEntry*>(hash_lookup(store_table, key))) {
+    if (StoreEntry *e = store_table->find(key)) {
         // callers must only search for public entries
         assert(!EBIT_TEST(e->flags, KEY_PRIVATE));
         assert(e->publicKey());
@@ -656,7 +659,7 @@ Store::Controller::handleIdleEntry(StoreEntry &e)
     // its own index, should not stay in the global store_table.
     if (!dereferenceIdle(e, keepInLocalMemory)) {
         debugs(20, 5, "destroying unlocked entry: " << &e << ' ' << e);
-        destroyStoreEntry(static_cast<hash_link*>(&e));
+        destroyStoreEntry(&e);
         return;
     }
 
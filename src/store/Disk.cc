@@ -14,16 +14,19 @@
 #include "ConfigOption.h"
 #include "ConfigParser.h"
 #include "globals.h"
+#include "md5.h"
 #include "Parsing.h"
+#include "RemovalPolicy.h"
 #include "SquidConfig.h"
 #include "Store.h"
+#include "store/AdmissionFilter.h"
 #include "store/Disk.h"
 #include "StoreFileSystem.h"
 #include "tools.h"
 
 Store::Disk::Disk(char const *aType): theType(aType),
     max_size(0), min_objsize(-1), max_objsize (-1),
-    path(nullptr), index(-1), disker(-1),
+    path(nullptr), index(-1), disker(-1), diskers(0),
     repl(nullptr), removals(0), scanned(0),
     cleanLog(nullptr)
 {
@@ -77,11 +80,36 @@ Store::Disk::stat(StoreEntry &output) const
         if (repl->Stats)
             repl->Stats(repl, &output);
     }
+
+    AdmissionFilter::StatStore(output, index);
 }
 
 void
 Store::Disk::statfs(StoreEntry &)const {}
 
+bool
+Store::Disk::needsEvictionFor(const int64_t diskSpaceNeeded) const
+{
+    // maintain() purges entries down to the swap_low_watermark
+    return currentSize() + diskSpaceNeeded > minSize();
+}
+
+bool
+Store::Disk::peekAtVictim(cache_key * const key) const
+{
+    if (!repl)
+        return false;
+
+    // the replacement policy walk starts with the next purge victim
+    const auto walker = repl->WalkInit(repl);
+    const auto victim = walker->Next(walker);
+    const auto found = victim && victim->publicKey();
+    if (found)
+        memcpy(key, victim->publicKey(), SQUID_MD5_DIGEST_LENGTH);
+    walker->Done(walker);
+    return found;
+}
+
 void
 Store::Disk::maintain() {}
 
@@ -239,7 +267,7 @@ Store::Disk::active() const
         return true;
 
     // we are inside a disker dedicated to this disk
-    if (KidIdentifier == disker)
+    if (disker >= 0 && disker <= KidIdentifier && KidIdentifier < disker + diskers)
         return true;
 
     return false; // Coordinator, wrong disker, etc.
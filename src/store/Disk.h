@@ -30,6 +30,8 @@ public:
     char const *type() const;
 
     virtual bool needsDiskStrand() const; ///< needs a dedicated kid process
+    /// the number of dedicated kid processes needed when needsDiskStrand()
+    virtual int diskStrandCount() const { return 1; }
     virtual bool active() const; ///< may be used in this strand
     /// whether stat should be reported by this SwapDir
     virtual bool doReportStat() const { return active(); }
@@ -101,7 +103,8 @@ protected:
 public:
     char *path;
     int index;          /* This entry's index into the swapDirs array */
-    int disker; ///< disker kid id dedicated to this SwapDir or -1
+    int disker; ///< the first disker kid id dedicated to this SwapDir or -1
+    int diskers; ///< the number of disker kids dedicated to this SwapDir
     RemovalPolicy *repl;
     int removals;
     int scanned;
@@ -119,9 +122,22 @@ public:
     /// check whether we can store the entry; if we can, report current load
     virtual bool canStore(const StoreEntry &e, int64_t diskSpaceNeeded, int &load) const = 0;
 
+    /// whether storing an entry of the given size is likely to evict others
+    virtual bool needsEvictionFor(int64_t diskSpaceNeeded) const;
+
+    /// copies the key of the entry this cache_dir is likely to evict next
+    /// \returns false if the next eviction victim is unknown
+    virtual bool peekAtVictim(cache_key *key) const;
+
     virtual StoreIOState::Pointer createStoreIO(StoreEntry &, StoreIOState::STIOCB *, void *) = 0;
     virtual StoreIOState::Pointer openStoreIO(StoreEntry &, StoreIOState::STIOCB *, void *) = 0;
 
+    /// Opens the swap file of a swapped out entry for reading without
+    /// StoreIOState, e.g. to send the stored bytes with sendfile(2).
+    /// The swap file starts with entry metadata (MemObject::swap_hdr_sz).
+    /// \returns a file_open() descriptor or -1 if not opened or not supported
+    virtual int openSwapFile(const StoreEntry &) const { return -1; }
+
     bool canLog(StoreEntry const &e)const;
     virtual void openLog();
     virtual void closeLog();
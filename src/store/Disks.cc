@@ -14,12 +14,16 @@
 #include "ConfigParser.h"
 #include "debug/Messages.h"
 #include "debug/Stream.h"
+#include "fatal.h"
 #include "globals.h"
+#include "md5.h"
 #include "sbuf/Stream.h"
 #include "SquidConfig.h"
 #include "Store.h"
+#include "store/AdmissionFilter.h"
 #include "store/Disk.h"
 #include "store/Disks.h"
+#include "store/LocalIndex.h"
 #include "store_rebuild.h"
 #include "StoreFileSystem.h"
 #include "swap_log_op.h"
@@ -263,25 +267,18 @@ Store::Disks::init()
     if (Config.Store.avgObjectSize <= 0)
         fatal("'store_avg_object_size' should be larger than 0.");
 
-    /* Calculate size of hash table (maximum currently 64k buckets).  */
+    /* Estimate the number of objects to pre-size the index.  */
     /* this is very bogus, its specific to the any Store maintaining an
      * in-core index, not global */
-    size_t buckets = (Store::Root().maxSize() + Config.memMaxSize) / Config.Store.avgObjectSize;
+    const size_t objects = (Store::Root().maxSize() + Config.memMaxSize) / Config.Store.avgObjectSize;
     debugs(20, Important(31), "Swap maxSize " << (Store::Root().maxSize() >> 10) <<
-           " + " << ( Config.memMaxSize >> 10) << " KB, estimated " << buckets << " objects");
-    buckets /= Config.Store.objectsPerBucket;
-    debugs(20, Important(32), "Target number of buckets: " << buckets);
-    /* ideally the full scan period should be configurable, for the
-     * moment it remains at approximately 24 hours.  */
-    store_hash_buckets = storeKeyHashBuckets(buckets);
-    debugs(20, Important(33), "Using " << store_hash_buckets << " Store buckets");
+           " + " << ( Config.memMaxSize >> 10) << " KB, estimated " << objects << " objects");
+    store_table = new Store::LocalIndex(objects);
+    debugs(20, Important(33), "Using " << store_table->capacity() << " Store index slots");
     debugs(20, Important(34), "Max Mem  size: " << ( Config.memMaxSize >> 10) << " KB" <<
            (Config.memShared ? " [shared]" : ""));
     debugs(20, Important(35), "Max Swap size: " << (Store::Root().maxSize() >> 10) << " KB");
 
-    store_table = hash_create(storeKeyHashCmp,
-                              store_hash_buckets, storeKeyHashHash);
-
     // Increment _before_ any possible storeRebuildComplete() calls so that
     // storeRebuildComplete() can reliably detect when all disks are done. The
     // level is decremented in each corresponding storeRebuildComplete() call.
@@ -392,7 +389,10 @@ Store::Disks::configure()
         if (disk.needsDiskStrand()) {
             assert(InDaemonMode());
             // XXX: Do not pretend to support disk.disker changes during reconfiguration
-            disk.disker = Config.workers + (++Config.cacheSwap.n_strands);
+            disk.disker = Config.workers + Config.cacheSwap.n_strands + 1;
+            disk.diskers = disk.diskStrandCount();
+            assert(disk.diskers > 0);
+            Config.cacheSwap.n_strands += disk.diskers;
         }
 
         if (!disk.active())
@@ -656,7 +656,18 @@ Store::Disks::SmpAware()
 SwapDir *
 Store::Disks::SelectSwapDir(const StoreEntry *e)
 {
-    return storeDirSelectSwapDir(e);
+    const auto dir = storeDirSelectSwapDir(e);
+    if (dir && AdmissionFilter::Enabled()) {
+        const auto objsize = objectSizeForDirSelection(*e);
+        if (dir->needsEvictionFor(objsize)) {
+            cache_key victim[SQUID_MD5_DIGEST_LENGTH];
+            if (!AdmissionFilter::Admits(*e, dir->index, dir->peekAtVictim(victim) ? victim : nullptr)) {
+                debugs(47, 3, "cache_dir " << dir->index << " rejected " << *e);
+                return nullptr;
+            }
+        }
+    }
+    return dir;
 }
 
 bool
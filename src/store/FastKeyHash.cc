@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 20    Storage Manager */
+
+#include "squid.h"
+#include "store/FastKeyHash.h"
+
+#include <algorithm>
+#include <cstring>
+
+/// pseudo-random per-lane constants mixed into the input (the XXH3 "secret")
+static const uint64_t Secret[] = {
+    0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL,
+    0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL, 0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL,
+    0xcb00c391bb52283cULL, 0xa32e531b8b65d088ULL, 0x4ef90da297486471ULL, 0xd8acdea946ef1938ULL,
+};
+
+static const uint64_t Prime32_1 = 0x9e3779b1ULL;
+static const uint64_t Prime64_1 = 0x9e3779b185ebca87ULL;
+static const uint64_t Prime64_2 = 0xc2b2ae3d27d4eb4fULL;
+
+/// reads a little-endian 64-bit integer, regardless of the platform byte order
+static uint64_t
+Read64(const unsigned char *bytes)
+{
+#if WORDS_BIGENDIAN
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i)
+        value = (value << 8) | bytes[i];
+    return value;
+#else
+    uint64_t value; // compilers turn this into a single, possibly unaligned load
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+#endif
+}
+
+/// writes a little-endian 64-bit integer, regardless of the platform byte order
+static void
+Write64(unsigned char *bytes, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<unsigned char>(value);
+        value >>= 8;
+    }
+}
+
+/// folds the 128-bit product of the two numbers into 64 bits
+static uint64_t
+MultiplyFold(const uint64_t a, const uint64_t b)
+{
+    // a portable 64x64->128 multiplication
+    const auto aLow = a & 0xffffffffULL;
+    const auto aHigh = a >> 32;
+    const auto bLow = b & 0xffffffffULL;
+    const auto bHigh = b >> 32;
+    const auto lowLow = aLow*bLow;
+    const auto highLow = aHigh*bLow;
+    const auto lowHigh = aLow*bHigh;
+    const auto highHigh = aHigh*bHigh;
+    const auto cross = (lowLow >> 32) + (highLow & 0xffffffffULL) + lowHigh;
+    const auto low = (cross << 32) | (lowLow & 0xffffffffULL);
+    const auto high = (highLow >> 32) + (cross >> 32) + highHigh;
+    return low ^ high;
+}
+
+/// spreads all input bits over the result (the XXH3 "avalanche")
+static uint64_t
+Avalanche(uint64_t h)
+{
+    h ^= h >> 37;
+    h *= 0x165667919e3779f9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+Store::FastKeyHash::FastKeyHash()
+{
+    static_assert(sizeof(Secret) >= sizeof(accumulators) + 4*sizeof(uint64_t), "enough secret for accumulators and final mixing");
+    for (size_t lane = 0; lane < Lanes; ++lane)
+        accumulators[lane] = Secret[lane] ^ Prime64_1;
+}
+
+void
+Store::FastKeyHash::update(const void * const data, size_t size)
+{
+    if (!size)
+        return;
+
+    auto bytes = static_cast<const unsigned char *>(data);
+    inputSize += size;
+
+    if (stripeSize) {
+        const auto appended = std::min(size, StripeSize - stripeSize);
+        memcpy(stripe + stripeSize, bytes, appended);
+        stripeSize += appended;
+        bytes += appended;
+        size -= appended;
+        if (stripeSize < StripeSize)
+            return;
+        accumulate(stripe);
+        stripeSize = 0;
+    }
+
+    // most URLs are processed here, without copying
+    for (; size >= StripeSize; bytes += StripeSize, size -= StripeSize)
+        accumulate(bytes);
+
+    memcpy(stripe, bytes, size);
+    stripeSize = size;
+}
+
+/// mixes one full stripe into the accumulators
+void
+Store::FastKeyHash::accumulate(const unsigned char * const input)
+{
+    // Each lane uses one 32x32-bit multiplication. The lanes are independent,
+    // allowing compilers to process them in SIMD registers. The local copy
+    // tells compilers that input bytes cannot alias the accumulators.
+    uint64_t acc[Lanes];
+    memcpy(acc, accumulators, sizeof(acc));
+    for (size_t lane = 0; lane < Lanes; ++lane) {
+        const auto value = Read64(input + lane*sizeof(uint64_t));
+        const auto key = value ^ Secret[lane];
+        acc[lane ^ 1] += value; // preserves input bits lost by the multiplication
+        acc[lane] += (key & 0xffffffffULL)*(key >> 32);
+    }
+    memcpy(accumulators, acc, sizeof(acc));
+
+    if (++stripes == StripesPerBlock) {
+        scramble();
+        stripes = 0;
+    }
+}
+
+/// prevents long inputs from accumulating multiplication bias
+void
+Store::FastKeyHash::scramble()
+{
+    for (size_t lane = 0; lane < Lanes; ++lane) {
+        auto acc = accumulators[lane];
+        acc ^= acc >> 47;
+        acc ^= Secret[lane + 1];
+        acc *= Prime32_1;
+        accumulators[lane] = acc;
+    }
+}
+
+void
+Store::FastKeyHash::final(unsigned char * const digest)
+{
+    // The zero-padded last stripe ends with the total input size so that
+    // inputs differing only in trailing zeros have different hashes.
+    memset(stripe + stripeSize, 0, StripeSize - stripeSize);
+    if (stripeSize > StripeSize - sizeof(uint64_t)) {
+        accumulate(stripe);
+        memset(stripe, 0, StripeSize);
+    }
+    Write64(stripe + StripeSize - sizeof(uint64_t), inputSize);
+    accumulate(stripe);
+
+    uint64_t low = inputSize*Prime64_1;
+    uint64_t high = ~inputSize*Prime64_2;
+    for (size_t lane = 0; lane < Lanes; lane += 2) {
+        low += MultiplyFold(accumulators[lane] ^ Secret[lane + 2], accumulators[lane + 1] ^ Secret[lane + 3]);
+        high += MultiplyFold(accumulators[lane] ^ Secret[lane + 4], accumulators[lane + 1] ^ Secret[lane + 5]);
+    }
+
+    Write64(digest, Avalanche(low));
+    Write64(digest + sizeof(uint64_t), Avalanche(high ^ (low >> 29)));
+}
+
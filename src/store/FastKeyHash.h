@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_STORE_FASTKEYHASH_H
+#define SQUID_SRC_STORE_FASTKEYHASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Store {
+
+/// A non-cryptographic 128-bit hash for computing store keys (see
+/// store_key_hash). Like XXH3, it splits input into 64-byte stripes
+/// accumulated into eight independent 64-bit lanes using 32x32-bit
+/// multiplications that compilers may vectorize.
+/// The result is stable across platforms and Squid versions because
+/// cache_dirs store it.
+class FastKeyHash
+{
+public:
+    FastKeyHash();
+
+    /// adds the given bytes to the hashed input
+    void update(const void *data, size_t size);
+
+    /// writes the 16-byte hash of all update()d bytes
+    void final(unsigned char *digest);
+
+    /// the size of the final() result in bytes
+    static const size_t DigestSize = 16;
+
+private:
+    static const size_t Lanes = 8;
+    static const size_t StripeSize = Lanes*sizeof(uint64_t);
+    /// the number of stripes between accumulator scrambles
+    static const size_t StripesPerBlock = 16;
+
+    void accumulate(const unsigned char *stripe);
+    void scramble();
+
+    uint64_t accumulators[Lanes];
+    unsigned char stripe[StripeSize]; ///< buffered input bytes
+    size_t stripeSize = 0; ///< the number of bytes in the stripe buffer
+    size_t stripes = 0; ///< the number of accumulated stripes since the last scramble
+    uint64_t inputSize = 0; ///< the total number of update()d bytes
+};
+
+} // namespace Store
+
+#endif /* SQUID_SRC_STORE_FASTKEYHASH_H */
+
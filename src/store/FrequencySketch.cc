@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 20    Storage Manager */
+
+#include "squid.h"
+#include "store/FrequencySketch.h"
+
+#include <algorithm>
+#include <cstring>
+
+/// the number of 4-bit counters in each 64-bit word
+static const uint32_t CountersPerWord = 16;
+
+/// keeps the lower three bits of every 4-bit counter
+static const uint64_t HalvingMask = 0x7777777777777777ULL;
+
+Store::FrequencySketch::FrequencySketch(const uint32_t minWidth):
+    sampleSize(10 * (uint64_t(1) << WidthBits(minWidth))),
+    widthBits(WidthBits(minWidth)),
+    increments(0),
+    decays_(0),
+    words(WordCount(widthBits))
+{
+    const auto wordCount = WordCount(widthBits);
+    for (uint32_t i = 0; i < wordCount; ++i)
+        words[i].store(0);
+}
+
+size_t
+Store::FrequencySketch::sharedMemorySize() const
+{
+    return SharedMemorySize(width());
+}
+
+size_t
+Store::FrequencySketch::SharedMemorySize(const uint32_t minWidth)
+{
+    return sizeof(FrequencySketch) + WordCount(WidthBits(minWidth)) * sizeof(std::atomic<uint64_t>);
+}
+
+uint32_t
+Store::FrequencySketch::WidthBits(const uint32_t minWidth)
+{
+    // at least one word per row; at most 512 MB of counters
+    uint32_t bits = 4;
+    while (bits < 28 && (1U << bits) < minWidth)
+        ++bits;
+    return bits;
+}
+
+uint32_t
+Store::FrequencySketch::WordCount(const uint32_t widthBits)
+{
+    return (uint32_t(Depth) << widthBits) / CountersPerWord;
+}
+
+uint32_t
+Store::FrequencySketch::counterIndex(const cache_key * const key, const int row) const
+{
+    // Store keys are hashes already. Derive Depth independent positions from
+    // the two key halves, using the top (best mixed) bits of the product.
+    uint64_t halves[2];
+    memcpy(halves, key, sizeof(halves));
+    const auto mixed = (halves[0] + row * (halves[1] | 1)) * 0x9e3779b97f4a7c15ULL;
+    return (uint32_t(row) << widthBits) + static_cast<uint32_t>(mixed >> (64 - widthBits));
+}
+
+void
+Store::FrequencySketch::increment(const cache_key * const key)
+{
+    auto incremented = false;
+    for (int row = 0; row < Depth; ++row) {
+        const auto counter = counterIndex(key, row);
+        auto &word = words[counter / CountersPerWord];
+        const auto shift = (counter % CountersPerWord) * 4;
+        auto value = word.load(std::memory_order_relaxed);
+        while (((value >> shift) & 0xF) != 0xF) {
+            if (word.compare_exchange_weak(value, value + (uint64_t(1) << shift), std::memory_order_relaxed)) {
+                incremented = true;
+                break;
+            }
+        }
+    }
+
+    // only the process that completes the sample pays for halving
+    if (incremented && ++increments == sampleSize)
+        halve();
+}
+
+int
+Store::FrequencySketch::estimate(const cache_key * const key) const
+{
+    auto result = MaxEstimate;
+    for (int row = 0; row < Depth; ++row) {
+        const auto counter = counterIndex(key, row);
+        const auto value = words[counter / CountersPerWord].load(std::memory_order_relaxed);
+        result = std::min(result, static_cast<int>((value >> ((counter % CountersPerWord) * 4)) & 0xF));
+    }
+    return result;
+}
+
+/// halves all counters, forgetting old popularity
+void
+Store::FrequencySketch::halve()
+{
+    const auto wordCount = WordCount(widthBits);
+    for (uint32_t i = 0; i < wordCount; ++i) {
+        auto &word = words[i];
+        auto value = word.load(std::memory_order_relaxed);
+        while (!word.compare_exchange_weak(value, (value >> 1) & HalvingMask, std::memory_order_relaxed)) {}
+    }
+    ++decays_;
+
+    // Halved counters represent half of the sample. Concurrent increments
+    // may have overshot sampleSize; make sure the next one triggers halve().
+    auto current = increments.load();
+    while (!increments.compare_exchange_weak(current, std::min(current - sampleSize/2, sampleSize - 1))) {}
+}
+
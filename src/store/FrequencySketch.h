@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_STORE_FREQUENCYSKETCH_H
+#define SQUID_SRC_STORE_FREQUENCYSKETCH_H
+
+#include "ipc/mem/FlexibleArray.h"
+#include "store/forward.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace Store {
+
+/// Estimates how often each store key was seen recently, using a count-min
+/// sketch: Depth rows of 4-bit saturating counters, one counter per row for
+/// every key. The estimate is the smallest of the key counters. Once the
+/// number of increments reaches sampleSize, all counters are halved so that
+/// old popularity fades. Safe for concurrent use from multiple processes.
+class FrequencySketch
+{
+public:
+    /// \param minWidth the minimum number of counters in each row
+    explicit FrequencySketch(uint32_t minWidth);
+
+    size_t sharedMemorySize() const;
+    static size_t SharedMemorySize(uint32_t minWidth);
+
+    /// records one more occurrence of the given key
+    void increment(const cache_key *key);
+
+    /// the approximate number of recent key occurrences, up to MaxEstimate
+    int estimate(const cache_key *key) const;
+
+    /// the number of counters in each row; a power of two
+    uint32_t width() const { return 1U << widthBits; }
+
+    /// the number of halve() calls so far
+    uint64_t decays() const { return decays_.load(); }
+
+    /// the maximum estimate() result
+    static const int MaxEstimate = 15;
+
+    /// the number of counter rows
+    static const int Depth = 4;
+
+    /// the number of increments between halve() calls
+    const uint64_t sampleSize;
+
+private:
+    /// the number of 64-bit words storing all counters
+    static uint32_t WordCount(uint32_t widthBits);
+    static uint32_t WidthBits(uint32_t minWidth);
+
+    /// the position of the given key counter in the given row
+    uint32_t counterIndex(const cache_key *key, int row) const;
+
+    void halve();
+
+    const uint32_t widthBits; ///< log2(width())
+
+    std::atomic<uint64_t> increments; ///< increments since the last halve()
+    std::atomic<uint64_t> decays_; ///< halve() calls so far
+
+    /// counters for all rows, 16 counters per word
+    Ipc::Mem::FlexibleArray< std::atomic<uint64_t> > words;
+};
+
+} // namespace Store
+
+#endif /* SQUID_SRC_STORE_FREQUENCYSKETCH_H */
+
@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 20    Storage Manager */
+
+#include "squid.h"
+#include "debug/Stream.h"
+#include "md5.h"
+#include "Store.h"
+#include "store/LocalIndex.h"
+
+#include <algorithm>
+#include <cstring>
+
+/// the number of retiring slots migrated by each index modification; large
+/// enough to finish migration well before the new table gets full
+static const size_t MigrationStep = 16;
+
+/// the smallest table size
+static const size_t MinSlots = 1024;
+
+/// whether the given number of entries fits a table with the given number of
+/// slots; the 75% load factor keeps linear probe sequences short
+static bool
+Fits(const size_t entries, const size_t slots)
+{
+    return entries <= slots/4*3;
+}
+
+/// the slot following the given one in a table with the given number of slots
+static size_t
+NextSlot(const size_t slotIndex, const size_t slots)
+{
+    return (slotIndex + 1) & (slots - 1);
+}
+
+Store::LocalIndex::LocalIndex(const size_t expectedEntries)
+{
+    auto slots = MinSlots;
+    while (!Fits(expectedEntries, slots))
+        slots <<= 1;
+    slots_.resize(slots);
+}
+
+uint64_t
+Store::LocalIndex::Hash(const cache_key * const key)
+{
+    // Public keys are MD5 digests, but private keys are mostly a counter (see
+    // storeKeyPrivate()), so we mix all key bits instead of using some of them.
+    static_assert(SQUID_MD5_DIGEST_LENGTH == 2*sizeof(uint64_t), "cache_key has two 64-bit halves");
+    uint64_t low;
+    uint64_t high;
+    memcpy(&low, key, sizeof(low));
+    memcpy(&high, key + sizeof(low), sizeof(high));
+
+    // a MurmurHash3 finalizer applied to both halves
+    auto hash = low ^ (high * 0x9e3779b97f4a7c15ULL);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+int64_t
+Store::LocalIndex::FindSlot(const Slots &slots, const uint64_t hash, const cache_key * const key)
+{
+    if (slots.empty())
+        return -1;
+
+    // our tables always have empty slots, ending this loop
+    for (auto slotIndex = hash & (slots.size() - 1); !slots[slotIndex].empty(); slotIndex = NextSlot(slotIndex, slots.size())) {
+        const auto &slot = slots[slotIndex];
+        if (slot.hash == hash && slot.entry && memcmp(slot.entry->key, key, SQUID_MD5_DIGEST_LENGTH) == 0)
+            return slotIndex;
+    }
+    return -1;
+}
+
+int64_t
+Store::LocalIndex::FindSlot(const Slots &slots, const uint64_t hash, const StoreEntry &entry)
+{
+    if (slots.empty())
+        return -1;
+
+    for (auto slotIndex = hash & (slots.size() - 1); !slots[slotIndex].empty(); slotIndex = NextSlot(slotIndex, slots.size())) {
+        if (slots[slotIndex].entry == &entry)
+            return slotIndex;
+    }
+    return -1;
+}
+
+StoreEntry *
+Store::LocalIndex::find(const cache_key * const key) const
+{
+    const auto hash = Hash(key);
+    auto slotIndex = FindSlot(slots_, hash, key);
+    if (slotIndex >= 0)
+        return slots_[slotIndex].entry;
+    slotIndex = FindSlot(retiring_, hash, key);
+    if (slotIndex >= 0)
+        return retiring_[slotIndex].entry;
+    return nullptr;
+}
+
+void
+Store::LocalIndex::add(StoreEntry &entry)
+{
+    assert(entry.key);
+    const auto hash = Hash(static_cast<const cache_key *>(entry.key));
+
+    if (!retiring_.empty())
+        migrate(MigrationStep);
+    else if (!Fits(size_ + 1, slots_.size()))
+        grow();
+
+    insert(hash, entry);
+    ++size_;
+}
+
+void
+Store::LocalIndex::remove(StoreEntry &entry)
+{
+    assert(entry.key);
+    const auto hash = Hash(static_cast<const cache_key *>(entry.key));
+
+    const auto slotIndex = FindSlot(slots_, hash, entry);
+    if (slotIndex >= 0) {
+        erase(slotIndex);
+    } else {
+        // Leave a mark instead of emptying the slot: Retiring slots are not
+        // shifted, so emptying would cut probe sequences of other entries.
+        const auto retiringIndex = FindSlot(retiring_, hash, entry);
+        assert(retiringIndex >= 0);
+        auto &slot = retiring_[retiringIndex];
+        slot.entry = nullptr;
+        slot.hash = 1;
+    }
+
+    assert(size_ > 0);
+    --size_;
+
+    if (!retiring_.empty())
+        migrate(MigrationStep);
+}
+
+/// places the given entry into the first available slots_ slot
+void
+Store::LocalIndex::insert(const uint64_t hash, StoreEntry &entry)
+{
+    auto slotIndex = hash & (slots_.size() - 1);
+    while (slots_[slotIndex].entry)
+        slotIndex = NextSlot(slotIndex, slots_.size());
+    auto &slot = slots_[slotIndex];
+    slot.hash = hash;
+    slot.entry = &entry;
+}
+
+/// empties the given slots_ slot, shifting subsequent slots of the same probe
+/// sequence back so that slots_ never needs removal marks
+void
+Store::LocalIndex::erase(size_t slotIndex)
+{
+    const auto mask = slots_.size() - 1;
+    auto nextIndex = NextSlot(slotIndex, slots_.size());
+    while (slots_[nextIndex].entry) {
+        // the distance from the entry's preferred slot to its current one
+        const auto displacement = (nextIndex - (slots_[nextIndex].hash & mask)) & mask;
+        // move the entry back unless it would precede its preferred slot
+        if (displacement >= ((nextIndex - slotIndex) & mask)) {
+            slots_[slotIndex] = slots_[nextIndex];
+            slotIndex = nextIndex;
+        }
+        nextIndex = NextSlot(nextIndex, slots_.size());
+    }
+    slots_[slotIndex] = Slot();
+}
+
+/// starts using a twice larger table
+void
+Store::LocalIndex::grow()
+{
+    assert(retiring_.empty());
+    debugs(20, 3, "from " << slots_.size() << " to " << 2*slots_.size() << " slots for " << size_ << " entries");
+    retiring_.swap(slots_);
+    slots_.resize(2*retiring_.size());
+    migrated_ = 0;
+    migrate(MigrationStep);
+}
+
+/// moves entries from a few retiring slots to the current table
+void
+Store::LocalIndex::migrate(size_t maxSlots)
+{
+    while (maxSlots-- > 0 && migrated_ < retiring_.size()) {
+        auto &slot = retiring_[migrated_++];
+        if (slot.entry) {
+            insert(slot.hash, *slot.entry);
+            // keep the slot non-empty for probe sequences of retiring entries
+            slot.entry = nullptr;
+            slot.hash = 1;
+        }
+    }
+
+    if (migrated_ == retiring_.size()) {
+        debugs(20, 5, "migrated " << migrated_ << " slots");
+        // slots_ positions shift back by the retiring_ size (see currentSlot())
+        lastRetiredSize_ = retiring_.size();
+        ++layout_;
+        Slots().swap(retiring_);
+        migrated_ = 0;
+    }
+}
+
+/// the given walk slot position converted to the current slot positions
+size_t
+Store::LocalIndex::currentSlot(const WalkPosition &walk) const
+{
+    if (walk.layout == layout_)
+        return walk.slot;
+
+    // slots_ positions shifted back when the retiring_ table was freed
+    if (walk.layout + 1 == layout_ && walk.slot >= lastRetiredSize_)
+        return walk.slot - lastRetiredSize_;
+
+    // The walk was still visiting retiring_ slots whose entries have since
+    // migrated to slots_ positions, or it lags behind several such shifts.
+    // Restart rather than skip entries.
+    debugs(20, 3, "restarting walk at " << walk.slot << " of layout " << walk.layout << '/' << layout_);
+    return 0;
+}
+
+void
+Store::LocalIndex::copyEntries(WalkPosition &walk, const size_t maxSlots, std::vector<StoreEntry *> &entries) const
+{
+    auto position = currentSlot(walk);
+    const auto end = std::min(position + maxSlots, capacity());
+    for (; position < end; ++position) {
+        const auto &slot = position < retiring_.size() ?
+                           retiring_[position] : slots_[position - retiring_.size()];
+        if (slot.entry)
+            entries.push_back(slot.entry);
+    }
+    walk.slot = position;
+    walk.layout = layout_;
+}
+
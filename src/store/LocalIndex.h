@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_STORE_LOCALINDEX_H
+#define SQUID_SRC_STORE_LOCALINDEX_H
+
+#include "store/forward.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Store {
+
+/// Indexes StoreEntry objects known to this worker by their keys (i.e. the
+/// store_table). An open-addressing hash table with linear probing: Each slot
+/// holds an entry pointer and the full 64-bit hash of the entry key. Probing
+/// compares hashes first, so it rarely dereferences entries, while moving
+/// slots around (after removals and when growing) never does.
+///
+/// The table grows without stalling the caller: A full table becomes a
+/// "retiring" table that is still searched but no longer receives new
+/// entries. Subsequent modifications migrate a few retiring slots each, until
+/// the retiring table is empty and gets freed.
+class LocalIndex
+{
+public:
+    /// preallocates enough slots for the given number of entries
+    explicit LocalIndex(size_t expectedEntries);
+    LocalIndex(LocalIndex &&) = delete; // no need to copy or move the index
+
+    /// \returns the entry with the given key or nil
+    StoreEntry *find(const cache_key *) const;
+
+    /// indexes the given entry using its key; the key must not be indexed yet
+    void add(StoreEntry &);
+
+    /// removes the given indexed entry; its key must not change while indexed
+    void remove(StoreEntry &);
+
+    /// the number of indexed entries
+    size_t size() const { return size_; }
+
+    /// the number of allocated slots (including retiring ones)
+    size_t capacity() const { return slots_.size() + retiring_.size(); }
+
+    /// the progress of an index walk (see copyEntries())
+    class WalkPosition
+    {
+    public:
+        size_t slot = 0; ///< the next slot position to visit, in [0, capacity()]
+        uint64_t layout = 0; ///< LocalIndex layout version that slot is valid for
+    };
+
+    /// Appends entries stored in (at most) maxSlots slots, starting at the
+    /// given walk position and advancing it. Index walkers use this to visit
+    /// all entries in chunks. Entries indexed, removed, or migrated between
+    /// calls may be missed or visited twice, but the end of index growth does
+    /// not make a walk skip the entries it has not visited yet.
+    void copyEntries(WalkPosition &, size_t maxSlots, std::vector<StoreEntry *> &entries) const;
+
+    /// whether the walk has visited all slots
+    bool walked(const WalkPosition &walk) const { return currentSlot(walk) >= capacity(); }
+
+    /// the hash of the given store key
+    static uint64_t Hash(const cache_key *);
+
+private:
+    /// a single hash table cell
+    class Slot
+    {
+    public:
+        /// whether this slot never stored an entry; empty slots end probing
+        bool empty() const { return !entry && !hash; }
+
+        uint64_t hash = 0; ///< Hash() of the entry key (or a nonzero mark for removed entries)
+        StoreEntry *entry = nullptr; ///< the indexed entry or nil
+    };
+    typedef std::vector<Slot> Slots;
+
+    /// the index of the slot with the given entry in the given table or -1
+    static int64_t FindSlot(const Slots &, uint64_t hash, const cache_key *key);
+    /// the index of the slot with the given entry in the given table or -1
+    static int64_t FindSlot(const Slots &, uint64_t hash, const StoreEntry &);
+
+    size_t currentSlot(const WalkPosition &) const;
+
+    void insert(uint64_t hash, StoreEntry &);
+    void erase(size_t slotIndex);
+    void grow();
+    void migrate(size_t maxSlots);
+
+    Slots slots_; ///< the table receiving new entries; power-of-two size
+    Slots retiring_; ///< the previous table (while its entries migrate)
+    size_t migrated_ = 0; ///< the number of leading retiring_ slots that were migrated
+    size_t size_ = 0; ///< the number of entries in both tables
+
+    /// the number of times slot positions shifted because retiring_ was freed
+    uint64_t layout_ = 0;
+    size_t lastRetiredSize_ = 0; ///< the size of the last freed retiring_ table
+};
+
+} // namespace Store
+
+#endif /* SQUID_SRC_STORE_LOCALINDEX_H */
+
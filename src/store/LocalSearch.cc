@@ -11,11 +11,15 @@
 #include "squid.h"
 #include "debug/Stream.h"
 #include "globals.h"
+#include "store/LocalIndex.h"
 #include "store/LocalSearch.h"
 #include "StoreSearch.h"
 
 namespace Store {
 
+/// the maximum number of store_table slots visited by a single copySlots()
+static const size_t SlotsPerStep = 64;
+
 /// iterates local store_table
 class LocalSearch : public StoreSearch
 {
@@ -30,9 +34,9 @@ public:
     StoreEntry *currentItem() override;
 
 private:
-    void copyBucket();
+    void copySlots();
     bool _done = false;
-    int bucket = 0;
+    LocalIndex::WalkPosition position; ///< the next store_table slot to visit
     std::vector<StoreEntry *> entries;
 };
 
@@ -60,7 +64,7 @@ Store::LocalSearch::next()
         entries.pop_back();
 
     while (!isDone() && !entries.size())
-        copyBucket();
+        copySlots();
 
     return currentItem() != nullptr;
 }
@@ -74,7 +78,7 @@ Store::LocalSearch::error() const
 bool
 Store::LocalSearch::isDone() const
 {
-    return bucket >= store_hash_buckets || _done;
+    return _done || store_table->walked(position);
 }
 
 StoreEntry *
@@ -87,26 +91,19 @@ Store::LocalSearch::currentItem()
 }
 
 void
-Store::LocalSearch::copyBucket()
+Store::LocalSearch::copySlots()
 {
     /* probably need to lock the store entries...
-     * we copy them all to prevent races on the links. */
+     * we copy them all to prevent races on the index. */
     assert (!entries.size());
-    hash_link *link_ptr = nullptr;
-    hash_link *link_next = nullptr;
-    link_next = hash_get_bucket(store_table, bucket);
-
-    while (nullptr != (link_ptr = link_next)) {
-        link_next = link_ptr->next;
-        StoreEntry *e = (StoreEntry *) link_ptr;
-
-        entries.push_back(e);
-    }
+    store_table->copyEntries(position, SlotsPerStep, entries);
 
     // minimize debugging: we may be called more than a million times on startup
     if (const auto count = entries.size())
-        debugs(47, 8, "bucket #" << bucket << " entries: " << count);
+        debugs(47, 8, "slots before #" << position.slot << " entries: " << count);
 
-    ++bucket;
+    // do not restart a finished walk if the index layout changes later
+    if (store_table->walked(position))
+        _done = true;
 }
 
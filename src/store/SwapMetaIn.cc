@@ -19,6 +19,7 @@
 #include "store/SwapMeta.h"
 #include "store/SwapMetaIn.h"
 #include "store/SwapMetaView.h"
+#include "store_key_md5.h"
 
 namespace Store {
 
@@ -68,26 +69,33 @@ private:
     size_t metasSize; ///< number of bytes in the metas buffer
 };
 
-/// validates serialized STORE_META_KEY_MD5 swap meta field
+/// validates the key deserialized from STORE_META_KEY_MD5 swap meta field
 static void
-CheckSwapMetaKey(const SwapMetaView &meta, const StoreEntry &entry)
+CheckSwapMetaKey(const cache_key * const storedKey, const char * const storedUrl, const StoreEntry &entry)
 {
-    Assure(meta.type == STORE_META_KEY_MD5);
-    meta.checkExpectedLength(SQUID_MD5_DIGEST_LENGTH);
-
-    if (!EBIT_TEST(entry.flags, KEY_PRIVATE) &&
-            memcmp(meta.rawValue, entry.key, SQUID_MD5_DIGEST_LENGTH) != 0) {
+    if (EBIT_TEST(entry.flags, KEY_PRIVATE) ||
+            memcmp(storedKey, entry.key, SQUID_MD5_DIGEST_LENGTH) == 0)
+        return;
+
+    // entries indexed before a store_key_hash change keep their old keys
+    // in metadata (see UnpackIndexSwapMeta())
+    if (storedUrl) {
+        cache_key convertedKey[SQUID_MD5_DIGEST_LENGTH];
+        storeKeyCopy(convertedKey, storedKey);
+        if (storeKeyConvert(convertedKey, SBuf(storedUrl), entry.mem().vary_headers) &&
+                memcmp(convertedKey, entry.key, SQUID_MD5_DIGEST_LENGTH) == 0)
+            return;
+    }
 
-        debugs(20, 2, "stored key mismatches " << entry.getMD5Text());
+    debugs(20, 2, "stored key mismatches " << entry.getMD5Text());
 
-        static unsigned int md5_mismatches = 0;
-        if (isPowTen(++md5_mismatches))
-            debugs(20, DBG_IMPORTANT, "WARNING: " << md5_mismatches << " swapin MD5 mismatches");
+    static unsigned int md5_mismatches = 0;
+    if (isPowTen(++md5_mismatches))
+        debugs(20, DBG_IMPORTANT, "WARNING: " << md5_mismatches << " swapin MD5 mismatches");
 
-        // TODO: Support TextException::frequent = isPowTen(++md5_mismatches)
-        // to suppress reporting, achieving the same effect as above
-        throw TextException("swap meta MD5 mismatch", Here());
-    }
+    // TODO: Support TextException::frequent = isPowTen(++md5_mismatches)
+    // to suppress reporting, achieving the same effect as above
+    throw TextException("swap meta MD5 mismatch", Here());
 }
 
 /// deserializes STORE_META_KEY_MD5 swap meta field
@@ -101,7 +109,8 @@ UnpackSwapMetaKey(const SwapMetaView &meta, cache_key *key)
 }
 
 /// validates serialized STORE_META_URL swap meta field
-static void
+/// \returns the stored URL
+static const char *
 CheckSwapMetaUrl(const SwapMetaView &meta, const StoreEntry &entry)
 {
     Assure(meta.type == STORE_META_URL);
@@ -110,12 +119,12 @@ CheckSwapMetaUrl(const SwapMetaView &meta, const StoreEntry &entry)
     if (!memrchr(meta.rawValue, '\0', meta.rawLength))
         throw TextException("unterminated URI or bad URI length", Here());
 
+    const auto storedUrl = static_cast<const char *>(meta.rawValue);
     const auto &emem = entry.mem();
 
     if (!emem.hasUris())
-        return; // cannot validate
+        return storedUrl; // cannot validate
 
-    const auto storedUrl = static_cast<const char *>(meta.rawValue);
     // XXX: ensure all Squid URL inputs are properly normalized then use case-sensitive compare here
     if (strcasecmp(emem.urlXXX(), storedUrl) != 0) {
         debugs(20, DBG_IMPORTANT, "WARNING: URL mismatch when loading a cached entry:" <<
@@ -123,17 +132,27 @@ CheckSwapMetaUrl(const SwapMetaView &meta, const StoreEntry &entry)
                Debug::Extra << "found:    " << storedUrl);
         throw TextException("URL mismatch", Here());
     }
+    return storedUrl;
 }
 
 /// deserializes STORE_META_VARY_HEADERS swap meta field
 static SBuf
-UnpackNewSwapMetaVaryHeaders(const SwapMetaView &meta, const StoreEntry &entry)
+UnpackSwapMetaVaryHeaders(const SwapMetaView &meta)
 {
     Assure(meta.type == STORE_META_VARY_HEADERS);
     SBuf rawVary(static_cast<const char *>(meta.rawValue), meta.rawLength);
     // entries created before SBuf-based Vary may include string terminator
     static const SBuf nul("\0", 1);
     rawVary.trim(nul, false, true);
+    return rawVary;
+}
+
+/// deserializes and validates STORE_META_VARY_HEADERS swap meta field
+/// \returns Vary headers unknown to the entry or an empty buffer
+static SBuf
+UnpackNewSwapMetaVaryHeaders(const SwapMetaView &meta, const StoreEntry &entry)
+{
+    const auto rawVary = UnpackSwapMetaVaryHeaders(meta);
 
     const auto &knownVary = entry.mem().vary_headers;
     if (knownVary.isEmpty())
@@ -243,6 +262,8 @@ size_t
 Store::UnpackIndexSwapMeta(const MemBuf &buf, StoreEntry &tmpe, cache_key * const key)
 {
     size_t swap_hdr_sz = 0;
+    const char *storedUrl = nullptr;
+    SBuf varyHeaders;
 
     const SwapMetaUnpacker metaFields(buf.content(), buf.contentSize(), swap_hdr_sz);
     for (const auto &meta: metaFields) {
@@ -295,7 +316,15 @@ Store::UnpackIndexSwapMeta(const MemBuf &buf, StoreEntry &tmpe, cache_key * cons
             break;
 
         case STORE_META_URL:
+            // PackSwapMeta() terminates; see CheckSwapMetaUrl()
+            if (memrchr(meta.rawValue, '\0', meta.rawLength))
+                storedUrl = static_cast<const char *>(meta.rawValue);
+            break;
+
         case STORE_META_VARY_HEADERS:
+            varyHeaders = UnpackSwapMetaVaryHeaders(meta);
+            break;
+
         case STORE_META_OBJSIZE:
             // We do not load this information at cache index rebuild time;
             // UnpackHitSwapMeta() handles these MemObject fields.
@@ -303,6 +332,13 @@ Store::UnpackIndexSwapMeta(const MemBuf &buf, StoreEntry &tmpe, cache_key * cons
         }
     }
 
+    // The URL and Vary fields are not loaded into the index (UnpackHitSwapMeta()
+    // handles them), but they let us recompute keys stored by a Squid
+    // configured with another store_key_hash. Keys that we cannot recompute
+    // are left as is.
+    if (tmpe.key && storedUrl && !EBIT_TEST(tmpe.flags, KEY_PRIVATE))
+        (void)storeKeyConvert(key, SBuf(storedUrl), varyHeaders);
+
     return swap_hdr_sz;
 }
 
@@ -314,6 +350,9 @@ Store::UnpackHitSwapMeta(char const * const buf, const ssize_t len, StoreEntry &
 
     size_t swap_hdr_sz = 0;
     SBuf varyHeaders;
+    cache_key storedKey[SQUID_MD5_DIGEST_LENGTH];
+    bool haveStoredKey = false;
+    const char *storedUrl = nullptr;
 
     const SwapMetaUnpacker metaFields(buf, len, swap_hdr_sz);
     for (const auto &meta: metaFields) {
@@ -323,7 +362,7 @@ Store::UnpackHitSwapMeta(char const * const buf, const ssize_t len, StoreEntry &
             break;
 
         case STORE_META_URL:
-            CheckSwapMetaUrl(meta, entry);
+            storedUrl = CheckSwapMetaUrl(meta, entry);
             break;
 
         case STORE_META_VARY_HEADERS:
@@ -336,7 +375,8 @@ Store::UnpackHitSwapMeta(char const * const buf, const ssize_t len, StoreEntry &
 
         case STORE_META_KEY_MD5:
             // already handled by UnpackIndexSwapMeta()
-            CheckSwapMetaKey(meta, entry); // paranoid
+            UnpackSwapMetaKey(meta, storedKey);
+            haveStoredKey = true;
             break;
 
         case STORE_META_STD:
@@ -358,5 +398,29 @@ Store::UnpackHitSwapMeta(char const * const buf, const ssize_t len, StoreEntry &
 
     if (!varyHeaders.isEmpty())
         emem.vary_headers = varyHeaders;
+
+    if (haveStoredKey)
+        CheckSwapMetaKey(storedKey, storedUrl, entry); // paranoid
 }
 
+
+bool
+Store::ConvertSwapMetaKey(const char * const buf, const size_t bufSize, cache_key * const key)
+{
+    try {
+        size_t swap_hdr_sz = 0;
+        const char *storedUrl = nullptr;
+        SBuf varyHeaders;
+        const SwapMetaUnpacker metaFields(buf, bufSize, swap_hdr_sz);
+        for (const auto &meta: metaFields) {
+            if (meta.type == STORE_META_URL && memrchr(meta.rawValue, '\0', meta.rawLength))
+                storedUrl = static_cast<const char *>(meta.rawValue);
+            else if (meta.type == STORE_META_VARY_HEADERS)
+                varyHeaders = UnpackSwapMetaVaryHeaders(meta);
+        }
+        return storedUrl && storeKeyConvert(key, SBuf(storedUrl), varyHeaders);
+    } catch (...) {
+        debugs(20, 3, "cannot convert " << storeKeyText(key) << ": " << CurrentException);
+        return false;
+    }
+}
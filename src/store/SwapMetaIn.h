@@ -27,6 +27,12 @@ size_t UnpackIndexSwapMeta(const MemBuf &, StoreEntry &, cache_key *);
 /// deserializes entry metadata from the given buffer into the cache hit entry
 void UnpackHitSwapMeta(char const *, ssize_t, StoreEntry &);
 
+/// Converts the given key of the entry with the given metadata to the
+/// store_key_hash algorithm (see storeKeyConvert()). Unlike other unpacking
+/// functions, does not throw.
+/// \retval false the metadata is unusable or the key was not computed from it
+bool ConvertSwapMetaKey(const char *buf, size_t bufSize, cache_key *key);
+
 } // namespace Store
 
 #endif /* SQUID_SRC_STORE_SWAPMETAIN_H */
@@ -31,9 +31,11 @@
 #include "refresh.h"
 #include "SquidConfig.h"
 #include "Store.h"
+#include "store/LocalIndex.h"
 #include "StoreSearch.h"
 #include "util.h"
 
+#include <algorithm>
 #include <cmath>
 
 /*
@@ -385,16 +387,16 @@ storeDigestRebuildFinish(void)
         storeDigestRewriteResume();
 }
 
-/* recalculate a few hash buckets per invocation; schedules next step */
+/* recalculate a few index entries per invocation; schedules next step */
 static void
 storeDigestRebuildStep(void *)
 {
     /* TODO: call Store::Root().size() to determine this.. */
-    int count = Config.Store.objectsPerBucket * (int) ceil((double) store_hash_buckets *
-                (double) Config.digest.rebuild_chunk_percentage / 100.0);
+    int count = std::max(1, (int) ceil((double) store_table->size() *
+                                       (double) Config.digest.rebuild_chunk_percentage / 100.0));
     assert(sd_state.rebuild_lock);
 
-    debugs(71, 3, "storeDigestRebuildStep: buckets: " << store_hash_buckets << " entries to check: " << count);
+    debugs(71, 3, "storeDigestRebuildStep: entries: " << store_table->size() << " entries to check: " << count);
 
     while (count-- && !sd_state.theSearch->isDone() && sd_state.theSearch->next())
         storeDigestAdd(sd_state.theSearch->currentItem());
@@ -11,6 +11,8 @@
 #include "squid.h"
 #include "HttpRequest.h"
 #include "md5.h"
+#include "SquidConfig.h"
+#include "store/FastKeyHash.h"
 #include "store_key_md5.h"
 
 const char *
@@ -91,21 +93,70 @@ storeKeyPrivate()
     return reinterpret_cast<cache_key*>(&key);
 }
 
-const cache_key *
-storeKeyPublic(const char *url, const HttpRequestMethod& method, const KeyScope keyScope)
+/// SquidMD5 calls in the FastKeyHash API shape
+class Md5KeyHash
+{
+public:
+    Md5KeyHash() { SquidMD5Init(&context); }
+    void update(const void *data, const size_t size) { SquidMD5Update(&context, data, size); }
+    void final(unsigned char *digest) { SquidMD5Final(digest, &context); }
+
+private:
+    SquidMD5_CTX context;
+};
+
+/// feeds public key ingredients to the given hash algorithm
+template <class Hash>
+static const cache_key *
+HashPublicKey(const char *storeId, const size_t storeIdLength, const HttpRequestMethod &method, const KeyScope keyScope, const SBuf &varyHeaders)
 {
     static cache_key digest[SQUID_MD5_DIGEST_LENGTH];
-    unsigned char m = (unsigned char) method.id();
-    SquidMD5_CTX M;
-    SquidMD5Init(&M);
-    SquidMD5Update(&M, &m, sizeof(m));
-    SquidMD5Update(&M, (unsigned char *) url, strlen(url));
+    static_assert(Store::FastKeyHash::DigestSize == sizeof(digest), "all key algorithms produce cache_key-sized hashes");
+    const unsigned char m = (unsigned char) method.id();
+    Hash hash;
+    hash.update(&m, sizeof(m));
+    hash.update(storeId, storeIdLength);
     if (keyScope)
-        SquidMD5Update(&M, &keyScope, sizeof(keyScope));
-    SquidMD5Final(digest, &M);
+        hash.update(&keyScope, sizeof(keyScope));
+    if (!varyHeaders.isEmpty())
+        hash.update(varyHeaders.rawContent(), varyHeaders.length());
+    hash.final(digest);
     return digest;
 }
 
+/// computes a public key using the given algorithm
+static const cache_key *
+PublicKey(const KeyHash keyHash, const char *storeId, const size_t storeIdLength, const HttpRequestMethod &method, const KeyScope keyScope, const SBuf &varyHeaders)
+{
+    if (keyHash == khFast)
+        return HashPublicKey<Store::FastKeyHash>(storeId, storeIdLength, method, keyScope, varyHeaders);
+    return HashPublicKey<Md5KeyHash>(storeId, storeIdLength, method, keyScope, varyHeaders);
+}
+
+KeyHash
+storeKeyHash()
+{
+    return static_cast<KeyHash>(Config.Store.keyHash);
+}
+
+const char *
+storeKeyHashName(const KeyHash keyHash)
+{
+    return keyHash == khFast ? "fast" : "md5";
+}
+
+const cache_key *
+storeKeyPublic(const char *url, const HttpRequestMethod& method, const KeyScope keyScope)
+{
+    return PublicKey(storeKeyHash(), url, strlen(url), method, keyScope, SBuf());
+}
+
+const cache_key *
+storeKeyPublicWith(const KeyHash keyHash, const SBuf &storeId, const HttpRequestMethod &method, const KeyScope keyScope, const SBuf &varyHeaders)
+{
+    return PublicKey(keyHash, storeId.rawContent(), storeId.length(), method, keyScope, varyHeaders);
+}
+
 const cache_key *
 storeKeyPublicByRequest(HttpRequest * request, const KeyScope keyScope)
 {
@@ -115,24 +166,41 @@ storeKeyPublicByRequest(HttpRequest * request, const KeyScope keyScope)
 const cache_key *
 storeKeyPublicByRequestMethod(HttpRequest * request, const HttpRequestMethod& method, const KeyScope keyScope)
 {
-    static cache_key digest[SQUID_MD5_DIGEST_LENGTH];
-    unsigned char m = (unsigned char) method.id();
-    const SBuf url = request->storeId(); /* returns the right storeID\URL for the MD5 calc */
-    SquidMD5_CTX M;
-    SquidMD5Init(&M);
-    SquidMD5Update(&M, &m, sizeof(m));
-    SquidMD5Update(&M, (unsigned char *) url.rawContent(), url.length());
-    if (keyScope)
-        SquidMD5Update(&M, &keyScope, sizeof(keyScope));
+    return storeKeyPublicByRequestMethod(request, method, keyScope, storeKeyHash());
+}
 
-    if (!request->vary_headers.isEmpty()) {
-        SquidMD5Update(&M, request->vary_headers.rawContent(), request->vary_headers.length());
-        debugs(20, 3, "updating public key by vary headers: " << request->vary_headers << " for: " << url);
-    }
+const cache_key *
+storeKeyPublicByRequestMethod(HttpRequest * request, const HttpRequestMethod& method, const KeyScope keyScope, const KeyHash keyHash)
+{
+    if (!request->vary_headers.isEmpty())
+        debugs(20, 3, "updating public key by vary headers: " << request->vary_headers << " for: " << request->storeId());
+
+    // same as HttpRequest::storeId() but without copying the ID
+    if (request->store_id.size() != 0)
+        return PublicKey(keyHash, request->store_id.rawBuf(), request->store_id.size(), method, keyScope, request->vary_headers);
+    const auto &uri = request->effectiveRequestUri();
+    return PublicKey(keyHash, uri.rawContent(), uri.length(), method, keyScope, request->vary_headers);
+}
 
-    SquidMD5Final(digest, &M);
+bool
+storeKeyConvert(cache_key * const key, const SBuf &storeId, const SBuf &varyHeaders)
+{
+    const auto configured = storeKeyHash();
+    const auto other = configured == khMd5 ? khFast : khMd5;
+
+    // cache_dirs store GET and HEAD responses under default-scope keys
+    for (const auto method: {Http::METHOD_GET, Http::METHOD_HEAD}) {
+        if (memcmp(key, storeKeyPublicWith(configured, storeId, method, ksDefault, varyHeaders), SQUID_MD5_DIGEST_LENGTH) == 0)
+            return true;
+
+        const auto converted = storeKeyPublicWith(other, storeId, method, ksDefault, varyHeaders);
+        if (memcmp(key, converted, SQUID_MD5_DIGEST_LENGTH) == 0) {
+            storeKeyCopy(key, storeKeyPublicWith(configured, storeId, method, ksDefault, varyHeaders));
+            return true;
+        }
+    }
 
-    return digest;
+    return false;
 }
 
 cache_key *
@@ -156,14 +224,3 @@ storeKeyFree(const cache_key * key)
     memFree((void *) key, MEM_MD5_DIGEST);
 }
 
-int
-storeKeyHashBuckets(int nbuckets)
-{
-    int n = 0x2000;
-
-    while (n < nbuckets)
-        n <<= 1;
-
-    return n;
-}
-
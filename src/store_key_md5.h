@@ -13,6 +13,7 @@
 
 #include "hash.h"
 #include "http/forward.h"
+#include "sbuf/forward.h"
 #include "store/forward.h"
 
 typedef enum {
@@ -20,6 +21,12 @@ typedef enum {
     ksRevalidation
 } KeyScope;
 
+/// store key computation algorithms (see store_key_hash)
+typedef enum {
+    khMd5 = 0,
+    khFast = 1
+} KeyHash;
+
 cache_key *storeKeyDup(const cache_key *);
 cache_key *storeKeyCopy(cache_key *, const cache_key *);
 void storeKeyFree(const cache_key *);
@@ -28,8 +35,22 @@ const char *storeKeyText(const cache_key *);
 const cache_key *storeKeyPublic(const char *, const HttpRequestMethod&, const KeyScope keyScope = ksDefault);
 const cache_key *storeKeyPublicByRequest(HttpRequest *, const KeyScope keyScope = ksDefault);
 const cache_key *storeKeyPublicByRequestMethod(HttpRequest *, const HttpRequestMethod&, const KeyScope keyScope = ksDefault);
+/// a public key computed using the given algorithm rather than store_key_hash
+const cache_key *storeKeyPublicByRequestMethod(HttpRequest *, const HttpRequestMethod&, const KeyScope, const KeyHash);
+/// a public key of an entry with the given store ID and Vary headers,
+/// computed using the given algorithm rather than store_key_hash
+const cache_key *storeKeyPublicWith(const KeyHash, const SBuf &storeId, const HttpRequestMethod&, const KeyScope, const SBuf &varyHeaders);
+/// Replaces a public key of a cached entry with the same key computed using
+/// store_key_hash, assuming the old key was computed from the given entry
+/// store ID and Vary headers, possibly using another algorithm.
+/// \retval true the key uses store_key_hash (after this or earlier conversion)
+/// \retval false the key was not computed from the given information
+bool storeKeyConvert(cache_key *key, const SBuf &storeId, const SBuf &varyHeaders);
 const cache_key *storeKeyPrivate();
-int storeKeyHashBuckets(int);
+/// the configured store_key_hash algorithm
+KeyHash storeKeyHash();
+/// the store_key_hash name of the given algorithm
+const char *storeKeyHashName(const KeyHash);
 
 extern HASHHASH storeKeyHashHash;
 extern HASHCMP storeKeyHashCmp;
@@ -15,6 +15,7 @@
 void fde::Init() STUB
 void fde::setIo(READ_HANDLER *, WRITE_HANDLER *) STUB
 void fde::useDefaultIo() STUB
+bool fde::usesDefaultIo() const STUB_RETVAL(false)
 void fde::useBufferedIo(READ_HANDLER *, WRITE_HANDLER *) STUB
 void fde::DumpStats(StoreEntry *) STUB
 char const *fde::remoteAddr() const STUB_RETVAL(nullptr)
@@ -65,6 +65,13 @@ void Comm::ReadCancel(int, AsyncCall::Pointer &) STUB
 void comm_read_base(const Comm::ConnectionPointer &, char *, int, AsyncCall::Pointer &) STUB
 void comm_read_cancel(int, IOCB *, void *) STUB
 
+#include "comm/Splice.h"
+bool Comm::SplicePipe::open() STUB_RETVAL(false)
+void Comm::SplicePipe::close() STUB
+bool Comm::SpliceSupported() STUB_RETVAL(false)
+Comm::Flag Comm::SpliceIn(CommIoCbParams &, SplicePipe &) STUB_RETVAL(Comm::COMM_ERROR)
+Comm::Flag Comm::SpliceOut(CommIoCbParams &, SplicePipe &) STUB_RETVAL(Comm::COMM_ERROR)
+
 #include "comm/TcpAcceptor.h"
 //Comm::TcpAcceptor(const Comm::ConnectionPointer &, const char *, const Subscription::Pointer &) STUB
 void Comm::TcpAcceptor::subscribe(const Subscription::Pointer &) STUB
@@ -74,10 +81,30 @@ void Comm::TcpAcceptor::notify(const Comm::Flag, const Comm::ConnectionPointer &
 
 #include "comm/Tcp.h"
 void Comm::ApplyTcpKeepAlive(int, const TcpKeepAlive &) STUB
+void Comm::ApplyTcpFastOpenListener(int, int) STUB
+bool Comm::EnableTcpFastOpenConnect(int) STUB_RETVAL(false)
+bool Comm::TcpFastOpenUsed(int) STUB_RETVAL(false)
+
+#include "comm/UdpBatch.h"
+bool Comm::UdpBatchingSupported() STUB_RETVAL(false)
+Comm::UdpBatchStats::UdpBatchStats(const char *aLabel): label(aLabel) STUB_NOP
+void Comm::UdpBatchStats::RegisterWithCacheManager() STUB
+void Comm::UdpBatchStats::count(int, uint64_t &, uint64_t &, uint64_t *) STUB
+Comm::UdpReceiveRing::UdpReceiveRing(size_t aSize, UdpBatchStats &aStats): maxDatagramSize_(aSize), buffers_(nullptr), stats_(aStats) STUB_NOP
+Comm::UdpReceiveRing::~UdpReceiveRing() STUB_NOP
+int Comm::UdpReceiveRing::receive(int, int) STUB_RETVAL(-1)
+void Comm::UdpSendBatch::add(const Ip::Address &, const void *, size_t) STUB
+int Comm::UdpSendBatch::send(int) STUB_RETVAL(0)
 
 #include "comm/Write.h"
 void Comm::Write(const Comm::ConnectionPointer &, const char *, int, AsyncCall::Pointer &, FREE *) STUB
 void Comm::Write(const Comm::ConnectionPointer &, MemBuf *, AsyncCall::Pointer &) STUB
+void Comm::Write(const Comm::ConnectionPointer &, AsyncCall::Pointer &) STUB
+void Comm::Write(const Comm::ConnectionPointer &, MemBuf *, const WriteVector &, AsyncCall::Pointer &) STUB
+void Comm::WriteFile(const Comm::ConnectionPointer &, int, off_t, int, AsyncCall::Pointer &) STUB
+bool Comm::WriteFileSupported() STUB_RETVAL(false)
+void Comm::WriteVector::add(const char *, size_t) STUB
+size_t Comm::WriteVector::size() const STUB_RETVAL(0)
 void Comm::WriteCancel(const Comm::ConnectionPointer &, const char *) STUB
 /*PF*/ void Comm::HandleWrite(int, void*) STUB
 
@@ -11,6 +11,16 @@
 #define STUB_API "store/libstore.la"
 #include "tests/STUB.h"
 
+#include "store/AdmissionFilter.h"
+namespace Store
+{
+bool AdmissionFilter::Enabled() STUB_RETVAL(false)
+void AdmissionFilter::NoteRequest(const cache_key *) STUB
+bool AdmissionFilter::Admits(const StoreEntry &, int, const cache_key *) STUB_RETVAL(true)
+void AdmissionFilter::Stat(StoreEntry &) STUB
+void AdmissionFilter::StatStore(StoreEntry &, int) STUB
+}
+
 #include "store/Controller.h"
 namespace Store
 {
@@ -85,6 +95,8 @@ ConfigOption *Disk::getOptionTree() const STUB_RETVAL(nullptr)
 void Disk::dump(StoreEntry &) const STUB
 bool Disk::doubleCheck(StoreEntry &) STUB_RETVAL(false)
 void Disk::statfs(StoreEntry &) const STUB
+bool Disk::needsEvictionFor(int64_t) const STUB_RETVAL(false)
+bool Disk::peekAtVictim(cache_key *) const STUB_RETVAL(false)
 bool Disk::canLog(StoreEntry const &) const STUB_RETVAL(false)
 void Disk::openLog() STUB
 void Disk::closeLog() STUB
@@ -132,6 +144,26 @@ void allocate_new_swapdir(Store::DiskConfig &) STUB
 void free_cachedir(Store::DiskConfig *) STUB;
 void storeDirSwapLog(const StoreEntry *, int) STUB
 
+#include "store/FastKeyHash.h"
+namespace Store
+{
+FastKeyHash::FastKeyHash() {STUB}
+void FastKeyHash::update(const void *, size_t) STUB
+void FastKeyHash::final(unsigned char *) STUB
+}
+
+#include "store/LocalIndex.h"
+namespace Store
+{
+LocalIndex::LocalIndex(size_t) {STUB}
+StoreEntry *LocalIndex::find(const cache_key *) const STUB_RETVAL(nullptr)
+void LocalIndex::add(StoreEntry &) STUB
+void LocalIndex::remove(StoreEntry &) STUB
+void LocalIndex::copyEntries(WalkPosition &, size_t, std::vector<StoreEntry *> &) const STUB
+size_t LocalIndex::currentSlot(const WalkPosition &) const STUB_RETVAL(0)
+uint64_t LocalIndex::Hash(const cache_key *) STUB_RETVAL(0)
+}
+
 #include "store/LocalSearch.h"
 namespace Store
 {
@@ -142,6 +174,7 @@ StoreSearch *NewLocalSearch() STUB_RETVAL(nullptr)
 size_t Store::UnpackSwapMetaSize(const SBuf &) STUB_RETVAL(0)
 size_t Store::UnpackIndexSwapMeta(const MemBuf &, StoreEntry &, cache_key *) STUB_RETVAL(0)
 void Store::UnpackHitSwapMeta(char const *, ssize_t, StoreEntry &) STUB
+bool Store::ConvertSwapMetaKey(const char *, size_t, cache_key *) STUB_RETVAL(false)
 
 #include "store/SwapMetaOut.h"
 AllocedBuf Store::PackSwapMeta(const StoreEntry &, size_t &) STUB_RETVAL(nullptr)
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "store/FastKeyHash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+class TestStoreFastKeyHash : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestStoreFastKeyHash);
+    CPPUNIT_TEST(testKnownHashes);
+    CPPUNIT_TEST(testIncrementalUpdates);
+    CPPUNIT_TEST(testTrailingZeros);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testKnownHashes();
+    void testIncrementalUpdates();
+    void testTrailingZeros();
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(TestStoreFastKeyHash);
+
+/// the hexadecimal FastKeyHash of the given input, fed in chunks of the given size
+static std::string
+Hash(const std::string &input, const size_t chunkSize = 0)
+{
+    Store::FastKeyHash hash;
+    if (!chunkSize) {
+        hash.update(input.data(), input.size());
+    } else {
+        for (size_t pos = 0; pos < input.size(); pos += chunkSize)
+            hash.update(input.data() + pos, std::min(chunkSize, input.size() - pos));
+    }
+
+    unsigned char digest[Store::FastKeyHash::DigestSize];
+    hash.final(digest);
+
+    std::string text;
+    for (const auto c: digest) {
+        char buf[3];
+        snprintf(buf, sizeof(buf), "%02X", c);
+        text += buf;
+    }
+    return text;
+}
+
+void
+TestStoreFastKeyHash::testKnownHashes()
+{
+    // cache_dirs store these hashes, so they must never change
+    CPPUNIT_ASSERT_EQUAL(std::string("46B47E85E8D16096E1C50897313A3A05"), Hash(""));
+    CPPUNIT_ASSERT_EQUAL(std::string("CAA01550CB78DB6E2EEE7B51275415AB"), Hash("http://www.example.com/"));
+    CPPUNIT_ASSERT_EQUAL(std::string("FD3AC5421DB31EB72AAF2B7FF481A3AA"), Hash(std::string(200, 'x')));
+}
+
+void
+TestStoreFastKeyHash::testIncrementalUpdates()
+{
+    std::string input;
+    for (size_t i = 0; i < 2000; ++i)
+        input += static_cast<char>(i * 7 + 3);
+
+    const auto expected = Hash(input);
+    for (const size_t chunkSize: {1, 3, 63, 64, 65, 1000})
+        CPPUNIT_ASSERT_EQUAL(expected, Hash(input, chunkSize));
+}
+
+void
+TestStoreFastKeyHash::testTrailingZeros()
+{
+    // inputs that differ only in their (zero-padded) last stripe size
+    auto previous = Hash("");
+    for (size_t size = 1; size < 200; ++size) {
+        const auto current = Hash(std::string(size, '\0'));
+        CPPUNIT_ASSERT(previous != current);
+        previous = current;
+    }
+}
+
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "md5.h"
+#include "store/FrequencySketch.h"
+
+#include <array>
+#include <cstring>
+#include <memory>
+
+class TestStoreFrequencySketch : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestStoreFrequencySketch);
+    CPPUNIT_TEST(testEstimate);
+    CPPUNIT_TEST(testSaturation);
+    CPPUNIT_TEST(testDecay);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testEstimate();
+    void testSaturation();
+    void testDecay();
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(TestStoreFrequencySketch);
+
+typedef std::array<cache_key, SQUID_MD5_DIGEST_LENGTH> Key;
+
+/// a pseudo-random store key
+static Key
+MakeKey(const uint64_t seed)
+{
+    Key key;
+    uint64_t value = seed;
+    for (size_t i = 0; i < key.size(); i += sizeof(value)) {
+        value = value * 0x5851f42d4c957f2dULL + 0x14057b7ef767814fULL;
+        memcpy(key.data() + i, &value, sizeof(value));
+    }
+    return key;
+}
+
+/// a FrequencySketch in local memory rather than a shared memory segment
+class LocalSketch
+{
+public:
+    explicit LocalSketch(const uint32_t width):
+        storage(new char[Store::FrequencySketch::SharedMemorySize(width)]),
+        sketch(new (storage.get()) Store::FrequencySketch(width))
+    {}
+
+    ~LocalSketch() { sketch->~FrequencySketch(); }
+
+    Store::FrequencySketch *operator ->() { return sketch; }
+
+private:
+    std::unique_ptr<char[]> storage;
+    Store::FrequencySketch *sketch;
+};
+
+void
+TestStoreFrequencySketch::testEstimate()
+{
+    LocalSketch sketch(1024);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(1024), sketch->width());
+
+    for (uint64_t i = 0; i < 100; ++i) {
+        const auto key = MakeKey(i);
+        for (uint64_t n = 0; n < i % 10; ++n)
+            sketch->increment(key.data());
+    }
+
+    // count-min sketches may overestimate but never underestimate
+    int exact = 0;
+    for (uint64_t i = 0; i < 100; ++i) {
+        const auto estimate = sketch->estimate(MakeKey(i).data());
+        CPPUNIT_ASSERT(estimate >= static_cast<int>(i % 10));
+        exact += (estimate == static_cast<int>(i % 10));
+    }
+    CPPUNIT_ASSERT(exact >= 95);
+}
+
+void
+TestStoreFrequencySketch::testSaturation()
+{
+    LocalSketch sketch(16);
+    const auto key = MakeKey(1);
+    for (int i = 0; i < 100; ++i)
+        sketch->increment(key.data());
+    CPPUNIT_ASSERT_EQUAL(Store::FrequencySketch::MaxEstimate, sketch->estimate(key.data()));
+}
+
+void
+TestStoreFrequencySketch::testDecay()
+{
+    LocalSketch sketch(1024);
+    const auto popular = MakeKey(0);
+    for (int i = 0; i < 12; ++i)
+        sketch->increment(popular.data());
+    CPPUNIT_ASSERT_EQUAL(12, sketch->estimate(popular.data()));
+
+    // other keys complete the sample, triggering one decay
+    uint64_t seed = 1;
+    while (!sketch->decays())
+        sketch->increment(MakeKey(seed++).data());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), sketch->decays());
+
+    // halved, possibly after collisions with other keys saturated counters
+    const auto estimate = sketch->estimate(popular.data());
+    CPPUNIT_ASSERT(estimate >= 6);
+    CPPUNIT_ASSERT(estimate <= Store::FrequencySketch::MaxEstimate/2);
+}
+
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "md5.h"
+#include "Store.h"
+#include "store/LocalIndex.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+class TestStoreLocalIndex : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestStoreLocalIndex);
+    CPPUNIT_TEST(testFind);
+    CPPUNIT_TEST(testRemove);
+    CPPUNIT_TEST(testGrowth);
+    CPPUNIT_TEST(testCopyEntries);
+    CPPUNIT_TEST(testWalkDuringGrowth);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testFind();
+    void testRemove();
+    void testGrowth();
+    void testCopyEntries();
+    void testWalkDuringGrowth();
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(TestStoreLocalIndex);
+
+typedef std::array<cache_key, SQUID_MD5_DIGEST_LENGTH> Key;
+
+/// StoreEntry objects with storeKeyPrivate()-like keys that differ only in
+/// their leading counter, the worst case for naive hash functions
+class Entries
+{
+public:
+    explicit Entries(const size_t count): keys(count), entries(count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            const uint64_t counter = i + 1;
+            keys[i].fill(7);
+            memcpy(keys[i].data(), &counter, sizeof(counter));
+            entries[i] = new StoreEntry();
+            entries[i]->key = keys[i].data();
+        }
+    }
+
+    ~Entries()
+    {
+        for (const auto e: entries) {
+            e->key = nullptr; // not allocated by storeKeyDup()
+            delete e;
+        }
+    }
+
+    std::vector<Key> keys;
+    std::vector<StoreEntry *> entries;
+};
+
+void
+TestStoreLocalIndex::testFind()
+{
+    Entries entries(100);
+    Store::LocalIndex index(100);
+    for (const auto e: entries.entries)
+        index.add(*e);
+    CPPUNIT_ASSERT_EQUAL(size_t(100), index.size());
+
+    for (size_t i = 0; i < entries.keys.size(); ++i)
+        CPPUNIT_ASSERT_EQUAL(entries.entries[i], index.find(entries.keys[i].data()));
+
+    Key missing;
+    missing.fill(7);
+    CPPUNIT_ASSERT(!index.find(missing.data()));
+}
+
+void
+TestStoreLocalIndex::testRemove()
+{
+    Entries entries(1000);
+    Store::LocalIndex index(1000);
+    for (const auto e: entries.entries)
+        index.add(*e);
+
+    // removals shift other entries of the same probe sequences
+    for (size_t i = 0; i < entries.entries.size(); i += 2)
+        index.remove(*entries.entries[i]);
+    CPPUNIT_ASSERT_EQUAL(size_t(500), index.size());
+
+    for (size_t i = 0; i < entries.keys.size(); ++i) {
+        const auto expected = (i % 2) ? entries.entries[i] : nullptr;
+        CPPUNIT_ASSERT_EQUAL(expected, index.find(entries.keys[i].data()));
+    }
+
+    // removed keys may be indexed again
+    index.add(*entries.entries[0]);
+    CPPUNIT_ASSERT_EQUAL(entries.entries[0], index.find(entries.keys[0].data()));
+}
+
+void
+TestStoreLocalIndex::testGrowth()
+{
+    Entries entries(50000);
+    std::vector<bool> indexed(entries.entries.size(), false);
+    Store::LocalIndex index(0);
+    const auto initialCapacity = index.capacity();
+
+    // remove some entries while the index is growing
+    for (size_t i = 0; i < entries.entries.size(); ++i) {
+        index.add(*entries.entries[i]);
+        indexed[i] = true;
+
+        const auto victim = i/2;
+        if (i % 3 == 0 && indexed[victim]) {
+            index.remove(*entries.entries[victim]);
+            indexed[victim] = false;
+        }
+
+        // an entry added long ago and possibly migrated already
+        const auto old = i/4;
+        CPPUNIT_ASSERT_EQUAL(indexed[old] ? entries.entries[old] : nullptr, index.find(entries.keys[old].data()));
+    }
+    CPPUNIT_ASSERT(index.capacity() > initialCapacity);
+
+    size_t found = 0;
+    for (size_t i = 0; i < entries.keys.size(); ++i) {
+        CPPUNIT_ASSERT_EQUAL(indexed[i] ? entries.entries[i] : nullptr, index.find(entries.keys[i].data()));
+        found += indexed[i];
+    }
+    CPPUNIT_ASSERT_EQUAL(index.size(), found);
+}
+
+void
+TestStoreLocalIndex::testCopyEntries()
+{
+    Entries entries(5000);
+    Store::LocalIndex index(0);
+    for (const auto e: entries.entries)
+        index.add(*e);
+
+    std::vector<StoreEntry *> copied;
+    Store::LocalIndex::WalkPosition position;
+    while (!index.walked(position))
+        index.copyEntries(position, 100, copied);
+
+    CPPUNIT_ASSERT_EQUAL(entries.entries.size(), copied.size());
+    std::sort(copied.begin(), copied.end());
+    auto expected = entries.entries;
+    std::sort(expected.begin(), expected.end());
+    CPPUNIT_ASSERT(expected == copied);
+}
+
+void
+TestStoreLocalIndex::testWalkDuringGrowth()
+{
+    Entries entries(20000);
+    const size_t initialCount = 5000;
+    Store::LocalIndex index(0);
+    for (size_t i = 0; i < initialCount; ++i)
+        index.add(*entries.entries[i]);
+
+    // keep adding entries while walking, growing the index (more than once)
+    std::vector<StoreEntry *> copied;
+    Store::LocalIndex::WalkPosition position;
+    auto added = initialCount;
+    while (!index.walked(position)) {
+        index.copyEntries(position, 10, copied);
+        for (auto n = 0; n < 4 && added < entries.entries.size(); ++n)
+            index.add(*entries.entries[added++]);
+    }
+    CPPUNIT_ASSERT_EQUAL(entries.entries.size(), added);
+
+    // entries indexed before the walk started must not be missed
+    std::sort(copied.begin(), copied.end());
+    for (size_t i = 0; i < initialCount; ++i)
+        CPPUNIT_ASSERT(std::binary_search(copied.begin(), copied.end(), entries.entries[i]));
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "comm/TimeoutWheel.h"
+#include "compat/cppunit.h"
+#include "unitTestMain.h"
+
+#include <algorithm>
+#include <vector>
+
+class TestTimeoutWheel : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestTimeoutWheel);
+    CPPUNIT_TEST(testExpireInOrder);
+    CPPUNIT_TEST(testReschedule);
+    CPPUNIT_TEST(testForget);
+    CPPUNIT_TEST(testFarFuture);
+    CPPUNIT_TEST(testLongPause);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testExpireInOrder();
+    void testReschedule();
+    void testForget();
+    void testFarFuture();
+    void testLongPause();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestTimeoutWheel );
+
+/// the start of test time
+static const time_t Now = 1000000;
+
+/// wheel.expire() results as a sorted vector
+static std::vector<int>
+Expire(Comm::TimeoutWheel &wheel, const time_t now)
+{
+    std::vector<int> due;
+    wheel.expire(now, due);
+    std::sort(due.begin(), due.end());
+    return due;
+}
+
+void
+TestTimeoutWheel::testExpireInOrder()
+{
+    Comm::TimeoutWheel wheel(16, Now);
+    wheel.schedule(3, Now + 10);
+    wheel.schedule(5, Now + 2);
+    wheel.schedule(7, Now + 2);
+    CPPUNIT_ASSERT_EQUAL(size_t(3), wheel.size());
+
+    CPPUNIT_ASSERT(Expire(wheel, Now + 1).empty());
+    CPPUNIT_ASSERT_EQUAL(std::vector<int>({5, 7}), Expire(wheel, Now + 2));
+    CPPUNIT_ASSERT(!wheel.scheduled(5));
+    CPPUNIT_ASSERT(wheel.scheduled(3));
+    CPPUNIT_ASSERT_EQUAL(std::vector<int>({3}), Expire(wheel, Now + 15));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), wheel.size());
+
+    // the past is due at the next expiration
+    wheel.schedule(1, Now);
+    CPPUNIT_ASSERT_EQUAL(std::vector<int>({1}), Expire(wheel, Now + 16));
+}
+
+void
+TestTimeoutWheel::testReschedule()
+{
+    Comm::TimeoutWheel wheel(16, Now);
+
+    // later times do not move an already scheduled descriptor
+    wheel.schedule(2, Now + 5);
+    wheel.schedule(2, Now + 50);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), wheel.size());
+    CPPUNIT_ASSERT_EQUAL(std::vector<int>({2}), Expire(wheel, Now + 5));
+
+    // earlier times do
+    wheel.schedule(4, Now + 50);
+    wheel.schedule(4, Now + 7);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), wheel.size());
+    CPPUNIT_ASSERT_EQUAL(std::vector<int>({4}), Expire(wheel, Now + 7));
+    CPPUNIT_ASSERT(Expire(wheel, Now + 50).empty());
+}
+
+void
+TestTimeoutWheel::testForget()
+{
+    Comm::TimeoutWheel wheel(16, Now);
+    wheel.schedule(1, Now + 3);
+    wheel.schedule(2, Now + 3);
+    wheel.schedule(3, Now + 3);
+    wheel.forget(2);
+    wheel.forget(2);
+    wheel.forget(9);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), wheel.size());
+    CPPUNIT_ASSERT_EQUAL(std::vector<int>({1, 3}), Expire(wheel, Now + 3));
+}
+
+void
+TestTimeoutWheel::testFarFuture()
+{
+    Comm::TimeoutWheel wheel(16, Now);
+    const auto far = Now + 3*Comm::TimeoutWheel::Slots;
+    wheel.schedule(6, far);
+
+    // returned early, from the farthest slot
+    CPPUNIT_ASSERT(Expire(wheel, Now + Comm::TimeoutWheel::Slots - 2).empty());
+    CPPUNIT_ASSERT_EQUAL(std::vector<int>({6}), Expire(wheel, Now + Comm::TimeoutWheel::Slots - 1));
+
+    // callers reschedule such descriptors until their real deadline
+    auto now = Now + Comm::TimeoutWheel::Slots - 1;
+    int returns = 1;
+    while (now < far) {
+        wheel.schedule(6, far);
+        now += Comm::TimeoutWheel::Slots / 2;
+        returns += Expire(wheel, now).size();
+    }
+    CPPUNIT_ASSERT(!wheel.scheduled(6));
+    CPPUNIT_ASSERT_EQUAL(4, returns);
+}
+
+void
+TestTimeoutWheel::testLongPause()
+{
+    Comm::TimeoutWheel wheel(16, Now);
+    for (int fd = 0; fd < 16; ++fd)
+        wheel.schedule(fd, Now + fd*Comm::TimeoutWheel::Slots/16);
+
+    const auto due = Expire(wheel, Now + 10*Comm::TimeoutWheel::Slots);
+    CPPUNIT_ASSERT_EQUAL(size_t(16), due.size());
+    CPPUNIT_ASSERT_EQUAL(size_t(0), wheel.size());
+
+    wheel.schedule(0, Now + 10*Comm::TimeoutWheel::Slots + 1);
+    CPPUNIT_ASSERT_EQUAL(std::vector<int>({0}), Expire(wheel, Now + 10*Comm::TimeoutWheel::Slots + 1));
+}
+
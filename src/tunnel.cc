@@ -23,6 +23,7 @@
 #include "comm/Connection.h"
 #include "comm/ConnOpener.h"
 #include "comm/Read.h"
+#include "comm/Splice.h"
 #include "comm/Write.h"
 #include "errorpage.h"
 #include "fd.h"
@@ -52,6 +53,7 @@
 #include "tools.h"
 #include "tunnel.h"
 #if USE_DELAY_POOLS
+#include "BandwidthBucket.h"
 #include "DelayId.h"
 #endif
 
@@ -86,6 +88,10 @@ public:
     static void ReadServer(const Comm::ConnectionPointer &, char *buf, size_t len, Comm::Flag errcode, int xerrno, void *data);
     static void WriteClientDone(const Comm::ConnectionPointer &, char *buf, size_t len, Comm::Flag flag, int xerrno, void *data);
     static void WriteServerDone(const Comm::ConnectionPointer &, char *buf, size_t len, Comm::Flag flag, int xerrno, void *data);
+    static void SpliceReadyClient(const Comm::ConnectionPointer &, char *buf, size_t len, Comm::Flag errcode, int xerrno, void *data);
+    static void SpliceReadyServer(const Comm::ConnectionPointer &, char *buf, size_t len, Comm::Flag errcode, int xerrno, void *data);
+    static void SpliceWritableClient(const Comm::ConnectionPointer &, char *buf, size_t len, Comm::Flag flag, int xerrno, void *data);
+    static void SpliceWritableServer(const Comm::ConnectionPointer &, char *buf, size_t len, Comm::Flag flag, int xerrno, void *data);
 
     bool noConnections() const;
     /// closes both client and server connections
@@ -164,6 +170,11 @@ public:
         const char * const side;
 
         char *buf;
+
+        /// bytes read from this connection with splice(2), waiting to be
+        /// spliced to the other connection; used instead of buf when splicing
+        Comm::SplicePipe pipe;
+
         AsyncCall::Pointer writer; ///< pending Comm::Write callback
         uint64_t *size_ptr;      /* pointer to size in an ConnStateData for logging */
 
@@ -223,6 +234,10 @@ public:
 
     void copyRead(Connection &from, Connection &to, IOCB *completion);
 
+    /// whether bytes can be moved from one connection to the other using
+    /// splice(2), without Squid seeing them
+    bool canSplice(const Connection &from, const Connection &to) const;
+
     /// continue to set up connection to a peer, going async for SSL peers
     void connectToPeer(const Comm::ConnectionPointer &);
     void secureConnectionToPeer(const Comm::ConnectionPointer &);
@@ -281,6 +296,8 @@ private:
 public:
     bool keepGoingAfterRead(size_t len, Comm::Flag errcode, int xerrno, Connection &from, Connection &to);
     void copy(size_t len, Connection &from, Connection &to, IOCB *);
+    void spliceIn(Connection &from, IOCB *completion, Comm::Flag errcode, int xerrno);
+    void spliceOut(Connection &from, Connection &to, IOCB *completion, Comm::Flag flag, int xerrno);
     void readServer(char *buf, size_t len, Comm::Flag errcode, int xerrno);
     void readClient(char *buf, size_t len, Comm::Flag errcode, int xerrno);
     void writeClientDone(char *buf, size_t len, Comm::Flag flag, int xerrno);
@@ -319,6 +336,9 @@ operator <<(std::ostream &os, const TunnelStateData::Connection &c)
     if (c.len)
         os << " buf=" << c.len;
 
+    if (c.pipe.isOpen())
+        os << " spliced=" << c.pipe.buffered();
+
     if (c.writer)
         os << " writing";
     else if (!c.dirty)
@@ -482,7 +502,7 @@ TunnelStateData::~TunnelStateData()
 TunnelStateData::Connection::Connection(const char * const aSide):
     len(0),
     side(aSide),
-    buf(static_cast<char *>(xmalloc(SQUID_TCP_SO_RCVBUF))),
+    buf(static_cast<char *>(memAllocBuf(SQUID_TCP_SO_RCVBUF, nullptr))),
     size_ptr(nullptr),
     delayedLoops(0),
     dirty(false),
@@ -496,7 +516,7 @@ TunnelStateData::Connection::~Connection()
     if (readPending)
         eventDelete(readPendingFunc, readPending);
 
-    safe_free(buf);
+    memFreeBuf(SQUID_TCP_SO_RCVBUF, buf);
 }
 
 const char *
@@ -760,6 +780,11 @@ TunnelStateData::keepGoingAfterRead(size_t len, Comm::Flag errcode, int xerrno,
 void
 TunnelStateData::copy(size_t len, Connection &from, Connection &to, IOCB *completion)
 {
+    if (from.pipe.buffered()) {
+        assert(len == from.pipe.buffered());
+        return spliceOut(from, to, completion, Comm::OK, 0);
+    }
+
     debugs(26, 3, "Schedule Write");
     AsyncCall::Pointer call = commCbCall(5,5, "TunnelBlindCopyWriteHandler",
                                          CommIoCbPtrFun(completion, this));
@@ -999,11 +1024,142 @@ TunnelStateData::copyRead(Connection &from, Connection &to, IOCB * const complet
         return;
     }
 
+    if (canSplice(from, to) && from.pipe.open()) {
+        AsyncCall::Pointer call = commCbCall(5,4, "TunnelSpliceReadHandler",
+                                             CommIoCbPtrFun(&from == &client ? SpliceReadyClient : SpliceReadyServer, this));
+        Comm::Read(from.conn, call);
+        return;
+    }
+
     AsyncCall::Pointer call = commCbCall(5,4, "TunnelBlindCopyReadHandler",
                                          CommIoCbPtrFun(completion, this));
     comm_read(from.conn, from.buf, bw, call);
 }
 
+bool
+TunnelStateData::canSplice(const Connection &from, const Connection &to) const
+{
+    if (!Config.onoff.tunnel_splice || !Comm::SpliceSupported())
+        return false;
+
+    if (!Comm::IsConnOpen(from.conn) || !Comm::IsConnOpen(to.conn))
+        return false;
+
+#if USE_DELAY_POOLS
+    if (from.delayId || to.delayId)
+        return false;
+
+    if (BandwidthBucket::SelectBucket(&fd_table[from.conn->fd]) || BandwidthBucket::SelectBucket(&fd_table[to.conn->fd]))
+        return false;
+#endif
+
+    // TLS and other I/O layers must see every byte
+    return fd_table[from.conn->fd].usesDefaultIo() && fd_table[to.conn->fd].usesDefaultIo();
+}
+
+/// the from.conn socket is ready for splice(2)ing into from.pipe
+/// \param completion the regular read callback to report spliced bytes to
+void
+TunnelStateData::spliceIn(Connection &from, IOCB * const completion, const Comm::Flag errcode, const int xerrno)
+{
+    if (errcode != Comm::OK)
+        return completion(from.conn, nullptr, 0, errcode, xerrno, this);
+
+    CommIoCbParams params(this);
+    params.conn = from.conn;
+    switch (Comm::SpliceIn(params, from.pipe)) {
+    case Comm::OK:
+        // splice(2) does not give us the payload, only its size
+        debugs(26, DBG_DATA, "Tunnel " << from.side << " spliced " << params.size << " payload bytes into a pipe");
+        return completion(from.conn, nullptr, params.size, Comm::OK, 0, this);
+
+    case Comm::ENDFILE:
+        return completion(from.conn, nullptr, 0, Comm::OK, 0, this);
+
+    case Comm::INPROGRESS: {
+        // a false readiness report; wait for the next one
+        AsyncCall::Pointer call = commCbCall(5,4, "TunnelSpliceReadHandler",
+                                             CommIoCbPtrFun(&from == &client ? SpliceReadyClient : SpliceReadyServer, this));
+        Comm::Read(from.conn, call);
+        return;
+    }
+
+    default:
+        return completion(from.conn, nullptr, 0, Comm::COMM_ERROR, params.xerrno, this);
+    }
+}
+
+/// moves bytes buffered in from.pipe to the to.conn socket, waiting for that
+/// socket to become writable as needed
+/// \param completion the regular write callback to report fully spliced bytes to
+void
+TunnelStateData::spliceOut(Connection &from, Connection &to, IOCB * const completion, const Comm::Flag flag, const int xerrno)
+{
+    to.writer = nullptr; // the write readiness callback (if any) has fired
+
+    if (flag != Comm::OK)
+        return completion(to.conn, nullptr, 0, flag, xerrno, this);
+
+    to.dirty = true;
+
+    CommIoCbParams params(this);
+    params.conn = to.conn;
+    switch (Comm::SpliceOut(params, from.pipe)) {
+    case Comm::OK:
+        debugs(26, DBG_DATA, "Tunnel " << from.side << " spliced " << params.size << " payload bytes to " << to.side);
+        if (!from.pipe.buffered())
+            return completion(to.conn, nullptr, from.len, Comm::OK, 0, this);
+        break; // wait for to.conn to drain its socket buffer
+
+    case Comm::INPROGRESS:
+        break;
+
+    default:
+        return completion(to.conn, nullptr, 0, Comm::COMM_ERROR, params.xerrno, this);
+    }
+
+    AsyncCall::Pointer call = commCbCall(5,5, "TunnelSpliceWriteHandler",
+                                         CommIoCbPtrFun(&to == &client ? SpliceWritableClient : SpliceWritableServer, this));
+    to.writer = call;
+    Comm::Write(to.conn, call);
+}
+
+/// the client socket is ready for a splice(2) into client.pipe
+void
+TunnelStateData::SpliceReadyClient(const Comm::ConnectionPointer &, char *, size_t, Comm::Flag errcode, int xerrno, void *data)
+{
+    const auto tunnelState = static_cast<TunnelStateData *>(data);
+    assert(cbdataReferenceValid(tunnelState));
+    tunnelState->spliceIn(tunnelState->client, ReadClient, errcode, xerrno);
+}
+
+/// the server socket is ready for a splice(2) into server.pipe
+void
+TunnelStateData::SpliceReadyServer(const Comm::ConnectionPointer &, char *, size_t, Comm::Flag errcode, int xerrno, void *data)
+{
+    const auto tunnelState = static_cast<TunnelStateData *>(data);
+    assert(cbdataReferenceValid(tunnelState));
+    tunnelState->spliceIn(tunnelState->server, ReadServer, errcode, xerrno);
+}
+
+/// the client socket is ready for a splice(2) from server.pipe
+void
+TunnelStateData::SpliceWritableClient(const Comm::ConnectionPointer &, char *, size_t, Comm::Flag flag, int xerrno, void *data)
+{
+    const auto tunnelState = static_cast<TunnelStateData *>(data);
+    assert(cbdataReferenceValid(tunnelState));
+    tunnelState->spliceOut(tunnelState->server, tunnelState->client, WriteClientDone, flag, xerrno);
+}
+
+/// the server socket is ready for a splice(2) from client.pipe
+void
+TunnelStateData::SpliceWritableServer(const Comm::ConnectionPointer &, char *, size_t, Comm::Flag flag, int xerrno, void *data)
+{
+    const auto tunnelState = static_cast<TunnelStateData *>(data);
+    assert(cbdataReferenceValid(tunnelState));
+    tunnelState->spliceOut(tunnelState->client, tunnelState->server, WriteServerDone, flag, xerrno);
+}
+
 void
 TunnelStateData::copyClientBytes()
 {
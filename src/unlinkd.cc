@@ -9,6 +9,7 @@
 /* DEBUG: section 02    Unlink Daemon */
 
 #include "squid.h"
+#include "fatal.h"
 
 #if USE_UNLINKD
 #include "compat/select.h"
@@ -57,7 +58,7 @@ unlinkdUnlink(const char *path)
      * time.
      */
     if (queuelen >= UNLINKD_QUEUE_LIMIT) {
-#if defined(USE_EPOLL) || defined(USE_KQUEUE) || defined(USE_DEVPOLL)
+#if defined(USE_EPOLL) || defined(USE_KQUEUE) || defined(USE_DEVPOLL) || defined(USE_IO_URING)
         /*
          * DPW 2007-04-23
          * We can't use fd_set when using epoll() or kqueue().  In
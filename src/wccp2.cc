@@ -9,6 +9,7 @@
 /* DEBUG: section 80    WCCP Support */
 
 #include "squid.h"
+#include "fatal.h"
 
 #if USE_WCCPv2
 #include "base/RunnersRegistry.h"
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 19    Store Memory Primitives */
+
+/*
+ * Measures mem_hdr node lookups in large in-memory objects, comparing the
+ * offset-indexed mem_hdr with the Splay<mem_node*> tree it used to rely on.
+ * Both indexes point to the same nodes; the splay tree is rebuilt here using
+ * the old node comparison function.
+ *
+ * Usage: mem_hdr_bench [object size in MB [lookups]]
+ */
+
+#include "squid.h"
+#include "mem_node.h"
+#include "splay.h"
+#include "stmem.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/// the old mem_hdr::NodeCompare(): nodes are equal if they intersect
+static int
+NodeCompare(mem_node * const &left, mem_node * const &right)
+{
+    if (left->dataRange().intersection(right->dataRange()).size() > 0)
+        return 0;
+    return *left < *right ? -1 : 1;
+}
+
+/// the old mem_hdr::getBlockContainingLocation()
+static mem_node *
+SplayLookup(const Splay<mem_node *> &nodes, const int64_t location)
+{
+    mem_node target(location);
+    target.nodeBuffer.length = 1;
+    const auto result = nodes.find(&target, NodeCompare);
+    return result ? *result : nullptr;
+}
+
+/// prevents the compiler from optimizing lookups away
+static volatile int64_t Sink = 0;
+
+/// times the given lookups and returns nanoseconds per lookup
+template <class Lookup>
+static double
+Time(const std::vector<int64_t> &locations, const Lookup &lookup)
+{
+    const auto start = std::chrono::steady_clock::now();
+    int64_t sum = 0;
+    for (const auto location: locations)
+        sum += lookup(location)->start();
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    Sink = Sink + sum;
+    return elapsed.count() / locations.size();
+}
+
+/// reports one comparison
+static void
+Report(const char * const label, const double splayNs, const double indexNs)
+{
+    std::cout << std::setw(22) << label <<
+              std::fixed << std::setprecision(1) <<
+              std::setw(14) << splayNs <<
+              std::setw(14) << indexNs <<
+              std::setw(10) << std::setprecision(2) << (splayNs / indexNs) << "\n";
+}
+
+int
+main(int argc, char *argv[])
+{
+    const int64_t megabytes = argc > 1 ? atoll(argv[1]) : 256;
+    const size_t lookups = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000000;
+    if (megabytes < 1 || !lookups) {
+        std::cerr << "usage: " << argv[0] << " [object size in MB [lookups]]\n";
+        return EXIT_FAILURE;
+    }
+    const int64_t objectSize = megabytes*1024*1024;
+
+    // append the object like a server-side reader would, in 16KB chunks
+    mem_hdr header;
+    std::vector<char> chunk(16*1024, 'x');
+    const auto appendStart = std::chrono::steady_clock::now();
+    for (int64_t offset = 0; offset < objectSize; offset += chunk.size())
+        header.write(StoreIOBuffer(chunk.size(), offset, chunk.data()));
+    const std::chrono::duration<double, std::milli> appendTime = std::chrono::steady_clock::now() - appendStart;
+
+    Splay<mem_node *> splay;
+    for (const auto node: header.getNodes())
+        splay.insert(node, NodeCompare);
+
+    std::cout << "object: " << megabytes << " MB in " << header.size() << " nodes; appended in " <<
+              std::fixed << std::setprecision(1) << appendTime.count() << " ms\n";
+    std::cout << std::setw(22) << "lookups" << std::setw(14) << "splay ns" << std::setw(14) << "index ns" << std::setw(10) << "speedup" << "\n";
+
+    // store_client-like reading: ascending offsets, several reads per node
+    std::vector<int64_t> locations;
+    locations.reserve(lookups);
+    for (int64_t offset = 0; locations.size() < lookups; offset = (offset + 1500) % objectSize)
+        locations.push_back(offset);
+    Report("sequential", Time(locations, [&](const int64_t location) {
+        return SplayLookup(splay, location);
+    }), Time(locations, [&](const int64_t location) {
+        return header.getBlockContainingLocation(location);
+    }));
+
+    // many clients reading different parts of the same object
+    std::mt19937_64 random(1);
+    std::uniform_int_distribution<int64_t> anywhere(0, objectSize - 1);
+    for (auto &location: locations)
+        location = anywhere(random);
+    Report("random", Time(locations, [&](const int64_t location) {
+        return SplayLookup(splay, location);
+    }), Time(locations, [&](const int64_t location) {
+        return header.getBlockContainingLocation(location);
+    }));
+
+    // the splay tree does not own the nodes
+    splay.destroy([](mem_node *&) {});
+    return EXIT_SUCCESS;
+}
+
@@ -13,8 +13,10 @@
 #include "mem_node.h"
 #include "stmem.h"
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 static void
 testLowAndHigh()
@@ -40,35 +42,79 @@ testLowAndHigh()
     assert (!aHeader.hasContigousContentRange(Range<int64_t>(10,101)));
 }
 
+/// writes size bytes of a known pattern at the given offset
 static void
-testSplayOfNodes()
+writePattern(mem_hdr &aHeader, const int64_t offset, const size_t size)
 {
-    Splay<mem_node *> aSplay;
-    mem_node *temp5;
-    temp5 = new mem_node(5);
-    temp5->nodeBuffer.length = 10;
-    aSplay.insert (temp5, mem_hdr::NodeCompare);
-    assert (aSplay.start()->data == temp5);
-    assert (aSplay.finish()->data == temp5);
+    std::vector<char> data(size);
+    for (size_t i = 0; i < size; ++i)
+        data[i] = static_cast<char>((offset + i) % 251);
+    assert (aHeader.write (StoreIOBuffer(size, offset, data.data())));
+}
+
+/// whether the given offset is in a node starting at the expected offset
+static bool
+foundIn(const mem_hdr &aHeader, const int64_t location, const int64_t expectedStart)
+{
+    const auto node = aHeader.getBlockContainingLocation(location);
+    return node && node->start() == expectedStart;
+}
+
+static void
+testAppendedLookups()
+{
+    mem_hdr aHeader;
+    writePattern(aHeader, 0, 3*SM_PAGE_SIZE + 10);
+    assert (aHeader.size() == 4);
+    assert (foundIn(aHeader, 0, 0));
+    assert (foundIn(aHeader, SM_PAGE_SIZE - 1, 0));
+    assert (foundIn(aHeader, SM_PAGE_SIZE, SM_PAGE_SIZE));
+    assert (foundIn(aHeader, 3*SM_PAGE_SIZE + 9, 3*SM_PAGE_SIZE));
+    assert (!aHeader.getBlockContainingLocation(3*SM_PAGE_SIZE + 10));
+    assert (!aHeader.getBlockContainingLocation(-1));
 
-    mem_node *temp0;
-    temp0 = new mem_node(0);
-    temp0->nodeBuffer.length = 5;
-    aSplay.insert (temp0, mem_hdr::NodeCompare);
-    assert (aSplay.start()->data == temp0);
-    assert (aSplay.finish()->data == temp5);
+    // small appends extend the last node
+    writePattern(aHeader, 3*SM_PAGE_SIZE + 10, 20);
+    assert (aHeader.size() == 4);
+    assert (aHeader.endOffset() == 3*SM_PAGE_SIZE + 30);
 
-    mem_node *temp14;
-    temp14 = new mem_node (14);
-    temp14->nodeBuffer.length = 1;
-    assert (aSplay.find(temp14,mem_hdr::NodeCompare));
-    delete temp14;
+    // freeing the beginning keeps lookups working
+    assert (aHeader.freeDataUpto(2*SM_PAGE_SIZE) == 2*SM_PAGE_SIZE);
+    assert (!aHeader.getBlockContainingLocation(SM_PAGE_SIZE));
+    assert (foundIn(aHeader, 2*SM_PAGE_SIZE + 5, 2*SM_PAGE_SIZE));
+    assert (foundIn(aHeader, 3*SM_PAGE_SIZE + 29, 3*SM_PAGE_SIZE));
 
-    mem_node ref13  (13);
-    assert (!aSplay.find(&ref13,mem_hdr::NodeCompare));
-    ref13.nodeBuffer.length = 1;
-    assert (aSplay.find(&ref13,mem_hdr::NodeCompare));
-    aSplay.destroy();
+    // copies span nodes
+    char buf[SM_PAGE_SIZE];
+    const auto offset = 3*SM_PAGE_SIZE - 100;
+    assert (aHeader.copy(StoreIOBuffer(sizeof(buf), offset, buf)) == 130);
+    for (int i = 0; i < 130; ++i)
+        assert (buf[i] == static_cast<char>((offset + i) % 251));
+}
+
+static void
+testSparseLookups()
+{
+    mem_hdr aHeader;
+    writePattern(aHeader, 100, 1);
+    writePattern(aHeader, 10, 1);
+    writePattern(aHeader, 2*SM_PAGE_SIZE + 7, 2*SM_PAGE_SIZE);
+    writePattern(aHeader, 11, 5);
+    assert (aHeader.lowestOffset() == 10);
+    assert (aHeader.endOffset() == 4*SM_PAGE_SIZE + 7);
+    assert (foundIn(aHeader, 15, 10));
+    assert (!aHeader.getBlockContainingLocation(16));
+    assert (foundIn(aHeader, 100, 100));
+    assert (!aHeader.getBlockContainingLocation(SM_PAGE_SIZE));
+    assert (foundIn(aHeader, 3*SM_PAGE_SIZE + 6, 2*SM_PAGE_SIZE + 7));
+    assert (foundIn(aHeader, 3*SM_PAGE_SIZE + 7, 3*SM_PAGE_SIZE + 7));
+    assert (aHeader.hasContigousContentRange(Range<int64_t>(10, 16)));
+    assert (!aHeader.hasContigousContentRange(Range<int64_t>(10, 17)));
+    assert (aHeader.hasContigousContentRange(Range<int64_t>(2*SM_PAGE_SIZE + 7, 4*SM_PAGE_SIZE + 7)));
+
+    // a copy stops at the first gap
+    char buf[10];
+    assert (aHeader.copy(StoreIOBuffer(sizeof(buf), 12, buf)) == 4);
 }
 
 static void
@@ -83,9 +129,9 @@ testHdrVisit()
     safe_free (sampleData);
     std::ostringstream result;
     PointerPrinter<mem_node *> foo(result, "\n");
-    for_each (aHeader.getNodes().end(), aHeader.getNodes().end(), foo);
-    for_each (aHeader.getNodes().begin(), aHeader.getNodes().begin(), foo);
-    for_each (aHeader.getNodes().begin(), aHeader.getNodes().end(), foo);
+    std::for_each (aHeader.getNodes().end(), aHeader.getNodes().end(), foo);
+    std::for_each (aHeader.getNodes().begin(), aHeader.getNodes().begin(), foo);
+    std::for_each (aHeader.getNodes().begin(), aHeader.getNodes().end(), foo);
     std::ostringstream expectedResult;
     expectedResult << "[100,101)" << std::endl << "[102,103)" << std::endl;
     assert (result.str() == expectedResult.str());
@@ -97,7 +143,9 @@ main(int, char *[])
     assert (mem_node::InUseCount() == 0);
     testLowAndHigh();
     assert (mem_node::InUseCount() == 0);
-    testSplayOfNodes();
+    testAppendedLookups();
+    assert (mem_node::InUseCount() == 0);
+    testSparseLookups();
     assert (mem_node::InUseCount() == 0);
     testHdrVisit();
     assert (mem_node::InUseCount() == 0);
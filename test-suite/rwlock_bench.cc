@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 54    Interprocess Communication */
+
+/*
+ * Measures cache hit throughput of SMP workers reading a small set of hot
+ * shared memory objects, comparing Ipc::ReadWriteLock shared locking with
+ * optimistic (seqlock-style) reading. Each worker is a process, like a Squid
+ * kid, and all workers share one anonymous memory mapping.
+ *
+ * Usage: rwlock_bench [max workers [seconds per run [object size]]]
+ */
+
+#include "squid.h"
+#include "ipc/ReadWriteLock.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/// the number of hot objects all workers are reading
+static const int HotObjects = 16;
+
+/// the maximum object size
+static const size_t MaxObjectSize = 32*1024;
+
+/// a StoreMap anchor stand-in; anchors are adjacent, like in Ipc::StoreMap
+class Anchor
+{
+public:
+    Ipc::ReadWriteLock lock;
+    uint64_t key[2] = {0, 0};
+};
+
+/// the memory shared by all workers
+class Shared
+{
+public:
+    Anchor anchors[HotObjects];
+    char pages[HotObjects][MaxObjectSize];
+    uint64_t hits[256]; ///< per-worker results
+};
+
+/// prevents the compiler from optimizing copies away
+static volatile char Sink = 0;
+
+/// a single cache hit that locks the anchor for reading
+static void
+LockedHit(Shared &shared, const int object, char *buf, const size_t size)
+{
+    auto &lock = shared.anchors[object].lock;
+    while (!lock.lockShared()) {}
+    memcpy(buf, shared.pages[object], size);
+    lock.unlockShared();
+}
+
+/// a single cache hit that reads the anchor optimistically
+static void
+OptimisticHit(Shared &shared, const int object, char *buf, const size_t size)
+{
+    auto &lock = shared.anchors[object].lock;
+    uint32_t version = 0;
+    if (lock.startOptimisticRead(version)) {
+        memcpy(buf, shared.pages[object], size);
+        if (lock.finishOptimisticRead(version))
+            return;
+    }
+    LockedHit(shared, object, buf, size); // fall back, like MemStore::get()
+}
+
+typedef void HitFunction(Shared &, int, char *, size_t);
+
+/// runs hits until the deadline and reports their number
+static uint64_t
+Work(Shared &shared, const int worker, HitFunction *hit, const size_t size, const std::chrono::steady_clock::time_point deadline)
+{
+    char buf[MaxObjectSize];
+    uint64_t hits = 0;
+    auto object = worker % HotObjects;
+    while (true) {
+        for (int i = 0; i < 1000; ++i) {
+            hit(shared, object, buf, size);
+            Sink = Sink + buf[size - 1];
+            object = (object + 1) % HotObjects;
+        }
+        hits += 1000;
+        if (std::chrono::steady_clock::now() >= deadline)
+            return hits;
+    }
+}
+
+/// runs the given number of worker processes in parallel
+/// \returns the total number of hits per second
+static double
+Run(Shared &shared, const int workers, HitFunction *hit, const size_t size, const double seconds)
+{
+    const auto duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    const auto deadline = std::chrono::steady_clock::now() + duration;
+    for (int worker = 0; worker < workers; ++worker) {
+        const auto pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            shared.hits[worker] = Work(shared, worker, hit, size, deadline);
+            _exit(EXIT_SUCCESS);
+        }
+    }
+
+    for (int worker = 0; worker < workers; ++worker) {
+        int status = 0;
+        if (wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            std::cerr << "worker failure\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    uint64_t total = 0;
+    for (int worker = 0; worker < workers; ++worker)
+        total += shared.hits[worker];
+    return total / seconds;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const int maxWorkers = argc > 1 ? atoi(argv[1]) : 32;
+    const double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+    const size_t size = argc > 3 ? strtoul(argv[3], nullptr, 10) : 512;
+    if (maxWorkers < 1 || maxWorkers > 256 || seconds <= 0 || size < 1 || size > MaxObjectSize) {
+        std::cerr << "usage: " << argv[0] << " [max workers (1-256) [seconds per run [object size (1-" << MaxObjectSize << ")]]]\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto mem = mmap(nullptr, sizeof(Shared), PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+    const auto shared = new (mem) Shared();
+    for (int object = 0; object < HotObjects; ++object)
+        memset(shared->pages[object], 'a' + object, MaxObjectSize);
+
+    std::cout << "hot objects: " << HotObjects << "; object size: " << size << " bytes; " << seconds << " s per run\n";
+    std::cout << std::setw(8) << "workers" << std::setw(16) << "locked hits/s" << std::setw(20) << "optimistic hits/s" << std::setw(10) << "speedup" << "\n";
+    for (int workers = 1; workers <= maxWorkers; workers *= 2) {
+        const auto locked = Run(*shared, workers, &LockedHit, size, seconds);
+        const auto optimistic = Run(*shared, workers, &OptimisticHit, size, seconds);
+        std::cout << std::fixed << std::setprecision(0) <<
+                  std::setw(8) << workers <<
+                  std::setw(16) << locked <<
+                  std::setw(20) << optimistic <<
+                  std::setw(10) << std::setprecision(2) << (optimistic / locked) << "\n";
+    }
+
+    shared->~Shared();
+    munmap(mem, sizeof(Shared));
+    return EXIT_SUCCESS;
+}
+